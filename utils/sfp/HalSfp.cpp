@@ -18,9 +18,47 @@
 
 #include "HalSfp.h"
 #include <stdlib.h>
+#include <stddef.h>
 #include <arpa/inet.h>
 #include <math.h>
+#include <new>
 #include "SfpDb.h"
+#include "SfpDdmBatch.h"
+#include "SfpAlarm.h"
+#include "SfpPmHistory.h"
+#include "SfpPageBuffer.h"
+#include "SfpPageCache.h"
+#include "SfpTime.h"
+#include "SfpModuleDesc.h"
+#include "SfpPresence.h"
+#include "SfpInventory.h"
+#include "SfpCtrlShadow.h"
+#include "SfpProbe.h"
+#include "SfpArena.h"
+
+static const SfpModuleDesc s_noDesc = SfpModuleDesc();   // Descriptor when no module is decoded
+
+SfpArena* HalSfp::s_pArena = NULL;
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Convert a 2 digit ASCII date code field
+
+   @param [in]     a_pSrc : Field
+
+   @return     Value of the leading digits
+*/
+// ------------------------------------------------------------------------------------------------
+static acd_uint16_t decodeDateField(const acd_uint8_t* a_pSrc)
+{
+   acd_uint32_t   i = (a_pSrc[0] == ' ') ? 1 : 0;
+   acd_uint16_t   value = 0;
+
+   for( ; (i < 2) && (a_pSrc[i] >= '0') && (a_pSrc[i] <= '9') ; i++)
+   {
+      value = value * 10 + (a_pSrc[i] - '0');
+   }
+   return value;
+}
 
 //#define SFP_DEBUG
 
@@ -44,17 +82,44 @@ m_isPresent(false),
 m_mode(HalSfpModeUndefined),
 m_defaultSpeed(a_defaultSpeed),
 m_bIsCopper(false),
-m_logErrorCount(0)
+m_bIncrementalMon(false),
+m_bMonStaticValid(false),
+m_bQsfp(false),
+m_monWindowOffset(0),
+m_bIdentityCache(false),
+m_pDesc(&s_noDesc),
+m_pEepromIoDrv(NULL),
+m_alarmFlags(0),
+m_pPmHistory(NULL),
+m_pPhyPages(NULL),
+m_pPageCache(NULL),
+m_pPresence(NULL),
+m_presenceId(0),
+m_pCtrlShadow(NULL),
+m_txDisableMask(0),
+m_pInventory(NULL),
+m_inventoryIndex(0),
+m_bRestored(false),
+m_pArena(s_pArena)
 {
+   void* pMem = (m_pArena != NULL) ? m_pArena->Alloc(sizeof(SfpPageBuffer)) : NULL;
+
    HalSetDebug(false);
+   m_pAlarm = new SfpAlarmEngine();
    memset(m_monData, 0, HAL_SFP_PAGE_SIZE);
    memset(m_interfaceData, 0, HAL_SFP_PAGE_SIZE);
-   memset(m_phyData, 0, HAL_SFP_PAGE_SIZE);
 
-   m_pHdr = (sfp_hdr_type*)m_interfaceData;
-   m_pMon = (sfp_mon_type*)m_monData;
+   // Published pages next to the ones of the other SFPs of the board, see SetArena()
+   m_pPages = (pMem != NULL) ? new(pMem) SfpPageBuffer() : new SfpPageBuffer();
+   publishData();
 
    memset(m_speedCap, 0, sizeof(m_speedCap));
+   memset(&m_identity, 0, sizeof(m_identity));
+   memset(&m_a0Scan, 0, sizeof(m_a0Scan));
+   memset(&m_a2Scan, 0, sizeof(m_a2Scan));
+   memset(&m_counters, 0, sizeof(m_counters));
+   m_pLocalDesc[0] = NULL;
+   m_pLocalDesc[1] = NULL;
 }
 
 // ------------------------------------------------------------------------------------------------
@@ -64,6 +129,29 @@ m_logErrorCount(0)
 // ------------------------------------------------------------------------------------------------
 HalSfp::~HalSfp()
 {
+   // No message left referring to the logger
+   SfpLogRing::GetInstance()->Flush();
+   delete m_pAlarm;
+   delete m_pPmHistory;
+   if ( (m_pArena != NULL) && m_pArena->Owns(m_pPages) )
+   {
+      m_pPages->~SfpPageBuffer();
+   }
+   else
+   {
+      delete m_pPages;
+   }
+   if ( (m_pArena != NULL) && m_pArena->Owns(m_pPhyPages) )
+   {
+      m_pPhyPages->~SfpPhyPageBuffer();
+   }
+   else
+   {
+      delete m_pPhyPages;
+   }
+   delete m_pPageCache;
+   delete m_pLocalDesc[0];
+   delete m_pLocalDesc[1];
 }
 
 // ------------------------------------------------------------------------------------------------
@@ -81,6 +169,20 @@ bool HalSfp::Enable()
    return true;
 }
 
+// ------------------------------------------------------------------------------------------------
+/*!@brief Power-up the SFP without waiting for the supply to settle
+
+   Called by the power-up sequencer (see SfpPowerSequencer), which takes care of the spacing
+   between the power-ups. Same as Enable() unless the platform delays the power-up.
+
+   @return     true if successful
+*/
+// ------------------------------------------------------------------------------------------------
+bool HalSfp::PowerUp()
+{
+   return Enable();
+}
+
 // ------------------------------------------------------------------------------------------------
 /*!@brief Disable the SFP
 
@@ -121,6 +223,35 @@ bool HalSfp::SetTxEnable(bool a_bEnable)
    return true;
 }
 
+// ------------------------------------------------------------------------------------------------
+/*!@brief Set the SFP Tx enable with a bounded latency
+
+   For protection switching and safety shutdowns: the Tx disable bit is changed with a single
+   write of the control register image (see SfpCtrlShadow). The register is only read when the
+   image is not loaded yet (first access or after a write failure). The write latency is kept in
+   the shadow statistics. Same as SetTxEnable() on platforms without a control register shadow.
+
+   The Tx enable state is only updated once the register holds the requested value.
+
+   @param [in]     a_bEnable     : Flag to control the SFP Tx enable
+
+   @return     true if successful, false if the register could not be read or written
+*/
+// ------------------------------------------------------------------------------------------------
+bool HalSfp::SetTxEnableFast(bool a_bEnable)
+{
+   if ( m_pCtrlShadow == NULL )
+   {
+      return SetTxEnable(a_bEnable);
+   }
+   if ( !m_pCtrlShadow->Write(m_txDisableMask, !a_bEnable) )
+   {
+      return false;
+   }
+   m_bTxEnable = a_bEnable;
+   return true;
+}
+
 // ------------------------------------------------------------------------------------------------
 /*!@brief Qwery the SFP Tx enable
 
@@ -164,14 +295,7 @@ bool HalSfp::IsFiber()
 // ------------------------------------------------------------------------------------------------
 bool HalSfp::GetConnector(acd_uint8_t& a_connector)
 {
-   if (m_bIsCopper)
-   {
-      a_connector = SFP_CONN_RJ45;
-   }
-   else
-   {
-      a_connector = m_pHdr->connector;
-   }
+   a_connector = m_pDesc->connector;
 
    return true;
 }
@@ -186,7 +310,7 @@ bool HalSfp::GetConnector(acd_uint8_t& a_connector)
 // ------------------------------------------------------------------------------------------------
 bool HalSfp::GetWaveLength(acd_uint16_t& a_wavelength)
 {
-   a_wavelength = m_pHdr->wave_length;
+   a_wavelength = m_pDesc->wavelength;
 
    return true;
 }
@@ -194,6 +318,8 @@ bool HalSfp::GetWaveLength(acd_uint16_t& a_wavelength)
 // ------------------------------------------------------------------------------------------------
 /*!@brief Get the vendor name field
 
+   The trailing spaces are replaced by NULL, see SfpModuleDesc.
+
    @param [in]     a_name : Vendor name field
 
    @return     true if successful
@@ -201,7 +327,7 @@ bool HalSfp::GetWaveLength(acd_uint16_t& a_wavelength)
 // ------------------------------------------------------------------------------------------------
 bool HalSfp::GetVendorName(char* a_name)
 {
-   memcpy(a_name, m_pHdr->vendor, sizeof(m_pHdr->vendor));
+   memcpy(a_name, m_pDesc->vendor, sizeof(m_pDesc->vendor) - 1);
 
    return true;
 }
@@ -216,7 +342,7 @@ bool HalSfp::GetVendorName(char* a_name)
 // ------------------------------------------------------------------------------------------------
 bool HalSfp::GetVendorOui(char* a_oui)
 {
-   memcpy(a_oui, m_pHdr->vendor_oui, sizeof(m_pHdr->vendor_oui));
+   memcpy(a_oui, m_pDesc->vendorOui, sizeof(m_pDesc->vendorOui));
 
    return true;
 }
@@ -231,24 +357,15 @@ bool HalSfp::GetVendorOui(char* a_oui)
 // ------------------------------------------------------------------------------------------------
 bool HalSfp::GetVendorPartNumber(acd_uchar8_t* a_pn)
 {
-   memcpy(a_pn, m_pHdr->vendor_pn, sizeof(m_pHdr->vendor_pn));
-
-   // Replace all spaces by NULL
-   for(acd_uint32_t i = 0 ; i < sizeof(m_pHdr->vendor_pn) ; i++)
-   {
-      if ( a_pn[i] == ' ' )
-      {
-         a_pn[i] = '\0';
-      }
-   }
-   // Add NULL caracter for safety
-   *(a_pn + sizeof(m_pHdr->vendor_pn)) = '\0';
+   memcpy(a_pn, m_pDesc->vendorPn, sizeof(m_pDesc->vendorPn));
    return true;
 }
 
 // ------------------------------------------------------------------------------------------------
 /*!@brief Get the vendor revision field
 
+   The trailing spaces are replaced by NULL, see SfpModuleDesc.
+
    @param [out]     a_rev : Vendor revision field
 
    @return     true if successful
@@ -256,7 +373,7 @@ bool HalSfp::GetVendorPartNumber(acd_uchar8_t* a_pn)
 // ------------------------------------------------------------------------------------------------
 bool HalSfp::GetVendorRevision(char* a_rev)
 {
-   memcpy(a_rev, m_pHdr->vendor_rev, sizeof(m_pHdr->vendor_rev));
+   memcpy(a_rev, m_pDesc->vendorRev, sizeof(m_pDesc->vendorRev) - 1);
 
    return true;
 }
@@ -271,7 +388,14 @@ bool HalSfp::GetVendorRevision(char* a_rev)
 // ------------------------------------------------------------------------------------------------
 bool HalSfp::GetSerial(char* a_serial)
 {
-   memcpy(a_serial, m_pHdr->serial, sizeof(m_pHdr->serial));
+   SfpPages            pages;
+   const sfp_hdr_type* pHdr = (const sfp_hdr_type*)pages.interfaceData;
+
+   if ( !m_pPages->Read(pages) )
+   {
+      return false;
+   }
+   memcpy(a_serial, pHdr->serial, sizeof(pHdr->serial));
 
    return true;
 }
@@ -289,19 +413,18 @@ bool HalSfp::GetSerial(char* a_serial)
 // ------------------------------------------------------------------------------------------------
 bool HalSfp::GetDateCode(acd_uint16_t& a_year, acd_uint16_t& a_month, acd_uint16_t& a_day, acd_uint16_t& a_lot)
 {
-   char  str[3] = {0,0,0};
-
-   memcpy(str, &m_pHdr->year, 2);
-   a_year = atoi(str) + 2000;
+   SfpPages            pages;
+   const sfp_hdr_type* pHdr = (const sfp_hdr_type*)pages.interfaceData;
 
-   memcpy(str, &m_pHdr->month, 2);
-   a_month = atoi(str);
-
-   memcpy(str, &m_pHdr->day, 2);
-   a_day = atoi(str);
-
-   memcpy(str, &m_pHdr->lot, 2);
-   a_lot = atoi(str);
+   if ( !m_pPages->Read(pages) )
+   {
+      return false;
+   }
+   // Specific to the unit, not in the module descriptor
+   a_year  = decodeDateField((const acd_uint8_t*)&pHdr->year) + 2000;
+   a_month = decodeDateField((const acd_uint8_t*)&pHdr->month);
+   a_day   = decodeDateField((const acd_uint8_t*)&pHdr->day);
+   a_lot   = decodeDateField((const acd_uint8_t*)&pHdr->lot);
 
    return true;
 }
@@ -316,7 +439,14 @@ bool HalSfp::GetDateCode(acd_uint16_t& a_year, acd_uint16_t& a_month, acd_uint16
 // ------------------------------------------------------------------------------------------------
 bool HalSfp::GetExtendedType(acd_uint8_t& a_type)
 {
-   a_type = m_pHdr->ext_id;
+   SfpPages            pages;
+   const sfp_hdr_type* pHdr = (const sfp_hdr_type*)pages.interfaceData;
+
+   if ( !m_pPages->Read(pages) )
+   {
+      return false;
+   }
+   a_type = pHdr->ext_id;
 
    return true;
 }
@@ -331,7 +461,14 @@ bool HalSfp::GetExtendedType(acd_uint8_t& a_type)
 // ------------------------------------------------------------------------------------------------
 bool HalSfp::GetType(acd_uint8_t& a_type)
 {
-   a_type = m_pHdr->id;
+   SfpPages            pages;
+   const sfp_hdr_type* pHdr = (const sfp_hdr_type*)pages.interfaceData;
+
+   if ( !m_pPages->Read(pages) )
+   {
+      return false;
+   }
+   a_type = pHdr->id;
 
    return true;
 }
@@ -346,7 +483,14 @@ bool HalSfp::GetType(acd_uint8_t& a_type)
 // ------------------------------------------------------------------------------------------------
 bool HalSfp::GetTranceiverCode(char* a_code)
 {
-   memcpy(a_code, &m_pHdr->trans3, 8);
+   SfpPages            pages;
+   const sfp_hdr_type* pHdr = (const sfp_hdr_type*)pages.interfaceData;
+
+   if ( !m_pPages->Read(pages) )
+   {
+      return false;
+   }
+   memcpy(a_code, &pHdr->trans3, 8);
 
    return true;
 }
@@ -359,7 +503,9 @@ bool HalSfp::GetTranceiverCode(char* a_code)
 // ------------------------------------------------------------------------------------------------
 bool HalSfp::IsDiagCapable()
 {
-   return (m_pHdr->diag & 0x40) != 0;
+   SfpPages pages;
+
+   return m_pPages->Read(pages) && isDiagCapable(pages);
 }
 
 // ------------------------------------------------------------------------------------------------
@@ -370,7 +516,9 @@ bool HalSfp::IsDiagCapable()
 // ------------------------------------------------------------------------------------------------
 bool HalSfp::IsInternallyCalibrated()
 {
-   return (m_pHdr->diag & 0x20) != 0 ;
+   SfpPages pages;
+
+   return m_pPages->Read(pages) && isInternallyCalibrated(pages);
 }
 
 // ------------------------------------------------------------------------------------------------
@@ -381,7 +529,14 @@ bool HalSfp::IsInternallyCalibrated()
 // ------------------------------------------------------------------------------------------------
 bool HalSfp::IsAlarmCapable()
 {
-   return (m_pHdr->enhance & 0x80) != 0;
+   SfpPages            pages;
+   const sfp_hdr_type* pHdr = (const sfp_hdr_type*)pages.interfaceData;
+
+   if ( !m_pPages->Read(pages) )
+   {
+      return false;
+   }
+   return (pHdr->enhance & 0x80) != 0;
 }
 
 // ------------------------------------------------------------------------------------------------
@@ -394,7 +549,14 @@ bool HalSfp::IsAlarmCapable()
 // ------------------------------------------------------------------------------------------------
 bool HalSfp::GetDiagMonRev(acd_uint8_t& a_rev)
 {
-   a_rev = m_pHdr->rev_8472;
+   SfpPages            pages;
+   const sfp_hdr_type* pHdr = (const sfp_hdr_type*)pages.interfaceData;
+
+   if ( !m_pPages->Read(pages) )
+   {
+      return false;
+   }
+   a_rev = pHdr->rev_8472;
 
    return true;
 }
@@ -409,9 +571,9 @@ bool HalSfp::GetDiagMonRev(acd_uint8_t& a_rev)
 // ------------------------------------------------------------------------------------------------
 bool HalSfp::GetBias(acd_uint32_t& a_bias)
 {
-   a_bias = convertBias( ntohs(m_pMon->bias) );
+   SfpPages pages;
 
-   return true;
+   return m_pPages->Read(pages) && getBias(pages, a_bias);
 }
 
 // ------------------------------------------------------------------------------------------------
@@ -430,21 +592,43 @@ bool HalSfp::GetBias(acd_uint32_t& a_bias)
 // ------------------------------------------------------------------------------------------------
 bool HalSfp::GetMemory(acd_uint32_t a_region, acd_uint8_t* a_memory, acd_uint32_t a_size)
 {
-   bool bRet = false;
+   bool              bRet = false;
+   SfpPages          pages;
+   SfpPhyPageBuffer* pPhyPages = m_pPhyPages;
 
-   if (a_region == 0xA0)
+   if ( a_size > HAL_SFP_PAGE_SIZE )
    {
-      memcpy(a_memory, m_interfaceData, a_size);
-      bRet = true;
+      a_size = HAL_SFP_PAGE_SIZE;
    }
-   else if (a_region == 0xA2)
+
+   if ( a_region == 0xAC )
+   {
+      acd_uint8_t phyData[HAL_SFP_PAGE_SIZE];
+
+      // Cleared until a copper module is read
+      memset(phyData, 0, sizeof(phyData));
+      if ( (pPhyPages != NULL) && !pPhyPages->Read(phyData) )
+      {
+         memset(a_memory, 0xEE, a_size);
+      }
+      else
+      {
+         memcpy(a_memory, phyData, a_size);
+         bRet = true;
+      }
+   }
+   else if ( !m_pPages->Read(pages) )
+   {
+      memset(a_memory, 0xEE, a_size);
+   }
+   else if (a_region == 0xA0)
    {
-      memcpy(a_memory, m_monData, a_size);
+      memcpy(a_memory, pages.interfaceData, a_size);
       bRet = true;
    }
-   else if (a_region == 0xAC)
+   else if (a_region == 0xA2)
    {
-      memcpy(a_memory, m_phyData, a_size);
+      memcpy(a_memory, pages.monData, a_size);
       bRet = true;
    }
    else
@@ -465,8 +649,9 @@ bool HalSfp::GetMemory(acd_uint32_t a_region, acd_uint8_t* a_memory, acd_uint32_
 // ------------------------------------------------------------------------------------------------
 bool HalSfp::GetRxPower(acd_uint32_t& a_pwr)
 {
-   a_pwr = convertRxPower( ntohs(m_pMon->rx_pwr) );
-   return true;
+   SfpPages pages;
+
+   return m_pPages->Read(pages) && getRxPower(pages, a_pwr);
 }
 
 // ------------------------------------------------------------------------------------------------
@@ -479,8 +664,9 @@ bool HalSfp::GetRxPower(acd_uint32_t& a_pwr)
 // ------------------------------------------------------------------------------------------------
 bool HalSfp::GetTemperature(acd_int16_t& a_temp)
 {
-   a_temp = convertTemp( ntohs(m_pMon->temp) );
-   return true;
+   SfpPages pages;
+
+   return m_pPages->Read(pages) && getTemperature(pages, a_temp);
 }
 
 // ------------------------------------------------------------------------------------------------
@@ -493,8 +679,9 @@ bool HalSfp::GetTemperature(acd_int16_t& a_temp)
 // ------------------------------------------------------------------------------------------------
 bool HalSfp::GetTxPower(acd_uint32_t& a_pwr)
 {
-   a_pwr = convertTxPower( ntohs(m_pMon->tx_pwr) );
-   return true;
+   SfpPages pages;
+
+   return m_pPages->Read(pages) && getTxPower(pages, a_pwr);
 }
 
 // ------------------------------------------------------------------------------------------------
@@ -507,13 +694,44 @@ bool HalSfp::GetTxPower(acd_uint32_t& a_pwr)
 // ------------------------------------------------------------------------------------------------
 bool HalSfp::GetVoltage(acd_uint16_t& a_vcc)
 {
-   a_vcc = convertVoltage( ntohs(m_pMon->vcc) );
-   return true;
+   SfpPages pages;
+
+   return m_pPages->Read(pages) && getVoltage(pages, a_vcc);
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Load the SFP calibration constants and live values into a DDM batch
+
+   The calibration constants only need to be reloaded when the module changes but they are
+   cheap to copy compared to the conversion itself.
+
+   @param [in,out]  a_batch : DDM batch
+   @param [in]      a_index : Port index in the batch
+
+   @return     true if successful
+*/
+// ------------------------------------------------------------------------------------------------
+bool HalSfp::GetDdmBatchEntry(SfpDdmBatch& a_batch, acd_uint32_t a_index)
+{
+   SfpPages            pages;
+   const sfp_mon_type* pMon = (const sfp_mon_type*)pages.monData;
+
+   if ( m_bQsfp || !m_pPages->Read(pages) )
+   {
+      return false;
+   }
+   if ( !a_batch.SetCalibration(a_index, isInternallyCalibrated(pages), pMon) )
+   {
+      return false;
+   }
+   return a_batch.SetLiveValues(a_index, pMon);
 }
 
 // ------------------------------------------------------------------------------------------------
 /*!@brief Get the temperature threshold
 
+   Threshold programmed in the module. The threshold the alarms use is given by GetDdmThreshold().
+
    @param [in]    a_id     : Temperature threshold identifier
    @param [out]   a_temp   : Temperature threshold
 
@@ -522,32 +740,16 @@ bool HalSfp::GetVoltage(acd_uint16_t& a_vcc)
 // ------------------------------------------------------------------------------------------------
 bool HalSfp::GetTemperatureThreshold(HalSfpThresholdId a_id, acd_int16_t& a_temp)
 {
-   bool bRet = true;
+   SfpPages pages;
 
-   switch(a_id)
-   {
-      case HalSfpThresholdHighAlarm:
-         a_temp = convertTemp( ntohs(m_pMon->ts_high_alm) );
-         break;
-      case HalSfpThresholdLowAlarm:
-         a_temp = convertTemp( ntohs(m_pMon->ts_low_alm) );
-         break;
-      case HalSfpThresholdHighWarning:
-         a_temp = convertTemp( ntohs(m_pMon->ts_high_warn) );
-         break;
-      case HalSfpThresholdLowWarning:
-         a_temp = convertTemp( ntohs(m_pMon->ts_low_warn) );
-         break;
-      default:
-         bRet = false;
-         break;
-   }
-   return bRet;
+   return m_pPages->Read(pages) && getTemperatureThreshold(pages, a_id, a_temp);
 }
 
 // ------------------------------------------------------------------------------------------------
 /*!@brief Get the rx power threshold
 
+   Threshold programmed in the module. The threshold the alarms use is given by GetDdmThreshold().
+
    @param [in]    a_id  : Rx power threshold identifier
    @param [out]   a_pwr : Rx power threshold
 
@@ -556,32 +758,16 @@ bool HalSfp::GetTemperatureThreshold(HalSfpThresholdId a_id, acd_int16_t& a_temp
 // ------------------------------------------------------------------------------------------------
 bool HalSfp::GetRxPowerThreshold(HalSfpThresholdId a_id, acd_uint32_t& a_pwr)
 {
-   bool bRet = true;
+   SfpPages pages;
 
-   switch(a_id)
-   {
-      case HalSfpThresholdHighAlarm:
-         a_pwr = convertRxPower( ntohs(m_pMon->rx_pwr_high_alm) );
-         break;
-      case HalSfpThresholdLowAlarm:
-         a_pwr = convertRxPower( ntohs(m_pMon->rx_pwr_low_alm) );
-         break;
-      case HalSfpThresholdHighWarning:
-         a_pwr = convertRxPower( ntohs(m_pMon->rx_pwr_high_warn) );
-         break;
-      case HalSfpThresholdLowWarning:
-         a_pwr = convertRxPower( ntohs(m_pMon->rx_pwr_low_warn) );
-         break;
-      default:
-         bRet = false;
-         break;
-   }
-   return bRet;
+   return m_pPages->Read(pages) && getRxPowerThreshold(pages, a_id, a_pwr);
 }
 
 // ------------------------------------------------------------------------------------------------
 /*!@brief Get the tx power threshold
 
+   Threshold programmed in the module. The threshold the alarms use is given by GetDdmThreshold().
+
    @param [in]    a_id  : Tx power threshold identifier
    @param [out]   a_pwr : Tx power threshold
 
@@ -590,32 +776,16 @@ bool HalSfp::GetRxPowerThreshold(HalSfpThresholdId a_id, acd_uint32_t& a_pwr)
 // ------------------------------------------------------------------------------------------------
 bool HalSfp::GetTxPowerThreshold(HalSfpThresholdId a_id, acd_uint32_t& a_pwr)
 {
-   bool bRet = true;
+   SfpPages pages;
 
-   switch(a_id)
-   {
-      case HalSfpThresholdHighAlarm:
-         a_pwr = convertTxPower( ntohs(m_pMon->tx_pwr_high_alm) );
-         break;
-      case HalSfpThresholdLowAlarm:
-         a_pwr = convertTxPower( ntohs(m_pMon->tx_pwr_low_alm) );
-         break;
-      case HalSfpThresholdHighWarning:
-         a_pwr = convertTxPower( ntohs(m_pMon->tx_pwr_high_warn) );
-         break;
-      case HalSfpThresholdLowWarning:
-         a_pwr = convertTxPower( ntohs(m_pMon->tx_pwr_low_warn) );
-         break;
-      default:
-         bRet = false;
-         break;
-   }
-   return bRet;
+   return m_pPages->Read(pages) && getTxPowerThreshold(pages, a_id, a_pwr);
 }
 
 // ------------------------------------------------------------------------------------------------
 /*!@brief Get the voltage threshold
 
+   Threshold programmed in the module. The threshold the alarms use is given by GetDdmThreshold().
+
    @param [in]    a_id  : Voltage threshold identifier
    @param [out]   a_vcc : Voltage threshold
 
@@ -624,32 +794,16 @@ bool HalSfp::GetTxPowerThreshold(HalSfpThresholdId a_id, acd_uint32_t& a_pwr)
 // ------------------------------------------------------------------------------------------------
 bool HalSfp::GetVoltageThreshold(HalSfpThresholdId a_id, acd_uint16_t& a_vcc)
 {
-   bool bRet = true;
+   SfpPages pages;
 
-   switch(a_id)
-   {
-      case HalSfpThresholdHighAlarm:
-         a_vcc = convertVoltage( ntohs(m_pMon->vcc_high_alm) );
-         break;
-      case HalSfpThresholdLowAlarm:
-         a_vcc = convertVoltage( ntohs(m_pMon->vcc_low_alm) );
-         break;
-      case HalSfpThresholdHighWarning:
-         a_vcc = convertVoltage( ntohs(m_pMon->vcc_high_warn) );
-         break;
-      case HalSfpThresholdLowWarning:
-         a_vcc = convertVoltage( ntohs(m_pMon->vcc_low_warn) );
-         break;
-      default:
-         bRet = false;
-         break;
-   }
-   return bRet;
+   return m_pPages->Read(pages) && getVoltageThreshold(pages, a_id, a_vcc);
 }
 
 // ------------------------------------------------------------------------------------------------
 /*!@brief Get the bias threshold
 
+   Threshold programmed in the module. The threshold the alarms use is given by GetDdmThreshold().
+
    @param [in]    a_id     : Bias threshold identifier
    @param [out]   a_bias   : Bias threshold
 
@@ -658,95 +812,122 @@ bool HalSfp::GetVoltageThreshold(HalSfpThresholdId a_id, acd_uint16_t& a_vcc)
 // ------------------------------------------------------------------------------------------------
 bool HalSfp::GetBiasThreshold(HalSfpThresholdId a_id, acd_uint32_t& a_bias)
 {
-   bool bRet = true;
+   SfpPages pages;
 
-   switch(a_id)
-   {
-      case HalSfpThresholdHighAlarm:
-         a_bias = convertBias( ntohs(m_pMon->lbc_high_alm) );
-         break;
-      case HalSfpThresholdLowAlarm:
-         a_bias = convertBias( ntohs(m_pMon->lbc_low_alm) );
-         break;
-      case HalSfpThresholdHighWarning:
-         a_bias = convertBias( ntohs(m_pMon->lbc_high_warn) );
-         break;
-      case HalSfpThresholdLowWarning:
-         a_bias = convertBias( ntohs(m_pMon->lbc_low_warn) );
-         break;
-      default:
-         bRet = false;
-         break;
-   }
-   //HalDebug("GetBiasThreshold(%d, %d) = %d", id, bias, bRet);
-   return bRet;
+   return m_pPages->Read(pages) && getBiasThreshold(pages, a_id, a_bias);
 }
 
 // ------------------------------------------------------------------------------------------------
-/*!@brief Set the temperature threshold
+/*!@brief Get all the monitoring values
 
-   @param [in]    a_id     : Temperature threshold identifier
-   @param [in]    a_temp   : Temperature threshold
-
-   @return     true if successful
+   @param [out]   a_values : Values in the units of the getters, indexed by SfpDdmParam
 */
 // ------------------------------------------------------------------------------------------------
-bool HalSfp::SetTemperatureThreshold(HalSfpThresholdId a_id, acd_int16_t& a_temp)
+void HalSfp::GetDdmValues(acd_int32_t a_values[SfpDdmParamMax])
 {
-   bool bRet = true;
+   SfpPages pages;
 
-   // TODO: Save temperature threshold
-   switch(a_id)
+   if ( !m_pPages->Read(pages) )
    {
-      case HalSfpThresholdHighAlarm:
-         break;
-      case HalSfpThresholdLowAlarm:
-         break;
-      case HalSfpThresholdHighWarning:
-         break;
-      case HalSfpThresholdLowWarning:
-         break;
-      default:
-         bRet = false;
-         break;
+      memset(a_values, 0, SfpDdmParamMax * sizeof(acd_int32_t));
+      return;
    }
-   return bRet;
+   getDdmValues(pages, a_values);
 }
 
 // ------------------------------------------------------------------------------------------------
-/*!@brief Set the rx power threshold
+/*!@brief Get the threshold applied to a monitoring value
 
-   @param [in]    a_id  : Rx power threshold identifier
-   @param [in]    a_pwr : Rx power threshold
+   The user threshold (see the Set*Threshold() methods) if set, the module threshold otherwise.
+
+   @param [in]    a_param  : Parameter
+   @param [in]    a_id     : Threshold identifier
+   @param [out]   a_value  : Threshold in the units of the getters
 
    @return     true if successful
 */
 // ------------------------------------------------------------------------------------------------
-bool HalSfp::SetRxPowerThreshold(HalSfpThresholdId a_id, acd_uint32_t& a_pwr)
+bool HalSfp::GetDdmThreshold(SfpDdmParam a_param, HalSfpThresholdId a_id, acd_int32_t& a_value)
 {
-   bool bRet = true;
+   SfpPages pages;
 
-   // TODO: Save rx power threshold
-   switch(a_id)
+   if ( m_pAlarm->GetThreshold(a_param, a_id, a_value) )
    {
-      case HalSfpThresholdHighAlarm:
-         break;
-      case HalSfpThresholdLowAlarm:
-         break;
-      case HalSfpThresholdHighWarning:
-         break;
-      case HalSfpThresholdLowWarning:
-         break;
-      default:
-         bRet = false;
-         break;
+      return true;
    }
-   return bRet;
+   return m_pPages->Read(pages) && getDdmThreshold(pages, a_param, a_id, a_value);
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Get the monitoring values and thresholds from a single page snapshot
+
+   Same values as GetDdmValues() and GetDdmThreshold() for a fraction of the cost when all of
+   them are needed.
+
+   @param [out]   a_sample : Values and thresholds
+
+   @return     true if successful
+*/
+// ------------------------------------------------------------------------------------------------
+bool HalSfp::GetDdmSample(SfpDdmSample& a_sample)
+{
+   SfpPages pages;
+
+   if ( !m_pPages->Read(pages) )
+   {
+      return false;
+   }
+   getDdmValues(pages, a_sample.values);
+   for(acd_uint32_t p = 0 ; p < SfpDdmParamMax ; p++)
+   {
+      for(acd_uint32_t id = 0 ; id < HalSfpThresholdMax ; id++)
+      {
+         a_sample.bThreshold[p][id] = m_pAlarm->GetThreshold((SfpDdmParam)p, (HalSfpThresholdId)id,
+                                                            a_sample.threshold[p][id]) ||
+                                      getDdmThreshold(pages, (SfpDdmParam)p, (HalSfpThresholdId)id,
+                                                      a_sample.threshold[p][id]);
+      }
+   }
+   return true;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Set the temperature threshold
+
+   User threshold of the alarm engine, the module is not written. Read back with GetDdmThreshold().
+
+   @param [in]    a_id     : Temperature threshold identifier
+   @param [in]    a_temp   : Temperature threshold
+
+   @return     true if successful
+*/
+// ------------------------------------------------------------------------------------------------
+bool HalSfp::SetTemperatureThreshold(HalSfpThresholdId a_id, acd_int16_t& a_temp)
+{
+   return m_pAlarm->SetThreshold(SfpDdmParamTemp, a_id, a_temp);
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Set the rx power threshold
+
+   User threshold of the alarm engine, the module is not written. Read back with GetDdmThreshold().
+
+   @param [in]    a_id  : Rx power threshold identifier
+   @param [in]    a_pwr : Rx power threshold
+
+   @return     true if successful
+*/
+// ------------------------------------------------------------------------------------------------
+bool HalSfp::SetRxPowerThreshold(HalSfpThresholdId a_id, acd_uint32_t& a_pwr)
+{
+   return m_pAlarm->SetThreshold(SfpDdmParamRxPower, a_id, a_pwr);
 }
 
 // ------------------------------------------------------------------------------------------------
 /*!@brief Set the tx power threshold
 
+   User threshold of the alarm engine, the module is not written. Read back with GetDdmThreshold().
+
    @param [in]     a_id  : Tx power threshold identifier
    @param [in]     a_pwr : Tx power threshold
 
@@ -755,29 +936,14 @@ bool HalSfp::SetRxPowerThreshold(HalSfpThresholdId a_id, acd_uint32_t& a_pwr)
 // ------------------------------------------------------------------------------------------------
 bool HalSfp::SetTxPowerThreshold(HalSfpThresholdId a_id, acd_uint32_t& a_pwr)
 {
-   bool bRet = true;
-
-   // TODO: Save tx power threshold
-   switch(a_id)
-   {
-      case HalSfpThresholdHighAlarm:
-         break;
-      case HalSfpThresholdLowAlarm:
-         break;
-      case HalSfpThresholdHighWarning:
-         break;
-      case HalSfpThresholdLowWarning:
-         break;
-      default:
-         bRet = false;
-         break;
-   }
-   return bRet;
+   return m_pAlarm->SetThreshold(SfpDdmParamTxPower, a_id, a_pwr);
 }
 
 // ------------------------------------------------------------------------------------------------
 /*!@brief Set the voltage threshold
 
+   User threshold of the alarm engine, the module is not written. Read back with GetDdmThreshold().
+
    @param [in]     a_id    : Voltage threshold identifier
    @param [in]     a_vcc   : Voltage threshold
 
@@ -786,29 +952,14 @@ bool HalSfp::SetTxPowerThreshold(HalSfpThresholdId a_id, acd_uint32_t& a_pwr)
 // ------------------------------------------------------------------------------------------------
 bool HalSfp::SetVoltageThreshold(HalSfpThresholdId a_id, acd_uint16_t& a_vcc)
 {
-   bool bRet = true;
-
-   // TODO: Save voltage threshold
-   switch(a_id)
-   {
-      case HalSfpThresholdHighAlarm:
-         break;
-      case HalSfpThresholdLowAlarm:
-         break;
-      case HalSfpThresholdHighWarning:
-         break;
-      case HalSfpThresholdLowWarning:
-         break;
-      default:
-         bRet = false;
-         break;
-   }
-   return bRet;
+   return m_pAlarm->SetThreshold(SfpDdmParamVcc, a_id, a_vcc);
 }
 
 // ------------------------------------------------------------------------------------------------
 /*!@brief Set the bias threshold
 
+   User threshold of the alarm engine, the module is not written. Read back with GetDdmThreshold().
+
    @param [in]     a_id    : Bias threshold identifier
    @param [in]     a_bias  : Bias threshold
 
@@ -817,24 +968,7 @@ bool HalSfp::SetVoltageThreshold(HalSfpThresholdId a_id, acd_uint16_t& a_vcc)
 // ------------------------------------------------------------------------------------------------
 bool HalSfp::SetBiasThreshold(HalSfpThresholdId a_id, acd_uint32_t& a_bias)
 {
-   bool bRet = true;
-
-   // TODO: Save bias threshold
-   switch(a_id)
-   {
-      case HalSfpThresholdHighAlarm:
-         break;
-      case HalSfpThresholdLowAlarm:
-         break;
-      case HalSfpThresholdHighWarning:
-         break;
-      case HalSfpThresholdLowWarning:
-         break;
-      default:
-         bRet = false;
-         break;
-   }
-   return bRet;
+   return m_pAlarm->SetThreshold(SfpDdmParamBias, a_id, a_bias);
 }
 
 // ------------------------------------------------------------------------------------------------
@@ -858,310 +992,1723 @@ bool HalSfp::IsPresent()
 // ------------------------------------------------------------------------------------------------
 bool HalSfp::GetLength(acd_uint32_t& a_length)
 {
-   bool bRet = true;
+   const SfpModuleDesc* pDesc = m_pDesc;
+
+   a_length = pDesc->length;
+
+   return pDesc->bLengthValid;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Update SFP data
+
+   @return     true if successful
+*/
+// ------------------------------------------------------------------------------------------------
+bool HalSfp::UpdateData()
+{
+   const sfp_hdr_type* pHdr = (const sfp_hdr_type*)m_interfaceData;
+   bool                bRet;
 
-   if (m_pHdr->length9mkm != 0)
+   // m_pDesc is left as is: the getters keep the previous descriptor until the new one is set
+   m_identity.bValid = false;
+   m_bQsfp = isQsfpId(m_interfaceData[0]);
+   if ( m_bQsfp )
    {
-      // Link length supported for 9/125 mm fiber, units of km
-      a_length = m_pHdr->length9mkm * 1000;
+      bRet = updateQsfp();
    }
-   else if (m_pHdr->length9m != 0)
+   else
    {
-      // Length (9m) Link length supported for 9/125 mm fiber, units of 100 m
-      a_length = m_pHdr->length9m * 100;
+      if ( m_pPageCache != NULL )
+      {
+         m_pPageCache->SetPagedRegion(0xA2);
+      }
+      publishData();
+      bRet = m_a0Scan.bBaseValid && m_a0Scan.bExtValid;
    }
-   else if (m_pHdr->length50 != 0)
+   if ( !bRet )
    {
-      // Link length supported for 50/125 mm fiber, units of 10 m
-      a_length = m_pHdr->length50 * 10;
+      SFP_PROBE2(checksum_fail, this, 0xA0);
+      m_counters.a0ChecksumErrors++;
+      logEvent(SfpLogA0Checksum);
+      return false;
    }
-   else if (m_pHdr->length625 != 0)
+
+   bRet = updateDescriptor();
+   if ( bRet )
    {
-      // Link length supported for 62.5/125 mm fiber, units of 10 m
-      a_length = m_pHdr->length625 * 10;
+      m_identity.ccBase = m_interfaceData[HAL_SFP_CC_BASE];
+      m_identity.ccExt  = m_interfaceData[HAL_SFP_CC_EXT];
+      memcpy(m_identity.vendorPn, pHdr->vendor_pn, sizeof(m_identity.vendorPn));
+      memcpy(m_identity.serial, pHdr->serial, sizeof(m_identity.serial));
+      m_identity.bValid = true;
+      saveInventory();
    }
-   else if (m_pHdr->length_copper != 0)
+   return bRet;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Update SFP monitoring data
+
+   @return     true if successful
+*/
+// ------------------------------------------------------------------------------------------------
+bool HalSfp::UpdateMonitoringData()
+{
+   publishData();
+   if ( m_monWindowOffset == 0 )
    {
-      // Length (Copper) Link length supported for copper, units of meters
-      a_length = m_pHdr->length_copper;
+      if ( !m_a2Scan.bDmiValid )
+      {
+         m_bMonStaticValid = false;
+         SFP_PROBE2(checksum_fail, this, 0xA2);
+         m_counters.a2ChecksumErrors++;
+         logEvent(SfpLogA2Checksum);
+         return false;
+      }
+      if ( !m_bMonStaticValid )
+      {
+         m_bMonStaticValid = true;
+         saveInventory();
+      }
    }
-   else
+   // else live values only, the thresholds and calibration constants were validated on insertion
+
+   m_alarmFlags = m_bQsfp ? 0 : decodeAlarmFlags(&m_monData[HAL_SFP_A2_FLAGS_OFFSET]);
+   processDdmValues();
+
+   if ( m_pPageCache != NULL )
    {
-      bRet = false;
-      a_length = 0;
+      m_pPageCache->Poll();
    }
+   return true;
+}
 
-   return bRet;
+// ------------------------------------------------------------------------------------------------
+/*!@brief Enable the incremental monitoring data read
+
+   When enabled, the A2h thresholds and calibration constants (bytes 0-95) are read once when
+   the SFP is inserted or until their check code is valid. Afterwards only the live values and
+   flags (bytes 96-117) are read by UpdateMonitoringData().
+   The I2C driver must support byte offset reads (see HAL_SFP_I2C_REG).
+
+   @param [in]     a_bEnable : Flag to control the incremental read
+*/
+// ------------------------------------------------------------------------------------------------
+void HalSfp::SetIncrementalMonitoring(bool a_bEnable)
+{
+   m_bIncrementalMon = a_bEnable;
 }
 
 // ------------------------------------------------------------------------------------------------
-/*!@brief Update SFP data
+/*!@brief Qwery the incremental monitoring data read
 
-   @return     true if successful
+   @return     true if the incremental read is enabled
 */
 // ------------------------------------------------------------------------------------------------
-bool HalSfp::UpdateData()
+bool HalSfp::IsIncrementalMonitoring()
+{
+   return m_bIncrementalMon;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Invalidate the SFP data
+
+   Forces a full EEPROM read on the next update. Called by IsPresent() when the SFP is removed,
+   not on every poll that finds the slot empty.
+*/
+// ------------------------------------------------------------------------------------------------
+void HalSfp::Invalidate()
 {
-   if ( !checkCodeBase(m_interfaceData) || !checkCodeExt(m_interfaceData) )
+   m_bMonStaticValid = false;
+   m_identity.bValid = false;
+   m_bRestored = false;
+   if ( m_pInventory != NULL )
    {
-      m_pLogger->LogDebug("SFP 0xA0 checksum failed");
-      return false;
+      m_pInventory->Erase(m_inventoryIndex);
+   }
+   m_pDesc = &s_noDesc;
+   m_bQsfp = false;
+   m_alarmFlags = 0;
+   m_pAlarm->Reset(this);
+   if ( m_pPageCache != NULL )
+   {
+      m_pPageCache->Invalidate();
    }
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Set the alarm listener
+
+   The listener is notified when a monitoring value crosses one of the thresholds set with
+   the Set*Threshold() methods.
 
-   // Shall be implemented in a derived class
-   return updateSpeedCap();
+   @param [in]     a_pListener : Alarm listener, NULL for none
+*/
+// ------------------------------------------------------------------------------------------------
+void HalSfp::SetAlarmListener(SfpAlarmListener* a_pListener)
+{
+   m_pAlarm->SetListener(a_pListener);
 }
 
 // ------------------------------------------------------------------------------------------------
-/*!@brief Update SFP monitoring data
+/*!@brief Get the alarm engine
+
+   Gives access to the hysteresis and hold-off settings of the port
+
+   @return     Alarm engine
+*/
+// ------------------------------------------------------------------------------------------------
+SfpAlarmEngine* HalSfp::GetAlarmEngine()
+{
+   return m_pAlarm;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Poll the module alarm and warning flags
+
+   Fast path for high rate alarm polling: only the A2h flag bytes (112-117) are read. The full
+   monitoring data is read with UpdateMonitoringData() only when a flag changed, so the values
+   and the software alarms are refreshed on the transitions.
+   The SFP must be alarm capable (see IsAlarmCapable()) and the I2C driver must support byte
+   offset reads (see HAL_SFP_I2C_REG).
+
+   @param [out]    a_bChanged : true if a flag changed since the last poll
 
    @return     true if successful
 */
 // ------------------------------------------------------------------------------------------------
-bool HalSfp::UpdateMonitoringData()
+bool HalSfp::PollAlarmFlags(bool& a_bChanged)
 {
-   if ( !checkCodeDmi(m_monData) )
+   acd_uint8_t    buffer[HAL_SFP_A2_FLAGS_SIZE];
+   acd_uint32_t   flags;
+
+   a_bChanged = false;
+   if ( !m_isPresent || !m_bEnable || m_bQsfp || !IsAlarmCapable() )
+   {
+      return false;
+   }
+
+   if ( !readEeprom(0xA2, HAL_SFP_A2_FLAGS_OFFSET, sizeof(buffer), buffer) )
    {
-      m_pLogger->LogDebug("SFP 0xA2 checksum failed");
+      logEvent(SfpLogFlagsReadFailed);
       return false;
    }
+
+   flags = decodeAlarmFlags(buffer);
+   if ( flags == m_alarmFlags )
+   {
+      return true;
+   }
+
+   a_bChanged = true;
+   if ( !UpdateMonitoringData() )
+   {
+      // Keep the flags reported by the module, the values are refreshed on the next change
+      memcpy(&m_monData[HAL_SFP_A2_FLAGS_OFFSET], buffer, sizeof(buffer));
+      m_alarmFlags = flags;
+      publishData();
+   }
    return true;
 }
 
 // ------------------------------------------------------------------------------------------------
-/*!@brief Convert the temperature
+/*!@brief Get the module alarm and warning flags
 
-   @param [in]     a_tsAd : Analog to digital converter value
+   Flags of the last monitoring update or flag poll. Test a flag with
+   HAL_SFP_FLAG(SfpDdmParam, HalSfpThresholdId).
 
-   @return     Temperature
+   @return     Flag bitmask
 */
 // ------------------------------------------------------------------------------------------------
-acd_int16_t HalSfp::convertTemp(acd_int16_t a_tsAd)
+acd_uint32_t HalSfp::GetAlarmFlags()
 {
-   acd_int16_t    ts_offset;
-   acd_uint16_t   ts_slope;
-   acd_int16_t    ts;
-   float          slope;
+   return m_alarmFlags;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Enable the DDM history
+
+   Each successful UpdateMonitoringData() adds a sample to the history and updates the 15 minute
+   and 24 hour bins. The memory is allocated here, not on the polling path.
 
-   if ( IsInternallyCalibrated() )
+   @param [in]     a_nbSamples : Number of samples kept, 0 to disable the history
+
+   @return     true if successful
+*/
+// ------------------------------------------------------------------------------------------------
+bool HalSfp::EnablePmHistory(acd_uint32_t a_nbSamples)
+{
+   delete m_pPmHistory;
+   m_pPmHistory = NULL;
+   if ( a_nbSamples != 0 )
    {
-      ts = (a_tsAd/256);
-      //HalDebug("internal ts: %d", ts);
+      m_pPmHistory = new SfpPmHistory(a_nbSamples);
    }
-   else
-   {
-      ts_slope = ntohs(m_pMon->ts_slope);
-      ts_offset = ntohs(m_pMon->ts_offset);
+   return true;
+}
 
-      slope = (ts_slope&0x00FF);
-      slope = slope/256;
-      slope += ts_slope>>8;
+// ------------------------------------------------------------------------------------------------
+/*!@brief Get the DDM history
 
-      ts = (acd_int16_t)((a_tsAd*slope + ts_offset)/256);
-      //HalDebug("external ts_slope: %f ts_offset: %d", slope, ts_offset);
-      //HalDebug("external ts: %d", ts);
-   }
-   return ts;
+   The history is read from memory only, the SFP is not accessed.
+
+   @return     DDM history, NULL if disabled
+*/
+// ------------------------------------------------------------------------------------------------
+SfpPmHistory* HalSfp::GetPmHistory()
+{
+   return m_pPmHistory;
 }
 
 // ------------------------------------------------------------------------------------------------
-/*!@brief Convert the voltage
+/*!@brief Get a consistent copy of the SFP memory
 
-   @param [in]     a_vccAd : Voltage analog to digital converter value
+   Can be called from any thread without blocking the poller. The copy is the data published by
+   the last UpdateData() or UpdateMonitoringData().
 
-   @return     Voltage
+   @param [out]    a_pages       : Copy of the A0h, A2h and ACh pages
+   @param [out]    a_pGeneration : Publication number of the copy, optional
+
+   @return     true if successful
 */
 // ------------------------------------------------------------------------------------------------
-acd_uint16_t HalSfp::convertVoltage(acd_uint16_t a_vccAd)
+bool HalSfp::GetSnapshot(SfpPages& a_pages, acd_uint32_t* a_pGeneration)
 {
-   acd_int16_t    vcc_offset;
-   acd_uint16_t   vcc_slope;
-   acd_uint16_t   vcc;
-   float          slope;
+   return m_pPages->Read(a_pages, a_pGeneration);
+}
 
-   if ( IsInternallyCalibrated() )
-   {
-      vcc = a_vccAd/10;
-      //HalDebug("internal vcc: %d", vcc);
-   }
-   else
-   {
-      vcc_slope = ntohs(m_pMon->vcc_slope);
-      vcc_offset = ntohs(m_pMon->vcc_offset);
-      slope = (vcc_slope&0x00FF)/256 + (vcc_slope>>8);
-      vcc = (acd_uint16_t)((a_vccAd*slope + vcc_offset)/10);
-      //HalDebug("external vcc_slope: %f vcc_offset: %d vcc:", slope, vcc_offset, vcc);
-   }
+// ------------------------------------------------------------------------------------------------
+/*!@brief Get the publication number of the SFP memory
 
-   return vcc;
+   Changes each time the poller publishes new data
+
+   @return     Publication number
+*/
+// ------------------------------------------------------------------------------------------------
+acd_uint32_t HalSfp::GetGeneration()
+{
+   return m_pPages->GetGeneration();
 }
 
 // ------------------------------------------------------------------------------------------------
-/*!@brief Convert the bias
+/*!@brief Read the SFP paged memory
 
-   @param [in]     a_lbcAd : Bias analog to digital converter value
+   Gives access to the A2h upper memory pages (ex: extended diagnostics) and to the vendor
+   specific memory. The pages are cached according to their refresh policy, see SetPagePolicy().
 
-   @return     Bias
+   @param [in]     a_region   : Memory region (0xA0 or 0xA2)
+   @param [in]     a_page     : A2h page select value, SFP_PAGE_LOWER for bytes 0-127
+   @param [in]     a_offset   : Byte offset within the page (0-127)
+   @param [in]     a_size     : Number of bytes to read
+   @param [out]    a_pBuf     : Data
+
+   @return     true if successful
 */
 // ------------------------------------------------------------------------------------------------
-acd_uint32_t HalSfp::convertBias(acd_uint16_t a_lbcAd)
+bool HalSfp::ReadPagedMemory(acd_uint32_t a_region, acd_uint32_t a_page, acd_uint32_t a_offset, acd_uint32_t a_size, acd_uint8_t* a_pBuf)
 {
-   acd_int16_t    lbc_offset;
-   acd_uint16_t   lbc_slope;
-   acd_uint32_t   lbc;
-   float          slope;
+   SfpPageCache* pCache = m_isPresent ? pageCache() : NULL;
 
-   if ( IsInternallyCalibrated() )
+   if ( pCache == NULL )
    {
-      lbc = (a_lbcAd*2);
-      //HalDebug("internal lbc: %d", lbc);
+      return false;
    }
-   else
-   {
-      lbc_slope = ntohs(m_pMon->lbc_slope);
-      lbc_offset = ntohs(m_pMon->lbc_offset);
-      slope = ((float)(lbc_slope&0x00FF) / 256.0) + (float)(lbc_slope>>8);
-      lbc = (acd_uint32_t)((a_lbcAd*slope + lbc_offset)*2);
-      //HalDebug("external lbc_slope: %f lbc_offset: %d lbc: %d", slope, lbc_offset, lbc);
+   return pCache->Read(a_region, a_page, a_offset, a_size, a_pBuf);
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Set the refresh policy of a SFP memory page
+
+   The periodic pages are refreshed by UpdateMonitoringData().
+
+   @param [in]     a_region   : Memory region (0xA0 or 0xA2)
+   @param [in]     a_page     : A2h page select value, SFP_PAGE_LOWER for bytes 0-127
+   @param [in]     a_policy   : Refresh policy
+   @param [in]     a_periodMs : Refresh period in msec of a periodic page
+
+   @return     true if successful
+*/
+// ------------------------------------------------------------------------------------------------
+bool HalSfp::SetPagePolicy(acd_uint32_t a_region, acd_uint32_t a_page, SfpPagePolicy a_policy, acd_uint32_t a_periodMs)
+{
+   SfpPageCache* pCache = pageCache();
+
+   if ( pCache == NULL )
+   {
+      return false;
+   }
+   return pCache->SetPolicy(a_region, a_page, a_policy, a_periodMs);
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Check if the module is a QSFP (SFF-8636)
+
+   @return     true if QSFP
+*/
+// ------------------------------------------------------------------------------------------------
+bool HalSfp::IsQsfp()
+{
+   return m_bQsfp;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Get the number of lanes
+
+   @return     Number of lanes, 4 for a QSFP and 1 for a SFP
+*/
+// ------------------------------------------------------------------------------------------------
+acd_uint32_t HalSfp::GetLaneCount()
+{
+   return m_bQsfp ? QSFP_LANES : 1;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Get the rx power of a lane
+
+   @param [in]      a_lane : Lane (0 to GetLaneCount() - 1)
+   @param [out]     a_pwr  : Rx power
+
+   @return     true if successful
+*/
+// ------------------------------------------------------------------------------------------------
+bool HalSfp::GetLaneRxPower(acd_uint32_t a_lane, acd_uint32_t& a_pwr)
+{
+   SfpPages       pages;
+
+   if ( a_lane >= GetLaneCount() )
+   {
+      return false;
+   }
+   if ( !m_bQsfp )
+   {
+      return GetRxPower(a_pwr);
+   }
+   if ( !m_pPages->Read(pages) )
+   {
+      return false;
+   }
+   a_pwr = convertRxPower( pages, qsfpWord(pages, QSFP_RX_PWR + 2 * a_lane) );
+   return true;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Get the tx bias of a lane
+
+   @param [in]      a_lane : Lane (0 to GetLaneCount() - 1)
+   @param [out]     a_bias : Bias
+
+   @return     true if successful
+*/
+// ------------------------------------------------------------------------------------------------
+bool HalSfp::GetLaneBias(acd_uint32_t a_lane, acd_uint32_t& a_bias)
+{
+   SfpPages       pages;
+
+   if ( a_lane >= GetLaneCount() )
+   {
+      return false;
+   }
+   if ( !m_bQsfp )
+   {
+      return GetBias(a_bias);
+   }
+   if ( !m_pPages->Read(pages) )
+   {
+      return false;
+   }
+   a_bias = convertBias( pages, qsfpWord(pages, QSFP_TX_BIAS + 2 * a_lane) );
+   return true;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Get the tx power of a lane
+
+   @param [in]      a_lane : Lane (0 to GetLaneCount() - 1)
+   @param [out]     a_pwr  : Tx power
+
+   @return     true if successful
+*/
+// ------------------------------------------------------------------------------------------------
+bool HalSfp::GetLaneTxPower(acd_uint32_t a_lane, acd_uint32_t& a_pwr)
+{
+   SfpPages       pages;
+
+   if ( a_lane >= GetLaneCount() )
+   {
+      return false;
+   }
+   if ( !m_bQsfp )
+   {
+      return GetTxPower(a_pwr);
+   }
+   if ( !m_pPages->Read(pages) )
+   {
+      return false;
+   }
+   a_pwr = convertTxPower( pages, qsfpWord(pages, QSFP_TX_PWR + 2 * a_lane) );
+   return true;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Enable the module identity cache
+
+   When enabled, UpdateData() does not read the A0h page again while the module identity is
+   known. A short read of the check codes and serial number (bytes 63-95) confirms that the same
+   module is still inserted. The identity is dropped when the SFP is removed or on Invalidate().
+   The I2C driver must support byte offset reads (see HAL_SFP_I2C_REG).
+
+   @param [in]     a_bEnable : Flag to control the identity cache
+*/
+// ------------------------------------------------------------------------------------------------
+void HalSfp::SetIdentityCache(bool a_bEnable)
+{
+   m_bIdentityCache = a_bEnable;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Get the module identity
+
+   @param [out]    a_identity : Module identity of the last valid A0h read
+
+   @return     true if the identity is known
+*/
+// ------------------------------------------------------------------------------------------------
+bool HalSfp::GetIdentity(HalSfpIdentity& a_identity)
+{
+   a_identity = m_identity;
+   return m_identity.bValid;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Get the poll counters
+
+   The counters are read without lock, they can be one update behind the poller.
+
+   @param [out]    a_counters : Poll counters
+*/
+// ------------------------------------------------------------------------------------------------
+void HalSfp::GetCounters(HalSfpCounters& a_counters)
+{
+   a_counters = m_counters;
+   if ( m_pPageCache != NULL )
+   {
+      a_counters.pageReads = m_pPageCache->GetReadCount();
+      a_counters.pageHits  = m_pPageCache->GetHitCount();
+   }
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Get the decoded module descriptor
+
+   The descriptor is immutable: it stays valid after the module is removed, a new descriptor is
+   used for the next module. Except when the descriptor pool is full: the SFP then reuses its
+   own descriptors, see keepLocalDescriptor().
+
+   @return     Module descriptor, all fields cleared if no module is decoded
+*/
+// ------------------------------------------------------------------------------------------------
+const SfpModuleDesc* HalSfp::GetModuleDesc()
+{
+   return m_pDesc;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Get the presence tracker of the board
+
+   The tracker is shared by all the SFPs of the board and updated by RefreshStatus().
+
+   @param [out]    a_pPortId : Port identifier of the SFP in the tracker, optional
+
+   @return     Presence tracker, NULL if not supported
+*/
+// ------------------------------------------------------------------------------------------------
+SfpPresenceTracker* HalSfp::GetPresenceTracker(acd_uint32_t* a_pPortId)
+{
+   if ( a_pPortId != NULL )
+   {
+      *a_pPortId = m_presenceId;
+   }
+   return m_pPresence;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Get the control register shadow
+
+   Gives access to the control register write latency, see SfpCtrlShadow::GetStats().
+
+   @return     Control register shadow, NULL if none
+*/
+// ------------------------------------------------------------------------------------------------
+SfpCtrlShadow* HalSfp::GetCtrlShadow()
+{
+   return m_pCtrlShadow;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Get the I2C driver used to access the SFP EEPROM
+
+   @return     I2C I/O driver, NULL if none
+*/
+// ------------------------------------------------------------------------------------------------
+BaseIoDrv<acd_uint8_t>* HalSfp::GetEepromIoDrv()
+{
+   return m_pEepromIoDrv;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Set the persistent inventory
+
+   The module data saved by a previous process is restored right away. The next UpdateData()
+   only reads the A0h check codes and serial number to confirm the module was not replaced
+   (see verifyIdentity()), and the A2h thresholds are not read again with the incremental
+   monitoring. The inventory is then updated each time the module data is read. QSFP modules
+   are not kept.
+
+   @param [in]     a_pStore : Inventory, opened by the caller, NULL for none
+   @param [in]     a_index  : Record of the SFP, unique per port
+
+   @return     true if data was restored
+*/
+// ------------------------------------------------------------------------------------------------
+bool HalSfp::SetInventoryStore(SfpInventoryStore* a_pStore, acd_uint32_t a_index)
+{
+   m_pInventory = a_pStore;
+   m_inventoryIndex = a_index;
+   return (m_pInventory != NULL) && restoreInventory();
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Set the state arena of the SFPs created afterwards
+
+   The published pages of each SFP created while the arena is set, and its ACh page when a copper
+   module is read, are allocated from the arena, so the state of all the SFPs of a board is
+   contiguous. The SFPs use the heap once the arena is used up. The arena must outlive the SFPs.
+
+   @param [in]     a_pArena : State arena, NULL to use the heap
+*/
+// ------------------------------------------------------------------------------------------------
+void HalSfp::SetArena(SfpArena* a_pArena)
+{
+   s_pArena = a_pArena;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Get the arena size needed by a number of SFPs
+
+   @param [in]     a_nbPorts : Number of SFPs
+
+   @return     Arena size in bytes, copper modules included
+*/
+// ------------------------------------------------------------------------------------------------
+acd_uint32_t HalSfp::GetArenaSize(acd_uint32_t a_nbPorts)
+{
+   acd_uint32_t portSize = ((sizeof(SfpPageBuffer) + SFP_ARENA_ALIGN - 1) & ~(SFP_ARENA_ALIGN - 1)) +
+                           ((sizeof(SfpPhyPageBuffer) + SFP_ARENA_ALIGN - 1) & ~(SFP_ARENA_ALIGN - 1));
+
+   return a_nbPorts * portSize;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Set the I2C driver used for partial EEPROM reads
+
+   @param [in]     a_pIoDrv : I2C I/O driver
+*/
+// ------------------------------------------------------------------------------------------------
+void HalSfp::setEepromIoDrv(BaseIoDrv<acd_uint8_t>* a_pIoDrv)
+{
+   m_pEepromIoDrv = a_pIoDrv;
+
+   // Created with the new driver on the first paged memory access, see pageCache()
+   delete m_pPageCache;
+   m_pPageCache = NULL;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Register the SFP in the board presence tracker
+
+   @param [in]     a_pTracker : Presence tracker
+   @param [in]     a_portId   : Port identifier
+   @param [in]     a_word     : Status register index
+   @param [in]     a_bit      : Detect bit in the status register
+*/
+// ------------------------------------------------------------------------------------------------
+void HalSfp::setPresenceTracker(SfpPresenceTracker* a_pTracker, acd_uint32_t a_portId, acd_uint32_t a_word, acd_uint32_t a_bit)
+{
+   if ( a_pTracker->AddPort(a_portId, a_word, a_bit) )
+   {
+      m_pPresence = a_pTracker;
+      m_presenceId = a_portId;
+   }
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Set the control register shadow
+
+   Called by the derived class constructor, enables SetTxEnableFast().
+
+   @param [in]     a_pShadow        : Shadow of the control register of the SFP
+   @param [in]     a_txDisableMask  : Tx disable bit of the SFP
+*/
+// ------------------------------------------------------------------------------------------------
+void HalSfp::setCtrlShadow(SfpCtrlShadow* a_pShadow, acd_uint64_t a_txDisableMask)
+{
+   m_pCtrlShadow = a_pShadow;
+   m_txDisableMask = a_txDisableMask;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Publish the SFP memory read by the poller
+
+   The getters read a consistent copy of the published pages, see SfpPageBuffer::Read().
+   Called by the poller once the EEPROM data is stored in m_interfaceData and m_monData.
+   The ACh page is published apart, see publishPhyData().
+*/
+// ------------------------------------------------------------------------------------------------
+void HalSfp::publishData()
+{
+   m_pPages->Publish(m_interfaceData, m_monData);
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Publish the ACh copper PHY page read by the poller
+
+   The page is only needed by copper modules, its buffer is allocated on the first use, from the
+   state arena if any (see SetArena()).
+
+   @param [in]     a_pPhy : ACh page, HAL_SFP_PAGE_SIZE bytes
+*/
+// ------------------------------------------------------------------------------------------------
+void HalSfp::publishPhyData(const acd_uint8_t* a_pPhy)
+{
+   if ( m_pPhyPages == NULL )
+   {
+      void*             pMem = (m_pArena != NULL) ? m_pArena->Alloc(sizeof(SfpPhyPageBuffer)) : NULL;
+      SfpPhyPageBuffer* pPhyPages = (pMem != NULL) ? new(pMem) SfpPhyPageBuffer() : new SfpPhyPageBuffer();
+
+      // The getters see the buffer once it is constructed
+      __sync_synchronize();
+      m_pPhyPages = pPhyPages;
+   }
+   m_pPhyPages->Publish(a_pPhy);
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Get the paged memory cache
+
+   The cache is created on the first paged memory access (SFF-8472 pages or QSFP module), so the
+   SFPs that never use it do not carry its pages. It can be created by the poller or by a caller
+   of ReadPagedMemory().
+
+   @return     Page cache, NULL without I2C driver
+*/
+// ------------------------------------------------------------------------------------------------
+SfpPageCache* HalSfp::pageCache()
+{
+   if ( (m_pPageCache == NULL) && (m_pEepromIoDrv != NULL) )
+   {
+      SfpPageCache* pCache = new SfpPageCache(m_pEepromIoDrv);
+
+      if ( !__sync_bool_compare_and_swap(&m_pPageCache, NULL, pCache) )
+      {
+         delete pCache;
+      }
+   }
+   return m_pPageCache;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Count an update of the derived class
+
+   @param [in]     a_bMonitoring : UpdateMonitoringData() if true, UpdateData() otherwise
+   @param [in]     a_bSuccess    : Update result
+*/
+// ------------------------------------------------------------------------------------------------
+void HalSfp::countUpdate(bool a_bMonitoring, bool a_bSuccess)
+{
+   if ( a_bMonitoring )
+   {
+      m_counters.monPolls++;
+      m_counters.monErrors += a_bSuccess ? 0 : 1;
+   }
+   else
+   {
+      m_counters.dataPolls++;
+      m_counters.dataErrors += a_bSuccess ? 0 : 1;
+   }
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Log a poller error
+
+   The errors of the poll loop are rate limited per SFP (see SfpLogBucket) and formatted by the
+   log thread (see SfpLogRing), so a flapping module does not slow down the poller.
+
+   @param [in]     a_id    : Message
+   @param [in]     a_arg0  : First message argument
+   @param [in]     a_arg1  : Second message argument
+*/
+// ------------------------------------------------------------------------------------------------
+void HalSfp::logEvent(SfpLogId a_id, acd_uint32_t a_arg0, acd_uint32_t a_arg1)
+{
+   if ( m_logBucket.Allow(sfpGetTimeUs()) )
+   {
+      SfpLogRing::GetInstance()->Log(m_pLogger, a_id, m_logBucket.TakeSuppressed(), a_arg0, a_arg1);
+   }
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Check if an identifier is a QSFP (SFF-8636)
+
+   @param [in]     a_id : Identifier (byte 0)
+
+   @return     true if QSFP
+*/
+// ------------------------------------------------------------------------------------------------
+bool HalSfp::isQsfpId(acd_uint8_t a_id)
+{
+   return (a_id == SFP_ID_QSFP) || (a_id == SFP_ID_QSFP_PLUS) || (a_id == SFP_ID_QSFP28);
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Update the QSFP data
+
+   m_interfaceData holds the lower page read by the derived class. It becomes the monitoring
+   page and is replaced by the upper page 00h, which has the SFP serial ID layout. The upper
+   pages 00h and 03h are static and read once per module through the page cache.
+
+   @return     true if successful
+*/
+// ------------------------------------------------------------------------------------------------
+bool HalSfp::updateQsfp()
+{
+   acd_uint8_t threshold;
+
+   if ( pageCache() == NULL )
+   {
+      return false;
+   }
+
+   memcpy(m_monData, m_interfaceData, HAL_SFP_PAGE_SIZE);
+   m_pPageCache->SetPagedRegion(0xA0);
+   if ( !m_pPageCache->Read(0xA0, QSFP_SERIAL_ID_PAGE, 0, HAL_SFP_PAGE_SIZE, m_interfaceData) )
+   {
+      return false;
+   }
+   if ( !(m_monData[QSFP_STATUS] & QSFP_FLAT_MEM) )
+   {
+      // Prefetch the thresholds
+      m_pPageCache->Read(0xA0, QSFP_THRESHOLD_PAGE, 0, 1, &threshold);
+   }
+
+   m_bIsCopper = false;
+   memset(m_speedCap, 0, sizeof(m_speedCap));
+   publishData();
+
+   scanPage(m_interfaceData, NULL, 0, HAL_SFP_PAGE_SIZE, m_a0Scan);
+   return m_a0Scan.bBaseValid && m_a0Scan.bExtValid;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Get a QSFP lower page word
+
+   @param [in]     a_pages  : Published pages
+   @param [in]     a_offset : Offset of the most significant byte
+
+   @return     Word in host byte order
+*/
+// ------------------------------------------------------------------------------------------------
+acd_uint16_t HalSfp::qsfpWord(const SfpPages& a_pages, acd_uint32_t a_offset)
+{
+   return (a_pages.monData[a_offset] << 8) | a_pages.monData[a_offset + 1];
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Get a QSFP threshold from the upper page 03h
+
+   The thresholds of a parameter are ordered as HalSfpThresholdId.
+
+   @param [in]     a_offset : Page offset of the parameter thresholds
+   @param [in]     a_id     : Threshold identifier
+   @param [out]    a_raw    : Threshold in host byte order
+
+   @return     true if successful
+*/
+// ------------------------------------------------------------------------------------------------
+bool HalSfp::getQsfpThreshold(acd_uint32_t a_offset, HalSfpThresholdId a_id, acd_uint16_t& a_raw)
+{
+   acd_uint8_t buf[2];
+
+   if ( (a_id >= HalSfpThresholdMax) || (pageCache() == NULL) ||
+        !m_pPageCache->Read(0xA0, QSFP_THRESHOLD_PAGE, a_offset + 2 * a_id, sizeof(buf), buf) )
+   {
+      return false;
+   }
+   a_raw = (buf[0] << 8) | buf[1];
+   return true;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Read a part of an EEPROM region
+
+   @param [in]     a_region : Memory region (0xA0, 0xA2, ...)
+   @param [in]     a_offset : First byte to read
+   @param [in]     a_size   : Number of bytes to read
+   @param [out]    a_pBuf   : Output buffer
+
+   @return     true if successful
+*/
+// ------------------------------------------------------------------------------------------------
+bool HalSfp::readEeprom(acd_uint32_t a_region, acd_uint32_t a_offset, acd_uint32_t a_size, acd_uint8_t* a_pBuf)
+{
+   if ( m_pEepromIoDrv == NULL )
+   {
+      return false;
+   }
+   return m_pEepromIoDrv->Read(HAL_SFP_I2C_REG(a_region, a_offset), a_size, a_pBuf);
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Confirm that the cached module identity matches the inserted module
+
+   Reads the A0h check codes and serial number. The identity is dropped on mismatch or on
+   read failure so the caller reads the full A0h page.
+   Also confirms the data restored from the persistent inventory, see SetInventoryStore().
+
+   @return     true if the A0h data does not need to be read again
+*/
+// ------------------------------------------------------------------------------------------------
+bool HalSfp::verifyIdentity()
+{
+   acd_uint8_t buffer[HAL_SFP_A0_ID_SIZE];
+
+   bool        bRestored = m_bRestored;
+
+   // A restored identity is verified once, even without the identity cache
+   m_bRestored = false;
+   if ( (!m_bIdentityCache && !bRestored) || !m_identity.bValid || m_bQsfp )
+   {
+      return false;
+   }
+
+   if ( !readEeprom(0xA0, HAL_SFP_A0_ID_OFFSET, sizeof(buffer), buffer) ||
+        (buffer[0] != m_identity.ccBase) ||
+        (buffer[HAL_SFP_CC_EXT - HAL_SFP_A0_ID_OFFSET] != m_identity.ccExt) ||
+        (memcmp(&buffer[offsetof(sfp_hdr_type, serial) - HAL_SFP_A0_ID_OFFSET],
+                m_identity.serial, sizeof(m_identity.serial)) != 0) )
+   {
+      //HalDebug("SFP module identity changed");
+      m_identity.bValid = false;
+      if ( bRestored )
+      {
+         // The restored thresholds belong to another module
+         m_bMonStaticValid = false;
+      }
+      return false;
+   }
+   m_counters.identityHits++;
+   return true;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Get the memory window to read on the next monitoring update
+
+   A QSFP only needs the lower page monitors, the thresholds are in the page cache.
+
+   @param [out]    a_region : Memory region, 0xA2 for a SFP or 0xA0 for a QSFP
+   @param [out]    a_offset : First byte to read
+   @param [out]    a_size   : Number of bytes to read
+*/
+// ------------------------------------------------------------------------------------------------
+void HalSfp::getMonitoringWindow(acd_uint32_t& a_region, acd_uint32_t& a_offset, acd_uint32_t& a_size)
+{
+   a_region = 0xA2;
+   if ( m_bQsfp )
+   {
+      a_region = 0xA0;
+      a_offset = HAL_QSFP_MON_OFFSET;
+      a_size   = HAL_QSFP_MON_SIZE;
+   }
+   else if ( m_bIncrementalMon && m_bMonStaticValid )
+   {
+      a_offset = HAL_SFP_A2_LIVE_OFFSET;
+      a_size   = HAL_SFP_A2_LIVE_SIZE;
+   }
+   else
+   {
+      a_offset = 0;
+      a_size   = HAL_SFP_PAGE_SIZE;
+   }
+   m_monWindowOffset = a_offset;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Feed the monitoring values to the alarm engine and the DDM history
+
+   The values are only converted when one of them is in use.
+*/
+// ------------------------------------------------------------------------------------------------
+void HalSfp::processDdmValues()
+{
+   acd_int32_t    values[SfpDdmParamMax];
+   bool           bAlarm = m_pAlarm->IsArmed();
+
+   if ( !bAlarm && (m_pPmHistory == NULL) )
+   {
+      return;
+   }
+
+   GetDdmValues(values);
+
+   if ( bAlarm )
+   {
+      m_pAlarm->Evaluate(this, values);
+   }
+   if ( m_pPmHistory != NULL )
+   {
+      m_pPmHistory->AddSample(sfpGetRealTimeUs(), values);
+   }
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Decode the A2h alarm and warning flags
+
+   The alarm (112-113) and warning (116-117) flag words have the same layout: temperature,
+   voltage, bias, tx power and rx power, high flag first, from the most significant bit.
+
+   @param [in]     a_pFlags : A2h bytes 112 to 117
+
+   @return     Flag bitmask, see HAL_SFP_FLAG
+*/
+// ------------------------------------------------------------------------------------------------
+acd_uint32_t HalSfp::decodeAlarmFlags(const acd_uint8_t* a_pFlags)
+{
+   acd_uint32_t   alarm = (a_pFlags[0] << 8) | a_pFlags[1];
+   acd_uint32_t   warning = (a_pFlags[4] << 8) | a_pFlags[5];
+   acd_uint32_t   flags = 0;
+
+   for(acd_uint32_t p = 0 ; p < SfpDdmParamMax ; p++)
+   {
+      acd_uint32_t high = 15 - 2 * p;
+      acd_uint32_t bits[HalSfpThresholdMax];
+
+      // Same order as HalSfpThresholdId
+      bits[HalSfpThresholdHighAlarm]   = (alarm >> high) & 1;
+      bits[HalSfpThresholdLowAlarm]    = (alarm >> (high - 1)) & 1;
+      bits[HalSfpThresholdHighWarning] = (warning >> high) & 1;
+      bits[HalSfpThresholdLowWarning]  = (warning >> (high - 1)) & 1;
+
+      for(acd_uint32_t id = 0 ; id < HalSfpThresholdMax ; id++)
+      {
+         if ( bits[id] )
+         {
+            flags |= HAL_SFP_FLAG(p, id);
+         }
+      }
+   }
+   return flags;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Check if the SFP is internally calibrated
+
+   @param [in]     a_pages : Published pages
+
+   @return     true if the SFP is internally calibrated
+*/
+// ------------------------------------------------------------------------------------------------
+bool HalSfp::isInternallyCalibrated(const SfpPages& a_pages)
+{
+   // The QSFP values are always internally calibrated
+   return m_bQsfp || ((((const sfp_hdr_type*)a_pages.interfaceData)->diag & 0x20) != 0);
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Convert the temperature
+
+   @param [in]     a_pages : Published pages, for the calibration constants
+   @param [in]     a_tsAd  : Analog to digital converter value
+
+   @return     Temperature
+*/
+// ------------------------------------------------------------------------------------------------
+acd_int16_t HalSfp::convertTemp(const SfpPages& a_pages, acd_int16_t a_tsAd)
+{
+   acd_int16_t         ts_offset;
+   acd_uint16_t        ts_slope;
+   acd_int16_t         ts;
+   float               slope;
+   const sfp_mon_type* pMon = (const sfp_mon_type*)a_pages.monData;
+
+   if ( isInternallyCalibrated(a_pages) )
+   {
+      ts = (a_tsAd/256);
+      //HalDebug("internal ts: %d", ts);
+   }
+   else
+   {
+      ts_slope = ntohs(pMon->ts_slope);
+      ts_offset = ntohs(pMon->ts_offset);
+
+      slope = (ts_slope&0x00FF);
+      slope = slope/256;
+      slope += ts_slope>>8;
+
+      ts = (acd_int16_t)((a_tsAd*slope + ts_offset)/256);
+      //HalDebug("external ts_slope: %f ts_offset: %d", slope, ts_offset);
+      //HalDebug("external ts: %d", ts);
+   }
+   return ts;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Convert the voltage
+
+   @param [in]     a_pages : Published pages, for the calibration constants
+   @param [in]     a_vccAd : Voltage analog to digital converter value
+
+   @return     Voltage
+*/
+// ------------------------------------------------------------------------------------------------
+acd_uint16_t HalSfp::convertVoltage(const SfpPages& a_pages, acd_uint16_t a_vccAd)
+{
+   acd_int16_t         vcc_offset;
+   acd_uint16_t        vcc_slope;
+   acd_uint16_t        vcc;
+   float               slope;
+   const sfp_mon_type* pMon = (const sfp_mon_type*)a_pages.monData;
+
+   if ( isInternallyCalibrated(a_pages) )
+   {
+      vcc = a_vccAd/10;
+      //HalDebug("internal vcc: %d", vcc);
+   }
+   else
+   {
+      vcc_slope = ntohs(pMon->vcc_slope);
+      vcc_offset = ntohs(pMon->vcc_offset);
+      slope = (vcc_slope&0x00FF)/256 + (vcc_slope>>8);
+      vcc = (acd_uint16_t)((a_vccAd*slope + vcc_offset)/10);
+      //HalDebug("external vcc_slope: %f vcc_offset: %d vcc:", slope, vcc_offset, vcc);
+   }
+
+   return vcc;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Convert the bias
+
+   @param [in]     a_pages : Published pages, for the calibration constants
+   @param [in]     a_lbcAd : Bias analog to digital converter value
+
+   @return     Bias
+*/
+// ------------------------------------------------------------------------------------------------
+acd_uint32_t HalSfp::convertBias(const SfpPages& a_pages, acd_uint16_t a_lbcAd)
+{
+   acd_int16_t         lbc_offset;
+   acd_uint16_t        lbc_slope;
+   acd_uint32_t        lbc;
+   float               slope;
+   const sfp_mon_type* pMon = (const sfp_mon_type*)a_pages.monData;
+
+   if ( isInternallyCalibrated(a_pages) )
+   {
+      lbc = (a_lbcAd*2);
+      //HalDebug("internal lbc: %d", lbc);
+   }
+   else
+   {
+      lbc_slope = ntohs(pMon->lbc_slope);
+      lbc_offset = ntohs(pMon->lbc_offset);
+      slope = ((float)(lbc_slope&0x00FF) / 256.0) + (float)(lbc_slope>>8);
+      lbc = (acd_uint32_t)((a_lbcAd*slope + lbc_offset)*2);
+      //HalDebug("external lbc_slope: %f lbc_offset: %d lbc: %d", slope, lbc_offset, lbc);
+   }
+
+   return lbc;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Convert the tx power
+
+   @param [in]     a_pages   : Published pages, for the calibration constants
+   @param [in]     a_txPwrAd : Tx power analog to digital converter value
+
+   @return     Tx power
+*/
+// ------------------------------------------------------------------------------------------------
+acd_uint32_t HalSfp::convertTxPower(const SfpPages& a_pages, acd_uint16_t a_txPwrAd)
+{
+   acd_int16_t         tx_offset;
+   acd_uint16_t        tx_slope;
+   acd_uint32_t        tx_pwr;
+   float               slope;
+   const sfp_mon_type* pMon = (const sfp_mon_type*)a_pages.monData;
+
+   if ( isInternallyCalibrated(a_pages) )
+   {
+        //HalDebug("internal rx_pwr: %d", a_txPwrAd);
+        tx_pwr = a_txPwrAd;
+   }
+   else
+   {
+      tx_slope = ntohs(pMon->tx_pwr_slope);
+      tx_offset = ntohs(pMon->tx_pwr_offset);
+      slope = ((float)(tx_slope&0x00FF) / 256.0) + (float)(tx_slope>>8);
+      tx_pwr = (acd_uint32_t)(a_txPwrAd*slope + tx_offset);
+      //HalDebug("external tx_slope: %f tx_offset: %d tx_pwr: %d", slope, tx_offset, tx_pwr);
+   }
+
+   return tx_pwr;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Convert the rx power
+
+   @param [in]     a_pages   : Published pages, for the calibration constants
+   @param [in]     a_rxPwrAd : Rx power analog to digital converter value
+
+   @return     Rx power
+*/
+// ------------------------------------------------------------------------------------------------
+acd_uint32_t HalSfp::convertRxPower(const SfpPages& a_pages, acd_uint16_t a_rxPwrAd)
+{
+   acd_uint16_t        rx_pwr;
+   float               rx_pwr4;
+   float               rx_pwr3;
+   float               rx_pwr2;
+   float               rx_pwr1;
+   float               rx_pwr0;
+   float               rx_ad;
+   float               mantissa;
+   acd_int32_t         exp;
+   acd_uint32_t        pwr;
+   const sfp_mon_type* pMon = (const sfp_mon_type*)a_pages.monData;
+
+   if ( isInternallyCalibrated(a_pages) )
+   {
+      //HalDebug("internal rx_pwr: %d", a_rxPwrAd);
+      rx_pwr = a_rxPwrAd;
+   }
+   else
+   {
+      /* Transform each IEEE-754 float in C float */
+      pwr = ntohl(pMon->rx_pwr4);
+      mantissa = pwr&0x7FFFFF;
+      mantissa = (mantissa/0x7FFFFF)+1;
+      exp = ((pwr&0x7F800000)>>23)-127;
+      rx_pwr4 = ldexpf(mantissa, exp);
+      if ((pwr&0x80000000) != 0) rx_pwr4 = -rx_pwr4;
+
+      pwr = ntohl(pMon->rx_pwr3);
+      mantissa = pwr&0x7FFFFF;
+      mantissa = (mantissa/0x7FFFFF)+1;
+      exp = ((pwr&0x7F800000)>>23)-127;
+      rx_pwr3 = ldexpf(mantissa, exp);
+      if ((pwr&0x80000000) != 0) rx_pwr3 = -rx_pwr3;
+
+      pwr = ntohl(pMon->rx_pwr2);
+      mantissa = pwr&0x7FFFFF;
+      mantissa = (mantissa/0x7FFFFF)+1;
+      exp = ((pwr&0x7F800000)>>23)-127;
+      rx_pwr2 = ldexpf(mantissa, exp);
+      if ((pwr&0x80000000) != 0) rx_pwr2 = -rx_pwr2;
+
+      pwr = ntohl(pMon->rx_pwr1);
+      mantissa = pwr&0x7FFFFF;
+      mantissa = (mantissa/0x7FFFFF)+1;
+      exp = ((pwr&0x7F800000)>>23)-127;
+      rx_pwr1 = ldexpf(mantissa, exp);
+      if ((pwr&0x80000000) != 0) rx_pwr4 = -rx_pwr1;
+
+      pwr = ntohl(pMon->rx_pwr0);
+      mantissa = pwr&0x7FFFFF;
+      mantissa = (mantissa/0x7FFFFF)+1;
+      exp = ((pwr&0x7F800000)>>23)-127;
+      rx_pwr0 = ldexpf(mantissa, exp);
+      if ((pwr&0x80000000) != 0) rx_pwr0 = -rx_pwr0;
+
+#ifdef SFP_DEBUG
+      HalDebug("rx_pwr4: %f", rx_pwr4);
+      HalDebug("rx_pwr3: %f", rx_pwr3);
+      HalDebug("rx_pwr2: %f", rx_pwr2);
+      HalDebug("rx_pwr1: %f", rx_pwr1);
+      HalDebug("rx_pwr0: %f", rx_pwr0);
+#endif
+      rx_ad = a_rxPwrAd;
+#ifdef SFP_DEBUG
+      HalDebug("rx_pwr_ad: %d (0x%04x)", rx_pwr_ad, a_rxPwrAd);
+      HalDebug("rx_ad: %f", rx_ad);
+#endif
+      pwr = (acd_uint32_t)(rx_pwr4*powf(rx_ad, 4) + \
+                           rx_pwr3*powf(rx_ad, 3) + \
+                           rx_pwr2*powf(rx_ad, 2) + \
+                           rx_pwr1*rx_ad + \
+                           rx_pwr0);
+#ifdef SFP_DEBUG
+      HalDebug("pwr: %d, built with:\n", pwr);
+      HalDebug("rx_pwr4*powf(rx_ad, 4): %f", rx_pwr4*powf(rx_ad, 4));
+      HalDebug("rx_pwr3*powf(rx_ad, 3): %f", rx_pwr3*powf(rx_ad, 3));
+      HalDebug("rx_pwr2*powf(rx_ad, 2): %f", rx_pwr2*powf(rx_ad, 2));
+      HalDebug("rx_pwr1*powf(rx_ad, 2): %f", rx_pwr1*rx_ad);
+      HalDebug("rx_pwr0: %f\n", rx_pwr0);
+#endif
+      // This check fixes ticket #1491
+      if ((pwr&0x80000000) == 0)
+      {
+         rx_pwr = pwr;
+      }
+      else
+      {
+         rx_pwr = 0;
+      }
+      //HalDebug("external rx_pwr: %d", rx_pwr);
+    }
+
+   return rx_pwr;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Check if the SFP support the diagnostics from a page snapshot
+
+   @param [in]    a_pages  : Page snapshot
+
+   @return     true if diagnostic is supported
+*/
+// ------------------------------------------------------------------------------------------------
+bool HalSfp::isDiagCapable(const SfpPages& a_pages)
+{
+   const sfp_hdr_type* pHdr = (const sfp_hdr_type*)a_pages.interfaceData;
+
+   return (pHdr->diag & 0x40) != 0;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Get the temperature from a page snapshot
+
+   @param [in]    a_pages  : Page snapshot
+   @param [out]   a_temp   : Temperature
+
+   @return     true if successful
+*/
+// ------------------------------------------------------------------------------------------------
+bool HalSfp::getTemperature(const SfpPages& a_pages, acd_int16_t& a_temp)
+{
+   const sfp_mon_type* pMon = (const sfp_mon_type*)a_pages.monData;
+
+   if ( m_bQsfp )
+   {
+      a_temp = convertTemp( a_pages, qsfpWord(a_pages, QSFP_TEMP) );
+      return true;
    }
+   a_temp = convertTemp( a_pages, ntohs(pMon->temp) );
+   return true;
+}
 
-   return lbc;
+// ------------------------------------------------------------------------------------------------
+/*!@brief Get the voltage from a page snapshot
+
+   @param [in]    a_pages  : Page snapshot
+   @param [out]   a_vcc    : Voltage
+
+   @return     true if successful
+*/
+// ------------------------------------------------------------------------------------------------
+bool HalSfp::getVoltage(const SfpPages& a_pages, acd_uint16_t& a_vcc)
+{
+   const sfp_mon_type* pMon = (const sfp_mon_type*)a_pages.monData;
+
+   if ( m_bQsfp )
+   {
+      a_vcc = convertVoltage( a_pages, qsfpWord(a_pages, QSFP_VCC) );
+      return true;
+   }
+   a_vcc = convertVoltage( a_pages, ntohs(pMon->vcc) );
+   return true;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Get the bias from a page snapshot
+
+   @param [in]    a_pages  : Page snapshot
+   @param [out]   a_bias   : Bias
+
+   @return     true if successful
+*/
+// ------------------------------------------------------------------------------------------------
+bool HalSfp::getBias(const SfpPages& a_pages, acd_uint32_t& a_bias)
+{
+   const sfp_mon_type* pMon = (const sfp_mon_type*)a_pages.monData;
+
+   if ( m_bQsfp )
+   {
+      a_bias = convertBias( a_pages, qsfpWord(a_pages, QSFP_TX_BIAS) );
+      return true;
+   }
+   a_bias = convertBias( a_pages, ntohs(pMon->bias) );
+
+   return true;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Get the tx power from a page snapshot
+
+   @param [in]    a_pages  : Page snapshot
+   @param [out]   a_pwr    : Tx power
+
+   @return     true if successful
+*/
+// ------------------------------------------------------------------------------------------------
+bool HalSfp::getTxPower(const SfpPages& a_pages, acd_uint32_t& a_pwr)
+{
+   const sfp_mon_type* pMon = (const sfp_mon_type*)a_pages.monData;
+
+   if ( m_bQsfp )
+   {
+      a_pwr = convertTxPower( a_pages, qsfpWord(a_pages, QSFP_TX_PWR) );
+      return true;
+   }
+   a_pwr = convertTxPower( a_pages, ntohs(pMon->tx_pwr) );
+   return true;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Get the rx power from a page snapshot
+
+   @param [in]    a_pages  : Page snapshot
+   @param [out]   a_pwr    : Rx power
+
+   @return     true if successful
+*/
+// ------------------------------------------------------------------------------------------------
+bool HalSfp::getRxPower(const SfpPages& a_pages, acd_uint32_t& a_pwr)
+{
+   const sfp_mon_type* pMon = (const sfp_mon_type*)a_pages.monData;
+
+   if ( m_bQsfp )
+   {
+      a_pwr = convertRxPower( a_pages, qsfpWord(a_pages, QSFP_RX_PWR) );
+      return true;
+   }
+   a_pwr = convertRxPower( a_pages, ntohs(pMon->rx_pwr) );
+   return true;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Get the temperature threshold from a page snapshot
+
+   @param [in]    a_pages  : Page snapshot
+   @param [in]    a_id     : Threshold identifier
+   @param [out]   a_temp   : Temperature threshold
+
+   @return     true if successful
+*/
+// ------------------------------------------------------------------------------------------------
+bool HalSfp::getTemperatureThreshold(const SfpPages& a_pages, HalSfpThresholdId a_id, acd_int16_t& a_temp)
+{
+   bool                bRet = true;
+   acd_uint16_t        raw;
+   const sfp_mon_type* pMon = (const sfp_mon_type*)a_pages.monData;
+
+   if ( m_bQsfp )
+   {
+      if ( !getQsfpThreshold(QSFP_TEMP_THRESH, a_id, raw) )
+      {
+         return false;
+      }
+      a_temp = convertTemp(a_pages, raw);
+      return true;
+   }
+
+   switch(a_id)
+   {
+      case HalSfpThresholdHighAlarm:
+         a_temp = convertTemp( a_pages, ntohs(pMon->ts_high_alm) );
+         break;
+      case HalSfpThresholdLowAlarm:
+         a_temp = convertTemp( a_pages, ntohs(pMon->ts_low_alm) );
+         break;
+      case HalSfpThresholdHighWarning:
+         a_temp = convertTemp( a_pages, ntohs(pMon->ts_high_warn) );
+         break;
+      case HalSfpThresholdLowWarning:
+         a_temp = convertTemp( a_pages, ntohs(pMon->ts_low_warn) );
+         break;
+      default:
+         bRet = false;
+         break;
+   }
+   return bRet;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Get the voltage threshold from a page snapshot
+
+   @param [in]    a_pages  : Page snapshot
+   @param [in]    a_id     : Threshold identifier
+   @param [out]   a_vcc    : Voltage threshold
+
+   @return     true if successful
+*/
+// ------------------------------------------------------------------------------------------------
+bool HalSfp::getVoltageThreshold(const SfpPages& a_pages, HalSfpThresholdId a_id, acd_uint16_t& a_vcc)
+{
+   bool                bRet = true;
+   acd_uint16_t        raw;
+   const sfp_mon_type* pMon = (const sfp_mon_type*)a_pages.monData;
+
+   if ( m_bQsfp )
+   {
+      if ( !getQsfpThreshold(QSFP_VCC_THRESH, a_id, raw) )
+      {
+         return false;
+      }
+      a_vcc = convertVoltage(a_pages, raw);
+      return true;
+   }
+
+   switch(a_id)
+   {
+      case HalSfpThresholdHighAlarm:
+         a_vcc = convertVoltage( a_pages, ntohs(pMon->vcc_high_alm) );
+         break;
+      case HalSfpThresholdLowAlarm:
+         a_vcc = convertVoltage( a_pages, ntohs(pMon->vcc_low_alm) );
+         break;
+      case HalSfpThresholdHighWarning:
+         a_vcc = convertVoltage( a_pages, ntohs(pMon->vcc_high_warn) );
+         break;
+      case HalSfpThresholdLowWarning:
+         a_vcc = convertVoltage( a_pages, ntohs(pMon->vcc_low_warn) );
+         break;
+      default:
+         bRet = false;
+         break;
+   }
+   return bRet;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Get the bias threshold from a page snapshot
+
+   @param [in]    a_pages  : Page snapshot
+   @param [in]    a_id     : Threshold identifier
+   @param [out]   a_bias   : Bias threshold
+
+   @return     true if successful
+*/
+// ------------------------------------------------------------------------------------------------
+bool HalSfp::getBiasThreshold(const SfpPages& a_pages, HalSfpThresholdId a_id, acd_uint32_t& a_bias)
+{
+   bool                bRet = true;
+   acd_uint16_t        raw;
+   const sfp_mon_type* pMon = (const sfp_mon_type*)a_pages.monData;
+
+   if ( m_bQsfp )
+   {
+      if ( !getQsfpThreshold(QSFP_TX_BIAS_THRESH, a_id, raw) )
+      {
+         return false;
+      }
+      a_bias = convertBias(a_pages, raw);
+      return true;
+   }
+
+   switch(a_id)
+   {
+      case HalSfpThresholdHighAlarm:
+         a_bias = convertBias( a_pages, ntohs(pMon->lbc_high_alm) );
+         break;
+      case HalSfpThresholdLowAlarm:
+         a_bias = convertBias( a_pages, ntohs(pMon->lbc_low_alm) );
+         break;
+      case HalSfpThresholdHighWarning:
+         a_bias = convertBias( a_pages, ntohs(pMon->lbc_high_warn) );
+         break;
+      case HalSfpThresholdLowWarning:
+         a_bias = convertBias( a_pages, ntohs(pMon->lbc_low_warn) );
+         break;
+      default:
+         bRet = false;
+         break;
+   }
+   //HalDebug("GetBiasThreshold(%d, %d) = %d", id, bias, bRet);
+   return bRet;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Get the tx power threshold from a page snapshot
+
+   @param [in]    a_pages  : Page snapshot
+   @param [in]    a_id     : Threshold identifier
+   @param [out]   a_pwr    : Tx power threshold
+
+   @return     true if successful
+*/
+// ------------------------------------------------------------------------------------------------
+bool HalSfp::getTxPowerThreshold(const SfpPages& a_pages, HalSfpThresholdId a_id, acd_uint32_t& a_pwr)
+{
+   bool                bRet = true;
+   acd_uint16_t        raw;
+   const sfp_mon_type* pMon = (const sfp_mon_type*)a_pages.monData;
+
+   if ( m_bQsfp )
+   {
+      if ( !getQsfpThreshold(QSFP_TX_PWR_THRESH, a_id, raw) )
+      {
+         return false;
+      }
+      a_pwr = convertTxPower(a_pages, raw);
+      return true;
+   }
+
+   switch(a_id)
+   {
+      case HalSfpThresholdHighAlarm:
+         a_pwr = convertTxPower( a_pages, ntohs(pMon->tx_pwr_high_alm) );
+         break;
+      case HalSfpThresholdLowAlarm:
+         a_pwr = convertTxPower( a_pages, ntohs(pMon->tx_pwr_low_alm) );
+         break;
+      case HalSfpThresholdHighWarning:
+         a_pwr = convertTxPower( a_pages, ntohs(pMon->tx_pwr_high_warn) );
+         break;
+      case HalSfpThresholdLowWarning:
+         a_pwr = convertTxPower( a_pages, ntohs(pMon->tx_pwr_low_warn) );
+         break;
+      default:
+         bRet = false;
+         break;
+   }
+   return bRet;
 }
 
 // ------------------------------------------------------------------------------------------------
-/*!@brief Convert the tx power
+/*!@brief Get the rx power threshold from a page snapshot
 
-   @param [in]     a_txPwrAd : Tx power analog to digital converter value
+   @param [in]    a_pages  : Page snapshot
+   @param [in]    a_id     : Threshold identifier
+   @param [out]   a_pwr    : Rx power threshold
 
-   @return     Tx power
+   @return     true if successful
 */
 // ------------------------------------------------------------------------------------------------
-acd_uint32_t HalSfp::convertTxPower(acd_uint16_t a_txPwrAd)
+bool HalSfp::getRxPowerThreshold(const SfpPages& a_pages, HalSfpThresholdId a_id, acd_uint32_t& a_pwr)
 {
-   acd_int16_t    tx_offset;
-   acd_uint16_t   tx_slope;
-   acd_uint32_t   tx_pwr;
-   float          slope;
+   bool                bRet = true;
+   acd_uint16_t        raw;
+   const sfp_mon_type* pMon = (const sfp_mon_type*)a_pages.monData;
 
-   if ( IsInternallyCalibrated() )
+   if ( m_bQsfp )
    {
-        //HalDebug("internal rx_pwr: %d", a_txPwrAd);
-        tx_pwr = a_txPwrAd;
+      if ( !getQsfpThreshold(QSFP_RX_PWR_THRESH, a_id, raw) )
+      {
+         return false;
+      }
+      a_pwr = convertRxPower(a_pages, raw);
+      return true;
    }
-   else
+
+   switch(a_id)
    {
-      tx_slope = ntohs(m_pMon->tx_pwr_slope);
-      tx_offset = ntohs(m_pMon->tx_pwr_offset);
-      slope = ((float)(tx_slope&0x00FF) / 256.0) + (float)(tx_slope>>8);
-      tx_pwr = (acd_uint32_t)(a_txPwrAd*slope + tx_offset);
-      //HalDebug("external tx_slope: %f tx_offset: %d tx_pwr: %d", slope, tx_offset, tx_pwr);
+      case HalSfpThresholdHighAlarm:
+         a_pwr = convertRxPower( a_pages, ntohs(pMon->rx_pwr_high_alm) );
+         break;
+      case HalSfpThresholdLowAlarm:
+         a_pwr = convertRxPower( a_pages, ntohs(pMon->rx_pwr_low_alm) );
+         break;
+      case HalSfpThresholdHighWarning:
+         a_pwr = convertRxPower( a_pages, ntohs(pMon->rx_pwr_high_warn) );
+         break;
+      case HalSfpThresholdLowWarning:
+         a_pwr = convertRxPower( a_pages, ntohs(pMon->rx_pwr_low_warn) );
+         break;
+      default:
+         bRet = false;
+         break;
    }
+   return bRet;
+}
 
-   return tx_pwr;
+// ------------------------------------------------------------------------------------------------
+/*!@brief Get all the monitoring values from a page snapshot
+
+   @param [in]    a_pages  : Page snapshot
+   @param [out]   a_values : Values in the units of the getters, indexed by SfpDdmParam
+*/
+// ------------------------------------------------------------------------------------------------
+void HalSfp::getDdmValues(const SfpPages& a_pages, acd_int32_t a_values[SfpDdmParamMax])
+{
+   acd_int16_t    temp = 0;
+   acd_uint16_t   vcc = 0;
+   acd_uint32_t   bias = 0;
+   acd_uint32_t   txPwr = 0;
+   acd_uint32_t   rxPwr = 0;
+
+   getTemperature(a_pages, temp);
+   getVoltage(a_pages, vcc);
+   getBias(a_pages, bias);
+   getTxPower(a_pages, txPwr);
+   getRxPower(a_pages, rxPwr);
+
+   a_values[SfpDdmParamTemp]    = temp;
+   a_values[SfpDdmParamVcc]     = vcc;
+   a_values[SfpDdmParamBias]    = bias;
+   a_values[SfpDdmParamTxPower] = txPwr;
+   a_values[SfpDdmParamRxPower] = rxPwr;
 }
 
 // ------------------------------------------------------------------------------------------------
-/*!@brief Convert the rx power
+/*!@brief Get the module threshold of a monitoring value from a page snapshot
 
-   @param [in]     a_rxPwrAd : Rx power analog to digital converter value
+   @param [in]    a_pages  : Page snapshot
+   @param [in]    a_param  : Parameter
+   @param [in]    a_id     : Threshold identifier
+   @param [out]   a_value  : Threshold in the units of the getters
 
-   @return     Rx power
+   @return     true if successful
 */
 // ------------------------------------------------------------------------------------------------
-acd_uint32_t HalSfp::convertRxPower(acd_uint16_t a_rxPwrAd)
+bool HalSfp::getDdmThreshold(const SfpPages& a_pages, SfpDdmParam a_param, HalSfpThresholdId a_id,
+                             acd_int32_t& a_value)
 {
-   acd_uint16_t   rx_pwr;
-   float          rx_pwr4;
-   float          rx_pwr3;
-   float          rx_pwr2;
-   float          rx_pwr1;
-   float          rx_pwr0;
-   float          rx_ad;
-   float          mantissa;
-   acd_int32_t    exp;
-   acd_uint32_t   pwr;
+   bool           bRet = false;
+   acd_int16_t    temp;
+   acd_uint16_t   vcc;
+   acd_uint32_t   val32;
 
-   if ( IsInternallyCalibrated() )
+   if ( !m_bQsfp && !isDiagCapable(a_pages) )
    {
-      //HalDebug("internal rx_pwr: %d", a_rxPwrAd);
-      rx_pwr = a_rxPwrAd;
+      return false;
    }
-   else
-   {
-      /* Transform each IEEE-754 float in C float */
-      pwr = ntohl(m_pMon->rx_pwr4);
-      mantissa = pwr&0x7FFFFF;
-      mantissa = (mantissa/0x7FFFFF)+1;
-      exp = ((pwr&0x7F800000)>>23)-127;
-      rx_pwr4 = ldexpf(mantissa, exp);
-      if ((pwr&0x80000000) != 0) rx_pwr4 = -rx_pwr4;
-
-      pwr = ntohl(m_pMon->rx_pwr3);
-      mantissa = pwr&0x7FFFFF;
-      mantissa = (mantissa/0x7FFFFF)+1;
-      exp = ((pwr&0x7F800000)>>23)-127;
-      rx_pwr3 = ldexpf(mantissa, exp);
-      if ((pwr&0x80000000) != 0) rx_pwr3 = -rx_pwr3;
-
-      pwr = ntohl(m_pMon->rx_pwr2);
-      mantissa = pwr&0x7FFFFF;
-      mantissa = (mantissa/0x7FFFFF)+1;
-      exp = ((pwr&0x7F800000)>>23)-127;
-      rx_pwr2 = ldexpf(mantissa, exp);
-      if ((pwr&0x80000000) != 0) rx_pwr2 = -rx_pwr2;
-
-      pwr = ntohl(m_pMon->rx_pwr1);
-      mantissa = pwr&0x7FFFFF;
-      mantissa = (mantissa/0x7FFFFF)+1;
-      exp = ((pwr&0x7F800000)>>23)-127;
-      rx_pwr1 = ldexpf(mantissa, exp);
-      if ((pwr&0x80000000) != 0) rx_pwr4 = -rx_pwr1;
-
-      pwr = ntohl(m_pMon->rx_pwr0);
-      mantissa = pwr&0x7FFFFF;
-      mantissa = (mantissa/0x7FFFFF)+1;
-      exp = ((pwr&0x7F800000)>>23)-127;
-      rx_pwr0 = ldexpf(mantissa, exp);
-      if ((pwr&0x80000000) != 0) rx_pwr0 = -rx_pwr0;
-
-#ifdef SFP_DEBUG
-      HalDebug("rx_pwr4: %f", rx_pwr4);
-      HalDebug("rx_pwr3: %f", rx_pwr3);
-      HalDebug("rx_pwr2: %f", rx_pwr2);
-      HalDebug("rx_pwr1: %f", rx_pwr1);
-      HalDebug("rx_pwr0: %f", rx_pwr0);
-#endif
-      rx_ad = a_rxPwrAd;
-#ifdef SFP_DEBUG
-      HalDebug("rx_pwr_ad: %d (0x%04x)", rx_pwr_ad, a_rxPwrAd);
-      HalDebug("rx_ad: %f", rx_ad);
-#endif
-      pwr = (acd_uint32_t)(rx_pwr4*powf(rx_ad, 4) + \
-                           rx_pwr3*powf(rx_ad, 3) + \
-                           rx_pwr2*powf(rx_ad, 2) + \
-                           rx_pwr1*rx_ad + \
-                           rx_pwr0);
-#ifdef SFP_DEBUG
-      HalDebug("pwr: %d, built with:\n", pwr);
-      HalDebug("rx_pwr4*powf(rx_ad, 4): %f", rx_pwr4*powf(rx_ad, 4));
-      HalDebug("rx_pwr3*powf(rx_ad, 3): %f", rx_pwr3*powf(rx_ad, 3));
-      HalDebug("rx_pwr2*powf(rx_ad, 2): %f", rx_pwr2*powf(rx_ad, 2));
-      HalDebug("rx_pwr1*powf(rx_ad, 2): %f", rx_pwr1*rx_ad);
-      HalDebug("rx_pwr0: %f\n", rx_pwr0);
-#endif
-      // This check fixes ticket #1491
-      if ((pwr&0x80000000) == 0)
-      {
-         rx_pwr = pwr;
-      }
-      else
-      {
-         rx_pwr = 0;
-      }
-      //HalDebug("external rx_pwr: %d", rx_pwr);
-    }
 
-   return rx_pwr;
+   switch(a_param)
+   {
+      case SfpDdmParamTemp:
+         bRet = getTemperatureThreshold(a_pages, a_id, temp);
+         a_value = temp;
+         break;
+      case SfpDdmParamVcc:
+         bRet = getVoltageThreshold(a_pages, a_id, vcc);
+         a_value = vcc;
+         break;
+      case SfpDdmParamBias:
+         bRet = getBiasThreshold(a_pages, a_id, val32);
+         a_value = val32;
+         break;
+      case SfpDdmParamTxPower:
+         bRet = getTxPowerThreshold(a_pages, a_id, val32);
+         a_value = val32;
+         break;
+      case SfpDdmParamRxPower:
+         bRet = getRxPowerThreshold(a_pages, a_id, val32);
+         a_value = val32;
+         break;
+      default:
+         break;
+   }
+   return bRet;
 }
 
 // ------------------------------------------------------------------------------------------------
@@ -1196,12 +2743,15 @@ HalSfpSpeed HalSfp::GetDefaultSpeed()
 // ------------------------------------------------------------------------------------------------
 /*!@brief Update the SFP speed capabilities
 
+   @param [in]     a_pn : Vendor part number, see GetVendorPartNumber()
+
    @return     true if successful
 */
 // ------------------------------------------------------------------------------------------------
-bool HalSfp::updateSpeedCap()
+bool HalSfp::updateSpeedCap(const acd_uchar8_t* a_pn)
 {
-   bool bRet = true;
+   const sfp_hdr_type* pHdr = (const sfp_hdr_type*)m_interfaceData;
+   bool                bRet = true;
 
    // Reset speed capabilities
    memset(m_speedCap, 0, sizeof(m_speedCap));
@@ -1210,48 +2760,48 @@ bool HalSfp::updateSpeedCap()
 #if 0
    // NOTE: Trash Debug - Some variables might not be well represented
    HalDebug("SFP HDR: id(%d)-ext_id(%d)-connector(%d)-trans3(%d)-trans4(%d)-trans5(%d)",
-         m_pHdr->id, m_pHdr->ext_id, m_pHdr->connector, m_pHdr->trans3, m_pHdr->trans4, m_pHdr->trans5);
+         pHdr->id, pHdr->ext_id, pHdr->connector, pHdr->trans3, pHdr->trans4, pHdr->trans5);
    HalDebug("SFP HDR: trans6(%d)-trans7(%d)-trans8(%d)-trans9(%d)-trans10(%d)-encoding(%d)-bit_rate(%d)",
-         m_pHdr->trans6,m_pHdr->trans7,m_pHdr->trans8,m_pHdr->trans9,m_pHdr->trans10,m_pHdr->encoding,m_pHdr->bit_rate);
+         pHdr->trans6,pHdr->trans7,pHdr->trans8,pHdr->trans9,pHdr->trans10,pHdr->encoding,pHdr->bit_rate);
    HalDebug("SFP HDR: rsv1(%d)-length9mkm(%d)-length9m(%d)-length50(%d)-length625(%d)-length_copper(%d)",
-         m_pHdr->rsv1, m_pHdr->length9mkm,m_pHdr->length9m,m_pHdr->length50,m_pHdr->length625, m_pHdr->length_copper);
+         pHdr->rsv1, pHdr->length9mkm,pHdr->length9m,pHdr->length50,pHdr->length625, pHdr->length_copper);
    HalDebug("SFP HDR: rsv2(%d)-vendor[16](%s)-transceiver(%d)-vendor_oui[3](%d%d%d)-vendor_pn[16](%s)-vendor_rev[4](%s)",
-         m_pHdr->rsv2, m_pHdr->vendor,m_pHdr->transceiver, m_pHdr->vendor_oui[2],m_pHdr->vendor_oui[1],
-         m_pHdr->vendor_oui[0],m_pHdr->vendor_pn, m_pHdr->vendor_rev);
+         pHdr->rsv2, pHdr->vendor,pHdr->transceiver, pHdr->vendor_oui[2],pHdr->vendor_oui[1],
+         pHdr->vendor_oui[0],pHdr->vendor_pn, pHdr->vendor_rev);
    HalDebug("SFP HDR: wave_length(%d)-rsv4(%d)-cc_base(%d)-option1(%d)-option2(%d)-br_max(%d)-br_min(%d)",
-         m_pHdr->wave_length, m_pHdr->rsv4, m_pHdr->cc_base, m_pHdr->option1, m_pHdr->option2,
-         m_pHdr->br_max,m_pHdr->br_min);
+         pHdr->wave_length, pHdr->rsv4, pHdr->cc_base, pHdr->option1, pHdr->option2,
+         pHdr->br_max,pHdr->br_min);
    HalDebug("SFP HDR: serial[16](%s)-year(%d)-month(%d)-day(%d)-lot(%d)-diag(%d)-enhance(%d)-rev_8472(%d)",
-         m_pHdr->serial,m_pHdr->year,m_pHdr->month,m_pHdr->day,m_pHdr->lot,m_pHdr->diag,
-         m_pHdr->enhance,m_pHdr->rev_8472);
+         pHdr->serial,pHdr->year,pHdr->month,pHdr->day,pHdr->lot,pHdr->diag,
+         pHdr->enhance,pHdr->rev_8472);
 #endif
 
    //
    // Try to find part number from the SFP database first
    //
-   if ( updateSpeedCapFromDb() )
+   if ( updateSpeedCapFromDb(a_pn) )
    {
       bRet = true;
    }
    else
    {
       // 10G bit rate
-      if ( (m_pHdr->trans3 & ETH_10GBASE_XX) || (m_pHdr->bit_rate >= 0x64) )
+      if ( (pHdr->trans3 & ETH_10GBASE_XX) || (pHdr->bit_rate >= 0x64) )
       {
          m_speedCap[HalSfpSpeed10G] = true;
          bRet = true;
       }
       // 1G bit rate
-      if (((m_pHdr->trans6&ETH_1000BASE_SX) != 0) ||
-          ((m_pHdr->trans6&ETH_1000BASE_LX) != 0) ||
-         (((m_pHdr->trans6&ETH_BASE_BX) != 0) && (m_pHdr->bit_rate == 0x0A)) ||
-         (((m_pHdr->trans6&ETH_BASE_BX) != 0) && (m_pHdr->bit_rate == 0x0C)) ||
-         (((m_pHdr->trans6&ETH_BASE_BX) != 0) && (m_pHdr->bit_rate == 0x0D)))
+      if (((pHdr->trans6&ETH_1000BASE_SX) != 0) ||
+          ((pHdr->trans6&ETH_1000BASE_LX) != 0) ||
+         (((pHdr->trans6&ETH_BASE_BX) != 0) && (pHdr->bit_rate == 0x0A)) ||
+         (((pHdr->trans6&ETH_BASE_BX) != 0) && (pHdr->bit_rate == 0x0C)) ||
+         (((pHdr->trans6&ETH_BASE_BX) != 0) && (pHdr->bit_rate == 0x0D)))
       {
          m_speedCap[HalSfpSpeed1G] = true;
          bRet = true;
       }
-      if ((m_pHdr->trans6&ETH_1000BASE_T) != 0)
+      if ((pHdr->trans6&ETH_1000BASE_T) != 0)
       {
          m_speedCap[HalSfpSpeed1G] = true;
          m_bIsCopper = true;
@@ -1259,13 +2809,13 @@ bool HalSfp::updateSpeedCap()
       }
 
       // Sonet/Ethernet Compliance codes
-      if (((m_pHdr->trans5&SONET_OC3_SR) != 0) ||
-          ((m_pHdr->trans5&SONET_OC3_IR) != 0) ||
-          ((m_pHdr->trans5&SONET_OC3_LR) != 0) ||
-          ((m_pHdr->trans6&ETH_100BASE_FX) != 0) ||
-          ((m_pHdr->trans6&ETH_100BASE_LX) != 0) ||
-          (((m_pHdr->trans6&ETH_BASE_BX) != 0) && (m_pHdr->bit_rate == 0x01)) ||
-          (((m_pHdr->encoding&SFP_ENCODE_4B5B) != 0) && (m_pHdr->bit_rate == 0x01)))
+      if (((pHdr->trans5&SONET_OC3_SR) != 0) ||
+          ((pHdr->trans5&SONET_OC3_IR) != 0) ||
+          ((pHdr->trans5&SONET_OC3_LR) != 0) ||
+          ((pHdr->trans6&ETH_100BASE_FX) != 0) ||
+          ((pHdr->trans6&ETH_100BASE_LX) != 0) ||
+          (((pHdr->trans6&ETH_BASE_BX) != 0) && (pHdr->bit_rate == 0x01)) ||
+          (((pHdr->encoding&SFP_ENCODE_4B5B) != 0) && (pHdr->bit_rate == 0x01)))
       {
          m_speedCap[HalSfpSpeed100M] = true;
          bRet = true;
@@ -1296,10 +2846,12 @@ bool HalSfp::updateSpeedCap()
 // ------------------------------------------------------------------------------------------------
 /*!@brief Update the speed capability from the SFP database
 
+   @param [in]     a_pn : Vendor part number, see GetVendorPartNumber()
+
    @return     true if match found
 */
 // ------------------------------------------------------------------------------------------------
-bool HalSfp::updateSpeedCapFromDb()
+bool HalSfp::updateSpeedCapFromDb(const acd_uchar8_t* a_pn)
 {
    bool bRet = false;
    SfpDb* pSfpDb = SfpDb::GetInstance();
@@ -1310,13 +2862,10 @@ bool HalSfp::updateSpeedCapFromDb()
       return false;
    }
 
-   // Get valid vendor pn string
-   acd_uchar8_t vendorPnStr[sizeof(m_pHdr->vendor_pn) + 1];
-   GetVendorPartNumber(vendorPnStr);
-   //HalDebug("Vendor PN: %s", vendorPnStr);
+   //HalDebug("Vendor PN: %s", a_pn);
 
    SfpDb::SfpDesc sfpDesc;
-   string sPn((const char*)vendorPnStr);
+   string sPn((const char*)a_pn);
    if ( pSfpDb->Get(sPn, sfpDesc) )
    {
       //HalNotice("Found SFP %s in SFP database", sPn.c_str());
@@ -1334,6 +2883,254 @@ bool HalSfp::updateSpeedCapFromDb()
    return bRet;
 }
 
+// ------------------------------------------------------------------------------------------------
+/*!@brief Copy an ASCII field without its trailing spaces
+
+   @param [out]    a_pDst  : NULL terminated string, a_size + 1 bytes
+   @param [in]     a_pSrc  : Field
+   @param [in]     a_size  : Field size
+*/
+// ------------------------------------------------------------------------------------------------
+static void copyField(char* a_pDst, const acd_uint8_t* a_pSrc, acd_uint32_t a_size)
+{
+   memcpy(a_pDst, a_pSrc, a_size);
+   a_pDst[a_size] = '\0';
+   while ( (a_size > 0) && ((a_pDst[a_size - 1] == ' ') || (a_pDst[a_size - 1] == '\0')) )
+   {
+      a_pDst[--a_size] = '\0';
+   }
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Decode the A0h serial ID fields
+
+   Decodes m_interfaceData, except the speed capabilities and the connector which depend on
+   updateSpeedCap().
+
+   @param [out]    a_desc : Module descriptor
+*/
+// ------------------------------------------------------------------------------------------------
+void HalSfp::decodeDescriptor(SfpModuleDesc& a_desc)
+{
+   const sfp_hdr_type* pHdr = (const sfp_hdr_type*)m_interfaceData;
+
+   memset(&a_desc, 0, sizeof(a_desc));
+   SfpModuleDescPool::MakeKey(m_interfaceData, a_desc.key);
+
+   a_desc.id         = pHdr->id;
+   a_desc.connector  = pHdr->connector;
+   a_desc.wavelength = pHdr->wave_length;
+
+   copyField(a_desc.vendor, pHdr->vendor, sizeof(pHdr->vendor));
+   memcpy(a_desc.vendorOui, pHdr->vendor_oui, sizeof(a_desc.vendorOui));
+   copyField(a_desc.vendorRev, pHdr->vendor_rev, sizeof(pHdr->vendor_rev));
+
+   // The part number ends at the first space
+   for(acd_uint32_t i = 0 ; (i < sizeof(pHdr->vendor_pn)) && (pHdr->vendor_pn[i] != ' ') ; i++)
+   {
+      a_desc.vendorPn[i] = pHdr->vendor_pn[i];
+   }
+
+   a_desc.bLengthValid = true;
+   if (pHdr->length9mkm != 0)
+   {
+      // Link length supported for 9/125 mm fiber, units of km
+      a_desc.length = pHdr->length9mkm * 1000;
+   }
+   else if (pHdr->length9m != 0)
+   {
+      // Length (9m) Link length supported for 9/125 mm fiber, units of 100 m
+      a_desc.length = pHdr->length9m * 100;
+   }
+   else if (pHdr->length50 != 0)
+   {
+      // Link length supported for 50/125 mm fiber, units of 10 m
+      a_desc.length = pHdr->length50 * 10;
+   }
+   else if (pHdr->length625 != 0)
+   {
+      // Link length supported for 62.5/125 mm fiber, units of 10 m
+      a_desc.length = pHdr->length625 * 10;
+   }
+   else if (pHdr->length_copper != 0)
+   {
+      // Length (Copper) Link length supported for copper, units of meters
+      a_desc.length = pHdr->length_copper;
+   }
+   else
+   {
+      a_desc.bLengthValid = false;
+   }
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Get the descriptor of the module in m_interfaceData
+
+   A module type already seen (on any port) reuses its interned descriptor: the A0h fields are
+   not decoded and the SFP database is not searched again. Sets the speed capabilities.
+   m_pDesc is only replaced once the new descriptor is complete, the getters read it unlocked.
+
+   @return     true if successful, false if the module is not supported
+*/
+// ------------------------------------------------------------------------------------------------
+bool HalSfp::updateDescriptor()
+{
+   SfpModuleDescPool*   pPool = SfpModuleDescPool::GetInstance();
+   const SfpModuleDesc* pDesc;
+   SfpModuleDesc        desc;
+   acd_uint8_t          key[SFP_DESC_KEY_SIZE];
+
+   SfpModuleDescPool::MakeKey(m_interfaceData, key);
+   pDesc = m_pDesc;
+   if ( (pDesc == &s_noDesc) || (memcmp(pDesc->key, key, sizeof(key)) != 0) )
+   {
+      pDesc = pPool->Find(key);
+   }
+
+   if ( pDesc != NULL )
+   {
+      memcpy(m_speedCap, pDesc->speedCap, sizeof(m_speedCap));
+      m_bIsCopper = pDesc->bIsCopper;
+      m_pDesc = pDesc;
+      return true;
+   }
+
+   decodeDescriptor(desc);
+   // The QSFP speeds are not decoded, see updateQsfp()
+   if ( !m_bQsfp && !updateSpeedCap(desc.vendorPn) )
+   {
+      return false;
+   }
+   memcpy(desc.speedCap, m_speedCap, sizeof(desc.speedCap));
+   desc.bIsCopper = m_bIsCopper;
+   if ( m_bIsCopper )
+   {
+      desc.connector = SFP_CONN_RJ45;
+   }
+
+   pDesc = pPool->Intern(desc);
+   if ( pDesc == NULL )
+   {
+      pDesc = keepLocalDescriptor(desc);
+   }
+   m_pDesc = pDesc;
+   return true;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Keep a descriptor the pool could not intern
+
+   The pool is full: the SFP keeps the descriptor itself. Its two descriptors are used in turn so
+   the one m_pDesc points to is never rewritten; a getter is done copying from it long before
+   the next module is decoded.
+
+   @param [in]     a_desc : Decoded descriptor
+
+   @return     Descriptor of the SFP
+*/
+// ------------------------------------------------------------------------------------------------
+const SfpModuleDesc* HalSfp::keepLocalDescriptor(const SfpModuleDesc& a_desc)
+{
+   acd_uint32_t idx = (m_pDesc == m_pLocalDesc[0]) ? 1 : 0;
+
+   if ( m_pLocalDesc[idx] == NULL )
+   {
+      HalError("SFP module descriptor pool full, the port keeps its own descriptor");
+      m_pLocalDesc[idx] = new SfpModuleDesc;
+   }
+   *m_pLocalDesc[idx] = a_desc;
+   return m_pLocalDesc[idx];
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Restore the module data from the persistent inventory
+
+   @return     true if successful
+*/
+// ------------------------------------------------------------------------------------------------
+bool HalSfp::restoreInventory()
+{
+   SfpInventoryRecord   record;
+   HalSfpPageScan       scan;
+   const SfpModuleDesc* pDesc;
+   const sfp_hdr_type*  pHdr = (const sfp_hdr_type*)m_interfaceData;
+   acd_uint8_t          key[SFP_DESC_KEY_SIZE];
+
+   if ( !m_pInventory->Load(m_inventoryIndex, record) || isQsfpId(record.interfaceData[0]) )
+   {
+      return false;
+   }
+   // Same checks as on a read from the SFP
+   scanPage(record.interfaceData, NULL, 0, HAL_SFP_PAGE_SIZE, scan);
+   SfpModuleDescPool::MakeKey(record.interfaceData, key);
+   if ( !scan.bBaseValid || !scan.bExtValid || (memcmp(record.desc.key, key, sizeof(key)) != 0) )
+   {
+      return false;
+   }
+
+   pDesc = SfpModuleDescPool::GetInstance()->Find(key);
+   if ( pDesc == NULL )
+   {
+      pDesc = SfpModuleDescPool::GetInstance()->Intern(record.desc);
+   }
+   if ( pDesc == NULL )
+   {
+      pDesc = keepLocalDescriptor(record.desc);
+   }
+
+   memcpy(m_interfaceData, record.interfaceData, HAL_SFP_PAGE_SIZE);
+   m_a0Scan = scan;
+   m_bMonStaticValid = false;
+   if ( record.bMonValid )
+   {
+      scanPage(record.monData, NULL, 0, SFP_INVENTORY_A2_SIZE, scan);
+      if ( scan.bDmiValid )
+      {
+         memcpy(m_monData, record.monData, SFP_INVENTORY_A2_SIZE);
+         m_bMonStaticValid = true;
+      }
+   }
+   publishData();
+
+   m_bQsfp = false;
+   m_pDesc = pDesc;
+   memcpy(m_speedCap, pDesc->speedCap, sizeof(m_speedCap));
+   m_bIsCopper = pDesc->bIsCopper;
+   m_identity.ccBase = m_interfaceData[HAL_SFP_CC_BASE];
+   m_identity.ccExt  = m_interfaceData[HAL_SFP_CC_EXT];
+   memcpy(m_identity.vendorPn, pHdr->vendor_pn, sizeof(m_identity.vendorPn));
+   memcpy(m_identity.serial, pHdr->serial, sizeof(m_identity.serial));
+   m_identity.bValid = true;
+   m_bRestored = true;
+   return true;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Save the module data in the persistent inventory
+
+   Called when the A0h data or the A2h static data was validated.
+*/
+// ------------------------------------------------------------------------------------------------
+void HalSfp::saveInventory()
+{
+   SfpInventoryRecord record;
+
+   if ( (m_pInventory == NULL) || m_bQsfp || !m_identity.bValid || (m_pDesc == &s_noDesc) )
+   {
+      return;
+   }
+   // Zeroed so the padding bytes do not change the checksum
+   memset(&record, 0, sizeof(record));
+   memcpy(record.interfaceData, m_interfaceData, HAL_SFP_PAGE_SIZE);
+   if ( m_bMonStaticValid )
+   {
+      memcpy(record.monData, m_monData, SFP_INVENTORY_A2_SIZE);
+      record.bMonValid = true;
+   }
+   memcpy(&record.desc, m_pDesc, sizeof(record.desc));
+   m_pInventory->Save(m_inventoryIndex, record);
+}
+
 // ------------------------------------------------------------------------------------------------
 /*!@brief Set the SFP mode
 
@@ -1363,81 +3160,123 @@ bool HalSfp::GetMode(HalSfpMode& a_mode)
 }
 
 // ------------------------------------------------------------------------------------------------
-/*!@brief Validate the base check code
-
-   CC_BASE [Address A0h, Byte 63]
-   0 to byte 62 inclusive
+/*!@brief Sum and copy a range of bytes
 
-   @param [out]     a_pBuf     : SFP data 0xA0
+   @param [in]     a_pSrc   : Source
+   @param [out]    a_pDst   : Destination, NULL for no copy
+   @param [in]     a_from   : First byte
+   @param [in]     a_to     : Last byte + 1
+   @param [in,out] a_or     : OR of all the bytes
+   @param [in,out] a_and    : AND of all the bytes
 
-   @return     true if base check code is valid
+   @return     Sum of the bytes modulo 256
 */
 // ------------------------------------------------------------------------------------------------
-bool HalSfp::checkCodeBase(acd_uint8_t* a_pBuf)
+static inline acd_uint8_t sumCopy(const acd_uint8_t* a_pSrc, acd_uint8_t* a_pDst, acd_uint32_t a_from, acd_uint32_t a_to,
+                                  acd_uint8_t& a_or, acd_uint8_t& a_and)
 {
-   acd_uint8_t cc = 0;
+   acd_uint8_t sum = 0;
 
-   for(acd_uint32_t i = 0 ; i < HAL_SFP_CC_BASE ; i++)
+   for(acd_uint32_t i = a_from ; i < a_to ; i++)
    {
-      cc += a_pBuf[i];
-   }
-   if ( cc != a_pBuf[HAL_SFP_CC_BASE] )
-   {
-      //m_pLogger->LogDebug("SFP base check code failed");
+      acd_uint8_t b = a_pSrc[i];
+
+      if ( a_pDst != NULL )
+      {
+         a_pDst[i] = b;
+      }
+      sum   += b;
+      a_or  |= b;
+      a_and &= b;
    }
-   return (cc == a_pBuf[HAL_SFP_CC_BASE]);
+   return sum;
 }
 
 // ------------------------------------------------------------------------------------------------
-/*!@brief Validate the extended check code
+/*!@brief Validate and copy a page in a single pass
 
-   CC_EXT [Address A0h, Byte 95]
-   64 to byte 94 inclusive
+   Computes the check codes and classifies blank (all 0x00) and erased (all 0xFF) data while
+   the bytes are copied. The check codes are only valid when the window covers bytes 0 to 95.
 
-   @param [out]     a_pBuf     : SFP data 0xA0
+   CC_BASE [Address A0h, Byte 63]: 0 to byte 62 inclusive
+   CC_EXT  [Address A0h, Byte 95]: 64 to byte 94 inclusive
+   CC_DMI  [Address A2h, Byte 95]: 0 to byte 94 inclusive
 
-   @return     true if extended check code is valid
+   @param [in]     a_pSrc    : Data read from the SFP
+   @param [out]    a_pDst    : Destination of the first byte, NULL for no copy
+   @param [in]     a_offset  : Page offset of the first byte
+   @param [in]     a_size    : Number of bytes
+   @param [out]    a_scan    : Scan result
 */
 // ------------------------------------------------------------------------------------------------
-bool HalSfp::checkCodeExt(acd_uint8_t* a_pBuf)
+void HalSfp::scanPage(const acd_uint8_t* a_pSrc, acd_uint8_t* a_pDst, acd_uint32_t a_offset, acd_uint32_t a_size, HalSfpPageScan& a_scan)
 {
-   acd_uint8_t cc = 0;
+   acd_uint8_t    bOr  = 0x00;
+   acd_uint8_t    bAnd = 0xFF;
+   acd_uint8_t    ccBase;
+   acd_uint8_t    ccExt;
 
-   for(acd_uint32_t i = HAL_SFP_CC_BASE+1 ; i < HAL_SFP_CC_EXT ; i++)
+   memset(&a_scan, 0, sizeof(a_scan));
+   if ( (a_offset == 0) && (a_size > HAL_SFP_CC_EXT) )
    {
-      cc += a_pBuf[i];
+      // Bytes 0-62, 63, 64-94, 95 then the rest of the window
+      ccBase = sumCopy(a_pSrc, a_pDst, 0, HAL_SFP_CC_BASE, bOr, bAnd);
+      sumCopy(a_pSrc, a_pDst, HAL_SFP_CC_BASE, HAL_SFP_CC_BASE + 1, bOr, bAnd);
+      ccExt  = sumCopy(a_pSrc, a_pDst, HAL_SFP_CC_BASE + 1, HAL_SFP_CC_EXT, bOr, bAnd);
+      sumCopy(a_pSrc, a_pDst, HAL_SFP_CC_EXT, a_size, bOr, bAnd);
+
+      a_scan.bBaseValid = (ccBase == a_pSrc[HAL_SFP_CC_BASE]);
+      a_scan.bExtValid  = (ccExt == a_pSrc[HAL_SFP_CC_EXT]);
+      a_scan.bDmiValid  = ((acd_uint8_t)(ccBase + a_pSrc[HAL_SFP_CC_BASE] + ccExt) == a_pSrc[HAL_SFP_CC_DMI]);
    }
-   if ( cc != a_pBuf[HAL_SFP_CC_EXT] )
+   else
    {
-      //m_pLogger->LogDebug("SFP extended check code failed");
+      sumCopy(a_pSrc, a_pDst, 0, a_size, bOr, bAnd);
    }
-   return (cc == a_pBuf[HAL_SFP_CC_EXT]);
+   a_scan.bBlank  = (bOr == 0x00);
+   a_scan.bErased = (bAnd == 0xFF);
 }
 
 // ------------------------------------------------------------------------------------------------
-/*!@brief Validate the diagnostic management interface check code
+/*!@brief Store the A0h page read by the derived class
 
-   CC_DMI [Address A2h, Byte 95]
-   0 to byte 94, inclusive.
+   @param [in]     a_pBuf         : A0h data
+   @param [in]     a_size         : Number of bytes (from offset 0)
+   @param [in]     a_bRejectBlank : Keep the previous data if the page is blank
 
-   @param [out]     a_pBuf     : SFP data 0xA0
-
-   @return     true if diagnostic management interface check code is valid
+   @return     Scan result, see scanPage()
 */
 // ------------------------------------------------------------------------------------------------
-bool HalSfp::checkCodeDmi(acd_uint8_t* a_pBuf)
+const HalSfpPageScan& HalSfp::ingestInterfaceData(const acd_uint8_t* a_pBuf, acd_uint32_t a_size, bool a_bRejectBlank)
 {
-   acd_uint8_t cc = 0;
-
-   for(acd_uint32_t i = 0 ; i < HAL_SFP_CC_DMI ; i++)
+   scanPage(a_pBuf, m_interfaceData, 0, a_size, m_a0Scan);
+   if ( a_bRejectBlank && m_a0Scan.bBlank )
    {
-      cc += a_pBuf[i];
+      // The working copy is the same as the published one outside of an update
+      memcpy(m_interfaceData, m_pPages->GetActive()->interfaceData, a_size);
    }
-   if ( cc != a_pBuf[HAL_SFP_CC_DMI] )
+   return m_a0Scan;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Store the monitoring window read by the derived class
+
+   @param [in]     a_pBuf         : Data read, see getMonitoringWindow()
+   @param [in]     a_offset       : Page offset of the window
+   @param [in]     a_size         : Number of bytes
+   @param [in]     a_bRejectBlank : Keep the previous data if the window is blank
+
+   @return     Scan result, see scanPage()
+*/
+// ------------------------------------------------------------------------------------------------
+const HalSfpPageScan& HalSfp::ingestMonitoringData(const acd_uint8_t* a_pBuf, acd_uint32_t a_offset, acd_uint32_t a_size, bool a_bRejectBlank)
+{
+   scanPage(a_pBuf, &m_monData[a_offset], a_offset, a_size, m_a2Scan);
+   if ( a_bRejectBlank && m_a2Scan.bBlank )
    {
-      //m_pLogger->LogDebug("SFP DMI check code failed -- Computed %02xh  Expected %02xh", cc, a_pBuf[HAL_SFP_CC_DMI]);
+      memcpy(&m_monData[a_offset], &m_pPages->GetActive()->monData[a_offset], a_size);
    }
-   return (cc == a_pBuf[HAL_SFP_CC_DMI]);
+   return m_a2Scan;
 }
 
 // ------------------------------------------------------------------------------------------------
@@ -0,0 +1,397 @@
+// ------------------------------------------------------------------------------------------------
+/* ACCEDIAN PROPRIETARY - www.accedian.com
+   COPYRIGHT (c) 2004-2012 BY ACCEDIAN CORPORATION. ALL RIGHTS RESERVED. NO PART OF THIS PROGRAM OR
+   PUBLICATION MAY BE REPRODUCED, TRANSMITTED, TRANSCRIBED, STORED IN A RETRIEVAL SYSTEM,
+   OR TRANSLATED INTO ANY LANGUAGE OR COMPUTER LANGUAGE IN ANY FORM OR BY ANY MEANS, ELECTRONIC,
+   MECHANICAL, MAGNETIC, OPTICAL, CHEMICAL, MANUAL, OR OTHERWISE, WITHOUT THE PRIOR WRITTEN
+   PERMISSION OF ACCEDIAN INC.
+*/
+// ------------------------------------------------------------------------------------------------
+/*!@file    HalSfp.h
+   @brief   SFP Hardware Abstraction Layer base class
+
+   This file contains the SFP HAL base class definition
+*/
+// ------------------------------------------------------------------------------------------------
+#ifndef __HALSFP_H__
+#define __HALSFP_H__
+
+#include <string.h>
+
+#include <accedian/acclib/BaseIoDrv.h>
+#include "Hal.h"
+#include "sfp_msa.h"
+#include "SfpLog.h"
+
+class SfpDdmBatch;
+class SfpAlarmEngine;
+class SfpAlarmListener;
+class SfpPmHistory;
+class SfpPageBuffer;
+class SfpPhyPageBuffer;
+struct SfpPages;
+class SfpPageCache;
+struct SfpModuleDesc;
+class SfpPresenceTracker;
+class SfpInventoryStore;
+class SfpCtrlShadow;
+class SfpArena;
+
+#define HAL_SFP_PAGE_SIZE        128   // Size of a SFP EEPROM page
+#define HAL_SFP_CC_BASE          63    // A0h base check code offset
+#define HAL_SFP_CC_EXT           95    // A0h extended check code offset
+#define HAL_SFP_CC_DMI           95    // A2h diagnostic check code offset
+#define HAL_SFP_PAGE_SELECT      127   // A2h upper memory page select offset
+#define SFP_PAGE_LOWER           0x100 // Page number of the lower memory (bytes 0-127)
+
+#define HAL_SFP_A0_ID_OFFSET     HAL_SFP_CC_BASE                        // A0h check codes and serial
+#define HAL_SFP_A0_ID_SIZE       (HAL_SFP_CC_EXT - HAL_SFP_CC_BASE + 1)  // A0h bytes 63 to 95
+
+#define HAL_SFP_A2_LIVE_OFFSET   96    // A2h live values, status and alarm/warning flags
+#define HAL_SFP_A2_LIVE_SIZE     22    // A2h bytes 96 to 117
+
+#define HAL_QSFP_MON_OFFSET      22    // QSFP lower page temperature to lane 4 tx power
+#define HAL_QSFP_MON_SIZE        36    // QSFP lower page bytes 22 to 57
+
+#define HAL_SFP_A2_FLAGS_OFFSET  112   // A2h alarm flags (112-113) and warning flags (116-117)
+#define HAL_SFP_A2_FLAGS_SIZE    6     // A2h bytes 112 to 117
+
+// Alarm/warning flag bit, see HalSfp::GetAlarmFlags()
+#define HAL_SFP_FLAG(param, id)  (1 << ((param) * HalSfpThresholdMax + (id)))
+
+// I2C register offset addressing a byte offset within an EEPROM region (see I2cIoDrvV02::Read)
+#define HAL_SFP_I2C_REG(region, offset)   (((offset) << 8) | (region))
+
+#define SFP_CONN_RJ45            SFP_CONN_ID_RJ45
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief SFP speeds
+*/
+// ------------------------------------------------------------------------------------------------
+enum HalSfpSpeed
+{
+   HalSfpSpeed10M = 0,
+   HalSfpSpeed100M,
+   HalSfpSpeed1G,
+   HalSfpSpeed10G,
+   HalSfpSeedMax
+};
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief SFP modes
+*/
+// ------------------------------------------------------------------------------------------------
+enum HalSfpMode
+{
+   HalSfpModeUndefined = 0,
+   HalSfpModeAuto,
+   HalSfpModeForced
+};
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief SFP threshold identifiers
+*/
+// ------------------------------------------------------------------------------------------------
+enum HalSfpThresholdId
+{
+   HalSfpThresholdHighAlarm = 0,
+   HalSfpThresholdLowAlarm,
+   HalSfpThresholdHighWarning,
+   HalSfpThresholdLowWarning,
+   HalSfpThresholdMax
+};
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief SFP DDM parameters
+*/
+// ------------------------------------------------------------------------------------------------
+enum SfpDdmParam
+{
+   SfpDdmParamTemp = 0,    // Temperature in degree C
+   SfpDdmParamVcc,         // Voltage, see HalSfp::GetVoltage()
+   SfpDdmParamBias,        // Bias, see HalSfp::GetBias()
+   SfpDdmParamTxPower,     // Tx power, see HalSfp::GetTxPower()
+   SfpDdmParamRxPower,     // Rx power, see HalSfp::GetRxPower()
+   SfpDdmParamMax
+};
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief SFP monitoring values and thresholds
+
+   Decoded from a single page snapshot, see HalSfp::GetDdmSample()
+*/
+// ------------------------------------------------------------------------------------------------
+struct SfpDdmSample
+{
+   acd_int32_t    values[SfpDdmParamMax];                          // See HalSfp::GetDdmValues()
+   acd_int32_t    threshold[SfpDdmParamMax][HalSfpThresholdMax];   // See HalSfp::GetDdmThreshold()
+   bool           bThreshold[SfpDdmParamMax][HalSfpThresholdMax];  // Threshold is available
+};
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief SFP page refresh policies
+*/
+// ------------------------------------------------------------------------------------------------
+enum SfpPagePolicy
+{
+   SfpPagePolicyStatic = 0,   // Read once per module (ex: vendor data)
+   SfpPagePolicyPeriodic,     // Read again when older than the refresh period (ex: diagnostics)
+   SfpPagePolicyOnDemand      // Read on each access, never cached
+};
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief SFP module identity
+
+   Identifies the module for which the A0h data was last read
+*/
+// ------------------------------------------------------------------------------------------------
+struct HalSfpIdentity
+{
+   bool           bValid;           // Identity is known
+   acd_uint8_t    ccBase;           // A0h base check code
+   acd_uint8_t    ccExt;            // A0h extended check code
+   acd_uint8_t    vendorPn[16];     // Vendor part number
+   acd_uint8_t    serial[16];       // Vendor serial number
+};
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief SFP page scan result
+
+   See HalSfp::scanPage()
+*/
+// ------------------------------------------------------------------------------------------------
+struct HalSfpPageScan
+{
+   bool           bBaseValid;       // A0h base check code valid
+   bool           bExtValid;        // A0h extended check code valid
+   bool           bDmiValid;        // A2h diagnostic check code valid
+   bool           bBlank;           // All bytes are 0x00
+   bool           bErased;          // All bytes are 0xFF
+};
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief SFP poll counters
+
+   Updated by the poller of the SFP only, read without lock (see HalSfp::GetCounters()).
+*/
+// ------------------------------------------------------------------------------------------------
+struct HalSfpCounters
+{
+   acd_uint32_t   dataPolls;        // UpdateData() calls with the SFP present and enabled
+   acd_uint32_t   dataErrors;       // UpdateData() failures
+   acd_uint32_t   monPolls;         // UpdateMonitoringData() calls with the SFP present and enabled
+   acd_uint32_t   monErrors;        // UpdateMonitoringData() failures
+   acd_uint32_t   a0ChecksumErrors; // A0h check code failures
+   acd_uint32_t   a2ChecksumErrors; // A2h check code failures
+   acd_uint32_t   identityHits;     // A0h reads skipped, module unchanged (see SetIdentityCache())
+   acd_uint32_t   pageReads;        // Pages read by the paged memory cache
+   acd_uint32_t   pageHits;         // Paged memory reads served from the cache
+};
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief SFP Hardware Abstraction Layer
+
+   This class is the base class of all the platform specific SFP HAL
+*/
+// ------------------------------------------------------------------------------------------------
+class HalSfp : public Hal
+{
+
+public:
+   HalSfp(const char* a_name, HalSfpSpeed a_defaultSpeed);
+   virtual ~HalSfp();
+
+   virtual bool Enable();
+   virtual bool PowerUp();
+   virtual bool Disable();
+   virtual bool IsEnabled();
+   virtual bool SetTxEnable(bool a_bEnable);
+   bool SetTxEnableFast(bool a_bEnable);
+   virtual bool IsTxEnabled();
+
+   virtual bool IsPresent();
+   virtual bool UpdateData();
+   virtual bool UpdateMonitoringData();
+   virtual bool RefreshStatus();
+
+   bool IsCopper();
+   bool IsFiber();
+   bool GetConnector(acd_uint8_t& a_connector);
+   bool GetWaveLength(acd_uint16_t& a_wavelength);
+   bool GetVendorName(char* a_name);
+   bool GetVendorOui(char* a_oui);
+   bool GetVendorPartNumber(acd_uchar8_t* a_pn);
+   bool GetVendorRevision(char* a_rev);
+   bool GetSerial(char* a_serial);
+   bool GetDateCode(acd_uint16_t& a_year, acd_uint16_t& a_month, acd_uint16_t& a_day, acd_uint16_t& a_lot);
+   bool GetExtendedType(acd_uint8_t& a_type);
+   bool GetType(acd_uint8_t& a_type);
+   bool GetTranceiverCode(char* a_code);
+   bool GetLength(acd_uint32_t& a_length);
+   bool IsDiagCapable();
+   bool IsInternallyCalibrated();
+   bool IsAlarmCapable();
+   bool GetDiagMonRev(acd_uint8_t& a_rev);
+   bool GetMemory(acd_uint32_t a_region, acd_uint8_t* a_memory, acd_uint32_t a_size);
+
+   bool GetBias(acd_uint32_t& a_bias);
+   bool GetRxPower(acd_uint32_t& a_pwr);
+   bool GetTemperature(acd_int16_t& a_temp);
+   bool GetTxPower(acd_uint32_t& a_pwr);
+   bool GetVoltage(acd_uint16_t& a_vcc);
+
+   bool GetTemperatureThreshold(HalSfpThresholdId a_id, acd_int16_t& a_temp);
+   bool GetRxPowerThreshold(HalSfpThresholdId a_id, acd_uint32_t& a_pwr);
+   bool GetTxPowerThreshold(HalSfpThresholdId a_id, acd_uint32_t& a_pwr);
+   bool GetVoltageThreshold(HalSfpThresholdId a_id, acd_uint16_t& a_vcc);
+   bool GetBiasThreshold(HalSfpThresholdId a_id, acd_uint32_t& a_bias);
+
+   void GetDdmValues(acd_int32_t a_values[SfpDdmParamMax]);
+   bool GetDdmThreshold(SfpDdmParam a_param, HalSfpThresholdId a_id, acd_int32_t& a_value);
+   bool GetDdmSample(SfpDdmSample& a_sample);
+
+   bool SetTemperatureThreshold(HalSfpThresholdId a_id, acd_int16_t& a_temp);
+   bool SetRxPowerThreshold(HalSfpThresholdId a_id, acd_uint32_t& a_pwr);
+   bool SetTxPowerThreshold(HalSfpThresholdId a_id, acd_uint32_t& a_pwr);
+   bool SetVoltageThreshold(HalSfpThresholdId a_id, acd_uint16_t& a_vcc);
+   bool SetBiasThreshold(HalSfpThresholdId a_id, acd_uint32_t& a_bias);
+
+   bool GetSpeedCapability(HalSfpSpeed a_speed);
+   HalSfpSpeed GetDefaultSpeed();
+
+   bool SetMode(HalSfpMode a_mode);
+   bool GetMode(HalSfpMode& a_mode);
+
+   bool GetDdmBatchEntry(SfpDdmBatch& a_batch, acd_uint32_t a_index);
+
+   void SetIncrementalMonitoring(bool a_bEnable);
+   bool IsIncrementalMonitoring();
+   void SetIdentityCache(bool a_bEnable);
+   bool GetIdentity(HalSfpIdentity& a_identity);
+   void GetCounters(HalSfpCounters& a_counters);
+   const SfpModuleDesc* GetModuleDesc();
+   SfpPresenceTracker* GetPresenceTracker(acd_uint32_t* a_pPortId = NULL);
+   SfpCtrlShadow* GetCtrlShadow();
+   BaseIoDrv<acd_uint8_t>* GetEepromIoDrv();
+   bool SetInventoryStore(SfpInventoryStore* a_pStore, acd_uint32_t a_index);
+   static void SetArena(SfpArena* a_pArena);
+   static acd_uint32_t GetArenaSize(acd_uint32_t a_nbPorts);
+   void Invalidate();
+
+   void SetAlarmListener(SfpAlarmListener* a_pListener);
+   SfpAlarmEngine* GetAlarmEngine();
+
+   bool PollAlarmFlags(bool& a_bChanged);
+   acd_uint32_t GetAlarmFlags();
+
+   bool EnablePmHistory(acd_uint32_t a_nbSamples);
+   SfpPmHistory* GetPmHistory();
+
+   bool GetSnapshot(SfpPages& a_pages, acd_uint32_t* a_pGeneration = NULL);
+   acd_uint32_t GetGeneration();
+
+   bool ReadPagedMemory(acd_uint32_t a_region, acd_uint32_t a_page, acd_uint32_t a_offset, acd_uint32_t a_size, acd_uint8_t* a_pBuf);
+   bool SetPagePolicy(acd_uint32_t a_region, acd_uint32_t a_page, SfpPagePolicy a_policy, acd_uint32_t a_periodMs = 0);
+
+   bool IsQsfp();
+   acd_uint32_t GetLaneCount();
+   bool GetLaneRxPower(acd_uint32_t a_lane, acd_uint32_t& a_pwr);
+   bool GetLaneBias(acd_uint32_t a_lane, acd_uint32_t& a_bias);
+   bool GetLaneTxPower(acd_uint32_t a_lane, acd_uint32_t& a_pwr);
+
+protected:
+   void setEepromIoDrv(BaseIoDrv<acd_uint8_t>* a_pIoDrv);
+   void setPresenceTracker(SfpPresenceTracker* a_pTracker, acd_uint32_t a_portId, acd_uint32_t a_word, acd_uint32_t a_bit);
+   void setCtrlShadow(SfpCtrlShadow* a_pShadow, acd_uint64_t a_txDisableMask);
+   void publishData();
+   void publishPhyData(const acd_uint8_t* a_pPhy);
+   SfpPageCache* pageCache();
+   void countUpdate(bool a_bMonitoring, bool a_bSuccess);
+   void logEvent(SfpLogId a_id, acd_uint32_t a_arg0 = 0, acd_uint32_t a_arg1 = 0);
+   static bool isQsfpId(acd_uint8_t a_id);
+   bool updateQsfp();
+   acd_uint16_t qsfpWord(const SfpPages& a_pages, acd_uint32_t a_offset);
+   bool getQsfpThreshold(acd_uint32_t a_offset, HalSfpThresholdId a_id, acd_uint16_t& a_raw);
+   bool readEeprom(acd_uint32_t a_region, acd_uint32_t a_offset, acd_uint32_t a_size, acd_uint8_t* a_pBuf);
+   void getMonitoringWindow(acd_uint32_t& a_region, acd_uint32_t& a_offset, acd_uint32_t& a_size);
+   bool verifyIdentity();
+   void processDdmValues();
+   static acd_uint32_t decodeAlarmFlags(const acd_uint8_t* a_pFlags);
+
+   bool isDiagCapable(const SfpPages& a_pages);
+   bool isInternallyCalibrated(const SfpPages& a_pages);
+   acd_int16_t  convertTemp(const SfpPages& a_pages, acd_int16_t a_tsAd);
+   acd_uint16_t convertVoltage(const SfpPages& a_pages, acd_uint16_t a_vccAd);
+   acd_uint32_t convertBias(const SfpPages& a_pages, acd_uint16_t a_lbcAd);
+   acd_uint32_t convertTxPower(const SfpPages& a_pages, acd_uint16_t a_txPwrAd);
+   acd_uint32_t convertRxPower(const SfpPages& a_pages, acd_uint16_t a_rxPwrAd);
+
+   bool getTemperature(const SfpPages& a_pages, acd_int16_t& a_temp);
+   bool getVoltage(const SfpPages& a_pages, acd_uint16_t& a_vcc);
+   bool getBias(const SfpPages& a_pages, acd_uint32_t& a_bias);
+   bool getTxPower(const SfpPages& a_pages, acd_uint32_t& a_pwr);
+   bool getRxPower(const SfpPages& a_pages, acd_uint32_t& a_pwr);
+   bool getTemperatureThreshold(const SfpPages& a_pages, HalSfpThresholdId a_id, acd_int16_t& a_temp);
+   bool getVoltageThreshold(const SfpPages& a_pages, HalSfpThresholdId a_id, acd_uint16_t& a_vcc);
+   bool getBiasThreshold(const SfpPages& a_pages, HalSfpThresholdId a_id, acd_uint32_t& a_bias);
+   bool getTxPowerThreshold(const SfpPages& a_pages, HalSfpThresholdId a_id, acd_uint32_t& a_pwr);
+   bool getRxPowerThreshold(const SfpPages& a_pages, HalSfpThresholdId a_id, acd_uint32_t& a_pwr);
+   void getDdmValues(const SfpPages& a_pages, acd_int32_t a_values[SfpDdmParamMax]);
+   bool getDdmThreshold(const SfpPages& a_pages, SfpDdmParam a_param, HalSfpThresholdId a_id,
+                        acd_int32_t& a_value);
+
+   bool updateSpeedCap(const acd_uchar8_t* a_pn);
+   bool updateSpeedCapFromDb(const acd_uchar8_t* a_pn);
+   void decodeDescriptor(SfpModuleDesc& a_desc);
+   bool updateDescriptor();
+   bool restoreInventory();
+   const SfpModuleDesc* keepLocalDescriptor(const SfpModuleDesc& a_desc);
+   void saveInventory();
+
+   static void scanPage(const acd_uint8_t* a_pSrc, acd_uint8_t* a_pDst, acd_uint32_t a_offset, acd_uint32_t a_size, HalSfpPageScan& a_scan);
+   const HalSfpPageScan& ingestInterfaceData(const acd_uint8_t* a_pBuf, acd_uint32_t a_size, bool a_bRejectBlank = false);
+   const HalSfpPageScan& ingestMonitoringData(const acd_uint8_t* a_pBuf, acd_uint32_t a_offset, acd_uint32_t a_size, bool a_bRejectBlank = false);
+
+   bool           m_bEnable;                            // SFP enable (power)
+   bool           m_bTxEnable;                          // SFP Tx enable
+   bool           m_isPresent;                          // SFP presence, see IsPresent()
+   HalSfpMode     m_mode;                               // SFP mode
+   HalSfpSpeed    m_defaultSpeed;                       // Default SFP speed
+   bool           m_bIsCopper;                          // SFP type copper
+   SfpLogBucket   m_logBucket;                          // Poller error log rate limiter, see logEvent()
+   bool           m_speedCap[HalSfpSeedMax];            // SFP speed capabilities
+   bool           m_bIncrementalMon;                    // Read only the A2h live values once validated
+   bool           m_bMonStaticValid;                    // A2h thresholds & calibration are up to date
+   bool           m_bQsfp;                              // QSFP module, see updateQsfp()
+   acd_uint32_t   m_monWindowOffset;                    // A2h offset of the last monitoring read
+   bool           m_bIdentityCache;                     // Skip the A0h read while the module is unchanged
+   HalSfpIdentity m_identity;                           // Module identity of the last A0h read
+   const SfpModuleDesc* volatile m_pDesc;               // Decoded module descriptor, see updateDescriptor()
+   SfpModuleDesc* m_pLocalDesc[2];                      // Descriptors kept when the pool is full, see keepLocalDescriptor()
+   HalSfpPageScan m_a0Scan;                             // Scan of the last A0h page read
+   HalSfpPageScan m_a2Scan;                             // Scan of the last monitoring window read
+   BaseIoDrv<acd_uint8_t>* m_pEepromIoDrv;              // I2C driver used for partial EEPROM reads
+   SfpAlarmEngine* m_pAlarm;                            // User thresholds and alarm states
+   acd_uint32_t   m_alarmFlags;                         // Module alarm/warning flags, see HAL_SFP_FLAG
+   SfpPmHistory*  m_pPmHistory;                         // DDM history, NULL if disabled
+   SfpPageBuffer* m_pPages;                             // Published SFP memory, see publishData()
+   SfpPhyPageBuffer* volatile m_pPhyPages;              // Published ACh copper PHY page, NULL until read, see publishPhyData()
+   SfpPageCache* volatile m_pPageCache;                 // Paged memory cache, NULL until used, see pageCache()
+   SfpPresenceTracker* m_pPresence;                     // Board presence tracker, NULL if none
+   acd_uint32_t   m_presenceId;                         // Port identifier in m_pPresence
+   SfpCtrlShadow* m_pCtrlShadow;                        // Control register shadow, NULL if none
+   acd_uint64_t   m_txDisableMask;                      // Tx disable bit in m_pCtrlShadow
+   SfpInventoryStore* m_pInventory;                     // Persistent inventory, NULL if none
+   acd_uint32_t   m_inventoryIndex;                     // Record of the SFP in m_pInventory
+   bool           m_bRestored;                          // A0h data restored, not verified yet
+   HalSfpCounters m_counters;                           // Poll counters, see GetCounters()
+   SfpArena*      m_pArena;                             // State arena, NULL to use the heap
+
+   // Poller working copy, only accessed by the poller
+   acd_uint8_t    m_monData[HAL_SFP_PAGE_SIZE];         // A2h diagnostic memory
+   acd_uint8_t    m_interfaceData[HAL_SFP_PAGE_SIZE];   // A0h interface ID memory
+
+   static SfpArena* s_pArena;                           // Arena of the SFPs created, see SetArena()
+};
+
+#endif // #ifndef __HALSFP_H__
@@ -14,91 +14,16 @@
 
 */
 #include "HalSfpClipper.h"
+#include "SfpPresence.h"
+#include "SfpCtrlShadow.h"
+#include "SfpProbe.h"
+#include "SfpPowerSeq.h"
 #include <accedian/acclib/acd_utils.h>
 
-static const acd_uint32_t SFP_CTRL_1 = 0x500;
-static const acd_uint32_t SFP_STAT_1 = 0x502;
-
-// HAL_SFP_NB_PORT seems to include a dummy port 0???
-#ifdef CLIPPER2
-#define HAL_SFP_NB_PORT HalPortId9
-#define HAL_SFP_PORT_ID_MIN HalPortId1
-#define HAL_SFP_PORT_ID_MAX HalPortId8
-#else // CLIPPER
-#define HAL_SFP_NB_PORT HalPortId13
-#define HAL_SFP_PORT_ID_MIN HalPortId1
-#define HAL_SFP_PORT_ID_MAX HalPortId12
-static const acd_uint32_t SFP_CTRL_2 = 0x501;
-static const acd_uint32_t SFP_STAT_2 = 0x503;
-#endif
-
-struct sfpRegMap
-{
-   acd_uint32_t   regOffset;
-   acd_uint32_t   bitOffset;
-};
-
-static sfpRegMap  sfpEnMap[HAL_SFP_NB_PORT] =
-{
-   { SFP_CTRL_1,  0 },   // Port 0
-   { SFP_CTRL_1,  0 },   // Port 1
-   { SFP_CTRL_1,  4 },   // Port 2
-   { SFP_CTRL_1,  8 },   // Port 3
-   { SFP_CTRL_1, 12 },   // Port 4
-   { SFP_CTRL_1, 16 },   // Port 5
-   { SFP_CTRL_1, 20 },   // Port 6
-   { SFP_CTRL_1, 24 },   // Port 7
-   { SFP_CTRL_1, 28 },   // Port 8
-#ifdef CLIPPER
-   { SFP_CTRL_2,  0 },   // Port 9
-   { SFP_CTRL_2,  4 },   // Port 10
-   { SFP_CTRL_2,  8 },   // Port 11
-   { SFP_CTRL_2, 12 }    // Port 12
-#endif
-};
-
-static sfpRegMap  sfpTxDisMap[HAL_SFP_NB_PORT] =
-{
-   { SFP_CTRL_1,  1 },   // Port 0
-   { SFP_CTRL_1,  1 },   // Port 1
-   { SFP_CTRL_1,  5 },   // Port 2
-   { SFP_CTRL_1,  9 },   // Port 3
-   { SFP_CTRL_1, 13 },   // Port 4
-   { SFP_CTRL_1, 17 },   // Port 5
-   { SFP_CTRL_1, 21 },   // Port 6
-   { SFP_CTRL_1, 25 },   // Port 7
-   { SFP_CTRL_1, 29 },   // Port 8
-#ifdef CLIPPER
-   { SFP_CTRL_2,  1 },   // Port 9
-   { SFP_CTRL_2,  5 },   // Port 10
-   { SFP_CTRL_2,  9 },   // Port 11
-   { SFP_CTRL_2, 13 }    // Port 12
-#endif
-};
-
-static sfpRegMap  sfpDetectMap[HAL_SFP_NB_PORT] =
-{
-   { SFP_STAT_1,  0 },   // Port 0
-   { SFP_STAT_1,  1 },   // Port 1
-   { SFP_STAT_1,  5 },   // Port 2
-   { SFP_STAT_1,  9 },   // Port 3
-   { SFP_STAT_1, 13 },   // Port 4
-   { SFP_STAT_1, 17 },   // Port 5
-   { SFP_STAT_1, 21 },   // Port 6
-   { SFP_STAT_1, 25 },   // Port 7
-   { SFP_STAT_1, 29 },   // Port 8
-#ifdef CLIPPER
-   { SFP_STAT_2,  1 },   // Port 9
-   { SFP_STAT_2,  5 },   // Port 10
-   { SFP_STAT_2,  9 },   // Port 11
-   { SFP_STAT_2, 13 }    // Port 12
-#endif
-};
-
-acd_uint64_t HalSfpClipper::s_status1 = 0;
-#ifndef CLIPPER2
-acd_uint64_t HalSfpClipper::s_status2 = 0;
-#endif
+acd_uint64_t HalSfpClipper::s_status[SfpPlatformClipperBoard::NB_STATUS_REGS];
+SfpPresenceTracker HalSfpClipper::s_presence;
+SfpCtrlShadow HalSfpClipper::s_ctrl[SfpPlatformClipperBoard::NB_CTRL_REGS];
+SfpPowerSequencer* HalSfpClipper::s_pPowerSeq = NULL;
 
 // ================================================================================================
 // ================================================================================================
@@ -126,12 +51,16 @@ m_pIoDrv(a_pIoDrv),
 m_pI2cIoDrv(a_pI2cIoDrv)
 {
    HalSetDebug(false);
+   setEepromIoDrv(a_pI2cIoDrv);
 
-   if ( (a_portId < HAL_SFP_PORT_ID_MIN) || (a_portId > HAL_SFP_PORT_ID_MAX) )
+   if ( !sfpGetPortRegs<SfpPlatformClipperBoard>(m_portId - HalPortId1, m_regs) )
    {
       HalError("Invalid port id %d for HalSfpClipper", a_portId);
       throw(0);
    }
+   setPresenceTracker(&s_presence, m_portId, m_regs.detectWord, m_regs.detectBit);
+   s_ctrl[m_regs.ctrlWord].Attach(a_pIoDrv, m_regs.enableReg);
+   setCtrlShadow(&s_ctrl[m_regs.ctrlWord], m_regs.txDisableMask);
 }
 
 // ------------------------------------------------------------------------------------------------
@@ -141,65 +70,71 @@ m_pI2cIoDrv(a_pI2cIoDrv)
 // ------------------------------------------------------------------------------------------------
 HalSfpClipper::~HalSfpClipper()
 {
+   if ( s_pPowerSeq != NULL )
+   {
+      s_pPowerSeq->Cancel(this);
+   }
 }
 
 // ------------------------------------------------------------------------------------------------
 /*!@brief Enable the SFP
 
-   Power-up the SFP
+   Power-up the SFP. With a power-up sequencer (see SetPowerSequencer()), the power-up is queued
+   and the function returns at once, the SFP is enabled when the sequencer powers it up.
 
    @return     true if successful
 */
 // ------------------------------------------------------------------------------------------------
 bool HalSfpClipper::Enable()
 {
-   bool           bRet = true;
+   bool           bChanged = false;
    acd_uint64_t   val64;
-   acd_uint64_t   newVal;
-   acd_uint64_t   mask;
 
    //HalDebug("Enable");
-   if ( m_pIoDrv->Read(sfpEnMap[m_portId].regOffset, val64) )
+   if ( (s_pPowerSeq != NULL) && m_pCtrlShadow->Read(val64) &&
+        ((val64 & m_regs.enableMask) != 0) && s_pPowerSeq->Request(this) )
    {
-      newVal = val64;
-      mask = (1 << sfpEnMap[m_portId].bitOffset);
-      newVal &= ~mask;
-      if ( newVal != val64 )
-      {
-         bRet &= m_pIoDrv->Write(sfpEnMap[m_portId].regOffset, newVal);
-         acd_usleep(5000);   // 5 msec delay to reduce the power supply demand at startup
-      }
+      return true;
    }
-   return bRet && HalSfp::Enable();
+
+   if ( !m_pCtrlShadow->Write(m_regs.enableMask, false, &bChanged) )
+   {
+      return false;
+   }
+   if ( bChanged )
+   {
+      acd_usleep(5000);   // 5 msec delay to reduce the power supply demand at startup
+   }
+   return HalSfp::Enable();
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Power-up the SFP without waiting for the supply to settle
+
+   @return     true if successful
+*/
+// ------------------------------------------------------------------------------------------------
+bool HalSfpClipper::PowerUp()
+{
+   return m_pCtrlShadow->Write(m_regs.enableMask, false) && HalSfp::Enable();
 }
 
 // ------------------------------------------------------------------------------------------------
 /*!@brief Disable the SFP
 
-   Power-down the SFP
+   Power-down the SFP. A power-up queued in the power-up sequencer is cancelled.
 
    @return     true if successful
 */
 // ------------------------------------------------------------------------------------------------
 bool HalSfpClipper::Disable()
 {
-   bool           bRet = true;
-   acd_uint64_t   val64;
-   acd_uint64_t   newVal;
-   acd_uint64_t   mask;
-
    //HalDebug("Disable");
-   if ( m_pIoDrv->Read(sfpEnMap[m_portId].regOffset, val64) )
+   if ( s_pPowerSeq != NULL )
    {
-      newVal = val64;
-      mask = (1 << sfpEnMap[m_portId].bitOffset);
-      newVal |= mask;
-      if ( newVal != val64 )
-      {
-         bRet &= m_pIoDrv->Write(sfpEnMap[m_portId].regOffset, newVal);
-      }
+      s_pPowerSeq->Cancel(this);
    }
-   return bRet && HalSfp::Disable();
+   return m_pCtrlShadow->Write(m_regs.enableMask, true) && HalSfp::Disable();
 }
 
 // ------------------------------------------------------------------------------------------------
@@ -212,30 +147,9 @@ bool HalSfpClipper::Disable()
 // ------------------------------------------------------------------------------------------------
 bool HalSfpClipper::SetTxEnable(bool a_bEnable)
 {
-   bool           bRet = true;
-   acd_uint64_t   val64;
-   acd_uint64_t   newVal;
-   acd_uint64_t   mask;
-
    //HalDebug("SetTxEnable(%d)", a_bEnable);
-   if ( m_pIoDrv->Read(sfpTxDisMap[m_portId].regOffset, val64) )
-   {
-      newVal = val64;
-      mask = (1 << sfpTxDisMap[m_portId].bitOffset);
-      if ( a_bEnable )
-      {
-         newVal &= ~mask;
-      }
-      else
-      {
-         newVal |= mask;
-      }
-      if ( newVal != val64 )
-      {
-         bRet &= m_pIoDrv->Write(sfpTxDisMap[m_portId].regOffset, newVal);
-      }
-   }
-   return bRet && HalSfp::SetTxEnable(a_bEnable);
+   return m_pCtrlShadow->Write(m_regs.txDisableMask, !a_bEnable) &&
+          HalSfp::SetTxEnable(a_bEnable);
 }
 
 // ------------------------------------------------------------------------------------------------
@@ -249,27 +163,13 @@ bool HalSfpClipper::SetTxEnable(bool a_bEnable)
 // ------------------------------------------------------------------------------------------------
 bool HalSfpClipper::IsPresent()
 {
-   acd_uint64_t   val64;
-   acd_uint64_t   mask;
+   bool bWasPresent = m_isPresent;
 
-#ifdef CLIPPER2
-   val64 = s_status1;
-#else // CLIPPER
-   if ( m_portId < HalPortId9 )
-   {
-      val64 = s_status1;
-   }
-   else
+   m_isPresent = ((s_status[m_regs.detectWord] & m_regs.detectMask) == 0);
+   // Drop the data once on removal, or if restored for a module that is gone
+   if ( !m_isPresent && (bWasPresent || m_identity.bValid) )
    {
-      val64 = s_status2;
-   }
-#endif
-
-   mask = (1 << sfpDetectMap[m_portId].bitOffset);
-   m_isPresent = ((val64 & mask) == 0) ? true : false;
-   if ( !m_isPresent )
-   {
-      m_logErrorCount = 0;
+      Invalidate();
    }
    //HalDebug("SFP %d is %s", m_portId, m_isPresent ? "present" : "not present");
    return m_isPresent;
@@ -284,8 +184,7 @@ bool HalSfpClipper::IsPresent()
 bool HalSfpClipper::UpdateData()
 {
    acd_uint8_t buffer[128];
-   acd_uint8_t ff[128];
-   acd_uint8_t zero[128];
+   HalSfpPageScan scan;
    bool bRet = false;
 
    if ( !m_isPresent || !m_bEnable )
@@ -293,18 +192,20 @@ bool HalSfpClipper::UpdateData()
       return false;
    }
 
-   memset(ff, 0xff, sizeof(ff));
-   memset(zero, 0x00, sizeof(zero));
-   //HalDebug("UpdateData");
-   if ( m_pI2cIoDrv->Read(0xA0, sizeof(buffer), buffer) )
+   SFP_PROBE2(update_start, this, 0xA0);
+   if ( verifyIdentity() )
+   {
+      // Same module as on the last A0h read
+      bRet = true;
+   }
+   else if ( m_pI2cIoDrv->Read(0xA0, sizeof(buffer), buffer) )
    {
-      if ( memcmp(buffer, zero, sizeof(buffer)) == 0 )
+      if ( ingestInterfaceData(buffer, sizeof(buffer), true).bBlank )
       {
-         HalDebug("Invalid data (0x00) read from EEPROM 0xA0");
+         logEvent(SfpLogA0Blank);
       }
       else
       {
-         memcpy(m_interfaceData, buffer, sizeof (buffer));
          bRet = HalSfp::UpdateData();
          if (!bRet)
          {
@@ -314,33 +215,30 @@ bool HalSfpClipper::UpdateData()
    }
    else
    {
-      if ( ++m_logErrorCount < SFP_LOG_ERROR_THRESHOLD )
-      {
-         HalError("EEPROM 0xA0 read failed");
-      }
+      logEvent(SfpLogA0ReadFailed);
    }
 
    if (m_bIsCopper)
    {
       if ( m_pI2cIoDrv->Read(0xAC, sizeof(buffer)/2, buffer) )
       {
-         if ( memcmp(buffer, ff, sizeof(buffer)/2) == 0 )
+         scanPage(buffer, NULL, 0, sizeof(buffer)/2, scan);
+         if ( scan.bErased )
          {
-            HalDebug("Invalid data (0xff) read from EEPROM 0xAC");
+            logEvent(SfpLogAcErased);
          }
          else
          {
-            memcpy(m_phyData, buffer, sizeof(buffer)/2);
+            publishPhyData(buffer);
          }
       }
       else
       {
-         if ( ++m_logErrorCount < SFP_LOG_ERROR_THRESHOLD )
-         {
-            HalError("EEPROM 0xAC read failed");
-         }
+         logEvent(SfpLogAcReadFailed);
       }
    }
+   SFP_PROBE3(update_end, this, 0xA0, bRet);
+   countUpdate(false, bRet);
    return bRet;
 }
 
@@ -354,24 +252,25 @@ bool HalSfpClipper::UpdateMonitoringData()
 {
    bool        bRet = false;
    acd_uint8_t buffer[128];
-   acd_uint8_t zero[128];
+   acd_uint32_t region;
+   acd_uint32_t offset;
+   acd_uint32_t size;
 
    if ( !m_isPresent || !m_bEnable )
    {
       return false;
    }
-   //HalDebug("UpdateMonitoringData");
+   SFP_PROBE2(update_start, this, 0xA2);
 
-   memset(zero, 0x00, sizeof(zero));
-   if ( m_pI2cIoDrv->Read(0xA2, sizeof(buffer), buffer) )
+   getMonitoringWindow(region, offset, size);
+   if ( m_pI2cIoDrv->Read(HAL_SFP_I2C_REG(region, offset), size, buffer) )
    {
-      if ( memcmp(buffer, zero, sizeof(buffer)) == 0 )
+      if ( ingestMonitoringData(buffer, offset, size, true).bBlank )
       {
-         HalDebug("Invalid data (0x00) read from EEPROM 0xA2");
+         logEvent(SfpLogA2Blank);
       }
       else
       {
-         memcpy(m_monData, buffer, sizeof (buffer));
          bRet = HalSfp::UpdateMonitoringData();
          if (!bRet)
          {
@@ -381,11 +280,11 @@ bool HalSfpClipper::UpdateMonitoringData()
    }
    else
    {
-      if ( ++m_logErrorCount < SFP_LOG_ERROR_THRESHOLD )
-      {
-         HalError("0xA2 EEPROM read failed");
-      }
+      m_bMonStaticValid = false;
+      logEvent(SfpLogA2ReadFailed);
    }
+   SFP_PROBE3(update_end, this, 0xA2, bRet);
+   countUpdate(true, bRet);
    return bRet;
 }
 
@@ -397,12 +296,29 @@ bool HalSfpClipper::UpdateMonitoringData()
 // ------------------------------------------------------------------------------------------------
 bool HalSfpClipper::RefreshStatus()
 {
-   bool bRet;
-
-   bRet = m_pIoDrv->Read(SFP_STAT_1, s_status1);
-#ifdef CLIPPER
-   bRet = m_pIoDrv->Read(SFP_STAT_2, s_status2);
-#endif
+   bool bRet = true;
 
+   for(acd_uint32_t i = 0 ; bRet && (i < SfpPlatformClipperBoard::NB_STATUS_REGS) ; i++)
+   {
+      bRet = m_pIoDrv->Read(SfpPlatformClipperBoard::Detect::FIRST_REG + i * SfpPlatformClipperBoard::Detect::REG_STRIDE,
+                            s_status[i]);
+      if ( bRet )
+      {
+         s_presence.Update(i, s_status[i]);
+      }
+   }
    return bRet;
 }
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Set the power-up sequencer shared by all the SFPs
+
+   The sequencer staggers the power-ups without blocking Enable(), see SfpPowerSequencer.
+
+   @param [in]     a_pSequencer : Sequencer, NULL to power-up synchronously (default)
+*/
+// ------------------------------------------------------------------------------------------------
+void HalSfpClipper::SetPowerSequencer(SfpPowerSequencer* a_pSequencer)
+{
+   s_pPowerSeq = a_pSequencer;
+}
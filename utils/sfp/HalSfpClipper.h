@@ -17,8 +17,17 @@
 #define __HALSFPCLIPPER_H__
 
 #include "HalSfp.h"
+#include "SfpPlatform.h"
 #include <accedian/acclib/BaseIoDrv.h>
 
+class SfpPowerSequencer;
+
+#ifdef CLIPPER2
+typedef SfpPlatformClipper2   SfpPlatformClipperBoard;
+#else // CLIPPER
+typedef SfpPlatformClipper    SfpPlatformClipperBoard;
+#endif
+
 // ------------------------------------------------------------------------------------------------
 /*!@brief Clipper SFP Hardware Abstraction Layer
 
@@ -36,6 +45,7 @@ public:
    virtual ~HalSfpClipper();
 
    virtual bool Enable();
+   virtual bool PowerUp();
    virtual bool Disable();
    virtual bool SetTxEnable(bool a_bEnable);
 
@@ -44,13 +54,18 @@ public:
    virtual bool UpdateMonitoringData();
    virtual bool RefreshStatus();
 
+   static void SetPowerSequencer(SfpPowerSequencer* a_pSequencer);
+
 private:
    HalPortId   m_portId;
    BaseIoDrv<acd_uint64_t>* m_pIoDrv;     // The I/O driver used to access the FPGA registers
    BaseIoDrv<acd_uint8_t>*  m_pI2cIoDrv;  // The I/O driver used to access the I2C registers
+   SfpPortRegs m_regs;                    // Registers of the port
 
-   static acd_uint64_t s_status1;
-   static acd_uint64_t s_status2;
+   static acd_uint64_t s_status[SfpPlatformClipperBoard::NB_STATUS_REGS];
+   static SfpPresenceTracker s_presence;   // Presence of all the SFPs
+   static SfpCtrlShadow s_ctrl[SfpPlatformClipperBoard::NB_CTRL_REGS];   // Control registers
+   static SfpPowerSequencer* s_pPowerSeq;  // Power-up sequencer, NULL to power-up synchronously
 };
 
 #endif // #ifndef __HALSFPCLIPPER_H__
@@ -14,9 +14,14 @@
 
 */
 #include "HalSfpE4.h"
+#include "SfpPresence.h"
+#include "SfpCtrlShadow.h"
+#include "SfpProbe.h"
 #include <accedian/acclib/acd_utils.h>
 
 acd_uint64_t HalSfpE4::s_status = 0;
+SfpPresenceTracker HalSfpE4::s_presence;
+SfpCtrlShadow HalSfpE4::s_ctrl[SfpPlatformE4::NB_CTRL_REGS];
 
 // ================================================================================================
 // ================================================================================================
@@ -42,6 +47,13 @@ m_pIoDrv(a_pIoDrv),
 m_pI2cIoDrv(a_pI2cIoDrv)
 {
    HalSetDebug(false);
+   setEepromIoDrv(a_pI2cIoDrv);
+   if ( sfpGetPortRegs<SfpPlatformE4>(m_portId - HalPortId1, m_regs) )
+   {
+      setPresenceTracker(&s_presence, m_portId, m_regs.detectWord, m_regs.detectBit);
+      s_ctrl[m_regs.ctrlWord].Attach(a_pIoDrv, m_regs.enableReg);
+   }
+   setCtrlShadow(&s_ctrl[m_regs.ctrlWord], m_regs.txDisableMask);
 }
 
 // ------------------------------------------------------------------------------------------------
@@ -63,38 +75,8 @@ HalSfpE4::~HalSfpE4()
 // ------------------------------------------------------------------------------------------------
 bool HalSfpE4::Enable()
 {
-   bool bRet = true;
-   SfpControlReg_t   ctrl;
-   acd_uint64_t      val64;
-
    HalDebug("Enable");
-   if ( m_pIoDrv->Read(SFP_CONTROL_REG, val64) )
-   {
-      ctrl.value = val64;
-      switch (m_portId)
-      {
-         case HalPortId1:
-            ctrl.sfp1_enable_n = 0;
-            break;
-         case HalPortId2:
-            ctrl.sfp2_enable_n = 0;
-            break;
-         case HalPortId3:
-            ctrl.sfp3_enable_n = 0;
-            break;
-         case HalPortId4:
-            ctrl.sfp4_enable_n = 0;
-            break;
-         default:
-            bRet = false;
-            break;
-      }
-      if ( ctrl.value != val64 )
-      {
-         bRet &= m_pIoDrv->Write(SFP_CONTROL_REG, ctrl.value);
-      }
-   }
-   return bRet && HalSfp::Enable();
+   return m_pCtrlShadow->Write(m_regs.enableMask, false) && HalSfp::Enable();
 }
 
 // ------------------------------------------------------------------------------------------------
@@ -107,38 +89,8 @@ bool HalSfpE4::Enable()
 // ------------------------------------------------------------------------------------------------
 bool HalSfpE4::Disable()
 {
-   bool bRet = true;
-   SfpControlReg_t   ctrl;
-   acd_uint64_t      val64;
-
    HalDebug("Disable");
-   if ( m_pIoDrv->Read(SFP_CONTROL_REG, val64) )
-   {
-      ctrl.value = val64;
-      switch (m_portId)
-      {
-         case HalPortId1:
-            ctrl.sfp1_enable_n = 1;
-            break;
-         case HalPortId2:
-            ctrl.sfp2_enable_n = 1;
-            break;
-         case HalPortId3:
-            ctrl.sfp3_enable_n = 1;
-            break;
-         case HalPortId4:
-            ctrl.sfp4_enable_n = 1;
-            break;
-         default:
-            bRet = false;
-            break;
-      }
-      if ( ctrl.value != val64 )
-      {
-         bRet &= m_pIoDrv->Write(SFP_CONTROL_REG, ctrl.value);
-      }
-   }
-   return bRet && HalSfp::Disable();
+   return m_pCtrlShadow->Write(m_regs.enableMask, true) && HalSfp::Disable();
 }
 
 // ------------------------------------------------------------------------------------------------
@@ -151,38 +103,9 @@ bool HalSfpE4::Disable()
 // ------------------------------------------------------------------------------------------------
 bool HalSfpE4::SetTxEnable(bool a_bEnable)
 {
-   bool bRet = true;
-   SfpControlReg_t   ctrl;
-   acd_uint64_t      val64;
-
    HalDebug("SetTxEnable(%d)", a_bEnable);
-   if ( m_pIoDrv->Read(SFP_CONTROL_REG, val64) )
-   {
-      ctrl.value = val64;
-      switch (m_portId)
-      {
-         case HalPortId1:
-            ctrl.sfp1_txdisable = !a_bEnable;
-            break;
-         case HalPortId2:
-            ctrl.sfp2_txdisable = !a_bEnable;
-            break;
-         case HalPortId3:
-            ctrl.sfp3_txdisable = !a_bEnable;
-            break;
-         case HalPortId4:
-            ctrl.sfp4_txdisable = !a_bEnable;
-            break;
-         default:
-            bRet = false;
-            break;
-      }
-      if ( ctrl.value != val64 )
-      {
-         bRet &= m_pIoDrv->Write(SFP_CONTROL_REG, ctrl.value);
-      }
-   }
-   return bRet && HalSfp::SetTxEnable(a_bEnable);
+   return m_pCtrlShadow->Write(m_regs.txDisableMask, !a_bEnable) &&
+          HalSfp::SetTxEnable(a_bEnable);
 }
 
 // ------------------------------------------------------------------------------------------------
@@ -196,30 +119,13 @@ bool HalSfpE4::SetTxEnable(bool a_bEnable)
 // ------------------------------------------------------------------------------------------------
 bool HalSfpE4::IsPresent()
 {
-   SfpStatusReg_t    regVal;
+   bool bWasPresent = m_isPresent;
 
-   regVal.value = s_status;
-   switch (m_portId)
-   {
-      case HalPortId1:
-         m_isPresent = !regVal.sfp1_detect_n;
-         break;
-      case HalPortId2:
-         m_isPresent = !regVal.sfp2_detect_n;
-         break;
-      case HalPortId3:
-         m_isPresent = !regVal.sfp3_detect_n;
-         break;
-      case HalPortId4:
-         m_isPresent = !regVal.sfp4_detect_n;
-         break;
-      default:
-         m_isPresent = false;
-         break;
-   }
-   if ( !m_isPresent )
+   m_isPresent = (m_regs.detectMask != 0) && ((s_status & m_regs.detectMask) == 0);
+   // Drop the data once on removal, or if restored for a module that is gone
+   if ( !m_isPresent && (bWasPresent || m_identity.bValid) )
    {
-      m_logErrorCount = 0;
+      Invalidate();
    }
    //HalDebug("SFP %d is %s", m_portId, m_isPresent ? "present" : "not present");
    return m_isPresent;
@@ -241,10 +147,15 @@ bool HalSfpE4::UpdateData()
       return false;
    }
 
-   //HalDebug("UpdateData");
-   if ( m_pI2cIoDrv->Read(0xA0, sizeof(buffer), buffer) )
+   SFP_PROBE2(update_start, this, 0xA0);
+   if ( verifyIdentity() )
    {
-      memcpy(m_interfaceData, buffer, sizeof (buffer));
+      // Same module as on the last A0h read
+      bRet = true;
+   }
+   else if ( m_pI2cIoDrv->Read(0xA0, sizeof(buffer), buffer) )
+   {
+      ingestInterfaceData(buffer, sizeof(buffer));
       bRet = HalSfp::UpdateData();
       if (!bRet)
       {
@@ -253,10 +164,7 @@ bool HalSfpE4::UpdateData()
    }
    else
    {
-      if ( ++m_logErrorCount < SFP_LOG_ERROR_THRESHOLD )
-      {
-         HalError("0xA0 EEPROM read failed");
-      }
+      logEvent(SfpLogA0ReadFailed);
    }
 
    m_speedCap[HalSfpSpeed10G] = false;
@@ -265,9 +173,11 @@ bool HalSfpE4::UpdateData()
    {
       if ( m_pI2cIoDrv->Read(0xAC, sizeof(buffer)/2, buffer) )
       {
-         memcpy(m_phyData, buffer, sizeof(buffer)/2);
+         publishPhyData(buffer);
       }
    }
+   SFP_PROBE3(update_end, this, 0xA0, bRet);
+   countUpdate(false, bRet);
    return bRet;
 }
 
@@ -281,16 +191,20 @@ bool HalSfpE4::UpdateMonitoringData()
 {
    bool        bRet = false;
    acd_uint8_t buffer[128];
+   acd_uint32_t region;
+   acd_uint32_t offset;
+   acd_uint32_t size;
 
    if ( !m_isPresent || !m_bEnable )
    {
       return false;
    }
-   //HalDebug("UpdateMonitoringData");
+   SFP_PROBE2(update_start, this, 0xA2);
 
-   if ( m_pI2cIoDrv->Read(0xA2, sizeof(buffer), buffer) )
+   getMonitoringWindow(region, offset, size);
+   if ( m_pI2cIoDrv->Read(HAL_SFP_I2C_REG(region, offset), size, buffer) )
    {
-      memcpy(m_monData, buffer, sizeof (buffer));
+      ingestMonitoringData(buffer, offset, size);
       bRet = HalSfp::UpdateMonitoringData();
       if (!bRet)
       {
@@ -299,12 +213,12 @@ bool HalSfpE4::UpdateMonitoringData()
    }
    else
    {
-      if ( ++m_logErrorCount < SFP_LOG_ERROR_THRESHOLD )
-      {
-         HalError("0xA2 EEPROM read failed");
-      }
+      m_bMonStaticValid = false;
+      logEvent(SfpLogA2ReadFailed);
    }
 
+   SFP_PROBE3(update_end, this, 0xA2, bRet);
+   countUpdate(true, bRet);
    return bRet;
 }
 
@@ -316,5 +230,10 @@ bool HalSfpE4::UpdateMonitoringData()
 // ------------------------------------------------------------------------------------------------
 bool HalSfpE4::RefreshStatus()
 {
-   return m_pIoDrv->Read(SFP_STATUS_REG, s_status);
+   if ( !m_pIoDrv->Read(SfpPlatformE4::Detect::FIRST_REG, s_status) )
+   {
+      return false;
+   }
+   s_presence.Update(0, s_status);
+   return true;
 }
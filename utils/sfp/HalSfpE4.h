@@ -17,6 +17,7 @@
 #define __HALSFPE4_H__
 
 #include "HalSfp.h"
+#include "SfpPlatform.h"
 #include <accedian/acclib/BaseIoDrv.h>
 
 // ------------------------------------------------------------------------------------------------
@@ -45,97 +46,11 @@ private:
    HalPortId   m_portId;
    BaseIoDrv<acd_uint64_t>* m_pIoDrv;     // The I/O driver used to access the FPGA registers
    BaseIoDrv<acd_uint8_t>*  m_pI2cIoDrv;  // The I/O driver used to access the I2C registers
-
-   static const acd_uint32_t  SFP_CONTROL_REG = 0x01;
-   static const acd_uint32_t  SFP_STATUS_REG  = 0x86;
-
-   union SfpControlReg_t
-   {
-      struct
-      {
-#if BYTE_ORDER == BIG_ENDIAN
-         acd_uint64_t   Unused1              :  32;
-         acd_uint64_t   Unused2              :  20;
-         acd_uint64_t   sfp4_txdisable       :  1;
-         acd_uint64_t   sfp4_ratesel         :  1;
-         acd_uint64_t   sfp4_enable_n        :  1;
-         acd_uint64_t   sfp3_txdisable       :  1;
-         acd_uint64_t   sfp3_ratesel         :  1;
-         acd_uint64_t   sfp3_enable_n        :  1;
-         acd_uint64_t   sfp2_txdisable       :  1;
-         acd_uint64_t   sfp2_ratesel         :  1;
-         acd_uint64_t   sfp2_enable_n        :  1;
-         acd_uint64_t   sfp1_txdisable       :  1;
-         acd_uint64_t   sfp1_ratesel         :  1;
-         acd_uint64_t   sfp1_enable_n        :  1;
-#else
-         acd_uint64_t   sfp1_enable_n        :  1;
-         acd_uint64_t   sfp1_ratesel         :  1;
-         acd_uint64_t   sfp1_txdisable       :  1;
-         acd_uint64_t   sfp2_enable_n        :  1;
-         acd_uint64_t   sfp2_ratesel         :  1;
-         acd_uint64_t   sfp2_txdisable       :  1;
-         acd_uint64_t   sfp3_enable_n        :  1;
-         acd_uint64_t   sfp3_ratesel         :  1;
-         acd_uint64_t   sfp3_txdisable       :  1;
-         acd_uint64_t   sfp4_enable_n        :  1;
-         acd_uint64_t   sfp4_ratesel         :  1;
-         acd_uint64_t   sfp4_txdisable       :  1;
-         acd_uint64_t   Unused2              :  20;
-         acd_uint64_t   Unused1              :  32;
-#endif
-      };
-      acd_uint64_t value;
-   }__attribute__((__packed__));
-
-   union SfpStatusReg_t
-   {
-      struct
-      {
-#if BYTE_ORDER == BIG_ENDIAN
-         acd_uint64_t   Unused1              :  32;
-         acd_uint64_t   Unused2              :  16;
-         acd_uint64_t   sfp4_txfault         :  1;
-         acd_uint64_t   sfp4_sdet_n          :  1;    // 0x00 signal detected from sfp, 0x01 no signal detected from sfp
-         acd_uint64_t   sfp4_detect_n        :  1;    // 0x00 sfp detected, 0x01 no sfp detected
-         acd_uint64_t   sfp4_enable_n_status :  1;    // actual status of the sfp4_enable_n pin
-         acd_uint64_t   sfp3_txfault         :  1;
-         acd_uint64_t   sfp3_sdet_n          :  1;    // 0x00 signal detected from sfp, 0x01 no signal detected from sfp
-         acd_uint64_t   sfp3_detect_n        :  1;    // 0x00 sfp detected, 0x01 no sfp detected
-         acd_uint64_t   sfp3_enable_n_status :  1;    // actual status of the sfp3_enable_n pin
-         acd_uint64_t   sfp2_txfault         :  1;
-         acd_uint64_t   sfp2_sdet_n          :  1;    // 0x00 signal detected from sfp, 0x01 no signal detected from sfp
-         acd_uint64_t   sfp2_detect_n        :  1;    // 0x00 sfp detected, 0x01 no sfp detected
-         acd_uint64_t   sfp2_enable_n_status :  1;    // actual status of the sfp2_enable_n pin
-         acd_uint64_t   sfp1_txfault         :  1;
-         acd_uint64_t   sfp1_sdet_n          :  1;    // 0x00 signal detected from sfp, 0x01 no signal detected from sfp
-         acd_uint64_t   sfp1_detect_n        :  1;    // 0x00 sfp detected, 0x01 no sfp detected
-         acd_uint64_t   sfp1_enable_n_status :  1;    // actual status of the sfp1_enable_n pin
-#else
-         acd_uint64_t   sfp1_enable_n_status :  1;    // actual status of the sfp1_enable_n pin
-         acd_uint64_t   sfp1_detect_n        :  1;    // 0x00 sfp detected, 0x01 no sfp detected
-         acd_uint64_t   sfp1_sdet_n          :  1;    // 0x00 signal detected from sfp, 0x01 no signal detected from sfp
-         acd_uint64_t   sfp1_txfault         :  1;
-         acd_uint64_t   sfp2_enable_n_status :  1;    // actual status of the sfp2_enable_n pin
-         acd_uint64_t   sfp2_detect_n        :  1;    // 0x00 sfp detected, 0x01 no sfp detected
-         acd_uint64_t   sfp2_sdet_n          :  1;    // 0x00 signal detected from sfp, 0x01 no signal detected from sfp
-         acd_uint64_t   sfp2_txfault         :  1;
-         acd_uint64_t   sfp3_enable_n_status :  1;    // actual status of the sfp3_enable_n pin
-         acd_uint64_t   sfp3_detect_n        :  1;    // 0x00 sfp detected, 0x01 no sfp detected
-         acd_uint64_t   sfp3_sdet_n          :  1;    // 0x00 signal detected from sfp, 0x01 no signal detected from sfp
-         acd_uint64_t   sfp3_txfault         :  1;
-         acd_uint64_t   sfp4_enable_n_status :  1;    // actual status of the sfp4_enable_n pin
-         acd_uint64_t   sfp4_detect_n        :  1;    // 0x00 sfp detected, 0x01 no sfp detected
-         acd_uint64_t   sfp4_sdet_n          :  1;    // 0x00 signal detected from sfp, 0x01 no signal detected from sfp
-         acd_uint64_t   sfp4_txfault         :  1;
-         acd_uint64_t   Unused2              :  16;
-         acd_uint64_t   Unused1              :  32;
-#endif
-      };
-      acd_uint64_t value;
-   }__attribute__((__packed__));
+   SfpPortRegs m_regs;                    // Registers of the port
 
    static acd_uint64_t s_status;
+   static SfpPresenceTracker s_presence;   // Presence of all the SFPs
+   static SfpCtrlShadow s_ctrl[SfpPlatformE4::NB_CTRL_REGS];   // Control registers
 
 };
 #endif // #ifndef __HALSFPE4_H__
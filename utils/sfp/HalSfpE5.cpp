@@ -14,56 +14,14 @@
 
 */
 #include "HalSfpE5.h"
+#include "SfpPresence.h"
+#include "SfpCtrlShadow.h"
+#include "SfpProbe.h"
 #include <accedian/acclib/acd_utils.h>
 
-static const acd_uint32_t  SFP_CONTROL_REG = 0x10000;
-static const acd_uint32_t  SFP_STATUS_REG  = 0x10001;
-
-struct sfpRegMap
-{
-   acd_uint32_t   regOffset;
-   acd_uint32_t   bitOffset;
-};
-static sfpRegMap  sfpEnMap[HalPortId9] =
-{
-   { SFP_CONTROL_REG,  0 },   // Port 0
-   { SFP_CONTROL_REG,  0 },   // Port 1
-   { SFP_CONTROL_REG,  4 },   // Port 2
-   { SFP_CONTROL_REG,  8 },   // Port 3
-   { SFP_CONTROL_REG, 12 },   // Port 4
-   { SFP_CONTROL_REG, 16 },   // Port 5
-   { SFP_CONTROL_REG, 20 },   // Port 6
-   { SFP_CONTROL_REG, 24 },   // Port 7
-   { SFP_CONTROL_REG, 28 },   // Port 8
-};
-
-static sfpRegMap  sfpTxDisMap[HalPortId9] =
-{
-   { SFP_CONTROL_REG,  1 },   // Port 0
-   { SFP_CONTROL_REG,  1 },   // Port 1
-   { SFP_CONTROL_REG,  5 },   // Port 2
-   { SFP_CONTROL_REG,  9 },   // Port 3
-   { SFP_CONTROL_REG, 13 },   // Port 4
-   { SFP_CONTROL_REG, 17 },   // Port 5
-   { SFP_CONTROL_REG, 21 },   // Port 6
-   { SFP_CONTROL_REG, 25 },   // Port 7
-   { SFP_CONTROL_REG, 29 },   // Port 8
-};
-
-static sfpRegMap  sfpDetectMap[HalPortId9] =
-{
-   { SFP_STATUS_REG,  0 },   // Port 0
-   { SFP_STATUS_REG,  0 },   // Port 1
-   { SFP_STATUS_REG,  4 },   // Port 2
-   { SFP_STATUS_REG,  8 },   // Port 3
-   { SFP_STATUS_REG, 12 },   // Port 4
-   { SFP_STATUS_REG, 16 },   // Port 5
-   { SFP_STATUS_REG, 20 },   // Port 6
-   { SFP_STATUS_REG, 24 },   // Port 7
-   { SFP_STATUS_REG, 28 },   // Port 8
-};
-
 acd_uint64_t HalSfpE5::s_status = 0;
+SfpPresenceTracker HalSfpE5::s_presence;
+SfpCtrlShadow HalSfpE5::s_ctrl[SfpPlatformE5::NB_CTRL_REGS];
 
 // ================================================================================================
 // ================================================================================================
@@ -89,6 +47,13 @@ m_pIoDrv(a_pIoDrv),
 m_pI2cIoDrv(a_pI2cIoDrv)
 {
    HalSetDebug(false);
+   setEepromIoDrv(a_pI2cIoDrv);
+   if ( sfpGetPortRegs<SfpPlatformE5>(m_portId - HalPortId1, m_regs) )
+   {
+      setPresenceTracker(&s_presence, m_portId, m_regs.detectWord, m_regs.detectBit);
+      s_ctrl[m_regs.ctrlWord].Attach(a_pIoDrv, m_regs.enableReg);
+   }
+   setCtrlShadow(&s_ctrl[m_regs.ctrlWord], m_regs.txDisableMask);
 }
 
 // ------------------------------------------------------------------------------------------------
@@ -110,23 +75,8 @@ HalSfpE5::~HalSfpE5()
 // ------------------------------------------------------------------------------------------------
 bool HalSfpE5::Enable()
 {
-   bool           bRet = true;
-   acd_uint64_t   val64;
-   acd_uint64_t   newVal;
-   acd_uint64_t   mask;
-
    //HalDebug("Enable");
-   if ( m_pIoDrv->Read(sfpEnMap[m_portId].regOffset, val64) )
-   {
-      newVal = val64;
-      mask = (1 << sfpEnMap[m_portId].bitOffset);
-      newVal &= ~mask;
-      if ( newVal != val64 )
-      {
-         bRet &= m_pIoDrv->Write(sfpEnMap[m_portId].regOffset, newVal);
-      }
-   }
-   return bRet && HalSfp::Enable();
+   return m_pCtrlShadow->Write(m_regs.enableMask, false) && HalSfp::Enable();
 }
 
 // ------------------------------------------------------------------------------------------------
@@ -139,23 +89,8 @@ bool HalSfpE5::Enable()
 // ------------------------------------------------------------------------------------------------
 bool HalSfpE5::Disable()
 {
-   bool           bRet = true;
-   acd_uint64_t   val64;
-   acd_uint64_t   newVal;
-   acd_uint64_t   mask;
-
    //HalDebug("Disable");
-   if ( m_pIoDrv->Read(sfpEnMap[m_portId].regOffset, val64) )
-   {
-      newVal = val64;
-      mask = (1 << sfpEnMap[m_portId].bitOffset);
-      newVal |= mask;
-      if ( newVal != val64 )
-      {
-         bRet &= m_pIoDrv->Write(sfpEnMap[m_portId].regOffset, newVal);
-      }
-   }
-   return bRet && HalSfp::Disable();
+   return m_pCtrlShadow->Write(m_regs.enableMask, true) && HalSfp::Disable();
 }
 
 // ------------------------------------------------------------------------------------------------
@@ -168,30 +103,9 @@ bool HalSfpE5::Disable()
 // ------------------------------------------------------------------------------------------------
 bool HalSfpE5::SetTxEnable(bool a_bEnable)
 {
-   bool           bRet = true;
-   acd_uint64_t   val64;
-   acd_uint64_t   newVal;
-   acd_uint64_t   mask;
-
    //HalDebug("SetTxEnable(%d)", a_bEnable);
-   if ( m_pIoDrv->Read(sfpTxDisMap[m_portId].regOffset, val64) )
-   {
-      newVal = val64;
-      mask = (1 << sfpTxDisMap[m_portId].bitOffset);
-      if ( a_bEnable )
-      {
-         newVal &= ~mask;
-      }
-      else
-      {
-         newVal |= mask;
-      }
-      if ( newVal != val64 )
-      {
-         bRet &= m_pIoDrv->Write(sfpTxDisMap[m_portId].regOffset, newVal);
-      }
-   }
-   return bRet && HalSfp::SetTxEnable(a_bEnable);
+   return m_pCtrlShadow->Write(m_regs.txDisableMask, !a_bEnable) &&
+          HalSfp::SetTxEnable(a_bEnable);
 }
 
 // ------------------------------------------------------------------------------------------------
@@ -205,14 +119,13 @@ bool HalSfpE5::SetTxEnable(bool a_bEnable)
 // ------------------------------------------------------------------------------------------------
 bool HalSfpE5::IsPresent()
 {
-   acd_uint64_t   val64 = s_status;
-   acd_uint64_t   mask;
+   bool bWasPresent = m_isPresent;
 
-   mask = (1 << sfpDetectMap[m_portId].bitOffset);
-   m_isPresent = ((val64 & mask) == 0) ? true : false;
-   if ( !m_isPresent )
+   m_isPresent = (m_regs.detectMask != 0) && ((s_status & m_regs.detectMask) == 0);
+   // Drop the data once on removal, or if restored for a module that is gone
+   if ( !m_isPresent && (bWasPresent || m_identity.bValid) )
    {
-      m_logErrorCount = 0;
+      Invalidate();
    }
    //HalDebug("SFP %d is %s", m_portId, m_isPresent ? "present" : "not present");
    return m_isPresent;
@@ -234,10 +147,15 @@ bool HalSfpE5::UpdateData()
       return false;
    }
 
-   //HalDebug("UpdateData");
-   if ( m_pI2cIoDrv->Read(0xA0, sizeof(buffer), buffer) )
+   SFP_PROBE2(update_start, this, 0xA0);
+   if ( verifyIdentity() )
    {
-      memcpy(m_interfaceData, buffer, sizeof (buffer));
+      // Same module as on the last A0h read
+      bRet = true;
+   }
+   else if ( m_pI2cIoDrv->Read(0xA0, sizeof(buffer), buffer) )
+   {
+      ingestInterfaceData(buffer, sizeof(buffer));
       bRet = HalSfp::UpdateData();
       if (!bRet)
       {
@@ -246,10 +164,7 @@ bool HalSfpE5::UpdateData()
    }
    else
    {
-      if ( ++m_logErrorCount < SFP_LOG_ERROR_THRESHOLD )
-      {
-         HalError("0xA0 EEPROM read failed");
-      }
+      logEvent(SfpLogA0ReadFailed);
    }
 
    m_speedCap[HalSfpSpeed10G] = false;
@@ -258,9 +173,11 @@ bool HalSfpE5::UpdateData()
    {
       if ( m_pI2cIoDrv->Read(0xAC, sizeof(buffer)/2, buffer) )
       {
-         memcpy(m_phyData, buffer, sizeof(buffer)/2);
+         publishPhyData(buffer);
       }
    }
+   SFP_PROBE3(update_end, this, 0xA0, bRet);
+   countUpdate(false, bRet);
    return bRet;
 }
 
@@ -274,16 +191,20 @@ bool HalSfpE5::UpdateMonitoringData()
 {
    bool        bRet = false;
    acd_uint8_t buffer[128];
+   acd_uint32_t region;
+   acd_uint32_t offset;
+   acd_uint32_t size;
 
    if ( !m_isPresent || !m_bEnable )
    {
       return false;
    }
-   //HalDebug("UpdateMonitoringData");
+   SFP_PROBE2(update_start, this, 0xA2);
 
-   if ( m_pI2cIoDrv->Read(0xA2, sizeof(buffer), buffer) )
+   getMonitoringWindow(region, offset, size);
+   if ( m_pI2cIoDrv->Read(HAL_SFP_I2C_REG(region, offset), size, buffer) )
    {
-      memcpy(m_monData, buffer, sizeof (buffer));
+      ingestMonitoringData(buffer, offset, size);
       bRet = HalSfp::UpdateMonitoringData();
       if (!bRet)
       {
@@ -292,12 +213,12 @@ bool HalSfpE5::UpdateMonitoringData()
    }
    else
    {
-      if ( ++m_logErrorCount < SFP_LOG_ERROR_THRESHOLD )
-      {
-         HalError("0xA2 EEPROM read failed");
-      }
+      m_bMonStaticValid = false;
+      logEvent(SfpLogA2ReadFailed);
    }
 
+   SFP_PROBE3(update_end, this, 0xA2, bRet);
+   countUpdate(true, bRet);
    return bRet;
 }
 
@@ -309,5 +230,10 @@ bool HalSfpE5::UpdateMonitoringData()
 // ------------------------------------------------------------------------------------------------
 bool HalSfpE5::RefreshStatus()
 {
-   return m_pIoDrv->Read(SFP_STATUS_REG, s_status);
+   if ( !m_pIoDrv->Read(SfpPlatformE5::Detect::FIRST_REG, s_status) )
+   {
+      return false;
+   }
+   s_presence.Update(0, s_status);
+   return true;
 }
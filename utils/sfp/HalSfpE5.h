@@ -17,6 +17,7 @@
 #define __HALSFPE5_H__
 
 #include "HalSfp.h"
+#include "SfpPlatform.h"
 #include <accedian/acclib/BaseIoDrv.h>
 
 // ------------------------------------------------------------------------------------------------
@@ -46,7 +47,10 @@ private:
    HalPortId   m_portId;
    BaseIoDrv<acd_uint64_t>* m_pIoDrv;     // The I/O driver used to access the FPGA registers
    BaseIoDrv<acd_uint8_t>*  m_pI2cIoDrv;  // The I/O driver used to access the I2C registers
+   SfpPortRegs m_regs;                    // Registers of the port
 
    static acd_uint64_t s_status;
+   static SfpPresenceTracker s_presence;   // Presence of all the SFPs
+   static SfpCtrlShadow s_ctrl[SfpPlatformE5::NB_CTRL_REGS];   // Control registers
 };
 #endif // #ifndef __HALSFPE5_H__
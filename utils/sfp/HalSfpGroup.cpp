@@ -0,0 +1,707 @@
+// ------------------------------------------------------------------------------------------------
+/* ACCEDIAN PROPRIETARY - www.accedian.com
+   COPYRIGHT (c) 2004-2014 BY ACCEDIAN CORPORATION. ALL RIGHTS RESERVED. NO PART OF THIS PROGRAM OR
+   PUBLICATION MAY BE REPRODUCED, TRANSMITTED, TRANSCRIBED, STORED IN A RETRIEVAL SYSTEM,
+   OR TRANSLATED INTO ANY LANGUAGE OR COMPUTER LANGUAGE IN ANY FORM OR BY ANY MEANS, ELECTRONIC,
+   MECHANICAL, MAGNETIC, OPTICAL, CHEMICAL, MANUAL, OR OTHERWISE, WITHOUT THE PRIOR WRITTEN
+   PERMISSION OF ACCEDIAN INC.
+*/
+// ------------------------------------------------------------------------------------------------
+/*!@file    HalSfpGroup.cpp
+   @brief   SFP group Hardware Abstraction Layer
+
+   This file contains the board level SFP group class
+
+*/
+// ------------------------------------------------------------------------------------------------
+
+#include "HalSfpGroup.h"
+#include "SfpTime.h"
+#include "SfpPageBuffer.h"
+#include "SfpModuleDesc.h"
+#include "SfpDb.h"
+#include "SfpCtrlShadow.h"
+
+// ================================================================================================
+// ================================================================================================
+//            PUBLIC CLASS SECTION
+// ================================================================================================
+// ================================================================================================
+// ------------------------------------------------------------------------------------------------
+/*!@brief Constructor
+
+*/
+// ------------------------------------------------------------------------------------------------
+HalSfpGroup::HalSfpGroup() :
+m_nbPorts(0),
+m_nbControllers(0),
+m_pPolicy(NULL),
+m_pPresence(NULL),
+m_bPresenceScan(true),
+m_bCtrlSync(true),
+m_nbWorkers(0),
+m_sweepId(0),
+m_pending(0),
+m_bStop(false),
+m_bDiscovering(false),
+m_discoveryStart(0),
+m_nbDiscovered(0)
+{
+   memset(m_ports, 0, sizeof(m_ports));
+   memset(m_order, 0, sizeof(m_order));
+   memset(m_ctrlFirst, 0, sizeof(m_ctrlFirst));
+   memset(m_ctrlCount, 0, sizeof(m_ctrlCount));
+   memset(m_presenceIndex, SFP_PRESENCE_NO_PORT, sizeof(m_presenceIndex));
+   memset(&m_stats, 0, sizeof(m_stats));
+   pthread_mutex_init(&m_mutex, NULL);
+   pthread_cond_init(&m_startCond, NULL);
+   pthread_cond_init(&m_doneCond, NULL);
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Destructor
+
+   Deletes the SFPs of the group.
+*/
+// ------------------------------------------------------------------------------------------------
+HalSfpGroup::~HalSfpGroup()
+{
+   StopWorkers();
+   pthread_cond_destroy(&m_doneCond);
+   pthread_cond_destroy(&m_startCond);
+   pthread_mutex_destroy(&m_mutex);
+   for(acd_uint32_t i = 0 ; i < m_nbPorts ; i++)
+   {
+      delete m_ports[i].pSfp;
+   }
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Add a SFP to the group
+
+   The group becomes the owner of the SFP. All the SFPs of a group must share the same board
+   status, i.e. be of the same HalSfp derived class. SFPs cannot be added while the workers run.
+
+   @param [in]     a_pSfp       : SFP
+   @param [in]     a_controller : I2C controller identifier (ex: I2cIoDrvV02::GetBaseAddress())
+
+   @return     true if successful
+*/
+// ------------------------------------------------------------------------------------------------
+bool HalSfpGroup::AddPort(HalSfp* a_pSfp, acd_uint32_t a_controller)
+{
+   SfpPresenceTracker*  pTracker;
+   acd_uint32_t         presenceId;
+
+   if ( (a_pSfp == NULL) || (m_nbPorts >= HAL_SFP_GROUP_MAX_PORTS) || (m_nbWorkers != 0) )
+   {
+      return false;
+   }
+   memset(&m_ports[m_nbPorts], 0, sizeof(Port));
+   m_ports[m_nbPorts].pSfp = a_pSfp;
+   m_ports[m_nbPorts].controller = a_controller;
+   m_nbPorts++;
+   if ( !plan() )
+   {
+      m_nbPorts--;
+      plan();
+      return false;
+   }
+
+   // The presence changes are taken from the tracker only if all the SFPs share it
+   pTracker = a_pSfp->GetPresenceTracker(&presenceId);
+   if ( m_nbPorts == 1 )
+   {
+      m_pPresence = pTracker;
+   }
+   else if ( pTracker != m_pPresence )
+   {
+      m_pPresence = NULL;
+   }
+   if ( m_pPresence != NULL )
+   {
+      m_presenceIndex[presenceId] = m_nbPorts - 1;
+   }
+   m_bPresenceScan = true;
+   return true;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Get the number of SFPs
+
+   @return     Number of SFPs
+*/
+// ------------------------------------------------------------------------------------------------
+acd_uint32_t HalSfpGroup::GetPortCount()
+{
+   return m_nbPorts;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Get a SFP
+
+   @param [in]     a_index : SFP index, in the order they were added
+
+   @return     SFP, NULL if the index is invalid
+*/
+// ------------------------------------------------------------------------------------------------
+HalSfp* HalSfpGroup::GetPort(acd_uint32_t a_index)
+{
+   return (a_index < m_nbPorts) ? m_ports[a_index].pSfp : NULL;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Get the number of I2C controllers used by the SFPs
+
+   @return     Number of controllers
+*/
+// ------------------------------------------------------------------------------------------------
+acd_uint32_t HalSfpGroup::GetControllerCount()
+{
+   return m_nbControllers;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Start one worker thread per I2C controller
+
+   Poll() then sweeps the controllers in parallel. The singletons used to decode the SFPs are
+   created first, so the workers do not race to create them.
+
+   @return     true if successful
+*/
+// ------------------------------------------------------------------------------------------------
+bool HalSfpGroup::StartWorkers()
+{
+   if ( (m_nbWorkers != 0) || (m_nbControllers == 0) )
+   {
+      return false;
+   }
+
+   SfpModuleDescPool::GetInstance();
+   SfpDb::GetInstance();
+   m_bStop = false;
+   for(acd_uint32_t c = 0 ; c < m_nbControllers ; c++)
+   {
+      Worker* pWorker = &m_workers[c];
+
+      memset(&pWorker->sweep, 0, sizeof(pWorker->sweep));
+      pWorker->pGroup = this;
+      pWorker->controller = c;
+      pWorker->sweepId = m_sweepId;
+      if ( pthread_create(&pWorker->thread, NULL, workerMain, pWorker) != 0 )
+      {
+         StopWorkers();
+         return false;
+      }
+      m_nbWorkers++;
+   }
+   return true;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Stop the worker threads
+
+   Poll() then sweeps the controllers one after the other.
+*/
+// ------------------------------------------------------------------------------------------------
+void HalSfpGroup::StopWorkers()
+{
+   pthread_mutex_lock(&m_mutex);
+   m_bStop = true;
+   pthread_cond_broadcast(&m_startCond);
+   pthread_mutex_unlock(&m_mutex);
+
+   for(acd_uint32_t i = 0 ; i < m_nbWorkers ; i++)
+   {
+      pthread_join(m_workers[i].thread, NULL);
+   }
+   m_nbWorkers = 0;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Check if the controllers are swept in parallel
+
+   @return     true if the workers run
+*/
+// ------------------------------------------------------------------------------------------------
+bool HalSfpGroup::IsParallel()
+{
+   return m_nbWorkers != 0;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Set the adaptive polling policy
+
+   With a policy, the status is still read on each cycle but each SFP is updated only when its
+   interval elapsed, or right away when it is inserted. The policy is not owned by the group.
+
+   @param [in]     a_pPolicy : Polling policy, NULL to update all the SFPs on each cycle
+*/
+// ------------------------------------------------------------------------------------------------
+void HalSfpGroup::SetPollPolicy(SfpPollPolicy* a_pPolicy)
+{
+   m_pPolicy = a_pPolicy;
+   for(acd_uint32_t i = 0 ; i < m_nbPorts ; i++)
+   {
+      m_ports[i].nextPoll = 0;
+      if ( m_pPolicy != NULL )
+      {
+         m_pPolicy->Reset(m_ports[i].pollState);
+      }
+   }
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Build the initial inventory
+
+   Called once at startup, instead of the first Poll(). All the present SFPs are read, the
+   controllers in parallel even if the workers are not started. Each SFP publishes its data as
+   soon as it is read (see GetSnapshot() and GetDiscoveredCount()), so the inventory fills up
+   while the other SFPs are still being read. The time to the first SFP and to the full
+   inventory are kept in the statistics.
+
+   @return     true if the board status was read
+*/
+// ------------------------------------------------------------------------------------------------
+bool HalSfpGroup::Discover()
+{
+   bool bStarted = false;
+   bool bRet;
+
+   m_discoveryStart = sfpGetTimeUs();
+   m_nbDiscovered = 0;
+   m_stats.firstPortUs = 0;
+   m_stats.inventoryUs = 0;
+   for(acd_uint32_t i = 0 ; i < m_nbPorts ; i++)
+   {
+      // Read all the SFPs, as if they were just inserted
+      m_ports[i].bPresent = false;
+   }
+   m_bPresenceScan = true;
+   m_bCtrlSync = true;
+   if ( (m_nbWorkers == 0) && (m_nbControllers > 1) )
+   {
+      bStarted = StartWorkers();
+   }
+
+   m_bDiscovering = true;
+   bRet = Poll();
+   m_bDiscovering = false;
+
+   if ( bStarted )
+   {
+      StopWorkers();
+   }
+   m_stats.inventoryUs = sfpGetTimeUs() - m_discoveryStart;
+   m_stats.nbDiscovered = m_nbDiscovered;
+   return bRet;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Get the number of SFPs inventoried by Discover()
+
+   Can be called from any thread while Discover() runs.
+
+   @return     Number of SFPs
+*/
+// ------------------------------------------------------------------------------------------------
+acd_uint32_t HalSfpGroup::GetDiscoveredCount()
+{
+   return m_nbDiscovered;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Poll all the SFPs
+
+   Reads the board status once and checks the presence of the SFPs that changed since the last
+   cycle (of all the SFPs if they do not share a presence tracker), then for each present SFP,
+   updates the A0h data (only the identity is read while the module is unchanged, see
+   HalSfp::SetIdentityCache()) and the monitoring data. Should be called at the fastest interval
+   of the polling policy, if any.
+
+   The control register shadows (see SfpCtrlShadow) are read again on the first cycle and on the
+   first successful status read after a failure, in case the FPGA was reset in between.
+
+   @return     true if the board status was read
+*/
+// ------------------------------------------------------------------------------------------------
+bool HalSfpGroup::Poll()
+{
+   acd_uint64_t   start;
+   acd_uint64_t   t0;
+   acd_uint64_t   t1;
+   acd_uint64_t   stageUs[HalSfpGroupStageMax] = {0, 0, 0, 0};
+   acd_uint32_t   nbPresent = 0;
+   Sweep          total;
+   bool           bRet;
+
+   if ( m_nbPorts == 0 )
+   {
+      return false;
+   }
+
+   // The status is shared by all the SFPs of the board
+   start = sfpGetTimeUs();
+   bRet = m_ports[0].pSfp->RefreshStatus();
+   t0 = sfpGetTimeUs();
+   stageUs[HalSfpGroupStageStatus] = t0 - start;
+   if ( !bRet )
+   {
+      m_stats.nbStatusErrors++;
+      m_bCtrlSync = true;
+   }
+   else
+   {
+      if ( m_bCtrlSync )
+      {
+         m_bCtrlSync = !syncCtrl();
+      }
+
+      // Presence, no I2C access: only the SFPs reported changed by the tracker are checked
+      if ( (m_pPresence == NULL) || m_bPresenceScan )
+      {
+         if ( m_pPresence != NULL )
+         {
+            m_pPresence->TakeChanged();
+         }
+         m_bPresenceScan = false;
+         for(acd_uint32_t i = 0 ; i < m_nbPorts ; i++)
+         {
+            checkPresence(&m_ports[i], false);
+         }
+      }
+      else
+      {
+         acd_uint64_t changed = m_pPresence->TakeChanged();
+
+         while ( changed != 0 )
+         {
+            acd_uint32_t index = m_presenceIndex[__builtin_ctzll(changed)];
+
+            changed &= changed - 1;
+            if ( index < m_nbPorts )
+            {
+               checkPresence(&m_ports[index], true);
+            }
+         }
+      }
+
+      for(acd_uint32_t i = 0 ; i < m_nbPorts ; i++)
+      {
+         Port* pPort = &m_ports[i];
+
+         pPort->bDue = pPort->bPresent;
+         if ( !pPort->bPresent )
+         {
+            continue;
+         }
+         nbPresent++;
+         if ( (m_pPolicy != NULL) && pPort->bDataValid && (t0 < pPort->nextPoll) )
+         {
+            pPort->bDue = false;
+            m_stats.nbMonSkipped++;
+         }
+      }
+      t1 = sfpGetTimeUs();
+      stageUs[HalSfpGroupStagePresence] = t1 - t0;
+      t0 = t1;
+
+      // EEPROM updates, controller by controller
+      memset(&total, 0, sizeof(total));
+      if ( m_nbWorkers != 0 )
+      {
+         pthread_mutex_lock(&m_mutex);
+         m_pending = m_nbWorkers;
+         m_sweepId++;
+         pthread_cond_broadcast(&m_startCond);
+         while ( m_pending != 0 )
+         {
+            pthread_cond_wait(&m_doneCond, &m_mutex);
+         }
+         pthread_mutex_unlock(&m_mutex);
+
+         for(acd_uint32_t c = 0 ; c < m_nbWorkers ; c++)
+         {
+            const Sweep& result = m_workers[c].sweep;
+
+            total.dataUs       += result.dataUs;
+            total.monUs        += result.monUs;
+            total.nbDataErrors += result.nbDataErrors;
+            total.nbMonErrors  += result.nbMonErrors;
+            total.nbMonUpdates += result.nbMonUpdates;
+         }
+      }
+      else
+      {
+         for(acd_uint32_t c = 0 ; c < m_nbControllers ; c++)
+         {
+            sweep(c, total);
+         }
+      }
+      t0 = sfpGetTimeUs();
+
+      stageUs[HalSfpGroupStageData]       = total.dataUs;
+      stageUs[HalSfpGroupStageMonitoring] = total.monUs;
+      m_stats.nbDataErrors += total.nbDataErrors;
+      m_stats.nbMonErrors  += total.nbMonErrors;
+      m_stats.nbMonUpdates += total.nbMonUpdates;
+   }
+
+   m_stats.cycles++;
+   m_stats.nbPresent = nbPresent;
+   m_stats.lastCycleUs = t0 - start;
+   m_stats.totalCycleUs += m_stats.lastCycleUs;
+   if ( m_stats.lastCycleUs > m_stats.maxCycleUs )
+   {
+      m_stats.maxCycleUs = m_stats.lastCycleUs;
+   }
+   for(acd_uint32_t i = 0 ; i < HalSfpGroupStageMax ; i++)
+   {
+      m_stats.lastStageUs[i] = stageUs[i];
+      m_stats.totalStageUs[i] += stageUs[i];
+   }
+   return bRet;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Get a consistent copy of the memory published by a SFP
+
+   Can be called from any thread, even during a sweep.
+
+   @param [in]     a_index       : SFP index, in the order they were added
+   @param [out]    a_pages       : Copy of the pages
+   @param [out]    a_pGeneration : Publication number of the copy, optional
+
+   @return     true if successful
+*/
+// ------------------------------------------------------------------------------------------------
+bool HalSfpGroup::GetSnapshot(acd_uint32_t a_index, SfpPages& a_pages, acd_uint32_t* a_pGeneration)
+{
+   if ( a_index >= m_nbPorts )
+   {
+      return false;
+   }
+   return m_ports[a_index].pSfp->GetSnapshot(a_pages, a_pGeneration);
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Get the poll statistics
+
+   @param [out]    a_stats : Statistics
+*/
+// ------------------------------------------------------------------------------------------------
+void HalSfpGroup::GetStats(HalSfpGroupStats& a_stats)
+{
+   a_stats = m_stats;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Clear the poll statistics
+
+*/
+// ------------------------------------------------------------------------------------------------
+void HalSfpGroup::ClearStats()
+{
+   memset(&m_stats, 0, sizeof(m_stats));
+}
+
+// ================================================================================================
+// ================================================================================================
+//            PRIVATE CLASS SECTION
+// ================================================================================================
+// ================================================================================================
+// ------------------------------------------------------------------------------------------------
+/*!@brief Plan the sweep order
+
+   Groups the SFPs by I2C controller, keeping the order they were added within a controller.
+
+   @return     true if successful, false if there are too many controllers
+*/
+// ------------------------------------------------------------------------------------------------
+bool HalSfpGroup::plan()
+{
+   acd_uint32_t   nbPlanned = 0;
+   acd_uint32_t   nbControllers = 0;
+   bool           bPlanned[HAL_SFP_GROUP_MAX_PORTS];
+
+   memset(bPlanned, 0, sizeof(bPlanned));
+   for(acd_uint32_t i = 0 ; i < m_nbPorts ; i++)
+   {
+      if ( bPlanned[i] )
+      {
+         continue;
+      }
+      if ( nbControllers >= HAL_SFP_GROUP_MAX_CTRL )
+      {
+         return false;
+      }
+
+      // New controller, add all its SFPs
+      m_ctrlFirst[nbControllers] = nbPlanned;
+      for(acd_uint32_t j = i ; j < m_nbPorts ; j++)
+      {
+         if ( !bPlanned[j] && (m_ports[j].controller == m_ports[i].controller) )
+         {
+            m_order[nbPlanned++] = j;
+            bPlanned[j] = true;
+         }
+      }
+      m_ctrlCount[nbControllers] = nbPlanned - m_ctrlFirst[nbControllers];
+      nbControllers++;
+   }
+   m_nbControllers = nbControllers;
+   return true;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Check the presence of a SFP
+
+   An insertion or a removal resets the polling state, so the SFP is updated right away. A SFP
+   reported changed by the tracker but present as before was replaced between two cycles.
+
+   @param [in]     a_pPort    : SFP
+   @param [in]     a_bChanged : Reported changed by the presence tracker
+*/
+// ------------------------------------------------------------------------------------------------
+void HalSfpGroup::checkPresence(Port* a_pPort, bool a_bChanged)
+{
+   bool bPresent = a_pPort->pSfp->IsPresent();
+
+   if ( (bPresent == a_pPort->bPresent) && !a_bChanged )
+   {
+      return;
+   }
+   a_pPort->bPresent = bPresent;
+   a_pPort->nextPoll = 0;
+   if ( !bPresent )
+   {
+      a_pPort->bDataValid = false;
+   }
+   if ( m_pPolicy != NULL )
+   {
+      m_pPolicy->Reset(a_pPort->pollState);
+   }
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Read the control registers of the SFPs again
+
+   The shadows are shared by the SFPs of a register, each one is read once.
+
+   @return     true if all the registers were read
+*/
+// ------------------------------------------------------------------------------------------------
+bool HalSfpGroup::syncCtrl()
+{
+   bool bRet = true;
+
+   for(acd_uint32_t i = 0 ; i < m_nbPorts ; i++)
+   {
+      SfpCtrlShadow* pShadow = m_ports[i].pSfp->GetCtrlShadow();
+      bool           bDone = (pShadow == NULL);
+
+      for(acd_uint32_t j = 0 ; !bDone && (j < i) ; j++)
+      {
+         bDone = (m_ports[j].pSfp->GetCtrlShadow() == pShadow);
+      }
+      if ( !bDone && !pShadow->Sync() )
+      {
+         bRet = false;
+      }
+   }
+   return bRet;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Update the SFPs of a controller that are due
+
+   @param [in]     a_controller : Controller index
+   @param [in,out] a_sweep      : Accumulated results
+*/
+// ------------------------------------------------------------------------------------------------
+void HalSfpGroup::sweep(acd_uint32_t a_controller, Sweep& a_sweep)
+{
+   acd_uint64_t   t0 = sfpGetTimeUs();
+   acd_uint64_t   t1;
+
+   for(acd_uint32_t i = 0 ; i < m_ctrlCount[a_controller] ; i++)
+   {
+      Port* pPort = &m_ports[m_order[m_ctrlFirst[a_controller] + i]];
+
+      if ( !pPort->bDue )
+      {
+         continue;
+      }
+
+      pPort->bDataValid = pPort->pSfp->UpdateData();
+      t1 = sfpGetTimeUs();
+      a_sweep.dataUs += t1 - t0;
+      t0 = t1;
+      if ( !pPort->bDataValid )
+      {
+         a_sweep.nbDataErrors++;
+         continue;
+      }
+      if ( m_bDiscovering )
+      {
+         // The first SFP inventoried, by any worker, sets the time to first port
+         __sync_bool_compare_and_swap(&m_stats.firstPortUs, 0, t0 - m_discoveryStart);
+         __sync_fetch_and_add(&m_nbDiscovered, 1);
+      }
+
+      a_sweep.nbMonUpdates++;
+      if ( !pPort->pSfp->UpdateMonitoringData() )
+      {
+         a_sweep.nbMonErrors++;
+      }
+      else if ( m_pPolicy != NULL )
+      {
+         pPort->nextPoll = t0 + (acd_uint64_t)m_pPolicy->Evaluate(pPort->pSfp, pPort->pollState, t0) * 1000;
+      }
+      t1 = sfpGetTimeUs();
+      a_sweep.monUs += t1 - t0;
+      t0 = t1;
+   }
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Worker thread
+
+   Sweeps one controller each time Poll() starts a sweep.
+
+   @param [in]     a_pArg : Worker
+
+   @return     NULL
+*/
+// ------------------------------------------------------------------------------------------------
+void* HalSfpGroup::workerMain(void* a_pArg)
+{
+   Worker*        pWorker = (Worker*)a_pArg;
+   HalSfpGroup*   pGroup = pWorker->pGroup;
+
+   pthread_mutex_lock(&pGroup->m_mutex);
+   for(;;)
+   {
+      while ( !pGroup->m_bStop && (pGroup->m_sweepId == pWorker->sweepId) )
+      {
+         pthread_cond_wait(&pGroup->m_startCond, &pGroup->m_mutex);
+      }
+      if ( pGroup->m_bStop )
+      {
+         break;
+      }
+      pWorker->sweepId = pGroup->m_sweepId;
+      pthread_mutex_unlock(&pGroup->m_mutex);
+
+      memset(&pWorker->sweep, 0, sizeof(pWorker->sweep));
+      pGroup->sweep(pWorker->controller, pWorker->sweep);
+
+      pthread_mutex_lock(&pGroup->m_mutex);
+      if ( --pGroup->m_pending == 0 )
+      {
+         pthread_cond_signal(&pGroup->m_doneCond);
+      }
+   }
+   pthread_mutex_unlock(&pGroup->m_mutex);
+   return NULL;
+}
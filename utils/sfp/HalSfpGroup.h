@@ -0,0 +1,165 @@
+// ------------------------------------------------------------------------------------------------
+/* ACCEDIAN PROPRIETARY - www.accedian.com
+   COPYRIGHT (c) 2004-2014 BY ACCEDIAN CORPORATION. ALL RIGHTS RESERVED. NO PART OF THIS PROGRAM OR
+   PUBLICATION MAY BE REPRODUCED, TRANSMITTED, TRANSCRIBED, STORED IN A RETRIEVAL SYSTEM,
+   OR TRANSLATED INTO ANY LANGUAGE OR COMPUTER LANGUAGE IN ANY FORM OR BY ANY MEANS, ELECTRONIC,
+   MECHANICAL, MAGNETIC, OPTICAL, CHEMICAL, MANUAL, OR OTHERWISE, WITHOUT THE PRIOR WRITTEN
+   PERMISSION OF ACCEDIAN INC.
+*/
+// ------------------------------------------------------------------------------------------------
+/*!@file    HalSfpGroup.h
+   @brief   SFP group Hardware Abstraction Layer
+
+   This file contains the board level SFP group class definition
+*/
+// ------------------------------------------------------------------------------------------------
+#ifndef __HALSFPGROUP_H__
+#define __HALSFPGROUP_H__
+
+#include <pthread.h>
+#include "HalSfp.h"
+#include "SfpPollPolicy.h"
+#include "SfpPresence.h"
+
+#define HAL_SFP_GROUP_MAX_PORTS  64    // Maximum number of SFPs in a group
+#define HAL_SFP_GROUP_MAX_CTRL   16    // Maximum number of I2C controllers in a group
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief SFP group poll stages
+*/
+// ------------------------------------------------------------------------------------------------
+enum HalSfpGroupStage
+{
+   HalSfpGroupStageStatus = 0,   // Board status read, see HalSfp::RefreshStatus()
+   HalSfpGroupStagePresence,     // Presence check of the SFPs changed, see HalSfp::IsPresent()
+   HalSfpGroupStageData,         // A0h update, see HalSfp::UpdateData()
+   HalSfpGroupStageMonitoring,   // A2h update, see HalSfp::UpdateMonitoringData()
+   HalSfpGroupStageMax
+};
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief SFP group poll statistics
+
+   Times are in usec. With workers (see HalSfpGroup::StartWorkers()), the A0h and A2h stage times
+   are the sum of the times spent by all the workers, so they can exceed the cycle time.
+*/
+// ------------------------------------------------------------------------------------------------
+struct HalSfpGroupStats
+{
+   acd_uint32_t   cycles;                                // Number of poll cycles
+   acd_uint64_t   lastCycleUs;                           // Duration of the last cycle
+   acd_uint64_t   maxCycleUs;                            // Longest cycle
+   acd_uint64_t   totalCycleUs;                          // Duration of all the cycles
+   acd_uint64_t   lastStageUs[HalSfpGroupStageMax];      // Time spent in each stage, last cycle
+   acd_uint64_t   totalStageUs[HalSfpGroupStageMax];     // Time spent in each stage, all cycles
+   acd_uint32_t   nbPresent;                             // SFPs present on the last cycle
+   acd_uint32_t   nbDataErrors;                          // UpdateData() failures
+   acd_uint32_t   nbMonErrors;                           // UpdateMonitoringData() failures
+   acd_uint32_t   nbStatusErrors;                        // RefreshStatus() failures
+   acd_uint32_t   nbMonUpdates;                          // Monitoring updates
+   acd_uint32_t   nbMonSkipped;                          // Monitoring updates not due yet, see SetPollPolicy()
+   acd_uint64_t   firstPortUs;                           // Time from Discover() to the first SFP inventoried, 0 if none
+   acd_uint64_t   inventoryUs;                           // Time from Discover() to the full inventory
+   acd_uint32_t   nbDiscovered;                          // SFPs inventoried by the last Discover()
+};
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief SFP group Hardware Abstraction Layer
+
+   Owns all the SFPs of a board and polls them in one sweep: the board status, shared by all the
+   SFPs, is read once per cycle, then the SFPs are updated controller by controller so the I2C
+   accesses of a controller are not interleaved with the other ones.
+
+   The controllers can be swept in parallel by one worker thread each, see StartWorkers(). The
+   results are published by each SFP (see HalSfp::GetSnapshot()), readers never wait for a sweep.
+*/
+// ------------------------------------------------------------------------------------------------
+class HalSfpGroup
+{
+
+public:
+   HalSfpGroup();
+   virtual ~HalSfpGroup();
+
+   bool AddPort(HalSfp* a_pSfp, acd_uint32_t a_controller = 0);
+   acd_uint32_t GetPortCount();
+   HalSfp* GetPort(acd_uint32_t a_index);
+   acd_uint32_t GetControllerCount();
+
+   bool StartWorkers();
+   void StopWorkers();
+   bool IsParallel();
+
+   void SetPollPolicy(SfpPollPolicy* a_pPolicy);
+   bool Discover();
+   acd_uint32_t GetDiscoveredCount();
+   bool Poll();
+   bool GetSnapshot(acd_uint32_t a_index, SfpPages& a_pages, acd_uint32_t* a_pGeneration = NULL);
+
+   void GetStats(HalSfpGroupStats& a_stats);
+   void ClearStats();
+
+private:
+   struct Port
+   {
+      HalSfp*        pSfp;             // SFP, owned by the group
+      acd_uint32_t   controller;       // I2C controller identifier
+      bool           bDataValid;       // Last UpdateData() succeeded
+      bool           bPresent;         // Present on the last cycle
+      bool           bDue;             // To be updated on this cycle
+      acd_uint64_t   nextPoll;         // Time of the next monitoring update, see SetPollPolicy()
+      SfpPollState   pollState;        // Adaptive polling state
+   };
+
+   struct Sweep
+   {
+      acd_uint64_t   dataUs;           // Time spent in UpdateData()
+      acd_uint64_t   monUs;            // Time spent in UpdateMonitoringData()
+      acd_uint32_t   nbDataErrors;     // UpdateData() failures
+      acd_uint32_t   nbMonErrors;      // UpdateMonitoringData() failures
+      acd_uint32_t   nbMonUpdates;     // Monitoring updates
+   };
+
+   struct Worker
+   {
+      HalSfpGroup*   pGroup;           // Owner
+      acd_uint32_t   controller;       // Index of the controller swept, see m_ctrlFirst
+      pthread_t      thread;           // Worker thread
+      acd_uint32_t   sweepId;          // Last sweep started, see m_sweepId
+      Sweep          sweep;            // Result of the last sweep
+   };
+
+   bool plan();
+   void checkPresence(Port* a_pPort, bool a_bChanged);
+   bool syncCtrl();
+   void sweep(acd_uint32_t a_controller, Sweep& a_sweep);
+   static void* workerMain(void* a_pArg);
+
+   Port           m_ports[HAL_SFP_GROUP_MAX_PORTS];    // SFPs, in the order they were added
+   acd_uint32_t   m_nbPorts;                           // Number of SFPs
+   acd_uint8_t    m_order[HAL_SFP_GROUP_MAX_PORTS];    // Sweep order, grouped by controller
+   acd_uint32_t   m_nbControllers;                     // Number of I2C controllers
+   acd_uint8_t    m_ctrlFirst[HAL_SFP_GROUP_MAX_CTRL]; // First m_order entry of each controller
+   acd_uint8_t    m_ctrlCount[HAL_SFP_GROUP_MAX_CTRL]; // Number of SFPs of each controller
+   HalSfpGroupStats m_stats;                           // Poll statistics
+   SfpPollPolicy* m_pPolicy;                           // Adaptive polling policy, NULL to update on each cycle
+   SfpPresenceTracker* m_pPresence;                    // Presence tracker shared by all the SFPs, NULL if none
+   acd_uint8_t    m_presenceIndex[SFP_PRESENCE_MAX_PORTS]; // SFP of each tracker port identifier
+   bool           m_bPresenceScan;                     // Check all the SFPs on the next cycle
+   bool           m_bCtrlSync;                         // Read the control registers on the next cycle
+
+   Worker         m_workers[HAL_SFP_GROUP_MAX_CTRL];   // One worker per controller
+   acd_uint32_t   m_nbWorkers;                         // Number of workers running
+   pthread_mutex_t m_mutex;                            // Protects the worker synchronization
+   pthread_cond_t m_startCond;                         // Signaled when a sweep starts
+   pthread_cond_t m_doneCond;                          // Signaled when the last worker is done
+   acd_uint32_t   m_sweepId;                           // Sweep number, incremented to start a sweep
+   acd_uint32_t   m_pending;                           // Workers still sweeping
+   bool           m_bStop;                             // Workers must exit
+
+   volatile bool  m_bDiscovering;                      // Discover() in progress
+   acd_uint64_t   m_discoveryStart;                    // Time Discover() started
+   volatile acd_uint32_t m_nbDiscovered;               // SFPs inventoried since Discover() started
+};
+
+#endif // #ifndef __HALSFPGROUP_H__
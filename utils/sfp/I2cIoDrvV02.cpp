@@ -16,10 +16,16 @@
 #include <string.h>
 
 #include "I2cIoDrvV02.h"
+#include "SfpProbe.h"
+#include "SfpLog.h"
 #include <accedian/acclib/Logger.h>
 #include <accedian/acclib/acd_utils.h>
 
 pthread_mutex_t I2cIoDrvV02::s_mutex = PTHREAD_MUTEX_INITIALIZER;
+I2cIoDrvStats I2cIoDrvV02::s_stats;
+pthread_mutex_t I2cIoDrvV02::s_lockMutex = PTHREAD_MUTEX_INITIALIZER;
+I2cIoDrvV02::ControllerLock I2cIoDrvV02::s_locks[I2C_MAX_CONTROLLERS];
+acd_uint32_t I2cIoDrvV02::s_nbLocks = 0;
 
 // ================================================================================================
 // ================================================================================================
@@ -42,8 +48,8 @@ m_pIoBase(a_pIoBase),
 m_pLogger(NULL),
 m_baseAddress(a_baseAddress)
 {
-   m_pLogger = new Logger(a_name);
-   m_pLogger->SetDebug(false);
+   m_pLogger = SfpLoggerRegistry::GetInstance()->Acquire(a_name);
+   m_pMutex = getControllerMutex(a_baseAddress, m_pStats);
 }
 
 // ------------------------------------------------------------------------------------------------
@@ -53,12 +59,16 @@ m_baseAddress(a_baseAddress)
 // ------------------------------------------------------------------------------------------------
 I2cIoDrvV02::~I2cIoDrvV02()
 {
-   delete m_pLogger;
+   SfpLoggerRegistry::GetInstance()->Release(m_pLogger);
 }
 
 // ------------------------------------------------------------------------------------------------
 /*!@brief Read a set of contiguous registers
 
+   The I2C device address is given in bits 0-7 of a_reg and the first byte offset to read within
+   the device memory in bits 8-15 (see I2C_REG_OFF_SHIFT). A plain device address reads from
+   offset 0.
+
    @param [in]     a_reg         : Register offset
    @param [in]     a_nbr         : Number of registers to read
    @param [out]    a_data        : Register(s) content
@@ -71,18 +81,22 @@ bool I2cIoDrvV02::Read(acd_uint32_t a_reg, acd_uint32_t a_nbr, acd_uint8_t* a_da
 {
    I2cControlReg_t   control;
    acd_uint64_t      data[I2C_DATA_SIZE];
+   acd_uint32_t      dev = a_reg & I2C_REG_DEV_MASK;
+   acd_uint32_t      off = (a_reg >> I2C_REG_OFF_SHIFT) & I2C_REG_DEV_MASK;
 
    //m_pLogger->LogDebug("Read(%08xh, %d)", a_reg, a_nbr);
-   if ( a_nbr > (I2C_DATA_SIZE * sizeof(acd_uint64_t)) )
+   if ( (a_nbr == 0) || (a_nbr > (I2C_DATA_SIZE * sizeof(acd_uint64_t))) )
    {
       return false;
    }
 
    lock();
+   m_pStats->reads++;
 
    // Select I2C device & memory region to address
-   if ( !select(a_reg, 0) )
+   if ( !select(dev, off) )
    {
+      m_pStats->ioErrors++;
       unlock();
       return false;
    }
@@ -93,11 +107,13 @@ bool I2cIoDrvV02::Read(acd_uint32_t a_reg, acd_uint32_t a_nbr, acd_uint8_t* a_da
    control.start    = 1;
    control.stop     = 1;
    control.length   = a_nbr - 1;
-   control.address  = a_reg>>1;
+   control.address  = dev>>1;
 
    // Send read command
+   SFP_PROBE4(i2c_cmd, m_baseAddress, dev, off, a_nbr);
    if ( !m_pIoBase->Write(m_baseAddress + I2C_CONTROL_REG, 1, &control.value, true) )
    {
+      m_pStats->ioErrors++;
       unlock();
       return false;
    }
@@ -112,6 +128,7 @@ bool I2cIoDrvV02::Read(acd_uint32_t a_reg, acd_uint32_t a_nbr, acd_uint8_t* a_da
    if ( !m_pIoBase->Read(m_baseAddress + I2C_DATA_REG, I2C_DATA_SIZE, data) )
    {
       m_pLogger->LogDebug("I2C read I/O error");
+      m_pStats->ioErrors++;
       unlock();
       return false;
    }
@@ -141,6 +158,8 @@ bool I2cIoDrvV02::Read(acd_uint32_t a_reg, acd_uint8_t& a_data, bool a_bCheckSta
 // ------------------------------------------------------------------------------------------------
 /*!@brief Write a set of contiguous registers
 
+   The register offset is encoded as for Read(), each byte is written at the next byte offset.
+
    @param [in]     a_reg         : Register offset
    @param [in]     a_nbr         : Number of registers to write
    @param [in]     a_data        : Values to write
@@ -155,10 +174,13 @@ bool I2cIoDrvV02::Write(
     acd_uint8_t*    a_data,
     bool            a_bCheckState)
 {
+   acd_uint32_t   dev = a_reg & I2C_REG_DEV_MASK;
+   acd_uint32_t   off = (a_reg >> I2C_REG_OFF_SHIFT) & I2C_REG_DEV_MASK;
+
    // Write 1 byte at a time
    for(acd_uint32_t i = 0 ; i < a_nbr ; i++)
    {
-      if ( !Write(a_reg + i, a_data[i], a_bCheckState) )
+      if ( !Write(((off + i) << I2C_REG_OFF_SHIFT) | dev, a_data[i], a_bCheckState) )
       {
          return false;
       }
@@ -169,7 +191,9 @@ bool I2cIoDrvV02::Write(
 // ------------------------------------------------------------------------------------------------
 /*!@brief Write a value to a register
 
-   @param [in]     a_reg         : Register offset
+   The byte offset and the value are sent in a single I2C write transaction.
+
+   @param [in]     a_reg         : Register offset, see Read()
    @param [in]     a_data        : Value to write
    @param [in]     a_bCheckState : Flag to check the driver state before performing the access
 
@@ -181,34 +205,50 @@ bool I2cIoDrvV02::Write(
     acd_uint8_t     a_data,
     bool            a_bCheckState)
 {
+   I2cSelectReg_t    sel;
    I2cControlReg_t   control;
+   acd_uint64_t      data[2];
+   acd_uint32_t      dev = a_reg & I2C_REG_DEV_MASK;
+   acd_uint32_t      off = (a_reg >> I2C_REG_OFF_SHIFT) & I2C_REG_DEV_MASK;
 
    lock();
+   m_pStats->writes++;
 
-   // Select I2C device & memory region to address
-   if ( !select(a_reg, 0) )
+   if ( !m_pIoBase->IsReady() )
    {
+      m_pStats->ioErrors++;
       unlock();
       return false;
    }
 
+   sel.value = 0;
+   sel.i2c_sel = m_baseAdd;
+
+   // Byte offset followed by the value
    control.value    = 0;
    control.command  = eI2C_CMD_WR;
    control.start    = 1;
    control.stop     = 1;
-   control.length   = 0;   // 1 byte
-   control.address  = a_reg;
-   control.wrdata   = a_data << 24;
+   control.length   = 1;   // 2 bytes
+   control.address  = dev >> 1;
+   control.wrdata   = (off << 24) | (a_data << 16);
 
    // Send write command
-   if ( m_pIoBase->Write(m_baseAddress + I2C_CONTROL_REG, 1, &control.value, true) )
+   data[0] = sel.value;
+   data[1] = control.value;
+   SFP_PROBE4(i2c_cmd, m_baseAddress, dev, off, 1);
+   if ( !m_pIoBase->Write(m_baseAddress + I2C_SELECT_REG, 2, data, true) )
    {
-      // Pool for read completion, error or timeout
-      if ( !waitbusy(10) )
-      {
-         unlock();
-         return false;
-      }
+      m_pStats->ioErrors++;
+      unlock();
+      return false;
+   }
+
+   // Pool for write completion, error or timeout
+   if ( !waitbusy(10) )
+   {
+      unlock();
+      return false;
    }
 
    unlock();
@@ -253,8 +293,10 @@ bool I2cIoDrvV02::select(acd_uint32_t a_reg, acd_uint32_t a_off)
    if ( !m_pIoBase->Write(m_baseAddress + I2C_SELECT_REG, 2, data, true) )
    {
       //m_pLogger->LogDebug("Failed to select memory region %02xh", a_reg);
+      SFP_PROBE4(i2c_select, m_baseAddress, a_reg, a_off, 0);
       return false;
    }
+   SFP_PROBE4(i2c_select, m_baseAddress, a_reg, a_off, 1);
    return true;
 }
 
@@ -280,14 +322,20 @@ bool I2cIoDrvV02::waitbusy(acd_uint32_t a_timeoutMs)
       if ( status.status > 1 )
       {
          m_pLogger->LogDebug("I2C error status %d", (int)status.status);
+         m_pStats->busErrors++;
+         SFP_PROBE4(i2c_waitbusy, m_baseAddress, status.status, timeout, 0);
          return false;
       }
    }while( (status.status == 1) && (timeout++ < 10) );
-   if ( timeout == 10 )
+   if ( status.status == 1 )
    {
+      // Still busy after the last retry
       m_pLogger->LogDebug("I2C read timeout");
+      m_pStats->timeouts++;
+      SFP_PROBE4(i2c_waitbusy, m_baseAddress, status.status, timeout, 0);
       return false;
    }
+   SFP_PROBE4(i2c_waitbusy, m_baseAddress, status.status, timeout, 1);
    return true;
 }
 
@@ -299,7 +347,8 @@ bool I2cIoDrvV02::waitbusy(acd_uint32_t a_timeoutMs)
 // ------------------------------------------------------------------------------------------------
 bool I2cIoDrvV02::lock()
 {
-   pthread_mutex_lock(&s_mutex);
+   pthread_mutex_lock(m_pMutex);
+   SFP_PROBE1(i2c_lock, m_baseAddress);
    return true;
 }
 
@@ -311,6 +360,102 @@ bool I2cIoDrvV02::lock()
 // ------------------------------------------------------------------------------------------------
 bool I2cIoDrvV02::unlock()
 {
-   pthread_mutex_unlock(&s_mutex);
+   SFP_PROBE1(i2c_unlock, m_baseAddress);
+   pthread_mutex_unlock(m_pMutex);
+   return true;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Get the controller base address
+
+   SFPs on different controllers can be accessed in parallel.
+
+   @return     I2C base address
+*/
+// ------------------------------------------------------------------------------------------------
+acd_uint32_t I2cIoDrvV02::GetBaseAddress()
+{
+   return m_baseAddress;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Get the number of controllers with their own lock and statistics
+
+   @return     Number of controllers, see GetControllerStats()
+*/
+// ------------------------------------------------------------------------------------------------
+acd_uint32_t I2cIoDrvV02::GetControllerCount()
+{
+   return *(volatile acd_uint32_t*)&s_nbLocks;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Get the statistics of a controller
+
+   The statistics are read without taking the controller lock, so a transaction in progress is
+   never delayed. A counter can be one transaction behind.
+
+   @param [in]     a_index       : Controller index, 0 to GetControllerCount() - 1
+   @param [out]    a_baseAddress : Controller base address
+   @param [out]    a_stats       : Controller statistics
+
+   @return     true if successful, false if the index is out of range
+*/
+// ------------------------------------------------------------------------------------------------
+bool I2cIoDrvV02::GetControllerStats(acd_uint32_t a_index, acd_uint32_t& a_baseAddress, I2cIoDrvStats& a_stats)
+{
+   if ( a_index >= GetControllerCount() )
+   {
+      return false;
+   }
+   a_baseAddress = s_locks[a_index].baseAddress;
+   a_stats = s_locks[a_index].stats;
    return true;
 }
+
+// ================================================================================================
+// ================================================================================================
+//            PRIVATE CLASS SECTION
+// ================================================================================================
+// ================================================================================================
+// ------------------------------------------------------------------------------------------------
+/*!@brief Get the lock of a controller
+
+   All the drivers of a controller (one per SFP) share the same lock and statistics. The
+   controllers beyond I2C_MAX_CONTROLLERS share a common lock and statistics.
+
+   @param [in]     a_baseAddress : I2C base address
+   @param [out]    a_pStats      : Controller statistics
+
+   @return     Controller lock
+*/
+// ------------------------------------------------------------------------------------------------
+pthread_mutex_t* I2cIoDrvV02::getControllerMutex(acd_uint32_t a_baseAddress, I2cIoDrvStats*& a_pStats)
+{
+   pthread_mutex_t* pMutex = &s_mutex;
+
+   a_pStats = &s_stats;
+   pthread_mutex_lock(&s_lockMutex);
+   for(acd_uint32_t i = 0 ; i < s_nbLocks ; i++)
+   {
+      if ( s_locks[i].baseAddress == a_baseAddress )
+      {
+         pMutex = &s_locks[i].mutex;
+         a_pStats = &s_locks[i].stats;
+         break;
+      }
+   }
+   if ( (pMutex == &s_mutex) && (s_nbLocks < I2C_MAX_CONTROLLERS) )
+   {
+      s_locks[s_nbLocks].baseAddress = a_baseAddress;
+      pthread_mutex_init(&s_locks[s_nbLocks].mutex, NULL);
+      memset(&s_locks[s_nbLocks].stats, 0, sizeof(s_locks[s_nbLocks].stats));
+      pMutex = &s_locks[s_nbLocks].mutex;
+      a_pStats = &s_locks[s_nbLocks].stats;
+      // Entry complete before it is counted, GetControllerStats() does not take s_lockMutex
+      __sync_synchronize();
+      s_nbLocks++;
+   }
+   pthread_mutex_unlock(&s_lockMutex);
+   return pMutex;
+}
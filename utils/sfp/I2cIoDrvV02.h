@@ -26,6 +26,21 @@
 
 class Logger;
 
+// ------------------------------------------------------------------------------------------------
+/*!@brief I2C controller statistics
+
+   Updated under the controller lock, read without it (see I2cIoDrvV02::GetControllerStats()).
+*/
+// ------------------------------------------------------------------------------------------------
+struct I2cIoDrvStats
+{
+   acd_uint32_t   reads;            // Read transactions
+   acd_uint32_t   writes;           // Write transactions
+   acd_uint32_t   ioErrors;         // Controller register access failures
+   acd_uint32_t   busErrors;        // Transactions completed with an error status
+   acd_uint32_t   timeouts;         // Transactions still busy after the timeout
+};
+
 // ------------------------------------------------------------------------------------------------
 /*!@brief I2C I/O driver
 
@@ -47,6 +62,10 @@ public:
    bool waitbusy(acd_uint32_t a_timeoutMs);
    bool lock();
    bool unlock();
+   acd_uint32_t GetBaseAddress();
+
+   static acd_uint32_t GetControllerCount();
+   static bool GetControllerStats(acd_uint32_t a_index, acd_uint32_t& a_baseAddress, I2cIoDrvStats& a_stats);
 
    static const acd_uint32_t I2C_SELECT_REG    = 0x00;
    static const acd_uint32_t I2C_CONTROL_REG   = 0x01;
@@ -54,6 +73,10 @@ public:
    static const acd_uint32_t I2C_DATA_REG      = 0x10;
    static const acd_uint32_t I2C_DATA_SIZE     = 0x10;
 
+   static const acd_uint32_t I2C_REG_DEV_MASK  = 0xFF;   // Device address in a register offset
+   static const acd_uint32_t I2C_REG_OFF_SHIFT = 8;      // Byte offset in a register offset
+   static const acd_uint32_t I2C_MAX_CONTROLLERS = 16;   // Controllers with their own lock
+
    enum I2cLen
    {
       eI2C_LEN_1BYTE = 0,
@@ -126,11 +149,25 @@ public:
    };
 
 private:
+   static pthread_mutex_t* getControllerMutex(acd_uint32_t a_baseAddress, I2cIoDrvStats*& a_pStats);
+
+   struct ControllerLock
+   {
+      acd_uint32_t      baseAddress;   // Controller base address
+      pthread_mutex_t   mutex;         // Controller lock
+      I2cIoDrvStats     stats;         // Controller statistics
+   };
 
    BaseIoDrv<acd_uint64_t>*   m_pIoBase;
    Logger*                    m_pLogger;
    acd_uint32_t               m_baseAddress;
-   static pthread_mutex_t     s_mutex;
+   pthread_mutex_t*           m_pMutex;      // Lock of the controller, shared by its SFPs
+   I2cIoDrvStats*             m_pStats;      // Statistics of the controller, shared by its SFPs
+   static pthread_mutex_t     s_mutex;       // Lock of the controllers without their own lock
+   static I2cIoDrvStats       s_stats;       // Statistics of the controllers without their own lock
+   static pthread_mutex_t     s_lockMutex;   // Protects s_locks
+   static ControllerLock      s_locks[I2C_MAX_CONTROLLERS];
+   static acd_uint32_t        s_nbLocks;
 };
 
 #endif   // __I2CIODRVV02_H__
@@ -0,0 +1,358 @@
+// ------------------------------------------------------------------------------------------------
+/* ACCEDIAN PROPRIETARY - www.accedian.com
+   COPYRIGHT (c) 2004-2014 BY ACCEDIAN CORPORATION. ALL RIGHTS RESERVED. NO PART OF THIS PROGRAM OR
+   PUBLICATION MAY BE REPRODUCED, TRANSMITTED, TRANSCRIBED, STORED IN A RETRIEVAL SYSTEM,
+   OR TRANSLATED INTO ANY LANGUAGE OR COMPUTER LANGUAGE IN ANY FORM OR BY ANY MEANS, ELECTRONIC,
+   MECHANICAL, MAGNETIC, OPTICAL, CHEMICAL, MANUAL, OR OTHERWISE, WITHOUT THE PRIOR WRITTEN
+   PERMISSION OF ACCEDIAN INC.
+*/
+// ------------------------------------------------------------------------------------------------
+/*!@file    SfpAlarm.cpp
+   @brief   SFP software alarms
+
+   This file contains the SFP alarm engine class
+
+*/
+// ------------------------------------------------------------------------------------------------
+
+#include "SfpAlarm.h"
+#include "SfpTime.h"
+
+// ================================================================================================
+// ================================================================================================
+//            PUBLIC CLASS SECTION
+// ================================================================================================
+// ================================================================================================
+// ------------------------------------------------------------------------------------------------
+/*!@brief Constructor
+
+*/
+// ------------------------------------------------------------------------------------------------
+SfpAlarmEngine::SfpAlarmEngine() :
+m_holdOff(1),
+m_nbSet(0),
+m_eventCount(0),
+m_pListener(NULL)
+{
+   memset(m_threshold, 0, sizeof(m_threshold));
+   memset(m_hysteresis, 0, sizeof(m_hysteresis));
+   pthread_mutex_init(&m_mutex, NULL);
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Destructor
+
+*/
+// ------------------------------------------------------------------------------------------------
+SfpAlarmEngine::~SfpAlarmEngine()
+{
+   pthread_mutex_destroy(&m_mutex);
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Set a user threshold
+
+   @param [in]     a_param  : Parameter
+   @param [in]     a_id     : Threshold identifier
+   @param [in]     a_value  : Threshold value in the units of the matching HalSfp getter
+
+   @return     true if successful
+*/
+// ------------------------------------------------------------------------------------------------
+bool SfpAlarmEngine::SetThreshold(SfpDdmParam a_param, HalSfpThresholdId a_id, acd_int32_t a_value)
+{
+   if ( (a_param >= SfpDdmParamMax) || (a_id >= HalSfpThresholdMax) )
+   {
+      return false;
+   }
+
+   pthread_mutex_lock(&m_mutex);
+   Threshold& th = m_threshold[a_param][a_id];
+   if ( !th.bSet )
+   {
+      th.bSet = true;
+      m_nbSet++;
+   }
+   th.value = a_value;
+   pthread_mutex_unlock(&m_mutex);
+   return true;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Get a user threshold
+
+   @param [in]     a_param  : Parameter
+   @param [in]     a_id     : Threshold identifier
+   @param [out]    a_value  : Threshold value
+
+   @return     true if the threshold is set
+*/
+// ------------------------------------------------------------------------------------------------
+bool SfpAlarmEngine::GetThreshold(SfpDdmParam a_param, HalSfpThresholdId a_id, acd_int32_t& a_value)
+{
+   bool bRet;
+
+   if ( (a_param >= SfpDdmParamMax) || (a_id >= HalSfpThresholdMax) )
+   {
+      return false;
+   }
+
+   pthread_mutex_lock(&m_mutex);
+   bRet = m_threshold[a_param][a_id].bSet;
+   if ( bRet )
+   {
+      a_value = m_threshold[a_param][a_id].value;
+   }
+   pthread_mutex_unlock(&m_mutex);
+   return bRet;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Remove a user threshold
+
+   An active alarm on this threshold is dropped without a clear event.
+
+   @param [in]     a_param  : Parameter
+   @param [in]     a_id     : Threshold identifier
+
+   @return     true if successful
+*/
+// ------------------------------------------------------------------------------------------------
+bool SfpAlarmEngine::ClearThreshold(SfpDdmParam a_param, HalSfpThresholdId a_id)
+{
+   if ( (a_param >= SfpDdmParamMax) || (a_id >= HalSfpThresholdMax) )
+   {
+      return false;
+   }
+
+   pthread_mutex_lock(&m_mutex);
+   Threshold& th = m_threshold[a_param][a_id];
+   if ( th.bSet )
+   {
+      m_nbSet--;
+   }
+   memset(&th, 0, sizeof(th));
+   pthread_mutex_unlock(&m_mutex);
+   return true;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Set the hysteresis of a parameter
+
+   @param [in]     a_param      : Parameter
+   @param [in]     a_hysteresis : Hysteresis in the parameter units
+
+   @return     true if successful
+*/
+// ------------------------------------------------------------------------------------------------
+bool SfpAlarmEngine::SetHysteresis(SfpDdmParam a_param, acd_int32_t a_hysteresis)
+{
+   if ( (a_param >= SfpDdmParamMax) || (a_hysteresis < 0) )
+   {
+      return false;
+   }
+   pthread_mutex_lock(&m_mutex);
+   m_hysteresis[a_param] = a_hysteresis;
+   pthread_mutex_unlock(&m_mutex);
+   return true;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Set the hold-off
+
+   @param [in]     a_samples : Number of consecutive samples needed to raise or clear an alarm
+*/
+// ------------------------------------------------------------------------------------------------
+void SfpAlarmEngine::SetHoldOff(acd_uint32_t a_samples)
+{
+   pthread_mutex_lock(&m_mutex);
+   m_holdOff = (a_samples == 0) ? 1 : a_samples;
+   pthread_mutex_unlock(&m_mutex);
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Set the alarm listener
+
+   @param [in]     a_pListener : Listener notified of the alarm events, NULL for none
+*/
+// ------------------------------------------------------------------------------------------------
+void SfpAlarmEngine::SetListener(SfpAlarmListener* a_pListener)
+{
+   m_pListener = a_pListener;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Check if any user threshold is set
+
+   @return     true if at least one threshold is set
+*/
+// ------------------------------------------------------------------------------------------------
+bool SfpAlarmEngine::IsArmed()
+{
+   return m_nbSet != 0;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Check if an alarm is active
+
+   @param [in]     a_param  : Parameter
+   @param [in]     a_id     : Threshold identifier
+
+   @return     true if the threshold is crossed
+*/
+// ------------------------------------------------------------------------------------------------
+bool SfpAlarmEngine::IsActive(SfpDdmParam a_param, HalSfpThresholdId a_id)
+{
+   if ( (a_param >= SfpDdmParamMax) || (a_id >= HalSfpThresholdMax) )
+   {
+      return false;
+   }
+   return m_threshold[a_param][a_id].bActive;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Get the number of events published
+
+   @return     Number of events
+*/
+// ------------------------------------------------------------------------------------------------
+acd_uint32_t SfpAlarmEngine::GetEventCount()
+{
+   return m_eventCount;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Compare the monitoring values to the user thresholds
+
+   @param [in]     a_pSfp    : SFP reported in the events
+   @param [in]     a_values  : Converted values indexed by SfpDdmParam
+*/
+// ------------------------------------------------------------------------------------------------
+void SfpAlarmEngine::Evaluate(HalSfp* a_pSfp, const acd_int32_t a_values[SfpDdmParamMax])
+{
+   SfpAlarmEvent  events[SfpDdmParamMax * HalSfpThresholdMax];
+   acd_uint32_t   nbEvents = 0;
+
+   pthread_mutex_lock(&m_mutex);
+   for(acd_uint32_t p = 0 ; p < SfpDdmParamMax ; p++)
+   {
+      for(acd_uint32_t id = 0 ; id < HalSfpThresholdMax ; id++)
+      {
+         Threshold&  th = m_threshold[p][id];
+         bool        bHigh;
+         bool        bCrossed;
+         acd_int32_t limit;
+
+         if ( !th.bSet )
+         {
+            continue;
+         }
+
+         // An active alarm stays active until the value leaves the hysteresis band
+         bHigh = (id == HalSfpThresholdHighAlarm) || (id == HalSfpThresholdHighWarning);
+         if ( bHigh )
+         {
+            limit = th.bActive ? (th.value - m_hysteresis[p]) : th.value;
+            bCrossed = a_values[p] > limit;
+         }
+         else
+         {
+            limit = th.bActive ? (th.value + m_hysteresis[p]) : th.value;
+            bCrossed = a_values[p] < limit;
+         }
+
+         if ( bCrossed == th.bActive )
+         {
+            th.count = 0;
+         }
+         else if ( ++th.count >= m_holdOff )
+         {
+            th.bActive = bCrossed;
+            th.count = 0;
+            addEvent(events, nbEvents, (SfpDdmParam)p, (HalSfpThresholdId)id, a_values[p]);
+         }
+      }
+   }
+   pthread_mutex_unlock(&m_mutex);
+   publish(a_pSfp, events, nbEvents);
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Clear all the active alarms
+
+   Called when the monitoring values are no longer valid (ex: SFP removed)
+
+   @param [in]     a_pSfp    : SFP reported in the events
+*/
+// ------------------------------------------------------------------------------------------------
+void SfpAlarmEngine::Reset(HalSfp* a_pSfp)
+{
+   SfpAlarmEvent  events[SfpDdmParamMax * HalSfpThresholdMax];
+   acd_uint32_t   nbEvents = 0;
+
+   pthread_mutex_lock(&m_mutex);
+   for(acd_uint32_t p = 0 ; p < SfpDdmParamMax ; p++)
+   {
+      for(acd_uint32_t id = 0 ; id < HalSfpThresholdMax ; id++)
+      {
+         Threshold& th = m_threshold[p][id];
+
+         th.count = 0;
+         if ( th.bActive )
+         {
+            th.bActive = false;
+            addEvent(events, nbEvents, (SfpDdmParam)p, (HalSfpThresholdId)id, 0);
+         }
+      }
+   }
+   pthread_mutex_unlock(&m_mutex);
+   publish(a_pSfp, events, nbEvents);
+}
+
+// ================================================================================================
+// ================================================================================================
+//            PRIVATE CLASS SECTION
+// ================================================================================================
+// ================================================================================================
+// ------------------------------------------------------------------------------------------------
+/*!@brief Record an alarm transition, mutex taken
+
+   @param [out]    a_pEvents  : Events to publish
+   @param [in,out] a_nbEvents : Number of events
+   @param [in]     a_param    : Parameter
+   @param [in]     a_id       : Threshold identifier
+   @param [in]     a_value    : Parameter value
+*/
+// ------------------------------------------------------------------------------------------------
+void SfpAlarmEngine::addEvent(SfpAlarmEvent* a_pEvents, acd_uint32_t& a_nbEvents, SfpDdmParam a_param, HalSfpThresholdId a_id, acd_int32_t a_value)
+{
+   SfpAlarmEvent& event = a_pEvents[a_nbEvents++];
+
+   m_eventCount++;
+   event.param       = a_param;
+   event.thresholdId = a_id;
+   event.bRaised     = m_threshold[a_param][a_id].bActive;
+   event.value       = a_value;
+   event.threshold   = m_threshold[a_param][a_id].value;
+   event.timestamp   = sfpGetTimeUs();
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Notify the listener of the alarm transitions
+
+   Called once the mutex is released, so the listener can change the thresholds.
+
+   @param [in]     a_pSfp     : SFP reported in the events
+   @param [in]     a_pEvents  : Events
+   @param [in]     a_nbEvents : Number of events
+*/
+// ------------------------------------------------------------------------------------------------
+void SfpAlarmEngine::publish(HalSfp* a_pSfp, const SfpAlarmEvent* a_pEvents, acd_uint32_t a_nbEvents)
+{
+   SfpAlarmListener* pListener = m_pListener;
+
+   for(acd_uint32_t i = 0 ; (i < a_nbEvents) && (pListener != NULL) ; i++)
+   {
+      pListener->OnSfpAlarm(a_pSfp, a_pEvents[i]);
+   }
+}
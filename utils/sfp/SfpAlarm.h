@@ -0,0 +1,107 @@
+// ------------------------------------------------------------------------------------------------
+/* ACCEDIAN PROPRIETARY - www.accedian.com
+   COPYRIGHT (c) 2004-2014 BY ACCEDIAN CORPORATION. ALL RIGHTS RESERVED. NO PART OF THIS PROGRAM OR
+   PUBLICATION MAY BE REPRODUCED, TRANSMITTED, TRANSCRIBED, STORED IN A RETRIEVAL SYSTEM,
+   OR TRANSLATED INTO ANY LANGUAGE OR COMPUTER LANGUAGE IN ANY FORM OR BY ANY MEANS, ELECTRONIC,
+   MECHANICAL, MAGNETIC, OPTICAL, CHEMICAL, MANUAL, OR OTHERWISE, WITHOUT THE PRIOR WRITTEN
+   PERMISSION OF ACCEDIAN INC.
+*/
+// ------------------------------------------------------------------------------------------------
+/*!@file    SfpAlarm.h
+   @brief   SFP software alarms
+
+   This file contains the SFP alarm engine class definition
+*/
+// ------------------------------------------------------------------------------------------------
+#ifndef __SFPALARM_H__
+#define __SFPALARM_H__
+
+#include <pthread.h>
+#include "HalSfp.h"
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief SFP alarm event
+
+   Reported when a parameter crosses a user threshold
+*/
+// ------------------------------------------------------------------------------------------------
+struct SfpAlarmEvent
+{
+   SfpDdmParam          param;         // Parameter
+   HalSfpThresholdId    thresholdId;   // Threshold crossed
+   bool                 bRaised;       // true when raised, false when cleared
+   acd_int32_t          value;         // Parameter value
+   acd_int32_t          threshold;     // Threshold value
+   acd_uint64_t         timestamp;     // Monotonic time in usec
+};
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief SFP alarm listener
+
+   Interface implemented by the alarm consumers
+*/
+// ------------------------------------------------------------------------------------------------
+class SfpAlarmListener
+{
+public:
+   virtual ~SfpAlarmListener() {}
+   virtual void OnSfpAlarm(HalSfp* a_pSfp, const SfpAlarmEvent& a_event) = 0;
+};
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief SFP alarm engine
+
+   This class keeps the user thresholds of one port in converted units and compares them to the
+   monitoring values on each refresh.
+
+   A high threshold is raised when the value goes above it and cleared when the value goes back
+   below the threshold minus the hysteresis. A low threshold works the other way around.
+   A transition is only reported once it has been seen on hold-off consecutive samples.
+
+   The thresholds are set by the management threads and evaluated by the poller: a mutex keeps
+   an update from being evaluated half applied. The listener is notified once it is released.
+*/
+// ------------------------------------------------------------------------------------------------
+class SfpAlarmEngine
+{
+
+public:
+   SfpAlarmEngine();
+   virtual ~SfpAlarmEngine();
+
+   bool SetThreshold(SfpDdmParam a_param, HalSfpThresholdId a_id, acd_int32_t a_value);
+   bool GetThreshold(SfpDdmParam a_param, HalSfpThresholdId a_id, acd_int32_t& a_value);
+   bool ClearThreshold(SfpDdmParam a_param, HalSfpThresholdId a_id);
+   bool SetHysteresis(SfpDdmParam a_param, acd_int32_t a_hysteresis);
+   void SetHoldOff(acd_uint32_t a_samples);
+   void SetListener(SfpAlarmListener* a_pListener);
+
+   bool IsArmed();
+   bool IsActive(SfpDdmParam a_param, HalSfpThresholdId a_id);
+   acd_uint32_t GetEventCount();
+
+   void Evaluate(HalSfp* a_pSfp, const acd_int32_t a_values[SfpDdmParamMax]);
+   void Reset(HalSfp* a_pSfp);
+
+private:
+   struct Threshold
+   {
+      bool           bSet;          // Threshold configured
+      bool           bActive;       // Threshold crossed
+      acd_int32_t    value;         // Threshold value
+      acd_uint32_t   count;         // Consecutive samples in the other state
+   };
+
+   void addEvent(SfpAlarmEvent* a_pEvents, acd_uint32_t& a_nbEvents, SfpDdmParam a_param, HalSfpThresholdId a_id, acd_int32_t a_value);
+   void publish(HalSfp* a_pSfp, const SfpAlarmEvent* a_pEvents, acd_uint32_t a_nbEvents);
+
+   Threshold            m_threshold[SfpDdmParamMax][HalSfpThresholdMax];
+   acd_int32_t          m_hysteresis[SfpDdmParamMax];
+   acd_uint32_t         m_holdOff;
+   acd_uint32_t         m_nbSet;
+   acd_uint32_t         m_eventCount;
+   SfpAlarmListener*    m_pListener;
+   pthread_mutex_t      m_mutex;       // Protects the thresholds, the hysteresis and the hold-off
+};
+
+#endif // #ifndef __SFPALARM_H__
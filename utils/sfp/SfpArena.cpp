@@ -0,0 +1,127 @@
+// ------------------------------------------------------------------------------------------------
+/* ACCEDIAN PROPRIETARY - www.accedian.com
+   COPYRIGHT (c) 2004-2014 BY ACCEDIAN CORPORATION. ALL RIGHTS RESERVED. NO PART OF THIS PROGRAM OR
+   PUBLICATION MAY BE REPRODUCED, TRANSMITTED, TRANSCRIBED, STORED IN A RETRIEVAL SYSTEM,
+   OR TRANSLATED INTO ANY LANGUAGE OR COMPUTER LANGUAGE IN ANY FORM OR BY ANY MEANS, ELECTRONIC,
+   MECHANICAL, MAGNETIC, OPTICAL, CHEMICAL, MANUAL, OR OTHERWISE, WITHOUT THE PRIOR WRITTEN
+   PERMISSION OF ACCEDIAN INC.
+*/
+// ------------------------------------------------------------------------------------------------
+/*!@file    SfpArena.cpp
+   @brief   SFP state arena
+
+   This file contains the arena holding the state of all the SFPs of a board in one memory block
+
+*/
+// ------------------------------------------------------------------------------------------------
+
+#include <stdlib.h>
+#include <string.h>
+#include "SfpArena.h"
+
+// ================================================================================================
+// ================================================================================================
+//            PUBLIC CLASS SECTION
+// ================================================================================================
+// ================================================================================================
+// ------------------------------------------------------------------------------------------------
+/*!@brief Constructor
+
+   @param [in]     a_size : Block size in bytes, see HalSfp::GetArenaSize()
+*/
+// ------------------------------------------------------------------------------------------------
+SfpArena::SfpArena(acd_uint32_t a_size) :
+m_pBlock(NULL),
+m_size(0),
+m_used(0)
+{
+   void* pBlock = NULL;
+
+   if ( (a_size != 0) && (posix_memalign(&pBlock, SFP_ARENA_ALIGN, a_size) == 0) )
+   {
+      memset(pBlock, 0, a_size);
+      m_pBlock = (acd_uint8_t*)pBlock;
+      m_size = a_size;
+   }
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Destructor
+
+*/
+// ------------------------------------------------------------------------------------------------
+SfpArena::~SfpArena()
+{
+   free(m_pBlock);
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Allocate memory from the arena
+
+   The memory is zeroed.
+
+   @param [in]     a_size  : Number of bytes
+   @param [in]     a_align : Alignment, power of 2 up to SFP_ARENA_ALIGN
+
+   @return     Memory, NULL if the arena is used up
+*/
+// ------------------------------------------------------------------------------------------------
+void* SfpArena::Alloc(acd_uint32_t a_size, acd_uint32_t a_align)
+{
+   if ( (m_pBlock == NULL) || (a_align == 0) || (a_align > SFP_ARENA_ALIGN) || ((a_align & (a_align - 1)) != 0) )
+   {
+      return NULL;
+   }
+
+   for( ; ; )
+   {
+      acd_uint32_t used = m_used;
+      acd_uint32_t start = (used + a_align - 1) & ~(a_align - 1);
+
+      if ( (start < used) || (start > m_size) || (a_size > (m_size - start)) )
+      {
+         return NULL;
+      }
+      if ( __sync_bool_compare_and_swap(&m_used, used, start + a_size) )
+      {
+         return &m_pBlock[start];
+      }
+   }
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Check if memory was allocated from the arena
+
+   @param [in]     a_ptr : Memory
+
+   @return     true if the memory is within the arena block
+*/
+// ------------------------------------------------------------------------------------------------
+bool SfpArena::Owns(const void* a_ptr)
+{
+   const acd_uint8_t* ptr = (const acd_uint8_t*)a_ptr;
+
+   return (m_pBlock != NULL) && (ptr >= m_pBlock) && (ptr < (m_pBlock + m_size));
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Get the number of bytes allocated
+
+   @return     Bytes used, including the alignment padding
+*/
+// ------------------------------------------------------------------------------------------------
+acd_uint32_t SfpArena::GetUsed()
+{
+   return m_used;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Get the arena size
+
+   @return     Block size, 0 if the block could not be allocated
+*/
+// ------------------------------------------------------------------------------------------------
+acd_uint32_t SfpArena::GetSize()
+{
+   return m_size;
+}
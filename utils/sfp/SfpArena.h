@@ -0,0 +1,54 @@
+// ------------------------------------------------------------------------------------------------
+/* ACCEDIAN PROPRIETARY - www.accedian.com
+   COPYRIGHT (c) 2004-2014 BY ACCEDIAN CORPORATION. ALL RIGHTS RESERVED. NO PART OF THIS PROGRAM OR
+   PUBLICATION MAY BE REPRODUCED, TRANSMITTED, TRANSCRIBED, STORED IN A RETRIEVAL SYSTEM,
+   OR TRANSLATED INTO ANY LANGUAGE OR COMPUTER LANGUAGE IN ANY FORM OR BY ANY MEANS, ELECTRONIC,
+   MECHANICAL, MAGNETIC, OPTICAL, CHEMICAL, MANUAL, OR OTHERWISE, WITHOUT THE PRIOR WRITTEN
+   PERMISSION OF ACCEDIAN INC.
+*/
+// ------------------------------------------------------------------------------------------------
+/*!@file    SfpArena.h
+   @brief   SFP state arena
+
+   This file contains the arena holding the state of all the SFPs of a board in one memory block
+*/
+// ------------------------------------------------------------------------------------------------
+#ifndef __SFPARENA_H__
+#define __SFPARENA_H__
+
+#include <stddef.h>
+#include <global/acd_types.h>
+
+#define SFP_ARENA_ALIGN          64    // Default alignment, one cache line
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief SFP state arena
+
+   One contiguous memory block from which the SFPs of a board allocate their state (see
+   HalSfp::SetArena()), so a sweep of all the SFPs walks adjacent cache lines instead of
+   scattered heap blocks. Allocations are cache line aligned by default and are never freed
+   individually: the whole block is released with the arena, which must outlive its SFPs.
+
+   Alloc() can be called by several threads. It returns NULL once the block is used up, the
+   caller then uses the heap.
+*/
+// ------------------------------------------------------------------------------------------------
+class SfpArena
+{
+
+public:
+   SfpArena(acd_uint32_t a_size);
+   virtual ~SfpArena();
+
+   void* Alloc(acd_uint32_t a_size, acd_uint32_t a_align = SFP_ARENA_ALIGN);
+   bool Owns(const void* a_ptr);
+   acd_uint32_t GetUsed();
+   acd_uint32_t GetSize();
+
+private:
+   acd_uint8_t*   m_pBlock;            // Memory block, NULL if the allocation failed
+   acd_uint32_t   m_size;              // Block size
+   volatile acd_uint32_t m_used;       // Bytes allocated from the start of the block
+};
+
+#endif // #ifndef __SFPARENA_H__
@@ -0,0 +1,232 @@
+// ------------------------------------------------------------------------------------------------
+/* ACCEDIAN PROPRIETARY - www.accedian.com
+   COPYRIGHT (c) 2004-2014 BY ACCEDIAN CORPORATION. ALL RIGHTS RESERVED. NO PART OF THIS PROGRAM OR
+   PUBLICATION MAY BE REPRODUCED, TRANSMITTED, TRANSCRIBED, STORED IN A RETRIEVAL SYSTEM,
+   OR TRANSLATED INTO ANY LANGUAGE OR COMPUTER LANGUAGE IN ANY FORM OR BY ANY MEANS, ELECTRONIC,
+   MECHANICAL, MAGNETIC, OPTICAL, CHEMICAL, MANUAL, OR OTHERWISE, WITHOUT THE PRIOR WRITTEN
+   PERMISSION OF ACCEDIAN INC.
+*/
+// ------------------------------------------------------------------------------------------------
+/*!@file    SfpCtrlShadow.cpp
+   @brief   SFP control register shadow
+
+   This file contains the SFP control register shadow class
+
+*/
+// ------------------------------------------------------------------------------------------------
+
+#include <string.h>
+#include "SfpCtrlShadow.h"
+#include "SfpTime.h"
+
+// ================================================================================================
+// ================================================================================================
+//            PUBLIC CLASS SECTION
+// ================================================================================================
+// ================================================================================================
+// ------------------------------------------------------------------------------------------------
+/*!@brief Constructor
+
+*/
+// ------------------------------------------------------------------------------------------------
+SfpCtrlShadow::SfpCtrlShadow() :
+m_pIoDrv(NULL),
+m_reg(0),
+m_bValid(false),
+m_image(0)
+{
+   memset(&m_stats, 0, sizeof(m_stats));
+   pthread_mutex_init(&m_mutex, NULL);
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Destructor
+
+*/
+// ------------------------------------------------------------------------------------------------
+SfpCtrlShadow::~SfpCtrlShadow()
+{
+   pthread_mutex_destroy(&m_mutex);
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Attach the shadow to its register
+
+   Called by each port sharing the register, the first call sets the register.
+
+   @param [in]     a_pIoDrv : FPGA I/O driver
+   @param [in]     a_reg    : Control register
+*/
+// ------------------------------------------------------------------------------------------------
+void SfpCtrlShadow::Attach(BaseIoDrv<acd_uint64_t>* a_pIoDrv, acd_uint32_t a_reg)
+{
+   pthread_mutex_lock(&m_mutex);
+   if ( m_pIoDrv == NULL )
+   {
+      m_pIoDrv = a_pIoDrv;
+      m_reg = a_reg;
+      m_bValid = false;
+   }
+   pthread_mutex_unlock(&m_mutex);
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Read the register again
+
+   Needed if the register was changed without the shadow (ex: FPGA reset), otherwise the next
+   write restores the old bits. HalSfpGroup::Poll() calls it on the first cycle and after the
+   board status could not be read; without a group, the board code must call it after a reset.
+
+   @return     true if successful
+*/
+// ------------------------------------------------------------------------------------------------
+bool SfpCtrlShadow::Sync()
+{
+   bool bRet;
+
+   pthread_mutex_lock(&m_mutex);
+   m_bValid = false;
+   bRet = load();
+   pthread_mutex_unlock(&m_mutex);
+   return bRet;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Get the register image
+
+   @param [out]    a_image : Register value
+
+   @return     true if successful
+*/
+// ------------------------------------------------------------------------------------------------
+bool SfpCtrlShadow::Read(acd_uint64_t& a_image)
+{
+   bool bRet;
+
+   pthread_mutex_lock(&m_mutex);
+   bRet = load();
+   a_image = m_image;
+   pthread_mutex_unlock(&m_mutex);
+   return bRet;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Set or clear register bits
+
+   The register is only written when its image changes. The bits are left unchanged if the
+   register cannot be read to load the image (see Read()).
+
+   @param [in]     a_mask      : Bits to change
+   @param [in]     a_bSet      : Set the bits if true, clear them otherwise
+   @param [out]    a_pbChanged : true if the register was written, optional
+
+   @return     true if successful, false if the register could not be read or written or if
+               the mask is 0
+*/
+// ------------------------------------------------------------------------------------------------
+bool SfpCtrlShadow::Write(acd_uint64_t a_mask, bool a_bSet, bool* a_pbChanged)
+{
+   acd_uint64_t   start = sfpGetTimeUs();
+   acd_uint64_t   newVal;
+   acd_uint64_t   latency;
+   acd_uint32_t   bucket;
+   bool           bRet;
+
+   if ( a_pbChanged != NULL )
+   {
+      *a_pbChanged = false;
+   }
+   if ( a_mask == 0 )
+   {
+      return false;
+   }
+
+   pthread_mutex_lock(&m_mutex);
+   if ( !load() )
+   {
+      pthread_mutex_unlock(&m_mutex);
+      return false;
+   }
+   newVal = a_bSet ? (m_image | a_mask) : (m_image & ~a_mask);
+   if ( newVal == m_image )
+   {
+      pthread_mutex_unlock(&m_mutex);
+      return true;
+   }
+
+   bRet = m_pIoDrv->Write(m_reg, newVal);
+   if ( bRet )
+   {
+      m_image = newVal;
+   }
+   else
+   {
+      // The register state is unknown, read it on the next access
+      m_bValid = false;
+      m_stats.nbErrors++;
+   }
+   if ( a_pbChanged != NULL )
+   {
+      *a_pbChanged = true;
+   }
+
+   latency = sfpGetTimeUs() - start;
+   bucket = (latency < 10) ? 0 : (latency < 100) ? 1 : (latency < 250) ? 2 : (latency < 500) ? 3 : (latency < 1000) ? 4 : 5;
+   m_stats.nbWrites++;
+   m_stats.histogram[bucket]++;
+   m_stats.lastUs = latency;
+   m_stats.totalUs += latency;
+   if ( latency > m_stats.maxUs )
+   {
+      m_stats.maxUs = latency;
+   }
+   pthread_mutex_unlock(&m_mutex);
+   return bRet;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Get the write latency statistics
+
+   @param [out]    a_stats : Statistics
+*/
+// ------------------------------------------------------------------------------------------------
+void SfpCtrlShadow::GetStats(SfpCtrlLatencyStats& a_stats)
+{
+   pthread_mutex_lock(&m_mutex);
+   a_stats = m_stats;
+   pthread_mutex_unlock(&m_mutex);
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Clear the write latency statistics
+
+*/
+// ------------------------------------------------------------------------------------------------
+void SfpCtrlShadow::ClearStats()
+{
+   pthread_mutex_lock(&m_mutex);
+   memset(&m_stats, 0, sizeof(m_stats));
+   pthread_mutex_unlock(&m_mutex);
+}
+
+// ================================================================================================
+// ================================================================================================
+//            PRIVATE CLASS SECTION
+// ================================================================================================
+// ================================================================================================
+// ------------------------------------------------------------------------------------------------
+/*!@brief Read the register if the image is not valid
+
+   Must be called with the lock held.
+
+   @return     true if the image is valid
+*/
+// ------------------------------------------------------------------------------------------------
+bool SfpCtrlShadow::load()
+{
+   if ( !m_bValid && (m_pIoDrv != NULL) )
+   {
+      m_bValid = m_pIoDrv->Read(m_reg, m_image);
+   }
+   return m_bValid;
+}
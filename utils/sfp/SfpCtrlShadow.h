@@ -0,0 +1,76 @@
+// ------------------------------------------------------------------------------------------------
+/* ACCEDIAN PROPRIETARY - www.accedian.com
+   COPYRIGHT (c) 2004-2014 BY ACCEDIAN CORPORATION. ALL RIGHTS RESERVED. NO PART OF THIS PROGRAM OR
+   PUBLICATION MAY BE REPRODUCED, TRANSMITTED, TRANSCRIBED, STORED IN A RETRIEVAL SYSTEM,
+   OR TRANSLATED INTO ANY LANGUAGE OR COMPUTER LANGUAGE IN ANY FORM OR BY ANY MEANS, ELECTRONIC,
+   MECHANICAL, MAGNETIC, OPTICAL, CHEMICAL, MANUAL, OR OTHERWISE, WITHOUT THE PRIOR WRITTEN
+   PERMISSION OF ACCEDIAN INC.
+*/
+// ------------------------------------------------------------------------------------------------
+/*!@file    SfpCtrlShadow.h
+   @brief   SFP control register shadow
+
+   This file contains the SFP control register shadow class definition
+*/
+// ------------------------------------------------------------------------------------------------
+#ifndef __SFPCTRLSHADOW_H__
+#define __SFPCTRLSHADOW_H__
+
+#include <pthread.h>
+#include <accedian/acclib/BaseIoDrv.h>
+
+#define SFP_CTRL_LAT_BUCKETS     6     // Write latency histogram size, see SfpCtrlLatencyStats
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief SFP control register write latency statistics
+
+   The latency is measured from the call to the end of the register write, so it includes the
+   time waiting for the other ports sharing the register.
+*/
+// ------------------------------------------------------------------------------------------------
+struct SfpCtrlLatencyStats
+{
+   acd_uint32_t   nbWrites;                          // Register writes
+   acd_uint32_t   nbErrors;                          // Register write failures
+   acd_uint64_t   lastUs;                            // Latency of the last write
+   acd_uint64_t   maxUs;                             // Worst latency
+   acd_uint64_t   totalUs;                           // Sum of the latencies
+   acd_uint32_t   histogram[SFP_CTRL_LAT_BUCKETS];   // < 10, < 100, < 250, < 500, < 1000, >= 1000 usec
+};
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief SFP control register shadow
+
+   Keeps the image of a control register shared by several ports (power and Tx disable bits),
+   so a bit change is a single register write: no read-modify-write, and the lock shared by the
+   ports is only held while writing. The register is read once, on the first access or after a
+   write failure, or again by Sync(). All the writes to the register must go through its shadow.
+*/
+// ------------------------------------------------------------------------------------------------
+class SfpCtrlShadow
+{
+
+public:
+   SfpCtrlShadow();
+   virtual ~SfpCtrlShadow();
+
+   void Attach(BaseIoDrv<acd_uint64_t>* a_pIoDrv, acd_uint32_t a_reg);
+   bool Sync();
+   bool Read(acd_uint64_t& a_image);
+   bool Write(acd_uint64_t a_mask, bool a_bSet, bool* a_pbChanged = NULL);
+
+   void GetStats(SfpCtrlLatencyStats& a_stats);
+   void ClearStats();
+
+private:
+   bool load();
+
+   BaseIoDrv<acd_uint64_t>* m_pIoDrv;  // FPGA I/O driver, NULL until attached
+   acd_uint32_t         m_reg;         // Control register
+   bool                 m_bValid;      // The image matches the register
+   acd_uint64_t         m_image;       // Register image
+   SfpCtrlLatencyStats  m_stats;       // Write latency statistics
+   pthread_mutex_t      m_mutex;       // Serializes the writes
+};
+
+#endif // #ifndef __SFPCTRLSHADOW_H__
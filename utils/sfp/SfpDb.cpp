@@ -16,6 +16,7 @@
 // ------------------------------------------------------------------------------------------------
 
 #include "SfpDb.h"
+#include "SfpProbe.h"
 #include <stdio.h>
 
 SfpDb* SfpDb::s_pTheInstance = NULL;
@@ -75,6 +76,7 @@ bool SfpDb::Get(string& a_partNumber, SfpDesc& a_sfpDesc)
       a_sfpDesc = m_sfpMap[a_partNumber];
       bRet = true;
    }
+   SFP_PROBE2(db_lookup, a_partNumber.c_str(), bRet);
    return bRet;
 }
 
@@ -0,0 +1,555 @@
+// ------------------------------------------------------------------------------------------------
+/* ACCEDIAN PROPRIETARY - www.accedian.com
+   COPYRIGHT (c) 2004-2014 BY ACCEDIAN CORPORATION. ALL RIGHTS RESERVED. NO PART OF THIS PROGRAM OR
+   PUBLICATION MAY BE REPRODUCED, TRANSMITTED, TRANSCRIBED, STORED IN A RETRIEVAL SYSTEM,
+   OR TRANSLATED INTO ANY LANGUAGE OR COMPUTER LANGUAGE IN ANY FORM OR BY ANY MEANS, ELECTRONIC,
+   MECHANICAL, MAGNETIC, OPTICAL, CHEMICAL, MANUAL, OR OTHERWISE, WITHOUT THE PRIOR WRITTEN
+   PERMISSION OF ACCEDIAN INC.
+*/
+// ------------------------------------------------------------------------------------------------
+/*!@file    SfpDdmBatch.cpp
+   @brief   SFP multi-port DDM conversion
+
+   This file contains the SFP DDM batch conversion class
+
+   The scalar kernel uses the very same expressions as the HalSfp::convert*() methods. The SIMD
+   kernels use the same float operations in the same order (no FMA contraction) and the same
+   truncating conversions, so all kernels give identical results.
+   The rx power polynomial calls powf() and is always converted by the scalar code; only the
+   decoding of its IEEE-754 coefficients is hoisted to SetCalibration().
+
+*/
+// ------------------------------------------------------------------------------------------------
+
+#include "SfpDdmBatch.h"
+#include <string.h>
+#include <arpa/inet.h>
+#include <math.h>
+
+#if defined(__x86_64__)
+#define SFP_DDM_X86
+#include <immintrin.h>
+#endif
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Decode a rx power calibration constant
+
+   Same transformation as in HalSfp::convertRxPower()
+
+   @param [in]     a_pwr : Calibration constant in network byte order
+
+   @return     Calibration constant
+*/
+// ------------------------------------------------------------------------------------------------
+static float decodeRxPwrCoef(acd_uint32_t a_pwr)
+{
+   acd_uint32_t   pwr;
+   float          mantissa;
+   acd_int32_t    exp;
+
+   pwr = ntohl(a_pwr);
+   mantissa = pwr&0x7FFFFF;
+   mantissa = (mantissa/0x7FFFFF)+1;
+   exp = ((pwr&0x7F800000)>>23)-127;
+   return ldexpf(mantissa, exp);
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Allocate a zeroed array
+
+   @param [in]     a_size : Number of entries
+
+   @return     Array
+*/
+// ------------------------------------------------------------------------------------------------
+template <class T> static T* allocArray(acd_uint32_t a_size)
+{
+   T* pArray = new T[a_size];
+   memset(pArray, 0, a_size * sizeof(T));
+   return pArray;
+}
+
+// ================================================================================================
+// ================================================================================================
+//            PUBLIC CLASS SECTION
+// ================================================================================================
+// ================================================================================================
+// ------------------------------------------------------------------------------------------------
+/*!@brief Constructor
+
+   @param [in]     a_size : Number of ports
+*/
+// ------------------------------------------------------------------------------------------------
+SfpDdmBatch::SfpDdmBatch(acd_uint32_t a_size) :
+m_size(a_size),
+m_capacity((a_size + DDM_BATCH_ALIGN - 1) & ~(DDM_BATCH_ALIGN - 1)),
+m_kernel(SfpDdmKernelScalar)
+{
+   m_rawTemp   = allocArray<acd_uint16_t>(m_capacity);
+   m_rawVcc    = allocArray<acd_uint16_t>(m_capacity);
+   m_rawBias   = allocArray<acd_uint16_t>(m_capacity);
+   m_rawTxPwr  = allocArray<acd_uint16_t>(m_capacity);
+   m_rawRxPwr  = allocArray<acd_uint16_t>(m_capacity);
+
+   m_internal  = allocArray<acd_uint32_t>(m_capacity);
+   m_tsSlope   = allocArray<float>(m_capacity);
+   m_tsOffset  = allocArray<float>(m_capacity);
+   m_vccSlope  = allocArray<float>(m_capacity);
+   m_vccOffset = allocArray<float>(m_capacity);
+   m_lbcSlope  = allocArray<float>(m_capacity);
+   m_lbcOffset = allocArray<float>(m_capacity);
+   m_txSlope   = allocArray<float>(m_capacity);
+   m_txOffset  = allocArray<float>(m_capacity);
+   m_rxPwr4    = allocArray<float>(m_capacity);
+   m_rxPwr3    = allocArray<float>(m_capacity);
+   m_rxPwr2    = allocArray<float>(m_capacity);
+   m_rxPwr1    = allocArray<float>(m_capacity);
+   m_rxPwr0    = allocArray<float>(m_capacity);
+
+   m_temp      = allocArray<acd_int16_t>(m_capacity);
+   m_vcc       = allocArray<acd_uint16_t>(m_capacity);
+   m_bias      = allocArray<acd_uint32_t>(m_capacity);
+   m_txPwr     = allocArray<acd_uint32_t>(m_capacity);
+   m_rxPwr     = allocArray<acd_uint32_t>(m_capacity);
+
+   SetKernel(SfpDdmKernelAuto);
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Destructor
+
+*/
+// ------------------------------------------------------------------------------------------------
+SfpDdmBatch::~SfpDdmBatch()
+{
+   delete [] m_rawTemp;
+   delete [] m_rawVcc;
+   delete [] m_rawBias;
+   delete [] m_rawTxPwr;
+   delete [] m_rawRxPwr;
+
+   delete [] m_internal;
+   delete [] m_tsSlope;
+   delete [] m_tsOffset;
+   delete [] m_vccSlope;
+   delete [] m_vccOffset;
+   delete [] m_lbcSlope;
+   delete [] m_lbcOffset;
+   delete [] m_txSlope;
+   delete [] m_txOffset;
+   delete [] m_rxPwr4;
+   delete [] m_rxPwr3;
+   delete [] m_rxPwr2;
+   delete [] m_rxPwr1;
+   delete [] m_rxPwr0;
+
+   delete [] m_temp;
+   delete [] m_vcc;
+   delete [] m_bias;
+   delete [] m_txPwr;
+   delete [] m_rxPwr;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Get the number of ports
+
+   @return     Number of ports
+*/
+// ------------------------------------------------------------------------------------------------
+acd_uint32_t SfpDdmBatch::GetSize()
+{
+   return m_size;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Select the conversion kernel
+
+   @param [in]     a_kernel : Conversion kernel, SfpDdmKernelAuto selects the best one supported
+
+   @return     true if the kernel is supported on this CPU
+*/
+// ------------------------------------------------------------------------------------------------
+bool SfpDdmBatch::SetKernel(SfpDdmKernel a_kernel)
+{
+   bool bRet = true;
+
+   switch (a_kernel)
+   {
+      case SfpDdmKernelAuto:
+         m_kernel = SfpDdmKernelScalar;
+#ifdef SFP_DDM_X86
+         m_kernel = SfpDdmKernelSse2;
+         if ( __builtin_cpu_supports("avx2") )
+         {
+            m_kernel = SfpDdmKernelAvx2;
+         }
+#endif
+         break;
+      case SfpDdmKernelScalar:
+         m_kernel = a_kernel;
+         break;
+#ifdef SFP_DDM_X86
+      case SfpDdmKernelSse2:
+         m_kernel = a_kernel;
+         break;
+      case SfpDdmKernelAvx2:
+         bRet = __builtin_cpu_supports("avx2");
+         if ( bRet )
+         {
+            m_kernel = a_kernel;
+         }
+         break;
+#endif
+      default:
+         bRet = false;
+         break;
+   }
+   return bRet;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Get the selected conversion kernel
+
+   @return     Conversion kernel
+*/
+// ------------------------------------------------------------------------------------------------
+SfpDdmKernel SfpDdmBatch::GetKernel()
+{
+   return m_kernel;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Load the calibration constants of a port
+
+   Must be called again when the module is replaced
+
+   @param [in]     a_index     : Port index in the batch
+   @param [in]     a_bInternal : true if the module is internally calibrated (A0h byte 92 bit 5)
+   @param [in]     a_pMon      : A2h diagnostic memory
+
+   @return     true if successful
+*/
+// ------------------------------------------------------------------------------------------------
+bool SfpDdmBatch::SetCalibration(acd_uint32_t a_index, bool a_bInternal, const sfp_mon_type* a_pMon)
+{
+   acd_uint16_t   slope;
+   float          rxPwr1;
+
+   if ( a_index >= m_size )
+   {
+      return false;
+   }
+
+   m_internal[a_index] = a_bInternal ? 0xFFFFFFFF : 0;
+
+   slope = ntohs(a_pMon->ts_slope);
+   m_tsSlope[a_index] = (slope&0x00FF);
+   m_tsSlope[a_index] = m_tsSlope[a_index]/256;
+   m_tsSlope[a_index] += slope>>8;
+   m_tsOffset[a_index] = (acd_int16_t)ntohs(a_pMon->ts_offset);
+
+   // Integer division as in HalSfp::convertVoltage(): only the integer part of the slope is used
+   slope = ntohs(a_pMon->vcc_slope);
+   m_vccSlope[a_index] = (slope&0x00FF)/256 + (slope>>8);
+   m_vccOffset[a_index] = (acd_int16_t)ntohs(a_pMon->vcc_offset);
+
+   slope = ntohs(a_pMon->lbc_slope);
+   m_lbcSlope[a_index] = ((float)(slope&0x00FF) / 256.0) + (float)(slope>>8);
+   m_lbcOffset[a_index] = (acd_int16_t)ntohs(a_pMon->lbc_offset);
+
+   slope = ntohs(a_pMon->tx_pwr_slope);
+   m_txSlope[a_index] = ((float)(slope&0x00FF) / 256.0) + (float)(slope>>8);
+   m_txOffset[a_index] = (acd_int16_t)ntohs(a_pMon->tx_pwr_offset);
+
+   m_rxPwr4[a_index] = decodeRxPwrCoef(a_pMon->rx_pwr4);
+   if ((ntohl(a_pMon->rx_pwr4)&0x80000000) != 0) m_rxPwr4[a_index] = -m_rxPwr4[a_index];
+   m_rxPwr3[a_index] = decodeRxPwrCoef(a_pMon->rx_pwr3);
+   if ((ntohl(a_pMon->rx_pwr3)&0x80000000) != 0) m_rxPwr3[a_index] = -m_rxPwr3[a_index];
+   m_rxPwr2[a_index] = decodeRxPwrCoef(a_pMon->rx_pwr2);
+   if ((ntohl(a_pMon->rx_pwr2)&0x80000000) != 0) m_rxPwr2[a_index] = -m_rxPwr2[a_index];
+   // Same as HalSfp::convertRxPower(): a negative rx_pwr1 overwrites rx_pwr4
+   rxPwr1 = decodeRxPwrCoef(a_pMon->rx_pwr1);
+   m_rxPwr1[a_index] = rxPwr1;
+   if ((ntohl(a_pMon->rx_pwr1)&0x80000000) != 0) m_rxPwr4[a_index] = -rxPwr1;
+   m_rxPwr0[a_index] = decodeRxPwrCoef(a_pMon->rx_pwr0);
+   if ((ntohl(a_pMon->rx_pwr0)&0x80000000) != 0) m_rxPwr0[a_index] = -m_rxPwr0[a_index];
+
+   return true;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Load the raw live values of a port
+
+   The raw values can also be written directly through the GetRaw*() arrays
+
+   @param [in]     a_index     : Port index in the batch
+   @param [in]     a_pMon      : A2h diagnostic memory
+
+   @return     true if successful
+*/
+// ------------------------------------------------------------------------------------------------
+bool SfpDdmBatch::SetLiveValues(acd_uint32_t a_index, const sfp_mon_type* a_pMon)
+{
+   if ( a_index >= m_size )
+   {
+      return false;
+   }
+
+   m_rawTemp[a_index]   = ntohs(a_pMon->temp);
+   m_rawVcc[a_index]    = ntohs(a_pMon->vcc);
+   m_rawBias[a_index]   = ntohs(a_pMon->bias);
+   m_rawTxPwr[a_index]  = ntohs(a_pMon->tx_pwr);
+   m_rawRxPwr[a_index]  = ntohs(a_pMon->rx_pwr);
+   return true;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Convert the live values of all the ports
+
+*/
+// ------------------------------------------------------------------------------------------------
+void SfpDdmBatch::Convert()
+{
+   acd_uint32_t done = 0;
+
+   switch (m_kernel)
+   {
+      case SfpDdmKernelAvx2:
+         done = convertAvx2();
+         break;
+      case SfpDdmKernelSse2:
+         done = convertSse2();
+         break;
+      default:
+         break;
+   }
+   convertScalar(done);
+   convertRxPower();
+}
+
+// ================================================================================================
+// ================================================================================================
+//            PRIVATE CLASS SECTION
+// ================================================================================================
+// ================================================================================================
+// ------------------------------------------------------------------------------------------------
+/*!@brief Convert the temperature, voltage, bias and tx power with the scalar code
+
+   @param [in]     a_first : First port index to convert
+*/
+// ------------------------------------------------------------------------------------------------
+void SfpDdmBatch::convertScalar(acd_uint32_t a_first)
+{
+   for(acd_uint32_t i = a_first ; i < m_size ; i++)
+   {
+      acd_int16_t    tsAd = m_rawTemp[i];
+
+      if ( m_internal[i] )
+      {
+         m_temp[i]  = (tsAd/256);
+         m_vcc[i]   = m_rawVcc[i]/10;
+         m_bias[i]  = (m_rawBias[i]*2);
+         m_txPwr[i] = m_rawTxPwr[i];
+      }
+      else
+      {
+         m_temp[i]  = (acd_int16_t)((tsAd*m_tsSlope[i] + m_tsOffset[i])/256);
+         m_vcc[i]   = (acd_uint16_t)((m_rawVcc[i]*m_vccSlope[i] + m_vccOffset[i])/10);
+         m_bias[i]  = (acd_uint32_t)((m_rawBias[i]*m_lbcSlope[i] + m_lbcOffset[i])*2);
+         m_txPwr[i] = (acd_uint32_t)(m_rawTxPwr[i]*m_txSlope[i] + m_txOffset[i]);
+      }
+   }
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Convert the rx power of all the ports
+
+*/
+// ------------------------------------------------------------------------------------------------
+void SfpDdmBatch::convertRxPower()
+{
+   acd_uint16_t   rx_pwr;
+   float          rx_ad;
+   acd_uint32_t   pwr;
+
+   for(acd_uint32_t i = 0 ; i < m_size ; i++)
+   {
+      if ( m_internal[i] )
+      {
+         rx_pwr = m_rawRxPwr[i];
+      }
+      else
+      {
+         rx_ad = m_rawRxPwr[i];
+         pwr = (acd_uint32_t)(m_rxPwr4[i]*powf(rx_ad, 4) + \
+                              m_rxPwr3[i]*powf(rx_ad, 3) + \
+                              m_rxPwr2[i]*powf(rx_ad, 2) + \
+                              m_rxPwr1[i]*rx_ad + \
+                              m_rxPwr0[i]);
+         if ((pwr&0x80000000) == 0)
+         {
+            rx_pwr = pwr;
+         }
+         else
+         {
+            rx_pwr = 0;
+         }
+      }
+      m_rxPwr[i] = rx_pwr;
+   }
+}
+
+#ifdef SFP_DDM_X86
+// ------------------------------------------------------------------------------------------------
+/*!@brief Convert the temperature, voltage, bias and tx power with the SSE2 kernel
+
+   Processes 4 ports per iteration over the padded arrays
+
+   @return     Number of ports converted
+*/
+// ------------------------------------------------------------------------------------------------
+acd_uint32_t SfpDdmBatch::convertSse2()
+{
+   const __m128i  zero   = _mm_setzero_si128();
+   const __m128i  round  = _mm_set1_epi32(255);
+   const __m128i  div10  = _mm_set1_epi16((short)0xCCCD);
+   const __m128   f256   = _mm_set1_ps(256.0f);
+   const __m128   f10    = _mm_set1_ps(10.0f);
+   const __m128   f2     = _mm_set1_ps(2.0f);
+
+   for(acd_uint32_t i = 0 ; i < m_capacity ; i += 4)
+   {
+      __m128i  mask = _mm_loadu_si128((const __m128i*)&m_internal[i]);
+      __m128i  raw;
+      __m128i  ad;
+      __m128i  in;
+      __m128i  ex;
+      __m128   f;
+
+      // Temperature: signed ADC value, internal value truncated toward zero like a C division
+      raw = _mm_loadl_epi64((const __m128i*)&m_rawTemp[i]);
+      ad  = _mm_srai_epi32(_mm_unpacklo_epi16(raw, raw), 16);
+      in  = _mm_srai_epi32(_mm_add_epi32(ad, _mm_and_si128(_mm_srai_epi32(ad, 31), round)), 8);
+      f   = _mm_mul_ps(_mm_cvtepi32_ps(ad), _mm_loadu_ps(&m_tsSlope[i]));
+      f   = _mm_div_ps(_mm_add_ps(f, _mm_loadu_ps(&m_tsOffset[i])), f256);
+      ex  = _mm_cvttps_epi32(f);
+      ex  = _mm_or_si128(_mm_and_si128(mask, in), _mm_andnot_si128(mask, ex));
+      ex  = _mm_srai_epi32(_mm_slli_epi32(ex, 16), 16);
+      _mm_storel_epi64((__m128i*)&m_temp[i], _mm_packs_epi32(ex, ex));
+
+      // Voltage: internal value is (x * 0xCCCD) >> 19 which is x / 10 for 16-bit values
+      raw = _mm_loadl_epi64((const __m128i*)&m_rawVcc[i]);
+      ad  = _mm_unpacklo_epi16(raw, zero);
+      in  = _mm_unpacklo_epi16(_mm_srli_epi16(_mm_mulhi_epu16(raw, div10), 3), zero);
+      f   = _mm_mul_ps(_mm_cvtepi32_ps(ad), _mm_loadu_ps(&m_vccSlope[i]));
+      f   = _mm_div_ps(_mm_add_ps(f, _mm_loadu_ps(&m_vccOffset[i])), f10);
+      ex  = _mm_cvttps_epi32(f);
+      ex  = _mm_or_si128(_mm_and_si128(mask, in), _mm_andnot_si128(mask, ex));
+      ex  = _mm_srai_epi32(_mm_slli_epi32(ex, 16), 16);
+      _mm_storel_epi64((__m128i*)&m_vcc[i], _mm_packs_epi32(ex, ex));
+
+      // Bias
+      raw = _mm_loadl_epi64((const __m128i*)&m_rawBias[i]);
+      ad  = _mm_unpacklo_epi16(raw, zero);
+      in  = _mm_slli_epi32(ad, 1);
+      f   = _mm_mul_ps(_mm_cvtepi32_ps(ad), _mm_loadu_ps(&m_lbcSlope[i]));
+      f   = _mm_mul_ps(_mm_add_ps(f, _mm_loadu_ps(&m_lbcOffset[i])), f2);
+      ex  = _mm_cvttps_epi32(f);
+      _mm_storeu_si128((__m128i*)&m_bias[i], _mm_or_si128(_mm_and_si128(mask, in), _mm_andnot_si128(mask, ex)));
+
+      // Tx power
+      raw = _mm_loadl_epi64((const __m128i*)&m_rawTxPwr[i]);
+      ad  = _mm_unpacklo_epi16(raw, zero);
+      f   = _mm_mul_ps(_mm_cvtepi32_ps(ad), _mm_loadu_ps(&m_txSlope[i]));
+      f   = _mm_add_ps(f, _mm_loadu_ps(&m_txOffset[i]));
+      ex  = _mm_cvttps_epi32(f);
+      _mm_storeu_si128((__m128i*)&m_txPwr[i], _mm_or_si128(_mm_and_si128(mask, ad), _mm_andnot_si128(mask, ex)));
+   }
+   return m_size;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Convert the temperature, voltage, bias and tx power with the AVX2 kernel
+
+   Processes 8 ports per iteration over the padded arrays.
+   Only AVX2 is enabled for this function so the compiler cannot contract mul/add into FMA.
+
+   @return     Number of ports converted
+*/
+// ------------------------------------------------------------------------------------------------
+__attribute__((target("avx2")))
+acd_uint32_t SfpDdmBatch::convertAvx2()
+{
+   const __m256i  round  = _mm256_set1_epi32(255);
+   const __m128i  div10  = _mm_set1_epi16((short)0xCCCD);
+   const __m256   f256   = _mm256_set1_ps(256.0f);
+   const __m256   f10    = _mm256_set1_ps(10.0f);
+   const __m256   f2     = _mm256_set1_ps(2.0f);
+
+   for(acd_uint32_t i = 0 ; i < m_capacity ; i += 8)
+   {
+      __m256i  mask = _mm256_loadu_si256((const __m256i*)&m_internal[i]);
+      __m128i  raw;
+      __m256i  ad;
+      __m256i  in;
+      __m256i  ex;
+      __m256   f;
+
+      // Temperature
+      raw = _mm_loadu_si128((const __m128i*)&m_rawTemp[i]);
+      ad  = _mm256_cvtepi16_epi32(raw);
+      in  = _mm256_srai_epi32(_mm256_add_epi32(ad, _mm256_and_si256(_mm256_srai_epi32(ad, 31), round)), 8);
+      f   = _mm256_mul_ps(_mm256_cvtepi32_ps(ad), _mm256_loadu_ps(&m_tsSlope[i]));
+      f   = _mm256_div_ps(_mm256_add_ps(f, _mm256_loadu_ps(&m_tsOffset[i])), f256);
+      ex  = _mm256_blendv_epi8(_mm256_cvttps_epi32(f), in, mask);
+      ex  = _mm256_srai_epi32(_mm256_slli_epi32(ex, 16), 16);
+      _mm_storeu_si128((__m128i*)&m_temp[i],
+                       _mm_packs_epi32(_mm256_castsi256_si128(ex), _mm256_extracti128_si256(ex, 1)));
+
+      // Voltage
+      raw = _mm_loadu_si128((const __m128i*)&m_rawVcc[i]);
+      ad  = _mm256_cvtepu16_epi32(raw);
+      in  = _mm256_cvtepu16_epi32(_mm_srli_epi16(_mm_mulhi_epu16(raw, div10), 3));
+      f   = _mm256_mul_ps(_mm256_cvtepi32_ps(ad), _mm256_loadu_ps(&m_vccSlope[i]));
+      f   = _mm256_div_ps(_mm256_add_ps(f, _mm256_loadu_ps(&m_vccOffset[i])), f10);
+      ex  = _mm256_blendv_epi8(_mm256_cvttps_epi32(f), in, mask);
+      ex  = _mm256_srai_epi32(_mm256_slli_epi32(ex, 16), 16);
+      _mm_storeu_si128((__m128i*)&m_vcc[i],
+                       _mm_packs_epi32(_mm256_castsi256_si128(ex), _mm256_extracti128_si256(ex, 1)));
+
+      // Bias
+      raw = _mm_loadu_si128((const __m128i*)&m_rawBias[i]);
+      ad  = _mm256_cvtepu16_epi32(raw);
+      in  = _mm256_slli_epi32(ad, 1);
+      f   = _mm256_mul_ps(_mm256_cvtepi32_ps(ad), _mm256_loadu_ps(&m_lbcSlope[i]));
+      f   = _mm256_mul_ps(_mm256_add_ps(f, _mm256_loadu_ps(&m_lbcOffset[i])), f2);
+      ex  = _mm256_blendv_epi8(_mm256_cvttps_epi32(f), in, mask);
+      _mm256_storeu_si256((__m256i*)&m_bias[i], ex);
+
+      // Tx power
+      raw = _mm_loadu_si128((const __m128i*)&m_rawTxPwr[i]);
+      ad  = _mm256_cvtepu16_epi32(raw);
+      f   = _mm256_mul_ps(_mm256_cvtepi32_ps(ad), _mm256_loadu_ps(&m_txSlope[i]));
+      f   = _mm256_add_ps(f, _mm256_loadu_ps(&m_txOffset[i]));
+      ex  = _mm256_blendv_epi8(_mm256_cvttps_epi32(f), ad, mask);
+      _mm256_storeu_si256((__m256i*)&m_txPwr[i], ex);
+   }
+   return m_size;
+}
+#else
+// ------------------------------------------------------------------------------------------------
+/*!@brief SIMD kernels are not available on this architecture
+
+   @return     Number of ports converted
+*/
+// ------------------------------------------------------------------------------------------------
+acd_uint32_t SfpDdmBatch::convertSse2()
+{
+   return 0;
+}
+
+acd_uint32_t SfpDdmBatch::convertAvx2()
+{
+   return 0;
+}
+#endif
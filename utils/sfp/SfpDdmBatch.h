@@ -0,0 +1,116 @@
+// ------------------------------------------------------------------------------------------------
+/* ACCEDIAN PROPRIETARY - www.accedian.com
+   COPYRIGHT (c) 2004-2014 BY ACCEDIAN CORPORATION. ALL RIGHTS RESERVED. NO PART OF THIS PROGRAM OR
+   PUBLICATION MAY BE REPRODUCED, TRANSMITTED, TRANSCRIBED, STORED IN A RETRIEVAL SYSTEM,
+   OR TRANSLATED INTO ANY LANGUAGE OR COMPUTER LANGUAGE IN ANY FORM OR BY ANY MEANS, ELECTRONIC,
+   MECHANICAL, MAGNETIC, OPTICAL, CHEMICAL, MANUAL, OR OTHERWISE, WITHOUT THE PRIOR WRITTEN
+   PERMISSION OF ACCEDIAN INC.
+*/
+// ------------------------------------------------------------------------------------------------
+/*!@file    SfpDdmBatch.h
+   @brief   SFP multi-port DDM conversion
+
+   This file contains the SFP DDM batch conversion class definition
+*/
+// ------------------------------------------------------------------------------------------------
+#ifndef __SFPDDMBATCH_H__
+#define __SFPDDMBATCH_H__
+
+#include <global/acd_types.h>
+#include "sfp_msa.h"
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief SFP DDM conversion kernels
+*/
+// ------------------------------------------------------------------------------------------------
+enum SfpDdmKernel
+{
+   SfpDdmKernelAuto = 0,   // Best kernel supported by the CPU
+   SfpDdmKernelScalar,
+   SfpDdmKernelSse2,
+   SfpDdmKernelAvx2
+};
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief SFP DDM batch conversion
+
+   This class converts the A2h live values (temperature, voltage, bias, tx and rx power) of
+   several ports at once. The raw words and the calibration constants are kept in structure of
+   arrays form so the conversion can be done with SIMD kernels.
+
+   The results are bit-exact with the HalSfp::convert*() methods.
+*/
+// ------------------------------------------------------------------------------------------------
+class SfpDdmBatch
+{
+
+public:
+   SfpDdmBatch(acd_uint32_t a_size);
+   virtual ~SfpDdmBatch();
+
+   acd_uint32_t GetSize();
+   bool SetKernel(SfpDdmKernel a_kernel);
+   SfpDdmKernel GetKernel();
+
+   bool SetCalibration(acd_uint32_t a_index, bool a_bInternal, const sfp_mon_type* a_pMon);
+   bool SetLiveValues(acd_uint32_t a_index, const sfp_mon_type* a_pMon);
+   void Convert();
+
+   // Raw live values in host byte order, one entry per port
+   acd_uint16_t* GetRawTemp()          { return m_rawTemp;   }
+   acd_uint16_t* GetRawVoltage()       { return m_rawVcc;    }
+   acd_uint16_t* GetRawBias()          { return m_rawBias;   }
+   acd_uint16_t* GetRawTxPower()       { return m_rawTxPwr;  }
+   acd_uint16_t* GetRawRxPower()       { return m_rawRxPwr;  }
+
+   // Converted values, one entry per port
+   const acd_int16_t*  GetTemperature() { return m_temp;    }
+   const acd_uint16_t* GetVoltage()     { return m_vcc;     }
+   const acd_uint32_t* GetBias()        { return m_bias;    }
+   const acd_uint32_t* GetTxPower()     { return m_txPwr;   }
+   const acd_uint32_t* GetRxPower()     { return m_rxPwr;   }
+
+   static const acd_uint32_t DDM_BATCH_ALIGN = 8;   // Arrays are padded to a multiple of this
+
+private:
+   acd_uint32_t convertSse2();
+   acd_uint32_t convertAvx2();
+   void convertScalar(acd_uint32_t a_first);
+   void convertRxPower();
+
+   acd_uint32_t   m_size;          // Number of ports
+   acd_uint32_t   m_capacity;      // Number of entries allocated (padded)
+   SfpDdmKernel   m_kernel;        // Selected conversion kernel
+
+   // Raw live values
+   acd_uint16_t*  m_rawTemp;
+   acd_uint16_t*  m_rawVcc;
+   acd_uint16_t*  m_rawBias;
+   acd_uint16_t*  m_rawTxPwr;
+   acd_uint16_t*  m_rawRxPwr;
+
+   // Calibration constants
+   acd_uint32_t*  m_internal;      // All ones if internally calibrated
+   float*         m_tsSlope;
+   float*         m_tsOffset;
+   float*         m_vccSlope;
+   float*         m_vccOffset;
+   float*         m_lbcSlope;
+   float*         m_lbcOffset;
+   float*         m_txSlope;
+   float*         m_txOffset;
+   float*         m_rxPwr4;
+   float*         m_rxPwr3;
+   float*         m_rxPwr2;
+   float*         m_rxPwr1;
+   float*         m_rxPwr0;
+
+   // Converted values
+   acd_int16_t*   m_temp;
+   acd_uint16_t*  m_vcc;
+   acd_uint32_t*  m_bias;
+   acd_uint32_t*  m_txPwr;
+   acd_uint32_t*  m_rxPwr;
+};
+
+#endif // #ifndef __SFPDDMBATCH_H__
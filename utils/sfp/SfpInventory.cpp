@@ -0,0 +1,255 @@
+// ------------------------------------------------------------------------------------------------
+/* ACCEDIAN PROPRIETARY - www.accedian.com
+   COPYRIGHT (c) 2004-2014 BY ACCEDIAN CORPORATION. ALL RIGHTS RESERVED. NO PART OF THIS PROGRAM OR
+   PUBLICATION MAY BE REPRODUCED, TRANSMITTED, TRANSCRIBED, STORED IN A RETRIEVAL SYSTEM,
+   OR TRANSLATED INTO ANY LANGUAGE OR COMPUTER LANGUAGE IN ANY FORM OR BY ANY MEANS, ELECTRONIC,
+   MECHANICAL, MAGNETIC, OPTICAL, CHEMICAL, MANUAL, OR OTHERWISE, WITHOUT THE PRIOR WRITTEN
+   PERMISSION OF ACCEDIAN INC.
+*/
+// ------------------------------------------------------------------------------------------------
+/*!@file    SfpInventory.cpp
+   @brief   SFP persistent inventory
+
+   This file contains the SFP persistent inventory class
+
+*/
+// ------------------------------------------------------------------------------------------------
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "SfpInventory.h"
+
+// ================================================================================================
+// ================================================================================================
+//            PUBLIC CLASS SECTION
+// ================================================================================================
+// ================================================================================================
+// ------------------------------------------------------------------------------------------------
+/*!@brief Constructor
+
+*/
+// ------------------------------------------------------------------------------------------------
+SfpInventoryStore::SfpInventoryStore() :
+m_fd(-1),
+m_pMap(NULL),
+m_mapSize(0),
+m_pRecords(NULL),
+m_nbRecords(0)
+{
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Destructor
+
+*/
+// ------------------------------------------------------------------------------------------------
+SfpInventoryStore::~SfpInventoryStore()
+{
+   Close();
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Open the inventory file
+
+   The file is created if needed. Its records are erased if it was written by another version
+   or for another number of records.
+
+   @param [in]     a_path      : File path (ex: on a tmpfs to survive process restarts only)
+   @param [in]     a_nbRecords : Number of records, one per port
+
+   @return     true if successful
+*/
+// ------------------------------------------------------------------------------------------------
+bool SfpInventoryStore::Open(const char* a_path, acd_uint32_t a_nbRecords)
+{
+   Header*        pHeader;
+   struct stat    st;
+   size_t         size = sizeof(Header) + a_nbRecords * sizeof(SfpInventoryRecord);
+   bool           bReset;
+
+   if ( (m_fd != -1) || (a_nbRecords == 0) || (a_nbRecords > SFP_INVENTORY_MAX_PORTS) )
+   {
+      return false;
+   }
+
+   m_fd = open(a_path, O_RDWR | O_CREAT, 0644);
+   if ( m_fd == -1 )
+   {
+      return false;
+   }
+   if ( fstat(m_fd, &st) != 0 )
+   {
+      Close();
+      return false;
+   }
+   bReset = ((size_t)st.st_size != size);
+   if ( bReset && (ftruncate(m_fd, 0) != 0 || ftruncate(m_fd, size) != 0) )
+   {
+      Close();
+      return false;
+   }
+
+   m_pMap = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+   if ( m_pMap == MAP_FAILED )
+   {
+      m_pMap = NULL;
+      Close();
+      return false;
+   }
+   m_mapSize = size;
+   m_nbRecords = a_nbRecords;
+   m_pRecords = (SfpInventoryRecord*)((acd_uint8_t*)m_pMap + sizeof(Header));
+
+   pHeader = (Header*)m_pMap;
+   if ( bReset ||
+        (pHeader->magic != SFP_INVENTORY_MAGIC) ||
+        (pHeader->version != SFP_INVENTORY_VERSION) ||
+        (pHeader->recordSize != sizeof(SfpInventoryRecord)) ||
+        (pHeader->nbRecords != a_nbRecords) )
+   {
+      memset(m_pMap, 0, size);
+      pHeader->version = SFP_INVENTORY_VERSION;
+      pHeader->recordSize = sizeof(SfpInventoryRecord);
+      pHeader->nbRecords = a_nbRecords;
+      // Written last, the file is reset again if the process dies before
+      pHeader->magic = SFP_INVENTORY_MAGIC;
+   }
+   return true;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Close the inventory file
+
+   The records are kept in the file.
+*/
+// ------------------------------------------------------------------------------------------------
+void SfpInventoryStore::Close()
+{
+   if ( m_pMap != NULL )
+   {
+      munmap(m_pMap, m_mapSize);
+      m_pMap = NULL;
+   }
+   if ( m_fd != -1 )
+   {
+      close(m_fd);
+      m_fd = -1;
+   }
+   m_pRecords = NULL;
+   m_nbRecords = 0;
+   m_mapSize = 0;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Check if the inventory file is open
+
+   @return     true if open
+*/
+// ------------------------------------------------------------------------------------------------
+bool SfpInventoryStore::IsOpen()
+{
+   return m_pRecords != NULL;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Load a record
+
+   @param [in]     a_index  : Record index
+   @param [out]    a_record : Record
+
+   @return     true if the record is in use and its checksum is valid
+*/
+// ------------------------------------------------------------------------------------------------
+bool SfpInventoryStore::Load(acd_uint32_t a_index, SfpInventoryRecord& a_record)
+{
+   if ( a_index >= m_nbRecords )
+   {
+      return false;
+   }
+   a_record = m_pRecords[a_index];
+   return a_record.bValid && (a_record.checksum == checksum(a_record));
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Save a record
+
+   The file is only written when the record changed.
+
+   @param [in]     a_index  : Record index
+   @param [in,out] a_record : Record, its checksum is set
+
+   @return     true if successful
+*/
+// ------------------------------------------------------------------------------------------------
+bool SfpInventoryStore::Save(acd_uint32_t a_index, SfpInventoryRecord& a_record)
+{
+   SfpInventoryRecord* pRecord;
+
+   if ( a_index >= m_nbRecords )
+   {
+      return false;
+   }
+   pRecord = &m_pRecords[a_index];
+   a_record.bValid = true;
+   a_record.checksum = checksum(a_record);
+   if ( memcmp(pRecord, &a_record, sizeof(a_record)) != 0 )
+   {
+      // A record torn by a crash fails its checksum and is ignored
+      *pRecord = a_record;
+   }
+   return true;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Erase a record
+
+   Called when the module is removed.
+
+   @param [in]     a_index  : Record index
+
+   @return     true if successful
+*/
+// ------------------------------------------------------------------------------------------------
+bool SfpInventoryStore::Erase(acd_uint32_t a_index)
+{
+   if ( a_index >= m_nbRecords )
+   {
+      return false;
+   }
+   if ( m_pRecords[a_index].bValid )
+   {
+      m_pRecords[a_index].bValid = false;
+   }
+   return true;
+}
+
+// ================================================================================================
+// ================================================================================================
+//            PRIVATE CLASS SECTION
+// ================================================================================================
+// ================================================================================================
+// ------------------------------------------------------------------------------------------------
+/*!@brief Compute the checksum of a record
+
+   FNV-1a of all the bytes after the checksum field.
+
+   @param [in]     a_record : Record
+
+   @return     Checksum
+*/
+// ------------------------------------------------------------------------------------------------
+acd_uint32_t SfpInventoryStore::checksum(const SfpInventoryRecord& a_record)
+{
+   const acd_uint8_t*   pData = (const acd_uint8_t*)&a_record + sizeof(a_record.checksum);
+   acd_uint32_t         size = sizeof(a_record) - sizeof(a_record.checksum);
+   acd_uint32_t         hash = 2166136261U;
+
+   for(acd_uint32_t i = 0 ; i < size ; i++)
+   {
+      hash ^= pData[i];
+      hash *= 16777619U;
+   }
+   return hash;
+}
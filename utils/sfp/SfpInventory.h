@@ -0,0 +1,87 @@
+// ------------------------------------------------------------------------------------------------
+/* ACCEDIAN PROPRIETARY - www.accedian.com
+   COPYRIGHT (c) 2004-2014 BY ACCEDIAN CORPORATION. ALL RIGHTS RESERVED. NO PART OF THIS PROGRAM OR
+   PUBLICATION MAY BE REPRODUCED, TRANSMITTED, TRANSCRIBED, STORED IN A RETRIEVAL SYSTEM,
+   OR TRANSLATED INTO ANY LANGUAGE OR COMPUTER LANGUAGE IN ANY FORM OR BY ANY MEANS, ELECTRONIC,
+   MECHANICAL, MAGNETIC, OPTICAL, CHEMICAL, MANUAL, OR OTHERWISE, WITHOUT THE PRIOR WRITTEN
+   PERMISSION OF ACCEDIAN INC.
+*/
+// ------------------------------------------------------------------------------------------------
+/*!@file    SfpInventory.h
+   @brief   SFP persistent inventory
+
+   This file contains the SFP persistent inventory class definition
+*/
+// ------------------------------------------------------------------------------------------------
+#ifndef __SFPINVENTORY_H__
+#define __SFPINVENTORY_H__
+
+#include "HalSfp.h"
+#include "SfpModuleDesc.h"
+
+#define SFP_INVENTORY_MAGIC      0x53465049     // "SFPI"
+#define SFP_INVENTORY_VERSION    2              // File layout version
+#define SFP_INVENTORY_MAX_PORTS  64             // Maximum number of records
+#define SFP_INVENTORY_A2_SIZE    (HAL_SFP_CC_DMI + 1)   // A2h thresholds and calibration (0-95)
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief SFP inventory record
+
+   Module data of one port, kept across restarts
+*/
+// ------------------------------------------------------------------------------------------------
+struct SfpInventoryRecord
+{
+   acd_uint32_t   checksum;                           // Checksum of the rest of the record
+   acd_uint32_t   bValid;                             // Record in use
+   acd_uint32_t   bMonValid;                          // monData is valid
+   acd_uint8_t    interfaceData[HAL_SFP_PAGE_SIZE];   // A0h lower page
+   acd_uint8_t    monData[SFP_INVENTORY_A2_SIZE];     // A2h static bytes
+   SfpModuleDesc  desc;                               // Decoded module descriptor
+};
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief SFP persistent inventory
+
+   Keeps the module data of the ports in a memory mapped file, so it can be restored after a
+   process restart instead of being read again from the SFPs (see HalSfp::SetInventoryStore()).
+   The file holds a versioned header and one checksummed record per port. A file written by
+   another version or for another number of ports is reset.
+
+   Each port only accesses its own record, so the records can be updated by different threads.
+*/
+// ------------------------------------------------------------------------------------------------
+class SfpInventoryStore
+{
+
+public:
+   SfpInventoryStore();
+   virtual ~SfpInventoryStore();
+
+   bool Open(const char* a_path, acd_uint32_t a_nbRecords);
+   void Close();
+   bool IsOpen();
+
+   bool Load(acd_uint32_t a_index, SfpInventoryRecord& a_record);
+   bool Save(acd_uint32_t a_index, SfpInventoryRecord& a_record);
+   bool Erase(acd_uint32_t a_index);
+
+private:
+   struct Header
+   {
+      acd_uint32_t   magic;            // SFP_INVENTORY_MAGIC
+      acd_uint32_t   version;          // SFP_INVENTORY_VERSION
+      acd_uint32_t   recordSize;       // sizeof(SfpInventoryRecord)
+      acd_uint32_t   nbRecords;        // Number of records
+   };
+
+   static acd_uint32_t checksum(const SfpInventoryRecord& a_record);
+
+   int                  m_fd;          // File descriptor, -1 if closed
+   void*                m_pMap;        // File mapping
+   size_t               m_mapSize;     // Size of the mapping
+   SfpInventoryRecord*  m_pRecords;    // Records, in the mapping
+   acd_uint32_t         m_nbRecords;   // Number of records
+};
+
+#endif // #ifndef __SFPINVENTORY_H__
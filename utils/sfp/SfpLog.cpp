@@ -0,0 +1,565 @@
+// ------------------------------------------------------------------------------------------------
+/* ACCEDIAN PROPRIETARY - www.accedian.com
+   COPYRIGHT (c) 2004-2014 BY ACCEDIAN CORPORATION. ALL RIGHTS RESERVED. NO PART OF THIS PROGRAM OR
+   PUBLICATION MAY BE REPRODUCED, TRANSMITTED, TRANSCRIBED, STORED IN A RETRIEVAL SYSTEM,
+   OR TRANSLATED INTO ANY LANGUAGE OR COMPUTER LANGUAGE IN ANY FORM OR BY ANY MEANS, ELECTRONIC,
+   MECHANICAL, MAGNETIC, OPTICAL, CHEMICAL, MANUAL, OR OTHERWISE, WITHOUT THE PRIOR WRITTEN
+   PERMISSION OF ACCEDIAN INC.
+*/
+// ------------------------------------------------------------------------------------------------
+/*!@file    SfpLog.cpp
+   @brief   SFP deferred logging
+
+   This file contains the rate limiter and the log ring used by the SFP poller to log its errors,
+   and the registry of the loggers shared by the SFP drivers
+
+*/
+// ------------------------------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <string.h>
+#include <accedian/acclib/Logger.h>
+#include <accedian/acclib/acd_utils.h>
+#include "SfpLog.h"
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief SFP log message
+*/
+// ------------------------------------------------------------------------------------------------
+struct SfpLogMessage
+{
+   bool           bError;           // Logged as an error, as a debug message otherwise
+   const char*    format;           // printf format, up to SFP_LOG_MAX_ARGS unsigned arguments
+};
+
+static const SfpLogMessage s_messages[SfpLogIdMax] =
+{
+   { true,  "0xA0 EEPROM read failed"                 },   // SfpLogA0ReadFailed
+   { true,  "0xA2 EEPROM read failed"                 },   // SfpLogA2ReadFailed
+   { true,  "EEPROM 0xAC read failed"                 },   // SfpLogAcReadFailed
+   { true,  "0xA2 flags read failed"                  },   // SfpLogFlagsReadFailed
+   { false, "Invalid data (0x00) read from EEPROM 0xA0" }, // SfpLogA0Blank
+   { false, "Invalid data (0x00) read from EEPROM 0xA2" }, // SfpLogA2Blank
+   { false, "Invalid data (0xff) read from EEPROM 0xAC" }, // SfpLogAcErased
+   { false, "SFP 0xA0 checksum failed"                },   // SfpLogA0Checksum
+   { false, "SFP 0xA2 checksum failed"                },   // SfpLogA2Checksum
+};
+
+SfpLogRing* SfpLogRing::s_pTheInstance = NULL;
+SfpLoggerRegistry* SfpLoggerRegistry::s_pTheInstance = NULL;
+
+// ================================================================================================
+// ================================================================================================
+//            PUBLIC CLASS SECTION
+// ================================================================================================
+// ================================================================================================
+// ------------------------------------------------------------------------------------------------
+/*!@brief Constructor
+
+   @param [in]     a_burst    : Messages logged back to back
+   @param [in]     a_periodMs : Period of one more message once the burst is used
+*/
+// ------------------------------------------------------------------------------------------------
+SfpLogBucket::SfpLogBucket(acd_uint32_t a_burst, acd_uint32_t a_periodMs) :
+m_burst((a_burst != 0) ? a_burst : 1),
+m_tokens(m_burst),
+m_periodUs(((a_periodMs != 0) ? a_periodMs : 1) * (acd_uint64_t)1000),
+m_refillTime(0),
+m_suppressed(0)
+{
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Check if a message can be logged
+
+   @param [in]     a_now : Current time in usec, see sfpGetTimeUs()
+
+   @return     true if the message can be logged, false if it is suppressed
+*/
+// ------------------------------------------------------------------------------------------------
+bool SfpLogBucket::Allow(acd_uint64_t a_now)
+{
+   if ( m_refillTime == 0 )
+   {
+      m_refillTime = a_now;
+   }
+   else if ( a_now > m_refillTime )
+   {
+      acd_uint64_t nbTokens = (a_now - m_refillTime) / m_periodUs;
+
+      if ( (m_tokens + nbTokens) >= m_burst )
+      {
+         m_tokens = m_burst;
+         m_refillTime = a_now;
+      }
+      else
+      {
+         m_tokens += (acd_uint32_t)nbTokens;
+         m_refillTime += nbTokens * m_periodUs;
+      }
+   }
+
+   if ( m_tokens == 0 )
+   {
+      m_suppressed++;
+      return false;
+   }
+   m_tokens--;
+   return true;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Get and clear the number of messages suppressed
+
+   @return     Messages suppressed since the last call
+*/
+// ------------------------------------------------------------------------------------------------
+acd_uint32_t SfpLogBucket::TakeSuppressed()
+{
+   acd_uint32_t suppressed = m_suppressed;
+
+   m_suppressed = 0;
+   return suppressed;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Get the log ring instance
+
+   @return     Log ring
+*/
+// ------------------------------------------------------------------------------------------------
+SfpLogRing* SfpLogRing::GetInstance()
+{
+   if ( s_pTheInstance == NULL )
+   {
+      SfpLogRing* pRing = new SfpLogRing;
+
+      // The pollers can log for the first time concurrently
+      if ( !__sync_bool_compare_and_swap(&s_pTheInstance, NULL, pRing) )
+      {
+         delete pRing;
+      }
+   }
+   return s_pTheInstance;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Log a message
+
+   The message is posted to the ring when the log thread runs, formatted and written right away
+   otherwise. Can be called by several pollers concurrently.
+
+   @param [in]     a_pLogger     : Logger of the SFP, must stay valid until the message is
+                                   written, see Flush()
+   @param [in]     a_id          : Message
+   @param [in]     a_suppressed  : Messages suppressed before this one
+   @param [in]     a_arg0        : First message argument
+   @param [in]     a_arg1        : Second message argument
+*/
+// ------------------------------------------------------------------------------------------------
+void SfpLogRing::Log(Logger* a_pLogger, SfpLogId a_id, acd_uint32_t a_suppressed,
+                     acd_uint32_t a_arg0, acd_uint32_t a_arg1)
+{
+   bool bPosted = false;
+
+   if ( m_bRunning )
+   {
+      // Stop() waits for the posters once the thread is stopped, then writes what they posted
+      __sync_fetch_and_add(&m_posters, 1);
+      if ( m_bRunning )
+      {
+         if ( !post(a_pLogger, a_id, a_suppressed, a_arg0, a_arg1) )
+         {
+            __sync_fetch_and_add(&m_dropped, 1);
+         }
+         bPosted = true;
+      }
+      __sync_fetch_and_sub(&m_posters, 1);
+   }
+   if ( !bPosted )
+   {
+      acd_uint32_t args[SFP_LOG_MAX_ARGS] = { a_arg0, a_arg1 };
+
+      write(a_pLogger, a_id, a_suppressed, args);
+   }
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Format and write the messages posted
+
+   Called by the log thread, or with m_mutex taken once the thread is stopped.
+
+   @return     Number of messages written
+*/
+// ------------------------------------------------------------------------------------------------
+acd_uint32_t SfpLogRing::Drain()
+{
+   acd_uint32_t nbRecords = 0;
+
+   for( ; ; )
+   {
+      Record* pRecord = &m_records[m_tail & (SFP_LOG_RING_SIZE - 1)];
+
+      if ( pRecord->seq != (m_tail + 1) )
+      {
+         // Empty, or the next record is still being written
+         break;
+      }
+      __sync_synchronize();
+      write(pRecord->pLogger, pRecord->id, pRecord->suppressed, pRecord->args);
+      __sync_synchronize();
+      pRecord->seq = m_tail + SFP_LOG_RING_SIZE;
+      m_tail++;
+      nbRecords++;
+   }
+   return nbRecords;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Wait until the messages posted are written
+
+   Called before a SFP is destroyed, so no message refers to its logger. Without the log thread,
+   the messages left in the ring are written by the caller.
+*/
+// ------------------------------------------------------------------------------------------------
+void SfpLogRing::Flush()
+{
+   acd_uint32_t head = m_head;
+
+   while ( m_bRunning && ((acd_int32_t)(m_tail - head) < 0) )
+   {
+      acd_usleep(1000);
+   }
+   if ( !m_bRunning )
+   {
+      pthread_mutex_lock(&m_mutex);
+      if ( !m_bRunning )
+      {
+         Drain();
+      }
+      pthread_mutex_unlock(&m_mutex);
+   }
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Get the number of messages dropped
+
+   @return     Messages dropped because the ring was full
+*/
+// ------------------------------------------------------------------------------------------------
+acd_uint32_t SfpLogRing::GetDroppedCount()
+{
+   return m_dropped;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Start the log thread
+
+   @return     true if successful
+*/
+// ------------------------------------------------------------------------------------------------
+bool SfpLogRing::Start()
+{
+   bool bRet = false;
+
+   pthread_mutex_lock(&m_mutex);
+   if ( !m_bRunning )
+   {
+      m_bRunning = true;
+      bRet = (pthread_create(&m_thread, NULL, threadMain, this) == 0);
+      m_bRunning = bRet;
+   }
+   pthread_mutex_unlock(&m_mutex);
+   return bRet;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Stop the log thread
+
+   The messages already posted are written, including the ones of the pollers that were posting
+   while the thread stopped. The messages logged afterwards are written right away by Log().
+*/
+// ------------------------------------------------------------------------------------------------
+void SfpLogRing::Stop()
+{
+   pthread_mutex_lock(&m_mutex);
+   if ( m_bRunning )
+   {
+      m_bRunning = false;
+      __sync_synchronize();
+      pthread_join(m_thread, NULL);
+
+      // A poller that saw the thread running may still be posting
+      while ( m_posters != 0 )
+      {
+         acd_usleep(100);
+      }
+      Drain();
+   }
+   pthread_mutex_unlock(&m_mutex);
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Check if the log thread runs
+
+   @return     true if the messages are written by the log thread
+*/
+// ------------------------------------------------------------------------------------------------
+bool SfpLogRing::IsRunning()
+{
+   return m_bRunning;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Get the logger registry instance
+
+   @return     Logger registry
+*/
+// ------------------------------------------------------------------------------------------------
+SfpLoggerRegistry* SfpLoggerRegistry::GetInstance()
+{
+   if ( s_pTheInstance == NULL )
+   {
+      SfpLoggerRegistry* pRegistry = new SfpLoggerRegistry;
+
+      // The drivers of several controllers can be created concurrently
+      if ( !__sync_bool_compare_and_swap(&s_pTheInstance, NULL, pRegistry) )
+      {
+         delete pRegistry;
+      }
+   }
+   return s_pTheInstance;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Get the logger of a name
+
+   The logger is created, with the debug messages disabled, by the first user of the name.
+
+   @param [in]     a_name : Logger name
+
+   @return     Shared logger, to be released with Release()
+*/
+// ------------------------------------------------------------------------------------------------
+Logger* SfpLoggerRegistry::Acquire(const char* a_name)
+{
+   Logger* pLogger;
+
+   pthread_mutex_lock(&m_mutex);
+   LoggerMap::iterator it = m_loggers.find(a_name);
+   if ( it == m_loggers.end() )
+   {
+      Entry entry;
+
+      entry.pLogger = new Logger(a_name);
+      entry.pLogger->SetDebug(false);
+      entry.refs = 0;
+      it = m_loggers.insert(LoggerMap::value_type(a_name, entry)).first;
+   }
+   it->second.refs++;
+   pLogger = it->second.pLogger;
+   pthread_mutex_unlock(&m_mutex);
+   return pLogger;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Release a logger
+
+   @param [in]     a_pLogger : Logger returned by Acquire()
+*/
+// ------------------------------------------------------------------------------------------------
+void SfpLoggerRegistry::Release(Logger* a_pLogger)
+{
+   pthread_mutex_lock(&m_mutex);
+   for(LoggerMap::iterator it = m_loggers.begin() ; it != m_loggers.end() ; ++it)
+   {
+      if ( it->second.pLogger == a_pLogger )
+      {
+         if ( --it->second.refs == 0 )
+         {
+            delete it->second.pLogger;
+            m_loggers.erase(it);
+         }
+         break;
+      }
+   }
+   pthread_mutex_unlock(&m_mutex);
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Get the number of loggers
+
+   @return     Number of distinct loggers in use
+*/
+// ------------------------------------------------------------------------------------------------
+acd_uint32_t SfpLoggerRegistry::GetLoggerCount()
+{
+   acd_uint32_t count;
+
+   pthread_mutex_lock(&m_mutex);
+   count = m_loggers.size();
+   pthread_mutex_unlock(&m_mutex);
+   return count;
+}
+
+// ================================================================================================
+// ================================================================================================
+//            PRIVATE CLASS SECTION
+// ================================================================================================
+// ================================================================================================
+// ------------------------------------------------------------------------------------------------
+/*!@brief Constructor
+
+*/
+// ------------------------------------------------------------------------------------------------
+SfpLogRing::SfpLogRing() :
+m_head(0),
+m_tail(0),
+m_dropped(0),
+m_bRunning(false),
+m_posters(0)
+{
+   pthread_mutex_init(&m_mutex, NULL);
+   memset(m_records, 0, sizeof(m_records));
+   for(acd_uint32_t i = 0 ; i < SFP_LOG_RING_SIZE ; i++)
+   {
+      m_records[i].seq = i;
+   }
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Destructor
+
+*/
+// ------------------------------------------------------------------------------------------------
+SfpLogRing::~SfpLogRing()
+{
+   Stop();
+   pthread_mutex_destroy(&m_mutex);
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Post a message to the ring
+
+   A record is free for position "pos" when its sequence is pos, and ready to be formatted when
+   its sequence is pos + 1. A poller reserves a position by advancing m_head.
+
+   @param [in]     a_pLogger     : Logger of the SFP
+   @param [in]     a_id          : Message
+   @param [in]     a_suppressed  : Messages suppressed before this one
+   @param [in]     a_arg0        : First message argument
+   @param [in]     a_arg1        : Second message argument
+
+   @return     true if successful, false if the ring is full
+*/
+// ------------------------------------------------------------------------------------------------
+bool SfpLogRing::post(Logger* a_pLogger, SfpLogId a_id, acd_uint32_t a_suppressed, acd_uint32_t a_arg0, acd_uint32_t a_arg1)
+{
+   for( ; ; )
+   {
+      acd_uint32_t   pos = m_head;
+      Record*        pRecord = &m_records[pos & (SFP_LOG_RING_SIZE - 1)];
+      acd_int32_t    diff = (acd_int32_t)(pRecord->seq - pos);
+
+      if ( diff < 0 )
+      {
+         // Not formatted yet since the last lap
+         return false;
+      }
+      if ( (diff == 0) && __sync_bool_compare_and_swap(&m_head, pos, pos + 1) )
+      {
+         pRecord->pLogger = a_pLogger;
+         pRecord->id = a_id;
+         pRecord->suppressed = a_suppressed;
+         pRecord->args[0] = a_arg0;
+         pRecord->args[1] = a_arg1;
+         __sync_synchronize();
+         pRecord->seq = pos + 1;
+         return true;
+      }
+      // Position taken by another poller, try the next one
+   }
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Format and write a message
+
+   @param [in]     a_pLogger     : Logger of the SFP
+   @param [in]     a_id          : Message
+   @param [in]     a_suppressed  : Messages suppressed before this one
+   @param [in]     a_pArgs       : Message arguments, SFP_LOG_MAX_ARGS values
+*/
+// ------------------------------------------------------------------------------------------------
+void SfpLogRing::write(Logger* a_pLogger, SfpLogId a_id, acd_uint32_t a_suppressed, const acd_uint32_t* a_pArgs)
+{
+   char  text[160];
+   int   len;
+
+   if ( (a_pLogger == NULL) || (a_id >= SfpLogIdMax) )
+   {
+      return;
+   }
+
+   len = snprintf(text, sizeof(text), s_messages[a_id].format, a_pArgs[0], a_pArgs[1]);
+   if ( (a_suppressed != 0) && (len > 0) && ((acd_uint32_t)len < sizeof(text)) )
+   {
+      snprintf(&text[len], sizeof(text) - len, " (%u messages suppressed)", a_suppressed);
+   }
+
+   if ( s_messages[a_id].bError )
+   {
+      a_pLogger->LogError("%s", text);
+   }
+   else
+   {
+      a_pLogger->LogDebug("%s", text);
+   }
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Log thread
+
+   @param [in]     a_pArg : Log ring
+
+   @return     NULL
+*/
+// ------------------------------------------------------------------------------------------------
+void* SfpLogRing::threadMain(void* a_pArg)
+{
+   SfpLogRing* pThis = (SfpLogRing*)a_pArg;
+
+   while ( pThis->m_bRunning )
+   {
+      if ( pThis->Drain() == 0 )
+      {
+         acd_usleep(SFP_LOG_DRAIN_MS * 1000);
+      }
+   }
+   // Messages posted before the stop
+   pThis->Drain();
+   return NULL;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Constructor
+
+*/
+// ------------------------------------------------------------------------------------------------
+SfpLoggerRegistry::SfpLoggerRegistry()
+{
+   pthread_mutex_init(&m_mutex, NULL);
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Destructor
+
+*/
+// ------------------------------------------------------------------------------------------------
+SfpLoggerRegistry::~SfpLoggerRegistry()
+{
+   for(LoggerMap::iterator it = m_loggers.begin() ; it != m_loggers.end() ; ++it)
+   {
+      delete it->second.pLogger;
+   }
+   pthread_mutex_destroy(&m_mutex);
+}
@@ -0,0 +1,172 @@
+// ------------------------------------------------------------------------------------------------
+/* ACCEDIAN PROPRIETARY - www.accedian.com
+   COPYRIGHT (c) 2004-2014 BY ACCEDIAN CORPORATION. ALL RIGHTS RESERVED. NO PART OF THIS PROGRAM OR
+   PUBLICATION MAY BE REPRODUCED, TRANSMITTED, TRANSCRIBED, STORED IN A RETRIEVAL SYSTEM,
+   OR TRANSLATED INTO ANY LANGUAGE OR COMPUTER LANGUAGE IN ANY FORM OR BY ANY MEANS, ELECTRONIC,
+   MECHANICAL, MAGNETIC, OPTICAL, CHEMICAL, MANUAL, OR OTHERWISE, WITHOUT THE PRIOR WRITTEN
+   PERMISSION OF ACCEDIAN INC.
+*/
+// ------------------------------------------------------------------------------------------------
+/*!@file    SfpLog.h
+   @brief   SFP deferred logging
+
+   This file contains the rate limiter and the log ring used by the SFP poller to log its errors,
+   and the registry of the loggers shared by the SFP drivers
+*/
+// ------------------------------------------------------------------------------------------------
+#ifndef __SFPLOG_H__
+#define __SFPLOG_H__
+
+#include <pthread.h>
+#include <map>
+#include <string>
+#include <global/acd_types.h>
+
+class Logger;
+
+#define SFP_LOG_BURST            5     // Messages logged back to back by a SFP, see SfpLogBucket
+#define SFP_LOG_PERIOD_MS        60000 // Period of one more message once the burst is used
+#define SFP_LOG_RING_SIZE        256   // Messages waiting to be formatted (power of 2)
+#define SFP_LOG_MAX_ARGS         2     // Arguments of a message
+#define SFP_LOG_DRAIN_MS         50    // Log thread period when the ring is empty
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief SFP log messages
+
+   See s_messages in SfpLog.cpp for the level and format of each message
+*/
+// ------------------------------------------------------------------------------------------------
+enum SfpLogId
+{
+   SfpLogA0ReadFailed = 0,       // A0h EEPROM read failed
+   SfpLogA2ReadFailed,           // A2h EEPROM read failed
+   SfpLogAcReadFailed,           // ACh copper PHY read failed
+   SfpLogFlagsReadFailed,        // A2h alarm flags read failed
+   SfpLogA0Blank,                // A0h read as all 0x00
+   SfpLogA2Blank,                // A2h read as all 0x00
+   SfpLogAcErased,               // ACh read as all 0xFF
+   SfpLogA0Checksum,             // A0h check code failed
+   SfpLogA2Checksum,             // A2h check code failed
+   SfpLogIdMax
+};
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief SFP log rate limiter
+
+   Token bucket: up to "burst" messages are logged back to back, then one message per period.
+   The messages refused are counted and reported with the next message logged.
+
+   One bucket per SFP, used by its poller only. It is not reset when the module is removed, so a
+   flapping module does not get a new burst on each insertion.
+*/
+// ------------------------------------------------------------------------------------------------
+class SfpLogBucket
+{
+
+public:
+   SfpLogBucket(acd_uint32_t a_burst = SFP_LOG_BURST, acd_uint32_t a_periodMs = SFP_LOG_PERIOD_MS);
+
+   bool Allow(acd_uint64_t a_now);
+   acd_uint32_t TakeSuppressed();
+
+private:
+   acd_uint32_t   m_burst;             // Bucket size
+   acd_uint32_t   m_tokens;            // Messages that can be logged now
+   acd_uint64_t   m_periodUs;          // Time to get one more token
+   acd_uint64_t   m_refillTime;        // Time the last token was added, 0 before the first message
+   acd_uint32_t   m_suppressed;        // Messages refused since the last one logged
+};
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief SFP log ring
+
+   Lock-free ring of binary log records (message identifier and arguments). The pollers post
+   the records without formatting them, the log thread (see Start()) formats them and writes
+   them to the logger of each SFP. A record posted when the ring is full is dropped and counted.
+
+   Without the log thread, Log() formats and writes the message right away. Stop() waits for the
+   pollers posting when it stops the thread, and writes their messages.
+*/
+// ------------------------------------------------------------------------------------------------
+class SfpLogRing
+{
+
+public:
+   static SfpLogRing* GetInstance();
+
+   void Log(Logger* a_pLogger, SfpLogId a_id, acd_uint32_t a_suppressed,
+            acd_uint32_t a_arg0 = 0, acd_uint32_t a_arg1 = 0);
+   acd_uint32_t Drain();
+   void Flush();
+   acd_uint32_t GetDroppedCount();
+
+   bool Start();
+   void Stop();
+   bool IsRunning();
+
+private:
+   SfpLogRing();
+   virtual ~SfpLogRing();
+
+   struct Record
+   {
+      volatile acd_uint32_t seq;                   // Ring position the record is ready for
+      Logger*        pLogger;                      // Logger of the SFP
+      SfpLogId       id;                           // Message
+      acd_uint32_t   suppressed;                   // Messages suppressed before this one
+      acd_uint32_t   args[SFP_LOG_MAX_ARGS];       // Message arguments
+   };
+
+   bool post(Logger* a_pLogger, SfpLogId a_id, acd_uint32_t a_suppressed, acd_uint32_t a_arg0, acd_uint32_t a_arg1);
+   static void write(Logger* a_pLogger, SfpLogId a_id, acd_uint32_t a_suppressed, const acd_uint32_t* a_pArgs);
+   static void* threadMain(void* a_pArg);
+
+   static SfpLogRing* s_pTheInstance;
+
+   Record            m_records[SFP_LOG_RING_SIZE]; // Ring
+   volatile acd_uint32_t m_head;                   // Next position to post, shared by the pollers
+   volatile acd_uint32_t m_tail;                   // Next position to format, log thread only
+   volatile acd_uint32_t m_dropped;                // Records dropped, ring full
+   pthread_t         m_thread;                     // Log thread
+   volatile bool     m_bRunning;                   // Log thread running
+   volatile acd_uint32_t m_posters;                // Pollers posting, see Log()
+   pthread_mutex_t   m_mutex;                      // Serializes Start(), Stop() and the drains without thread
+};
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief SFP logger registry
+
+   The I2C and PHY drivers of the SFPs get their logger from the registry instead of creating
+   their own: the drivers created with the same name share one logger (ex: all the drivers of a
+   controller), which is deleted when the last of them releases it.
+*/
+// ------------------------------------------------------------------------------------------------
+class SfpLoggerRegistry
+{
+
+public:
+   static SfpLoggerRegistry* GetInstance();
+
+   Logger* Acquire(const char* a_name);
+   void Release(Logger* a_pLogger);
+   acd_uint32_t GetLoggerCount();
+
+private:
+   SfpLoggerRegistry();
+   virtual ~SfpLoggerRegistry();
+
+   struct Entry
+   {
+      Logger*        pLogger;          // Shared logger
+      acd_uint32_t   refs;             // Number of users
+   };
+
+   typedef std::map<std::string, Entry> LoggerMap;
+
+   static SfpLoggerRegistry* s_pTheInstance;
+
+   LoggerMap         m_loggers;        // Loggers by name
+   pthread_mutex_t   m_mutex;          // Protects m_loggers
+};
+
+#endif // #ifndef __SFPLOG_H__
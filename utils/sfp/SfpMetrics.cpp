@@ -0,0 +1,461 @@
+// ------------------------------------------------------------------------------------------------
+/* ACCEDIAN PROPRIETARY - www.accedian.com
+   COPYRIGHT (c) 2004-2014 BY ACCEDIAN CORPORATION. ALL RIGHTS RESERVED. NO PART OF THIS PROGRAM OR
+   PUBLICATION MAY BE REPRODUCED, TRANSMITTED, TRANSCRIBED, STORED IN A RETRIEVAL SYSTEM,
+   OR TRANSLATED INTO ANY LANGUAGE OR COMPUTER LANGUAGE IN ANY FORM OR BY ANY MEANS, ELECTRONIC,
+   MECHANICAL, MAGNETIC, OPTICAL, CHEMICAL, MANUAL, OR OTHERWISE, WITHOUT THE PRIOR WRITTEN
+   PERMISSION OF ACCEDIAN INC.
+*/
+// ------------------------------------------------------------------------------------------------
+/*!@file    SfpMetrics.cpp
+   @brief   SFP metrics exporter
+
+   This file contains the class exporting the SFP and I2C counters in the Prometheus text format
+
+*/
+// ------------------------------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "SfpMetrics.h"
+#include "I2cIoDrvV02.h"
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief SFP counter metric, see HalSfpCounters
+*/
+// ------------------------------------------------------------------------------------------------
+struct SfpCounterMetric
+{
+   const char*    name;             // Metric name
+   const char*    help;             // Metric description, NULL if same metric as the previous one
+   const char*    labels;           // Labels added to the port label, "" for none
+   acd_uint32_t HalSfpCounters::* pCounter;
+};
+
+static const SfpCounterMetric s_counterMetrics[] =
+{
+   { "sfp_data_polls_total",        "A0h updates",                      "",              &HalSfpCounters::dataPolls        },
+   { "sfp_data_errors_total",       "A0h update failures",              "",              &HalSfpCounters::dataErrors       },
+   { "sfp_monitoring_polls_total",  "A2h updates",                      "",              &HalSfpCounters::monPolls         },
+   { "sfp_monitoring_errors_total", "A2h update failures",              "",              &HalSfpCounters::monErrors        },
+   { "sfp_checksum_errors_total",   "Check code failures",              ",page=\"a0\"",  &HalSfpCounters::a0ChecksumErrors },
+   { "sfp_checksum_errors_total",   NULL,                               ",page=\"a2\"",  &HalSfpCounters::a2ChecksumErrors },
+   { "sfp_identity_cache_hits_total", "A0h reads skipped, module unchanged", "",         &HalSfpCounters::identityHits     },
+   { "sfp_page_reads_total",        "Pages read by the page cache",     "",              &HalSfpCounters::pageReads        },
+   { "sfp_page_cache_hits_total",   "Paged memory reads from the cache", "",             &HalSfpCounters::pageHits         },
+};
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief SFP DDM metric, in the units of the HalSfp getters
+*/
+// ------------------------------------------------------------------------------------------------
+struct SfpDdmMetric
+{
+   const char*    name;             // Metric name
+   const char*    help;             // Metric description
+   SfpDdmParam    param;            // DDM parameter
+};
+
+static const SfpDdmMetric s_ddmMetrics[] =
+{
+   { "sfp_temperature_celsius",        "Module temperature",            SfpDdmParamTemp    },
+   { "sfp_voltage_millivolts",         "Supply voltage",                SfpDdmParamVcc     },
+   { "sfp_bias_microamps",             "Laser bias current",            SfpDdmParamBias    },
+   { "sfp_tx_power_tenth_microwatts",  "Tx output power",               SfpDdmParamTxPower },
+   { "sfp_rx_power_tenth_microwatts",  "Rx input power",                SfpDdmParamRxPower },
+};
+
+static const char* s_stageNames[HalSfpGroupStageMax] = { "status", "presence", "data", "monitoring" };
+
+#define SFP_METRICS_POLL_MS      100   // Exporter thread stop check period
+
+// ================================================================================================
+// ================================================================================================
+//            PUBLIC CLASS SECTION
+// ================================================================================================
+// ================================================================================================
+// ------------------------------------------------------------------------------------------------
+/*!@brief Constructor
+
+   @param [in]     a_pGroup : SFP group exported
+*/
+// ------------------------------------------------------------------------------------------------
+SfpMetricsExporter::SfpMetricsExporter(HalSfpGroup* a_pGroup) :
+m_pGroup(a_pGroup),
+m_listenFd(-1),
+m_bRunning(false),
+m_scrapeCount(0)
+{
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Destructor
+
+*/
+// ------------------------------------------------------------------------------------------------
+SfpMetricsExporter::~SfpMetricsExporter()
+{
+   Stop();
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Format a snapshot of the metrics
+
+   @param [out]    a_text : Metrics in the Prometheus text exposition format
+*/
+// ------------------------------------------------------------------------------------------------
+void SfpMetricsExporter::Format(std::string& a_text)
+{
+   a_text.clear();
+   a_text.reserve(16384);
+   formatGroup(a_text);
+   formatPorts(a_text);
+   formatControllers(a_text);
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Write a snapshot of the metrics to a file
+
+   The snapshot is written to a temporary file renamed over a_path, so a reader never sees a
+   partial snapshot.
+
+   @param [in]     a_path : File path
+
+   @return     true if successful
+*/
+// ------------------------------------------------------------------------------------------------
+bool SfpMetricsExporter::WriteFile(const char* a_path)
+{
+   std::string text;
+   std::string tmpPath(a_path);
+   FILE*       pFile;
+   bool        bRet;
+
+   Format(text);
+   tmpPath += ".tmp";
+   pFile = fopen(tmpPath.c_str(), "w");
+   if ( pFile == NULL )
+   {
+      return false;
+   }
+   bRet = (fwrite(text.data(), 1, text.size(), pFile) == text.size());
+   bRet = (fclose(pFile) == 0) && bRet;
+   if ( bRet )
+   {
+      bRet = (rename(tmpPath.c_str(), a_path) == 0);
+   }
+   if ( !bRet )
+   {
+      unlink(tmpPath.c_str());
+   }
+   return bRet;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Start serving the metrics on a UNIX socket
+
+   The exporter thread writes one snapshot to each connection and closes it
+   (ex: "socat - UNIX-CONNECT:<path>").
+
+   @param [in]     a_socketPath : UNIX socket path, replaced if it exists
+
+   @return     true if successful
+*/
+// ------------------------------------------------------------------------------------------------
+bool SfpMetricsExporter::Start(const char* a_socketPath)
+{
+   struct sockaddr_un addr;
+
+   if ( m_bRunning || (strlen(a_socketPath) >= sizeof(addr.sun_path)) )
+   {
+      return false;
+   }
+
+   memset(&addr, 0, sizeof(addr));
+   addr.sun_family = AF_UNIX;
+   strcpy(addr.sun_path, a_socketPath);
+   unlink(a_socketPath);
+
+   m_listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+   if ( m_listenFd < 0 )
+   {
+      return false;
+   }
+   if ( (bind(m_listenFd, (struct sockaddr*)&addr, sizeof(addr)) != 0) ||
+        (listen(m_listenFd, 4) != 0) )
+   {
+      close(m_listenFd);
+      m_listenFd = -1;
+      return false;
+   }
+   m_socketPath = a_socketPath;
+
+   m_bRunning = true;
+   if ( pthread_create(&m_thread, NULL, threadMain, this) != 0 )
+   {
+      m_bRunning = false;
+      close(m_listenFd);
+      m_listenFd = -1;
+      unlink(m_socketPath.c_str());
+      return false;
+   }
+   return true;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Stop serving the metrics
+
+*/
+// ------------------------------------------------------------------------------------------------
+void SfpMetricsExporter::Stop()
+{
+   if ( m_bRunning )
+   {
+      m_bRunning = false;
+      pthread_join(m_thread, NULL);
+      close(m_listenFd);
+      m_listenFd = -1;
+      unlink(m_socketPath.c_str());
+   }
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Get the number of snapshots served on the socket
+
+   @return     Number of scrapes
+*/
+// ------------------------------------------------------------------------------------------------
+acd_uint32_t SfpMetricsExporter::GetScrapeCount()
+{
+   return m_scrapeCount;
+}
+
+// ================================================================================================
+// ================================================================================================
+//            PRIVATE CLASS SECTION
+// ================================================================================================
+// ================================================================================================
+// ------------------------------------------------------------------------------------------------
+/*!@brief Format the group poll statistics
+
+   @param [in,out] a_text : Metrics text
+*/
+// ------------------------------------------------------------------------------------------------
+void SfpMetricsExporter::formatGroup(std::string& a_text)
+{
+   HalSfpGroupStats stats;
+
+   m_pGroup->GetStats(stats);
+
+   header(a_text, "sfp_poll_cycles_total", "Poll cycles", "counter");
+   append(a_text, "sfp_poll_cycles_total %u\n", stats.cycles);
+   header(a_text, "sfp_poll_cycle_seconds_total", "Time spent in the poll cycles", "counter");
+   append(a_text, "sfp_poll_cycle_seconds_total %llu.%06llu\n",
+          stats.totalCycleUs / 1000000, stats.totalCycleUs % 1000000);
+   header(a_text, "sfp_poll_cycle_last_seconds", "Duration of the last poll cycle", "gauge");
+   append(a_text, "sfp_poll_cycle_last_seconds %llu.%06llu\n",
+          stats.lastCycleUs / 1000000, stats.lastCycleUs % 1000000);
+   header(a_text, "sfp_poll_cycle_max_seconds", "Longest poll cycle", "gauge");
+   append(a_text, "sfp_poll_cycle_max_seconds %llu.%06llu\n",
+          stats.maxCycleUs / 1000000, stats.maxCycleUs % 1000000);
+   header(a_text, "sfp_poll_stage_seconds_total", "Time spent in each poll stage", "counter");
+   for(acd_uint32_t i = 0 ; i < HalSfpGroupStageMax ; i++)
+   {
+      append(a_text, "sfp_poll_stage_seconds_total{stage=\"%s\"} %llu.%06llu\n", s_stageNames[i],
+             stats.totalStageUs[i] / 1000000, stats.totalStageUs[i] % 1000000);
+   }
+   header(a_text, "sfp_status_errors_total", "Board status read failures", "counter");
+   append(a_text, "sfp_status_errors_total %u\n", stats.nbStatusErrors);
+   header(a_text, "sfp_monitoring_skipped_total", "A2h updates not due yet", "counter");
+   append(a_text, "sfp_monitoring_skipped_total %u\n", stats.nbMonSkipped);
+   header(a_text, "sfp_ports_present", "SFPs present on the last poll cycle", "gauge");
+   append(a_text, "sfp_ports_present %u\n", stats.nbPresent);
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Format the counters and DDM values of each SFP
+
+   The DDM values are only given for the modules identified and diagnostic capable.
+
+   @param [in,out] a_text : Metrics text
+*/
+// ------------------------------------------------------------------------------------------------
+void SfpMetricsExporter::formatPorts(std::string& a_text)
+{
+   HalSfpCounters counters[HAL_SFP_GROUP_MAX_PORTS];
+   acd_int32_t    ddm[HAL_SFP_GROUP_MAX_PORTS][SfpDdmParamMax];
+   bool           bDdm[HAL_SFP_GROUP_MAX_PORTS];
+   acd_uint32_t   nbPorts = m_pGroup->GetPortCount();
+   HalSfpIdentity identity;
+
+   // One snapshot per SFP, then one metric at a time as the format requires
+   for(acd_uint32_t i = 0 ; i < nbPorts ; i++)
+   {
+      HalSfp* pSfp = m_pGroup->GetPort(i);
+
+      pSfp->GetCounters(counters[i]);
+      bDdm[i] = pSfp->GetIdentity(identity) && pSfp->IsDiagCapable();
+      if ( bDdm[i] )
+      {
+         pSfp->GetDdmValues(ddm[i]);
+      }
+   }
+
+   for(acd_uint32_t m = 0 ; m < (sizeof(s_counterMetrics) / sizeof(s_counterMetrics[0])) ; m++)
+   {
+      const SfpCounterMetric& metric = s_counterMetrics[m];
+
+      if ( metric.help != NULL )
+      {
+         header(a_text, metric.name, metric.help, "counter");
+      }
+      for(acd_uint32_t i = 0 ; i < nbPorts ; i++)
+      {
+         append(a_text, "%s{port=\"%u\"%s} %u\n", metric.name, i, metric.labels, counters[i].*metric.pCounter);
+      }
+   }
+
+   for(acd_uint32_t m = 0 ; m < (sizeof(s_ddmMetrics) / sizeof(s_ddmMetrics[0])) ; m++)
+   {
+      const SfpDdmMetric& metric = s_ddmMetrics[m];
+
+      header(a_text, metric.name, metric.help, "gauge");
+      for(acd_uint32_t i = 0 ; i < nbPorts ; i++)
+      {
+         if ( bDdm[i] )
+         {
+            append(a_text, "%s{port=\"%u\"} %d\n", metric.name, i, ddm[i][metric.param]);
+         }
+      }
+   }
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Format the statistics of each I2C controller
+
+   @param [in,out] a_text : Metrics text
+*/
+// ------------------------------------------------------------------------------------------------
+void SfpMetricsExporter::formatControllers(std::string& a_text)
+{
+   I2cIoDrvStats  stats[I2cIoDrvV02::I2C_MAX_CONTROLLERS];
+   acd_uint32_t   baseAddress[I2cIoDrvV02::I2C_MAX_CONTROLLERS];
+   acd_uint32_t   nbControllers = 0;
+
+   while ( (nbControllers < I2cIoDrvV02::I2C_MAX_CONTROLLERS) &&
+           I2cIoDrvV02::GetControllerStats(nbControllers, baseAddress[nbControllers], stats[nbControllers]) )
+   {
+      nbControllers++;
+   }
+
+   header(a_text, "sfp_i2c_reads_total", "I2C read transactions", "counter");
+   for(acd_uint32_t i = 0 ; i < nbControllers ; i++)
+   {
+      append(a_text, "sfp_i2c_reads_total{controller=\"0x%x\"} %u\n", baseAddress[i], stats[i].reads);
+   }
+   header(a_text, "sfp_i2c_writes_total", "I2C write transactions", "counter");
+   for(acd_uint32_t i = 0 ; i < nbControllers ; i++)
+   {
+      append(a_text, "sfp_i2c_writes_total{controller=\"0x%x\"} %u\n", baseAddress[i], stats[i].writes);
+   }
+   header(a_text, "sfp_i2c_errors_total", "I2C transaction failures", "counter");
+   for(acd_uint32_t i = 0 ; i < nbControllers ; i++)
+   {
+      append(a_text, "sfp_i2c_errors_total{controller=\"0x%x\",type=\"io\"} %u\n", baseAddress[i], stats[i].ioErrors);
+      append(a_text, "sfp_i2c_errors_total{controller=\"0x%x\",type=\"bus\"} %u\n", baseAddress[i], stats[i].busErrors);
+   }
+   header(a_text, "sfp_i2c_timeouts_total", "I2C transactions timed out", "counter");
+   for(acd_uint32_t i = 0 ; i < nbControllers ; i++)
+   {
+      append(a_text, "sfp_i2c_timeouts_total{controller=\"0x%x\"} %u\n", baseAddress[i], stats[i].timeouts);
+   }
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Add the HELP and TYPE lines of a metric
+
+   @param [in,out] a_text : Metrics text
+   @param [in]     a_name : Metric name
+   @param [in]     a_help : Metric description
+   @param [in]     a_type : Metric type ("counter" or "gauge")
+*/
+// ------------------------------------------------------------------------------------------------
+void SfpMetricsExporter::header(std::string& a_text, const char* a_name, const char* a_help, const char* a_type)
+{
+   append(a_text, "# HELP %s %s\n# TYPE %s %s\n", a_name, a_help, a_name, a_type);
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Add a formatted line to the metrics
+
+   @param [in,out] a_text   : Metrics text
+   @param [in]     a_format : printf format
+*/
+// ------------------------------------------------------------------------------------------------
+void SfpMetricsExporter::append(std::string& a_text, const char* a_format, ...)
+{
+   char     line[256];
+   va_list  args;
+   int      len;
+
+   va_start(args, a_format);
+   len = vsnprintf(line, sizeof(line), a_format, args);
+   va_end(args);
+   if ( len > 0 )
+   {
+      a_text.append(line, ((acd_uint32_t)len < sizeof(line)) ? len : (sizeof(line) - 1));
+   }
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Exporter thread
+
+   @param [in]     a_pArg : Exporter
+
+   @return     NULL
+*/
+// ------------------------------------------------------------------------------------------------
+void* SfpMetricsExporter::threadMain(void* a_pArg)
+{
+   SfpMetricsExporter* pThis = (SfpMetricsExporter*)a_pArg;
+   std::string         text;
+
+   while ( pThis->m_bRunning )
+   {
+      struct pollfd pfd;
+      int           fd;
+
+      pfd.fd = pThis->m_listenFd;
+      pfd.events = POLLIN;
+      pfd.revents = 0;
+      if ( poll(&pfd, 1, SFP_METRICS_POLL_MS) <= 0 )
+      {
+         continue;
+      }
+      fd = accept(pThis->m_listenFd, NULL, NULL);
+      if ( fd < 0 )
+      {
+         continue;
+      }
+
+      pThis->Format(text);
+      for(size_t sent = 0 ; sent < text.size() ; )
+      {
+         ssize_t len = send(fd, text.data() + sent, text.size() - sent, MSG_NOSIGNAL);
+
+         if ( len <= 0 )
+         {
+            break;
+         }
+         sent += len;
+      }
+      close(fd);
+      pThis->m_scrapeCount++;
+   }
+   return NULL;
+}
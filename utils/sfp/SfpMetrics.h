@@ -0,0 +1,70 @@
+// ------------------------------------------------------------------------------------------------
+/* ACCEDIAN PROPRIETARY - www.accedian.com
+   COPYRIGHT (c) 2004-2014 BY ACCEDIAN CORPORATION. ALL RIGHTS RESERVED. NO PART OF THIS PROGRAM OR
+   PUBLICATION MAY BE REPRODUCED, TRANSMITTED, TRANSCRIBED, STORED IN A RETRIEVAL SYSTEM,
+   OR TRANSLATED INTO ANY LANGUAGE OR COMPUTER LANGUAGE IN ANY FORM OR BY ANY MEANS, ELECTRONIC,
+   MECHANICAL, MAGNETIC, OPTICAL, CHEMICAL, MANUAL, OR OTHERWISE, WITHOUT THE PRIOR WRITTEN
+   PERMISSION OF ACCEDIAN INC.
+*/
+// ------------------------------------------------------------------------------------------------
+/*!@file    SfpMetrics.h
+   @brief   SFP metrics exporter
+
+   This file contains the class exporting the SFP and I2C counters in the Prometheus text format
+*/
+// ------------------------------------------------------------------------------------------------
+#ifndef __SFPMETRICS_H__
+#define __SFPMETRICS_H__
+
+#include <pthread.h>
+#include <string>
+#include "HalSfpGroup.h"
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief SFP metrics exporter
+
+   Formats a snapshot of the counters of a SFP group in the Prometheus text exposition format:
+   the group poll statistics, the poll counters and DDM values of each SFP (label "port", the
+   index in the group) and the statistics of each I2C controller (label "controller", the base
+   address).
+
+   The snapshot is taken without any lock (see HalSfpGroup::GetStats(), HalSfp::GetCounters()
+   and I2cIoDrvV02::GetControllerStats()), so a scrape never delays the poller. The counters of
+   a SFP can be one update behind.
+
+   The snapshot is pulled either from a file, rewritten atomically by WriteFile() (ex: for the
+   node exporter textfile collector), or from a UNIX socket served by the exporter thread (see
+   Start()), which writes one snapshot to each connection and closes it.
+*/
+// ------------------------------------------------------------------------------------------------
+class SfpMetricsExporter
+{
+
+public:
+   SfpMetricsExporter(HalSfpGroup* a_pGroup);
+   virtual ~SfpMetricsExporter();
+
+   void Format(std::string& a_text);
+   bool WriteFile(const char* a_path);
+
+   bool Start(const char* a_socketPath);
+   void Stop();
+   acd_uint32_t GetScrapeCount();
+
+private:
+   void formatGroup(std::string& a_text);
+   void formatPorts(std::string& a_text);
+   void formatControllers(std::string& a_text);
+   static void header(std::string& a_text, const char* a_name, const char* a_help, const char* a_type);
+   static void append(std::string& a_text, const char* a_format, ...);
+   static void* threadMain(void* a_pArg);
+
+   HalSfpGroup*      m_pGroup;            // SFP group exported
+   std::string       m_socketPath;        // UNIX socket path
+   int               m_listenFd;          // UNIX socket, -1 if not listening
+   pthread_t         m_thread;            // Exporter thread
+   volatile bool     m_bRunning;          // Exporter thread running
+   volatile acd_uint32_t m_scrapeCount;   // Snapshots served on the socket
+};
+
+#endif // #ifndef __SFPMETRICS_H__
@@ -0,0 +1,201 @@
+// ------------------------------------------------------------------------------------------------
+/* ACCEDIAN PROPRIETARY - www.accedian.com
+   COPYRIGHT (c) 2004-2014 BY ACCEDIAN CORPORATION. ALL RIGHTS RESERVED. NO PART OF THIS PROGRAM OR
+   PUBLICATION MAY BE REPRODUCED, TRANSMITTED, TRANSCRIBED, STORED IN A RETRIEVAL SYSTEM,
+   OR TRANSLATED INTO ANY LANGUAGE OR COMPUTER LANGUAGE IN ANY FORM OR BY ANY MEANS, ELECTRONIC,
+   MECHANICAL, MAGNETIC, OPTICAL, CHEMICAL, MANUAL, OR OTHERWISE, WITHOUT THE PRIOR WRITTEN
+   PERMISSION OF ACCEDIAN INC.
+*/
+// ------------------------------------------------------------------------------------------------
+/*!@file    SfpModuleDesc.cpp
+   @brief   Decoded SFP module descriptor
+
+   This file contains the SFP module descriptor pool class
+
+*/
+// ------------------------------------------------------------------------------------------------
+
+#include <string.h>
+#include <stddef.h>
+#include "SfpModuleDesc.h"
+
+SfpModuleDescPool* SfpModuleDescPool::s_pTheInstance = NULL;
+
+// ================================================================================================
+// ================================================================================================
+//            PUBLIC CLASS SECTION
+// ================================================================================================
+// ================================================================================================
+// ------------------------------------------------------------------------------------------------
+/*!@brief Get the descriptor pool instance
+
+*/
+// ------------------------------------------------------------------------------------------------
+SfpModuleDescPool* SfpModuleDescPool::GetInstance()
+{
+   if ( s_pTheInstance == NULL )
+   {
+      SfpModuleDescPool* pPool = new SfpModuleDescPool;
+
+      // The SFPs of several I2C controllers can be decoded concurrently, see HalSfpGroup
+      if ( !__sync_bool_compare_and_swap(&s_pTheInstance, NULL, pPool) )
+      {
+         delete pPool;
+      }
+   }
+   return s_pTheInstance;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Build the descriptor key of a module
+
+   The key is the A0h data less the fields specific to a unit: the serial number, the date code
+   and the extended check code computed over them are cleared.
+
+   @param [in]     a_pA0  : A0h bytes 0-95
+   @param [out]    a_pKey : Key (SFP_DESC_KEY_SIZE)
+*/
+// ------------------------------------------------------------------------------------------------
+void SfpModuleDescPool::MakeKey(const acd_uint8_t* a_pA0, acd_uint8_t* a_pKey)
+{
+   memcpy(a_pKey, a_pA0, SFP_DESC_KEY_SIZE);
+   memset(a_pKey + offsetof(sfp_hdr_type, serial), 0,
+          offsetof(sfp_hdr_type, diag) - offsetof(sfp_hdr_type, serial));
+   a_pKey[HAL_SFP_CC_EXT] = 0;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Find the descriptor of a module
+
+   Does not lock: the descriptors are fully written before they are linked in their bucket.
+
+   @param [in]     a_pKey : Key, see MakeKey()
+
+   @return     Interned descriptor, NULL if not found
+*/
+// ------------------------------------------------------------------------------------------------
+const SfpModuleDesc* SfpModuleDescPool::Find(const acd_uint8_t* a_pKey)
+{
+   return find(a_pKey, hash(a_pKey));
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Intern a descriptor
+
+   @param [in]     a_desc : Decoded descriptor, identified by its key
+
+   @return     Interned descriptor, NULL if the pool is full
+*/
+// ------------------------------------------------------------------------------------------------
+const SfpModuleDesc* SfpModuleDescPool::Intern(const SfpModuleDesc& a_desc)
+{
+   acd_uint32_t         bucket = hash(a_desc.key);
+   const SfpModuleDesc* pDesc;
+
+   pthread_mutex_lock(&m_mutex);
+
+   // Another port may have interned the same module in the meantime
+   pDesc = find(a_desc.key, bucket);
+   if ( (pDesc == NULL) && (m_count < SFP_DESC_POOL_SIZE) )
+   {
+      acd_uint32_t idx = m_count;
+
+      m_descs[idx] = a_desc;
+      m_next[idx]  = m_buckets[bucket];
+      __sync_synchronize();
+      m_buckets[bucket] = idx + 1;
+      m_count = idx + 1;
+      pDesc = &m_descs[idx];
+   }
+
+   pthread_mutex_unlock(&m_mutex);
+   return pDesc;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Get the number of interned descriptors
+
+   @return     Number of descriptors
+*/
+// ------------------------------------------------------------------------------------------------
+acd_uint32_t SfpModuleDescPool::GetCount()
+{
+   return m_count;
+}
+
+// ================================================================================================
+// ================================================================================================
+//            PRIVATE CLASS SECTION
+// ================================================================================================
+// ================================================================================================
+// ------------------------------------------------------------------------------------------------
+/*!@brief Constructor
+
+*/
+// ------------------------------------------------------------------------------------------------
+SfpModuleDescPool::SfpModuleDescPool() :
+m_count(0)
+{
+   memset(m_buckets, 0, sizeof(m_buckets));
+   pthread_mutex_init(&m_mutex, NULL);
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Destructor
+
+*/
+// ------------------------------------------------------------------------------------------------
+SfpModuleDescPool::~SfpModuleDescPool()
+{
+   pthread_mutex_destroy(&m_mutex);
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Hash a descriptor key
+
+   The base check code and the part number are enough to tell the module types apart.
+
+   @param [in]     a_pKey : Key, see MakeKey()
+
+   @return     Bucket index
+*/
+// ------------------------------------------------------------------------------------------------
+acd_uint32_t SfpModuleDescPool::hash(const acd_uint8_t* a_pKey)
+{
+   const acd_uint8_t*   pPn = a_pKey + offsetof(sfp_hdr_type, vendor_pn);
+   acd_uint32_t         h = 2166136261u;    // FNV-1a
+
+   h = (h ^ a_pKey[HAL_SFP_CC_BASE]) * 16777619u;
+   for(acd_uint32_t i = 0 ; i < sizeof(((sfp_hdr_type*)0)->vendor_pn) ; i++)
+   {
+      h = (h ^ pPn[i]) * 16777619u;
+   }
+   return h & (SFP_DESC_HASH_SIZE - 1);
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Find a descriptor in a bucket
+
+   @param [in]     a_pKey   : Key, see MakeKey()
+   @param [in]     a_bucket : Bucket index, see hash()
+
+   @return     Interned descriptor, NULL if not found
+*/
+// ------------------------------------------------------------------------------------------------
+const SfpModuleDesc* SfpModuleDescPool::find(const acd_uint8_t* a_pKey, acd_uint32_t a_bucket)
+{
+   acd_uint32_t idx = m_buckets[a_bucket];
+
+   __sync_synchronize();
+   while ( idx != 0 )
+   {
+      const SfpModuleDesc* pDesc = &m_descs[idx - 1];
+
+      if ( memcmp(pDesc->key, a_pKey, SFP_DESC_KEY_SIZE) == 0 )
+      {
+         return pDesc;
+      }
+      idx = m_next[idx - 1];
+   }
+   return NULL;
+}
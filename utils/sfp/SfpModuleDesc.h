@@ -0,0 +1,90 @@
+// ------------------------------------------------------------------------------------------------
+/* ACCEDIAN PROPRIETARY - www.accedian.com
+   COPYRIGHT (c) 2004-2014 BY ACCEDIAN CORPORATION. ALL RIGHTS RESERVED. NO PART OF THIS PROGRAM OR
+   PUBLICATION MAY BE REPRODUCED, TRANSMITTED, TRANSCRIBED, STORED IN A RETRIEVAL SYSTEM,
+   OR TRANSLATED INTO ANY LANGUAGE OR COMPUTER LANGUAGE IN ANY FORM OR BY ANY MEANS, ELECTRONIC,
+   MECHANICAL, MAGNETIC, OPTICAL, CHEMICAL, MANUAL, OR OTHERWISE, WITHOUT THE PRIOR WRITTEN
+   PERMISSION OF ACCEDIAN INC.
+*/
+// ------------------------------------------------------------------------------------------------
+/*!@file    SfpModuleDesc.h
+   @brief   Decoded SFP module descriptor
+
+   This file contains the SFP module descriptor and descriptor pool class definitions
+*/
+// ------------------------------------------------------------------------------------------------
+#ifndef __SFPMODULEDESC_H__
+#define __SFPMODULEDESC_H__
+
+#include <pthread.h>
+#include "HalSfp.h"
+
+#define SFP_DESC_KEY_SIZE     (HAL_SFP_CC_EXT + 1)    // A0h bytes identifying a module type (0-95)
+#define SFP_DESC_POOL_SIZE    256                     // Maximum number of descriptors interned
+#define SFP_DESC_HASH_SIZE    64                      // Number of hash buckets, power of 2
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Decoded SFP module descriptor
+
+   Built once per module type from the A0h serial ID fields, see HalSfp::decodeDescriptor().
+   The strings are NULL terminated with the trailing spaces removed, except the part number
+   which ends at its first space (same as HalSfp::GetVendorPartNumber()).
+
+   Only holds the fields shared by all the units of a type: the serial number and the date
+   code of a module are read from its A0h data, see HalSfp::GetSerial().
+*/
+// ------------------------------------------------------------------------------------------------
+struct SfpModuleDesc
+{
+   acd_uint8_t    key[SFP_DESC_KEY_SIZE];    // Key of the A0h data, see SfpModuleDescPool::MakeKey()
+   acd_uint8_t    id;                        // Identifier
+   acd_uint8_t    connector;                 // Connector, SFP_CONN_RJ45 for a copper module
+   acd_uint16_t   wavelength;                // Wavelength field, as read
+   char           vendor[17];                // Vendor name
+   acd_uint8_t    vendorOui[3];              // Vendor OUI
+   acd_uchar8_t   vendorPn[17];              // Vendor part number
+   char           vendorRev[5];              // Vendor revision
+   bool           bLengthValid;              // A link length is specified
+   acd_uint32_t   length;                    // Link length in meters
+   bool           bIsCopper;                 // Copper module
+   bool           speedCap[HalSfpSeedMax];   // Speed capabilities
+};
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief SFP module descriptor pool
+
+   Interns the descriptors by the A0h data they were decoded from, less the fields specific to a
+   unit (see MakeKey()), so a module type is decoded (and looked up in the SFP database) once, and
+   all the ports holding modules of the same type share the same descriptor. Interned descriptors
+   are never modified nor freed: readers may keep a pointer without locking. When the pool is
+   full, Intern() returns NULL and the SFP keeps its own copy, see HalSfp::keepLocalDescriptor().
+*/
+// ------------------------------------------------------------------------------------------------
+class SfpModuleDescPool
+{
+
+public:
+   static SfpModuleDescPool* GetInstance();
+   static void MakeKey(const acd_uint8_t* a_pA0, acd_uint8_t* a_pKey);
+
+   const SfpModuleDesc* Find(const acd_uint8_t* a_pKey);
+   const SfpModuleDesc* Intern(const SfpModuleDesc& a_desc);
+   acd_uint32_t GetCount();
+
+private:
+   SfpModuleDescPool();
+   virtual ~SfpModuleDescPool();
+
+   static acd_uint32_t hash(const acd_uint8_t* a_pKey);
+   const SfpModuleDesc* find(const acd_uint8_t* a_pKey, acd_uint32_t a_bucket);
+
+   SfpModuleDesc     m_descs[SFP_DESC_POOL_SIZE];   // Interned descriptors
+   acd_uint16_t      m_next[SFP_DESC_POOL_SIZE];    // Next descriptor in the same bucket
+   acd_uint16_t      m_buckets[SFP_DESC_HASH_SIZE]; // First descriptor of each bucket
+   volatile acd_uint32_t m_count;                   // Number of descriptors used
+   pthread_mutex_t   m_mutex;                       // Protects the insertions
+
+   static SfpModuleDescPool*  s_pTheInstance;
+};
+
+#endif // #ifndef __SFPMODULEDESC_H__
@@ -0,0 +1,224 @@
+// ------------------------------------------------------------------------------------------------
+/* ACCEDIAN PROPRIETARY - www.accedian.com
+   COPYRIGHT (c) 2004-2014 BY ACCEDIAN CORPORATION. ALL RIGHTS RESERVED. NO PART OF THIS PROGRAM OR
+   PUBLICATION MAY BE REPRODUCED, TRANSMITTED, TRANSCRIBED, STORED IN A RETRIEVAL SYSTEM,
+   OR TRANSLATED INTO ANY LANGUAGE OR COMPUTER LANGUAGE IN ANY FORM OR BY ANY MEANS, ELECTRONIC,
+   MECHANICAL, MAGNETIC, OPTICAL, CHEMICAL, MANUAL, OR OTHERWISE, WITHOUT THE PRIOR WRITTEN
+   PERMISSION OF ACCEDIAN INC.
+*/
+// ------------------------------------------------------------------------------------------------
+/*!@file    SfpPageBuffer.cpp
+   @brief   SFP published EEPROM pages
+
+   This file contains the SFP double buffered page classes
+
+*/
+// ------------------------------------------------------------------------------------------------
+
+#include <string.h>
+#include "SfpPageBuffer.h"
+
+// ================================================================================================
+// ================================================================================================
+//            PUBLIC CLASS SECTION
+// ================================================================================================
+// ================================================================================================
+// ------------------------------------------------------------------------------------------------
+/*!@brief Constructor
+
+*/
+// ------------------------------------------------------------------------------------------------
+SfpPageBuffer::SfpPageBuffer() :
+m_active(0),
+m_generation(0)
+{
+   memset(m_pages, 0, sizeof(m_pages));
+   m_seq[0] = 0;
+   m_seq[1] = 0;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Destructor
+
+*/
+// ------------------------------------------------------------------------------------------------
+SfpPageBuffer::~SfpPageBuffer()
+{
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Publish a new set of pages
+
+   Must only be called by the poller.
+
+   @param [in]     a_pInterface : A0h page
+   @param [in]     a_pMon       : A2h page
+
+   @return     Published pages
+*/
+// ------------------------------------------------------------------------------------------------
+const SfpPages* SfpPageBuffer::Publish(const acd_uint8_t* a_pInterface, const acd_uint8_t* a_pMon)
+{
+   acd_uint32_t   idx = m_active ^ 1;
+   SfpPages&      pages = m_pages[idx];
+
+   m_seq[idx]++;
+   __sync_synchronize();
+
+   memcpy(pages.interfaceData, a_pInterface, SFP_PAGE_BUFFER_SIZE);
+   memcpy(pages.monData, a_pMon, SFP_PAGE_BUFFER_SIZE);
+
+   __sync_synchronize();
+   m_seq[idx]++;
+   m_generation++;
+   __sync_synchronize();
+   m_active = idx;
+
+   return &pages;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Get the published pages
+
+   The pages are overwritten by the second next publication. Use Read() to get a copy that is
+   guaranteed to be consistent.
+
+   @return     Published pages
+*/
+// ------------------------------------------------------------------------------------------------
+const SfpPages* SfpPageBuffer::GetActive()
+{
+   return &m_pages[m_active];
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Get a consistent copy of the published pages
+
+   @param [out]    a_pages       : Copy of the pages
+   @param [out]    a_pGeneration : Publication number of the copy, optional
+
+   @return     true if successful, false if the poller kept overwriting the buffer
+*/
+// ------------------------------------------------------------------------------------------------
+bool SfpPageBuffer::Read(SfpPages& a_pages, acd_uint32_t* a_pGeneration)
+{
+   for(acd_uint32_t retry = 0 ; retry < SFP_PAGE_READ_RETRY ; retry++)
+   {
+      acd_uint32_t idx = m_active;
+      acd_uint32_t generation = m_generation;
+      acd_uint32_t seq;
+
+      __sync_synchronize();
+      seq = m_seq[idx];
+      if ( seq & 1 )
+      {
+         continue;
+      }
+      __sync_synchronize();
+
+      memcpy(&a_pages, &m_pages[idx], sizeof(a_pages));
+
+      __sync_synchronize();
+      if ( m_seq[idx] == seq )
+      {
+         if ( a_pGeneration != NULL )
+         {
+            *a_pGeneration = generation;
+         }
+         return true;
+      }
+   }
+   return false;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Get the number of publications
+
+   Readers can compare it to a previous value to know if the data changed.
+
+   @return     Publication number
+*/
+// ------------------------------------------------------------------------------------------------
+acd_uint32_t SfpPageBuffer::GetGeneration()
+{
+   return m_generation;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Constructor
+
+*/
+// ------------------------------------------------------------------------------------------------
+SfpPhyPageBuffer::SfpPhyPageBuffer() :
+m_active(0)
+{
+   memset(m_pages, 0, sizeof(m_pages));
+   m_seq[0] = 0;
+   m_seq[1] = 0;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Destructor
+
+*/
+// ------------------------------------------------------------------------------------------------
+SfpPhyPageBuffer::~SfpPhyPageBuffer()
+{
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Publish a new ACh page
+
+   Must only be called by the poller.
+
+   @param [in]     a_pPhy : ACh page
+*/
+// ------------------------------------------------------------------------------------------------
+void SfpPhyPageBuffer::Publish(const acd_uint8_t* a_pPhy)
+{
+   acd_uint32_t idx = m_active ^ 1;
+
+   m_seq[idx]++;
+   __sync_synchronize();
+
+   memcpy(m_pages[idx], a_pPhy, SFP_PAGE_BUFFER_SIZE);
+
+   __sync_synchronize();
+   m_seq[idx]++;
+   __sync_synchronize();
+   m_active = idx;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Get a consistent copy of the published ACh page
+
+   @param [out]    a_pPhy : Copy of the page (SFP_PAGE_BUFFER_SIZE bytes)
+
+   @return     true if successful, false if the poller kept overwriting the buffer
+*/
+// ------------------------------------------------------------------------------------------------
+bool SfpPhyPageBuffer::Read(acd_uint8_t* a_pPhy)
+{
+   for(acd_uint32_t retry = 0 ; retry < SFP_PAGE_READ_RETRY ; retry++)
+   {
+      acd_uint32_t idx = m_active;
+      acd_uint32_t seq;
+
+      __sync_synchronize();
+      seq = m_seq[idx];
+      if ( seq & 1 )
+      {
+         continue;
+      }
+      __sync_synchronize();
+
+      memcpy(a_pPhy, m_pages[idx], SFP_PAGE_BUFFER_SIZE);
+
+      __sync_synchronize();
+      if ( m_seq[idx] == seq )
+      {
+         return true;
+      }
+   }
+   return false;
+}
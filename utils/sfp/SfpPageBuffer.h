@@ -0,0 +1,85 @@
+// ------------------------------------------------------------------------------------------------
+/* ACCEDIAN PROPRIETARY - www.accedian.com
+   COPYRIGHT (c) 2004-2014 BY ACCEDIAN CORPORATION. ALL RIGHTS RESERVED. NO PART OF THIS PROGRAM OR
+   PUBLICATION MAY BE REPRODUCED, TRANSMITTED, TRANSCRIBED, STORED IN A RETRIEVAL SYSTEM,
+   OR TRANSLATED INTO ANY LANGUAGE OR COMPUTER LANGUAGE IN ANY FORM OR BY ANY MEANS, ELECTRONIC,
+   MECHANICAL, MAGNETIC, OPTICAL, CHEMICAL, MANUAL, OR OTHERWISE, WITHOUT THE PRIOR WRITTEN
+   PERMISSION OF ACCEDIAN INC.
+*/
+// ------------------------------------------------------------------------------------------------
+/*!@file    SfpPageBuffer.h
+   @brief   SFP published EEPROM pages
+
+   This file contains the SFP double buffered page classes definition
+*/
+// ------------------------------------------------------------------------------------------------
+#ifndef __SFPPAGEBUFFER_H__
+#define __SFPPAGEBUFFER_H__
+
+#include <global/acd_types.h>
+
+#define SFP_PAGE_BUFFER_SIZE     128   // Size of a page, same as HAL_SFP_PAGE_SIZE
+#define SFP_PAGE_READ_RETRY      100   // Maximum number of read attempts while the writer is active
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief SFP EEPROM pages
+*/
+// ------------------------------------------------------------------------------------------------
+struct SfpPages
+{
+   acd_uint8_t    interfaceData[SFP_PAGE_BUFFER_SIZE];   // A0h interface ID memory
+   acd_uint8_t    monData[SFP_PAGE_BUFFER_SIZE];         // A2h diagnostic memory
+};
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief SFP double buffered pages
+
+   The poller publishes a complete set of pages by filling the inactive buffer and switching the
+   active buffer index. Readers are never blocked: each buffer has a sequence counter that is odd
+   while the buffer is written, so a reader retries if the buffer it copied was reused by the
+   poller in the meantime. There must be only one writer.
+*/
+// ------------------------------------------------------------------------------------------------
+class SfpPageBuffer
+{
+
+public:
+   SfpPageBuffer();
+   virtual ~SfpPageBuffer();
+
+   const SfpPages* Publish(const acd_uint8_t* a_pInterface, const acd_uint8_t* a_pMon);
+   const SfpPages* GetActive();
+   bool Read(SfpPages& a_pages, acd_uint32_t* a_pGeneration = NULL);
+   acd_uint32_t GetGeneration();
+
+private:
+   SfpPages                m_pages[2];
+   volatile acd_uint32_t   m_seq[2];         // Odd while the buffer is written
+   volatile acd_uint32_t   m_active;         // Index of the published buffer
+   volatile acd_uint32_t   m_generation;     // Number of publications
+};
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief SFP double buffered ACh copper PHY page
+
+   Same as SfpPageBuffer for the ACh page, which only copper modules have: it is kept apart so
+   the fiber modules do not carry it, see HalSfp::publishPhyData().
+*/
+// ------------------------------------------------------------------------------------------------
+class SfpPhyPageBuffer
+{
+
+public:
+   SfpPhyPageBuffer();
+   virtual ~SfpPhyPageBuffer();
+
+   void Publish(const acd_uint8_t* a_pPhy);
+   bool Read(acd_uint8_t* a_pPhy);
+
+private:
+   acd_uint8_t             m_pages[2][SFP_PAGE_BUFFER_SIZE];
+   volatile acd_uint32_t   m_seq[2];         // Odd while the buffer is written
+   volatile acd_uint32_t   m_active;         // Index of the published buffer
+};
+
+#endif // #ifndef __SFPPAGEBUFFER_H__
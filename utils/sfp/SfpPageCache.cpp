@@ -0,0 +1,359 @@
+// ------------------------------------------------------------------------------------------------
+/* ACCEDIAN PROPRIETARY - www.accedian.com
+   COPYRIGHT (c) 2004-2014 BY ACCEDIAN CORPORATION. ALL RIGHTS RESERVED. NO PART OF THIS PROGRAM OR
+   PUBLICATION MAY BE REPRODUCED, TRANSMITTED, TRANSCRIBED, STORED IN A RETRIEVAL SYSTEM,
+   OR TRANSLATED INTO ANY LANGUAGE OR COMPUTER LANGUAGE IN ANY FORM OR BY ANY MEANS, ELECTRONIC,
+   MECHANICAL, MAGNETIC, OPTICAL, CHEMICAL, MANUAL, OR OTHERWISE, WITHOUT THE PRIOR WRITTEN
+   PERMISSION OF ACCEDIAN INC.
+*/
+// ------------------------------------------------------------------------------------------------
+/*!@file    SfpPageCache.cpp
+   @brief   SFP paged memory cache
+
+   This file contains the SFP paged memory cache class
+
+*/
+// ------------------------------------------------------------------------------------------------
+
+#include "SfpPageCache.h"
+#include "SfpTime.h"
+
+// ================================================================================================
+// ================================================================================================
+//            PUBLIC CLASS SECTION
+// ================================================================================================
+// ================================================================================================
+// ------------------------------------------------------------------------------------------------
+/*!@brief Constructor
+
+   @param [in]     a_pIoDrv  : I2C driver supporting byte offset accesses (see HAL_SFP_I2C_REG)
+   @param [in]     a_nbPages : Maximum number of pages cached
+*/
+// ------------------------------------------------------------------------------------------------
+SfpPageCache::SfpPageCache(BaseIoDrv<acd_uint8_t>* a_pIoDrv, acd_uint32_t a_nbPages) :
+m_pIoDrv(a_pIoDrv),
+m_nbPages(a_nbPages),
+m_pagedRegion(0xA2),
+m_selectedPage(SFP_PAGE_LOWER),
+m_readCount(0),
+m_hitCount(0)
+{
+   m_pPages = new Page[m_nbPages];
+   memset(m_pPages, 0, m_nbPages * sizeof(Page));
+   pthread_mutex_init(&m_mutex, NULL);
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Destructor
+
+*/
+// ------------------------------------------------------------------------------------------------
+SfpPageCache::~SfpPageCache()
+{
+   delete [] m_pPages;
+   pthread_mutex_destroy(&m_mutex);
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Set the memory region holding the page select byte
+
+   The cached pages are invalidated when the region changes.
+
+   @param [in]     a_region   : 0xA2 for a SFP (default), 0xA0 for a QSFP
+*/
+// ------------------------------------------------------------------------------------------------
+void SfpPageCache::SetPagedRegion(acd_uint32_t a_region)
+{
+   pthread_mutex_lock(&m_mutex);
+   if ( m_pagedRegion != a_region )
+   {
+      invalidate();
+      m_pagedRegion = a_region;
+   }
+   pthread_mutex_unlock(&m_mutex);
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Set the refresh policy of a page
+
+   Pages without a policy are static.
+
+   @param [in]     a_region   : Memory region (0xA0 or 0xA2)
+   @param [in]     a_page     : Page number, see SFP_PAGE_LOWER
+   @param [in]     a_policy   : Refresh policy
+   @param [in]     a_periodMs : Refresh period in msec of a periodic page
+
+   @return     true if successful
+*/
+// ------------------------------------------------------------------------------------------------
+bool SfpPageCache::SetPolicy(acd_uint32_t a_region, acd_uint32_t a_page, SfpPagePolicy a_policy, acd_uint32_t a_periodMs)
+{
+   Page* pPage;
+
+   pthread_mutex_lock(&m_mutex);
+   pPage = find(a_region, a_page, true);
+   if ( pPage != NULL )
+   {
+      pPage->policy = a_policy;
+      pPage->periodUs = (acd_uint64_t)a_periodMs * 1000;
+   }
+   pthread_mutex_unlock(&m_mutex);
+   return pPage != NULL;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Read paged memory
+
+   The page is read from the SFP only if it is not cached or if its refresh policy requires it.
+
+   @param [in]     a_region   : Memory region (0xA0 or 0xA2)
+   @param [in]     a_page     : Page number, see SFP_PAGE_LOWER
+   @param [in]     a_offset   : Byte offset within the page (0-127)
+   @param [in]     a_size     : Number of bytes to read
+   @param [out]    a_pBuf     : Data
+
+   @return     true if successful
+*/
+// ------------------------------------------------------------------------------------------------
+bool SfpPageCache::Read(acd_uint32_t a_region, acd_uint32_t a_page, acd_uint32_t a_offset, acd_uint32_t a_size, acd_uint8_t* a_pBuf)
+{
+   Page* pPage;
+   bool  bRet = false;
+
+   if ( (a_offset + a_size) > HAL_SFP_PAGE_SIZE )
+   {
+      return false;
+   }
+
+   pthread_mutex_lock(&m_mutex);
+   pPage = find(a_region, a_page, true);
+   if ( pPage != NULL )
+   {
+      if ( !pPage->bValid ||
+           (pPage->policy == SfpPagePolicyOnDemand) ||
+           ((pPage->policy == SfpPagePolicyPeriodic) && ((sfpGetTimeUs() - pPage->timestamp) >= pPage->periodUs)) )
+      {
+         bRet = fetch(pPage);
+      }
+      else
+      {
+         m_hitCount++;
+         bRet = true;
+      }
+      if ( bRet )
+      {
+         memcpy(a_pBuf, &pPage->data[a_offset], a_size);
+      }
+   }
+   pthread_mutex_unlock(&m_mutex);
+   return bRet;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Read a page from the SFP regardless of its policy
+
+   @param [in]     a_region   : Memory region (0xA0 or 0xA2)
+   @param [in]     a_page     : Page number, see SFP_PAGE_LOWER
+
+   @return     true if successful
+*/
+// ------------------------------------------------------------------------------------------------
+bool SfpPageCache::Refresh(acd_uint32_t a_region, acd_uint32_t a_page)
+{
+   Page* pPage;
+   bool  bRet;
+
+   pthread_mutex_lock(&m_mutex);
+   pPage = find(a_region, a_page, true);
+   bRet = (pPage != NULL) && fetch(pPage);
+   pthread_mutex_unlock(&m_mutex);
+   return bRet;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Read the periodic pages that are due
+
+   Called by the poller so the periodic pages are up to date when they are accessed. The mutex is
+   taken for each page so a Read() from another thread waits for one page read at most.
+*/
+// ------------------------------------------------------------------------------------------------
+void SfpPageCache::Poll()
+{
+   acd_uint64_t now = sfpGetTimeUs();
+
+   for(acd_uint32_t i = 0 ; i < m_nbPages ; i++)
+   {
+      Page* pPage = &m_pPages[i];
+
+      pthread_mutex_lock(&m_mutex);
+      if ( pPage->bUsed && (pPage->policy == SfpPagePolicyPeriodic) &&
+           (!pPage->bValid || ((now - pPage->timestamp) >= pPage->periodUs)) )
+      {
+         fetch(pPage);
+      }
+      pthread_mutex_unlock(&m_mutex);
+   }
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Invalidate all the pages
+
+   Called when the SFP is removed. The policies are kept.
+*/
+// ------------------------------------------------------------------------------------------------
+void SfpPageCache::Invalidate()
+{
+   pthread_mutex_lock(&m_mutex);
+   invalidate();
+   pthread_mutex_unlock(&m_mutex);
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Get the number of pages read from the SFP
+
+   @return     Number of page reads
+*/
+// ------------------------------------------------------------------------------------------------
+acd_uint32_t SfpPageCache::GetReadCount()
+{
+   return m_readCount;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Get the number of reads served from the cache
+
+   @return     Number of cache hits
+*/
+// ------------------------------------------------------------------------------------------------
+acd_uint32_t SfpPageCache::GetHitCount()
+{
+   return m_hitCount;
+}
+
+// ================================================================================================
+// ================================================================================================
+//            PRIVATE CLASS SECTION
+// ================================================================================================
+// ================================================================================================
+// ------------------------------------------------------------------------------------------------
+/*!@brief Invalidate all the pages, mutex taken
+
+*/
+// ------------------------------------------------------------------------------------------------
+void SfpPageCache::invalidate()
+{
+   for(acd_uint32_t i = 0 ; i < m_nbPages ; i++)
+   {
+      m_pPages[i].bValid = false;
+   }
+   m_selectedPage = SFP_PAGE_LOWER;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Find a page entry
+
+   @param [in]     a_region   : Memory region
+   @param [in]     a_page     : Page number
+   @param [in]     a_bCreate  : Allocate a free entry if the page is not found
+
+   @return     Page entry, NULL if not found or if the cache is full
+*/
+// ------------------------------------------------------------------------------------------------
+SfpPageCache::Page* SfpPageCache::find(acd_uint32_t a_region, acd_uint32_t a_page, bool a_bCreate)
+{
+   Page* pFree = NULL;
+
+   if ( ((a_region != 0xA0) && (a_region != 0xA2)) || (a_page > SFP_PAGE_LOWER) )
+   {
+      return NULL;
+   }
+   if ( (a_region != m_pagedRegion) && (a_page != SFP_PAGE_LOWER) )
+   {
+      // The upper memory of this region is not paged
+      a_page = 0;
+   }
+
+   for(acd_uint32_t i = 0 ; i < m_nbPages ; i++)
+   {
+      Page* pPage = &m_pPages[i];
+
+      if ( !pPage->bUsed )
+      {
+         if ( pFree == NULL )
+         {
+            pFree = pPage;
+         }
+      }
+      else if ( (pPage->region == a_region) && (pPage->page == a_page) )
+      {
+         return pPage;
+      }
+   }
+
+   if ( !a_bCreate || (pFree == NULL) )
+   {
+      return NULL;
+   }
+   pFree->bUsed  = true;
+   pFree->bValid = false;
+   pFree->region = a_region;
+   pFree->page   = a_page;
+   pFree->policy = SfpPagePolicyStatic;
+   return pFree;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Read a page from the SFP, mutex taken
+
+   On a failed read the page select byte is unknown: it is written again on the next access.
+
+   @param [in]     a_pPage : Page entry
+
+   @return     true if successful
+*/
+// ------------------------------------------------------------------------------------------------
+bool SfpPageCache::fetch(Page* a_pPage)
+{
+   acd_uint32_t offset = (a_pPage->page == SFP_PAGE_LOWER) ? 0 : HAL_SFP_PAGE_SIZE;
+
+   if ( (a_pPage->region == m_pagedRegion) && (a_pPage->page != SFP_PAGE_LOWER) && !selectPage(a_pPage->page) )
+   {
+      a_pPage->bValid = false;
+      return false;
+   }
+
+   a_pPage->bValid = m_pIoDrv->Read(HAL_SFP_I2C_REG(a_pPage->region, offset), HAL_SFP_PAGE_SIZE, a_pPage->data);
+   if ( a_pPage->bValid )
+   {
+      a_pPage->timestamp = sfpGetTimeUs();
+      m_readCount++;
+   }
+   else
+   {
+      m_selectedPage = SFP_PAGE_LOWER;
+   }
+   return a_pPage->bValid;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Select the upper memory page, mutex taken
+
+   @param [in]     a_page : Page number
+
+   @return     true if successful
+*/
+// ------------------------------------------------------------------------------------------------
+bool SfpPageCache::selectPage(acd_uint32_t a_page)
+{
+   if ( m_selectedPage == a_page )
+   {
+      return true;
+   }
+   if ( !m_pIoDrv->Write(HAL_SFP_I2C_REG(m_pagedRegion, HAL_SFP_PAGE_SELECT), (acd_uint8_t)a_page) )
+   {
+      m_selectedPage = SFP_PAGE_LOWER;
+      return false;
+   }
+   m_selectedPage = a_page;
+   return true;
+}
@@ -0,0 +1,87 @@
+// ------------------------------------------------------------------------------------------------
+/* ACCEDIAN PROPRIETARY - www.accedian.com
+   COPYRIGHT (c) 2004-2014 BY ACCEDIAN CORPORATION. ALL RIGHTS RESERVED. NO PART OF THIS PROGRAM OR
+   PUBLICATION MAY BE REPRODUCED, TRANSMITTED, TRANSCRIBED, STORED IN A RETRIEVAL SYSTEM,
+   OR TRANSLATED INTO ANY LANGUAGE OR COMPUTER LANGUAGE IN ANY FORM OR BY ANY MEANS, ELECTRONIC,
+   MECHANICAL, MAGNETIC, OPTICAL, CHEMICAL, MANUAL, OR OTHERWISE, WITHOUT THE PRIOR WRITTEN
+   PERMISSION OF ACCEDIAN INC.
+*/
+// ------------------------------------------------------------------------------------------------
+/*!@file    SfpPageCache.h
+   @brief   SFP paged memory cache
+
+   This file contains the SFP paged memory cache class definition
+*/
+// ------------------------------------------------------------------------------------------------
+#ifndef __SFPPAGECACHE_H__
+#define __SFPPAGECACHE_H__
+
+#include <pthread.h>
+#include <accedian/acclib/BaseIoDrv.h>
+#include "HalSfp.h"
+
+#define SFP_PAGE_CACHE_SIZE   8        // Default number of pages cached
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief SFP paged memory cache
+
+   This class gives access to the SFF-8472 paged memory of one SFP. A page is identified by its
+   memory region (0xA0 or 0xA2) and its page number: SFP_PAGE_LOWER for bytes 0-127, or the
+   value written to the page select byte (127) for the upper memory (bytes 128-255). The page
+   select byte is in A2h for a SFP and in A0h for a QSFP (SFF-8636). It is only written when the
+   page changes.
+
+   Pages are read as a whole and kept according to their refresh policy, so the pages that never
+   change are read once per module.
+
+   The cache is used by the poller (see Poll()) and by the callers of HalSfp::ReadPagedMemory():
+   the page table and the page select byte are protected by a mutex, held from the page select
+   write to the end of the page read.
+*/
+// ------------------------------------------------------------------------------------------------
+class SfpPageCache
+{
+
+public:
+   SfpPageCache(BaseIoDrv<acd_uint8_t>* a_pIoDrv, acd_uint32_t a_nbPages = SFP_PAGE_CACHE_SIZE);
+   virtual ~SfpPageCache();
+
+   void SetPagedRegion(acd_uint32_t a_region);
+   bool SetPolicy(acd_uint32_t a_region, acd_uint32_t a_page, SfpPagePolicy a_policy, acd_uint32_t a_periodMs = 0);
+   bool Read(acd_uint32_t a_region, acd_uint32_t a_page, acd_uint32_t a_offset, acd_uint32_t a_size, acd_uint8_t* a_pBuf);
+   bool Refresh(acd_uint32_t a_region, acd_uint32_t a_page);
+   void Poll();
+   void Invalidate();
+
+   acd_uint32_t GetReadCount();
+   acd_uint32_t GetHitCount();
+
+private:
+   struct Page
+   {
+      bool           bUsed;            // Entry in use
+      bool           bValid;           // Data is up to date
+      acd_uint32_t   region;           // Memory region
+      acd_uint32_t   page;             // Page number, see SFP_PAGE_LOWER
+      SfpPagePolicy  policy;           // Refresh policy
+      acd_uint64_t   periodUs;         // Refresh period of periodic pages
+      acd_uint64_t   timestamp;        // Time of the last read
+      acd_uint8_t    data[HAL_SFP_PAGE_SIZE];
+   };
+
+   void invalidate();
+   Page* find(acd_uint32_t a_region, acd_uint32_t a_page, bool a_bCreate);
+   bool fetch(Page* a_pPage);
+   bool selectPage(acd_uint32_t a_page);
+
+   BaseIoDrv<acd_uint8_t>* m_pIoDrv;  // I2C driver
+   Page*          m_pPages;            // Page entries
+   acd_uint32_t   m_nbPages;           // Number of entries
+   acd_uint32_t   m_pagedRegion;       // Region with a page select byte (0xA2 SFP, 0xA0 QSFP)
+   acd_uint32_t   m_selectedPage;      // Current page select value, SFP_PAGE_LOWER if unknown
+   acd_uint32_t   m_readCount;         // Number of pages read from the SFP
+   acd_uint32_t   m_hitCount;          // Number of Read() served from the cache
+   pthread_mutex_t m_mutex;            // Protects the pages and the page select byte
+};
+
+#endif // #ifndef __SFPPAGECACHE_H__
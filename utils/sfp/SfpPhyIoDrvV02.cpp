@@ -18,6 +18,7 @@
 #include <accedian/acclib/Logger.h>
 #include <accedian/acclib/acd_utils.h>
 #include "I2cIoDrvV02.h"
+#include "SfpLog.h"
 
 // ================================================================================================
 // ================================================================================================
@@ -42,8 +43,7 @@ m_pIoBase(a_pIoBase),
 m_pLogger(NULL),
 m_baseAddress(a_baseAddress)
 {
-   m_pLogger = new Logger(a_name);
-   m_pLogger->SetDebug(false);
+   m_pLogger = SfpLoggerRegistry::GetInstance()->Acquire(a_name);
 }
 
 // ------------------------------------------------------------------------------------------------
@@ -53,7 +53,7 @@ m_baseAddress(a_baseAddress)
 // ------------------------------------------------------------------------------------------------
 SfpPhyIoDrvV02::~SfpPhyIoDrvV02()
 {
-   delete m_pLogger;
+   SfpLoggerRegistry::GetInstance()->Release(m_pLogger);
 }
 
 // ------------------------------------------------------------------------------------------------
@@ -0,0 +1,172 @@
+// ------------------------------------------------------------------------------------------------
+/* ACCEDIAN PROPRIETARY - www.accedian.com
+   COPYRIGHT (c) 2004-2014 BY ACCEDIAN CORPORATION. ALL RIGHTS RESERVED. NO PART OF THIS PROGRAM OR
+   PUBLICATION MAY BE REPRODUCED, TRANSMITTED, TRANSCRIBED, STORED IN A RETRIEVAL SYSTEM,
+   OR TRANSLATED INTO ANY LANGUAGE OR COMPUTER LANGUAGE IN ANY FORM OR BY ANY MEANS, ELECTRONIC,
+   MECHANICAL, MAGNETIC, OPTICAL, CHEMICAL, MANUAL, OR OTHERWISE, WITHOUT THE PRIOR WRITTEN
+   PERMISSION OF ACCEDIAN INC.
+*/
+// ------------------------------------------------------------------------------------------------
+/*!@file    SfpPlatform.h
+   @brief   SFP control and status register maps
+
+   This file contains the SFP register map of each platform
+*/
+// ------------------------------------------------------------------------------------------------
+#ifndef __SFPPLATFORM_H__
+#define __SFPPLATFORM_H__
+
+#include <string.h>
+#include <global/acd_types.h>
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief SFP per port register field
+
+   Describes a one bit field repeated for each port: the field of port index i (0 for the first
+   SFP) is bit FIRST_BIT + (i % PORTS_PER_REG) * BIT_STRIDE of register
+   FIRST_REG + (i / PORTS_PER_REG) * REG_STRIDE. The arithmetic is on compile time constants,
+   no table nor branch per port.
+*/
+// ------------------------------------------------------------------------------------------------
+template <acd_uint32_t REG, acd_uint32_t BIT, acd_uint32_t STRIDE, acd_uint32_t PER_REG, acd_uint32_t REG_STEP>
+struct SfpPortField
+{
+   enum
+   {
+      FIRST_REG      = REG,            // Register of the first port
+      FIRST_BIT      = BIT,            // Bit of the first port
+      BIT_STRIDE     = STRIDE,         // Bits between two ports
+      PORTS_PER_REG  = PER_REG,        // Ports per register
+      REG_STRIDE     = REG_STEP        // Offset between two registers
+   };
+
+   static inline acd_uint32_t Word(acd_uint32_t a_index)
+   {
+      return a_index / PER_REG;
+   }
+
+   static inline acd_uint32_t Reg(acd_uint32_t a_index)
+   {
+      return REG + Word(a_index) * REG_STEP;
+   }
+
+   static inline acd_uint32_t Bit(acd_uint32_t a_index)
+   {
+      return BIT + (a_index % PER_REG) * STRIDE;
+   }
+
+   static inline acd_uint64_t Mask(acd_uint32_t a_index)
+   {
+      return (acd_uint64_t)1 << Bit(a_index);
+   }
+};
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Etchell-4 SFP registers
+
+   Control register: sfpN_enable_n, sfpN_ratesel, sfpN_txdisable for each SFP
+   Status register:  sfpN_enable_n_status, sfpN_detect_n, sfpN_sdet_n, sfpN_txfault for each SFP
+*/
+// ------------------------------------------------------------------------------------------------
+struct SfpPlatformE4
+{
+   enum { NB_PORTS = 4, NB_CTRL_REGS = 1, NB_STATUS_REGS = 1 };
+
+   typedef SfpPortField<0x01, 0, 3, 4, 0> Enable;      // sfpN_enable_n, active low
+   typedef SfpPortField<0x01, 2, 3, 4, 0> TxDisable;   // sfpN_txdisable
+   typedef SfpPortField<0x86, 1, 4, 4, 0> Detect;      // sfpN_detect_n, active low
+};
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Etchell-5 SFP registers
+
+*/
+// ------------------------------------------------------------------------------------------------
+struct SfpPlatformE5
+{
+   enum { NB_PORTS = 8, NB_CTRL_REGS = 1, NB_STATUS_REGS = 1 };
+
+   typedef SfpPortField<0x10000, 0, 4, 8, 0> Enable;   // Active low
+   typedef SfpPortField<0x10000, 1, 4, 8, 0> TxDisable;
+   typedef SfpPortField<0x10001, 0, 4, 8, 0> Detect;   // Active low
+};
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Clipper SFP registers
+
+   Ports 1-8 in the first control and status registers, ports 9-12 in the second ones.
+   The Tx disable bit of a port is in the same control register as its enable bit.
+*/
+// ------------------------------------------------------------------------------------------------
+struct SfpPlatformClipper
+{
+   enum { NB_PORTS = 12, NB_CTRL_REGS = 2, NB_STATUS_REGS = 2 };
+
+   typedef SfpPortField<0x500, 0, 4, 8, 1> Enable;     // Active low
+   typedef SfpPortField<0x500, 1, 4, 8, 1> TxDisable;
+   typedef SfpPortField<0x502, 1, 4, 8, 1> Detect;     // Active low
+};
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Clipper-2 SFP registers
+
+*/
+// ------------------------------------------------------------------------------------------------
+struct SfpPlatformClipper2
+{
+   enum { NB_PORTS = 8, NB_CTRL_REGS = 1, NB_STATUS_REGS = 1 };
+
+   typedef SfpPortField<0x500, 0, 4, 8, 1> Enable;     // Active low
+   typedef SfpPortField<0x500, 1, 4, 8, 1> TxDisable;
+   typedef SfpPortField<0x502, 1, 4, 8, 1> Detect;     // Active low
+};
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief SFP registers of a port
+
+   Resolved once per port from the platform register map, see sfpGetPortRegs()
+*/
+// ------------------------------------------------------------------------------------------------
+struct SfpPortRegs
+{
+   acd_uint32_t   ctrlWord;            // Control register index, see NB_CTRL_REGS
+   acd_uint32_t   enableReg;           // Enable (power) register
+   acd_uint64_t   enableMask;          // Enable bit, active low
+   acd_uint32_t   txDisableReg;        // Tx disable register
+   acd_uint64_t   txDisableMask;       // Tx disable bit
+   acd_uint32_t   detectWord;          // Status register index, see NB_STATUS_REGS
+   acd_uint32_t   detectBit;           // Detect bit number, active low
+   acd_uint64_t   detectMask;          // Detect bit
+};
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Resolve the registers of a port
+
+   The masks of an invalid port are 0.
+
+   @param [in]     a_index : Port index, 0 for the first SFP
+   @param [out]    a_regs  : Port registers
+
+   @return     true if successful, false if the port does not exist on the platform
+*/
+// ------------------------------------------------------------------------------------------------
+template <class P>
+inline bool sfpGetPortRegs(acd_uint32_t a_index, SfpPortRegs& a_regs)
+{
+   memset(&a_regs, 0, sizeof(a_regs));
+   if ( a_index >= (acd_uint32_t)P::NB_PORTS )
+   {
+      return false;
+   }
+   a_regs.ctrlWord      = P::Enable::Word(a_index);
+   a_regs.enableReg     = P::Enable::Reg(a_index);
+   a_regs.enableMask    = P::Enable::Mask(a_index);
+   a_regs.txDisableReg  = P::TxDisable::Reg(a_index);
+   a_regs.txDisableMask = P::TxDisable::Mask(a_index);
+   a_regs.detectWord    = P::Detect::Word(a_index);
+   a_regs.detectBit     = P::Detect::Bit(a_index);
+   a_regs.detectMask    = P::Detect::Mask(a_index);
+   return true;
+}
+
+#endif // #ifndef __SFPPLATFORM_H__
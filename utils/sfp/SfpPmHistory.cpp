@@ -0,0 +1,252 @@
+// ------------------------------------------------------------------------------------------------
+/* ACCEDIAN PROPRIETARY - www.accedian.com
+   COPYRIGHT (c) 2004-2014 BY ACCEDIAN CORPORATION. ALL RIGHTS RESERVED. NO PART OF THIS PROGRAM OR
+   PUBLICATION MAY BE REPRODUCED, TRANSMITTED, TRANSCRIBED, STORED IN A RETRIEVAL SYSTEM,
+   OR TRANSLATED INTO ANY LANGUAGE OR COMPUTER LANGUAGE IN ANY FORM OR BY ANY MEANS, ELECTRONIC,
+   MECHANICAL, MAGNETIC, OPTICAL, CHEMICAL, MANUAL, OR OTHERWISE, WITHOUT THE PRIOR WRITTEN
+   PERMISSION OF ACCEDIAN INC.
+*/
+// ------------------------------------------------------------------------------------------------
+/*!@file    SfpPmHistory.cpp
+   @brief   SFP DDM history
+
+   This file contains the SFP DDM history and performance monitoring bins class
+
+*/
+// ------------------------------------------------------------------------------------------------
+
+#include "SfpPmHistory.h"
+
+static const acd_uint64_t s_pmIntervalUs[SfpPmIntervalMax] =
+{
+   15ULL * 60 * 1000000,         // SfpPmInterval15Min
+   24ULL * 3600 * 1000000        // SfpPmInterval24H
+};
+
+static const acd_uint32_t s_pmBinCount[SfpPmIntervalMax] =
+{
+   SFP_PM_15MIN_BINS,
+   SFP_PM_24H_BINS
+};
+
+// ================================================================================================
+// ================================================================================================
+//            PUBLIC CLASS SECTION
+// ================================================================================================
+// ================================================================================================
+// ------------------------------------------------------------------------------------------------
+/*!@brief Constructor
+
+   @param [in]     a_nbSamples : Number of samples kept in the ring buffer
+*/
+// ------------------------------------------------------------------------------------------------
+SfpPmHistory::SfpPmHistory(acd_uint32_t a_nbSamples) :
+m_nbSamples(a_nbSamples ? a_nbSamples : 1)
+{
+   m_pSamples = new SfpPmSample[m_nbSamples];
+   Clear();
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Destructor
+
+*/
+// ------------------------------------------------------------------------------------------------
+SfpPmHistory::~SfpPmHistory()
+{
+   delete [] m_pSamples;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Add a sample
+
+   @param [in]     a_timestamp : Wall clock time in usec
+   @param [in]     a_values    : Converted values indexed by SfpDdmParam
+*/
+// ------------------------------------------------------------------------------------------------
+void SfpPmHistory::AddSample(acd_uint64_t a_timestamp, const acd_int32_t a_values[SfpDdmParamMax])
+{
+   SfpPmSample& sample = m_pSamples[m_head];
+
+   sample.timestamp = a_timestamp;
+   memcpy(sample.value, a_values, sizeof(sample.value));
+   m_head = (m_head + 1) % m_nbSamples;
+   if ( m_count < m_nbSamples )
+   {
+      m_count++;
+   }
+
+   updateBin(SfpPmInterval15Min, a_timestamp, a_values);
+   updateBin(SfpPmInterval24H, a_timestamp, a_values);
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Remove all the samples and bins
+
+*/
+// ------------------------------------------------------------------------------------------------
+void SfpPmHistory::Clear()
+{
+   m_head = 0;
+   m_count = 0;
+   memset(m_current, 0, sizeof(m_current));
+   memset(m_bin15Min, 0, sizeof(m_bin15Min));
+   memset(m_bin24H, 0, sizeof(m_bin24H));
+   memset(m_binHead, 0, sizeof(m_binHead));
+   memset(m_binCount, 0, sizeof(m_binCount));
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Get the number of samples in the ring buffer
+
+   @return     Number of samples
+*/
+// ------------------------------------------------------------------------------------------------
+acd_uint32_t SfpPmHistory::GetSampleCount()
+{
+   return m_count;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Get a sample
+
+   @param [in]     a_age    : 0 for the most recent sample
+   @param [out]    a_sample : Sample
+
+   @return     true if successful
+*/
+// ------------------------------------------------------------------------------------------------
+bool SfpPmHistory::GetSample(acd_uint32_t a_age, SfpPmSample& a_sample)
+{
+   if ( a_age >= m_count )
+   {
+      return false;
+   }
+   a_sample = m_pSamples[(m_head + m_nbSamples - 1 - a_age) % m_nbSamples];
+   return true;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Get the bin of the current interval
+
+   @param [in]     a_interval : Interval
+   @param [out]    a_bin      : Bin
+
+   @return     true if the bin has at least one sample
+*/
+// ------------------------------------------------------------------------------------------------
+bool SfpPmHistory::GetCurrentBin(SfpPmInterval a_interval, SfpPmBin& a_bin)
+{
+   if ( (a_interval >= SfpPmIntervalMax) || (m_current[a_interval].count == 0) )
+   {
+      return false;
+   }
+   a_bin = m_current[a_interval];
+   return true;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Get a completed bin
+
+   @param [in]     a_interval : Interval
+   @param [in]     a_age      : 0 for the most recent completed bin
+   @param [out]    a_bin      : Bin
+
+   @return     true if successful
+*/
+// ------------------------------------------------------------------------------------------------
+bool SfpPmHistory::GetHistoryBin(SfpPmInterval a_interval, acd_uint32_t a_age, SfpPmBin& a_bin)
+{
+   SfpPmBin*      pBins;
+   acd_uint32_t   size;
+
+   if ( (a_interval >= SfpPmIntervalMax) || (a_age >= m_binCount[a_interval]) )
+   {
+      return false;
+   }
+
+   pBins = (a_interval == SfpPmInterval15Min) ? m_bin15Min : m_bin24H;
+   size  = s_pmBinCount[a_interval];
+   a_bin = pBins[(m_binHead[a_interval] + size - 1 - a_age) % size];
+   return true;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Get the average of a parameter over a bin
+
+   @param [in]     a_bin    : Bin
+   @param [in]     a_param  : Parameter
+   @param [out]    a_avg    : Average
+
+   @return     true if the bin has at least one sample
+*/
+// ------------------------------------------------------------------------------------------------
+bool SfpPmHistory::GetAverage(const SfpPmBin& a_bin, SfpDdmParam a_param, acd_int32_t& a_avg)
+{
+   if ( (a_param >= SfpDdmParamMax) || (a_bin.count == 0) )
+   {
+      return false;
+   }
+   a_avg = (acd_int32_t)(a_bin.sum[a_param] / (acd_int64_t)a_bin.count);
+   return true;
+}
+
+// ================================================================================================
+// ================================================================================================
+//            PRIVATE CLASS SECTION
+// ================================================================================================
+// ================================================================================================
+// ------------------------------------------------------------------------------------------------
+/*!@brief Add a sample to the current bin of an interval
+
+   The current bin is moved to the completed bins when the sample belongs to another interval.
+
+   @param [in]     a_interval  : Interval
+   @param [in]     a_timestamp : Wall clock time in usec
+   @param [in]     a_values    : Converted values indexed by SfpDdmParam
+*/
+// ------------------------------------------------------------------------------------------------
+void SfpPmHistory::updateBin(SfpPmInterval a_interval, acd_uint64_t a_timestamp, const acd_int32_t a_values[SfpDdmParamMax])
+{
+   SfpPmBin&      bin = m_current[a_interval];
+   acd_uint64_t   start = a_timestamp - (a_timestamp % s_pmIntervalUs[a_interval]);
+
+   if ( (bin.count != 0) && (bin.start != start) )
+   {
+      SfpPmBin*      pBins = (a_interval == SfpPmInterval15Min) ? m_bin15Min : m_bin24H;
+      acd_uint32_t   size  = s_pmBinCount[a_interval];
+
+      pBins[m_binHead[a_interval]] = bin;
+      m_binHead[a_interval] = (m_binHead[a_interval] + 1) % size;
+      if ( m_binCount[a_interval] < size )
+      {
+         m_binCount[a_interval]++;
+      }
+      bin.count = 0;
+   }
+
+   if ( bin.count == 0 )
+   {
+      bin.start = start;
+      for(acd_uint32_t p = 0 ; p < SfpDdmParamMax ; p++)
+      {
+         bin.min[p] = a_values[p];
+         bin.max[p] = a_values[p];
+         bin.sum[p] = 0;
+      }
+   }
+
+   for(acd_uint32_t p = 0 ; p < SfpDdmParamMax ; p++)
+   {
+      if ( a_values[p] < bin.min[p] )
+      {
+         bin.min[p] = a_values[p];
+      }
+      if ( a_values[p] > bin.max[p] )
+      {
+         bin.max[p] = a_values[p];
+      }
+      bin.sum[p] += a_values[p];
+   }
+   bin.count++;
+}
@@ -0,0 +1,100 @@
+// ------------------------------------------------------------------------------------------------
+/* ACCEDIAN PROPRIETARY - www.accedian.com
+   COPYRIGHT (c) 2004-2014 BY ACCEDIAN CORPORATION. ALL RIGHTS RESERVED. NO PART OF THIS PROGRAM OR
+   PUBLICATION MAY BE REPRODUCED, TRANSMITTED, TRANSCRIBED, STORED IN A RETRIEVAL SYSTEM,
+   OR TRANSLATED INTO ANY LANGUAGE OR COMPUTER LANGUAGE IN ANY FORM OR BY ANY MEANS, ELECTRONIC,
+   MECHANICAL, MAGNETIC, OPTICAL, CHEMICAL, MANUAL, OR OTHERWISE, WITHOUT THE PRIOR WRITTEN
+   PERMISSION OF ACCEDIAN INC.
+*/
+// ------------------------------------------------------------------------------------------------
+/*!@file    SfpPmHistory.h
+   @brief   SFP DDM history
+
+   This file contains the SFP DDM history and performance monitoring bins class definition
+*/
+// ------------------------------------------------------------------------------------------------
+#ifndef __SFPPMHISTORY_H__
+#define __SFPPMHISTORY_H__
+
+#include "HalSfp.h"
+
+#define SFP_PM_15MIN_BINS     32    // Number of completed 15 minute bins kept
+#define SFP_PM_24H_BINS       1     // Number of completed 24 hour bins kept
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief SFP PM intervals
+*/
+// ------------------------------------------------------------------------------------------------
+enum SfpPmInterval
+{
+   SfpPmInterval15Min = 0,
+   SfpPmInterval24H,
+   SfpPmIntervalMax
+};
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief SFP DDM sample
+*/
+// ------------------------------------------------------------------------------------------------
+struct SfpPmSample
+{
+   acd_uint64_t   timestamp;                 // Wall clock time in usec
+   acd_int32_t    value[SfpDdmParamMax];     // Converted values indexed by SfpDdmParam
+};
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief SFP PM bin
+
+   Minimum, maximum and sum of the samples of one interval
+*/
+// ------------------------------------------------------------------------------------------------
+struct SfpPmBin
+{
+   acd_uint64_t   start;                     // Interval start time in usec
+   acd_uint32_t   count;                     // Number of samples, 0 if the bin is empty
+   acd_int32_t    min[SfpDdmParamMax];
+   acd_int32_t    max[SfpDdmParamMax];
+   acd_int64_t    sum[SfpDdmParamMax];
+};
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief SFP DDM history
+
+   This class keeps the last samples of one port in a ring buffer and aggregates them in 15
+   minute and 24 hour bins aligned on the wall clock. The memory is allocated once by the
+   constructor; adding a sample is done in constant time.
+*/
+// ------------------------------------------------------------------------------------------------
+class SfpPmHistory
+{
+
+public:
+   SfpPmHistory(acd_uint32_t a_nbSamples);
+   virtual ~SfpPmHistory();
+
+   void AddSample(acd_uint64_t a_timestamp, const acd_int32_t a_values[SfpDdmParamMax]);
+   void Clear();
+
+   acd_uint32_t GetSampleCount();
+   bool GetSample(acd_uint32_t a_age, SfpPmSample& a_sample);
+
+   bool GetCurrentBin(SfpPmInterval a_interval, SfpPmBin& a_bin);
+   bool GetHistoryBin(SfpPmInterval a_interval, acd_uint32_t a_age, SfpPmBin& a_bin);
+   static bool GetAverage(const SfpPmBin& a_bin, SfpDdmParam a_param, acd_int32_t& a_avg);
+
+private:
+   void updateBin(SfpPmInterval a_interval, acd_uint64_t a_timestamp, const acd_int32_t a_values[SfpDdmParamMax]);
+
+   SfpPmSample*   m_pSamples;                // Sample ring buffer
+   acd_uint32_t   m_nbSamples;               // Ring buffer size
+   acd_uint32_t   m_head;                    // Next sample entry
+   acd_uint32_t   m_count;                   // Number of valid samples
+
+   SfpPmBin       m_current[SfpPmIntervalMax];
+   SfpPmBin       m_bin15Min[SFP_PM_15MIN_BINS];
+   SfpPmBin       m_bin24H[SFP_PM_24H_BINS];
+   acd_uint32_t   m_binHead[SfpPmIntervalMax];   // Next completed bin entry
+   acd_uint32_t   m_binCount[SfpPmIntervalMax];  // Number of completed bins
+};
+
+#endif // #ifndef __SFPPMHISTORY_H__
@@ -0,0 +1,206 @@
+// ------------------------------------------------------------------------------------------------
+/* ACCEDIAN PROPRIETARY - www.accedian.com
+   COPYRIGHT (c) 2004-2014 BY ACCEDIAN CORPORATION. ALL RIGHTS RESERVED. NO PART OF THIS PROGRAM OR
+   PUBLICATION MAY BE REPRODUCED, TRANSMITTED, TRANSCRIBED, STORED IN A RETRIEVAL SYSTEM,
+   OR TRANSLATED INTO ANY LANGUAGE OR COMPUTER LANGUAGE IN ANY FORM OR BY ANY MEANS, ELECTRONIC,
+   MECHANICAL, MAGNETIC, OPTICAL, CHEMICAL, MANUAL, OR OTHERWISE, WITHOUT THE PRIOR WRITTEN
+   PERMISSION OF ACCEDIAN INC.
+*/
+// ------------------------------------------------------------------------------------------------
+/*!@file    SfpPollPolicy.cpp
+   @brief   SFP adaptive polling policy
+
+   This file contains the SFP polling policy class
+
+*/
+// ------------------------------------------------------------------------------------------------
+
+#include "SfpPollPolicy.h"
+
+// ================================================================================================
+// ================================================================================================
+//            PUBLIC CLASS SECTION
+// ================================================================================================
+// ================================================================================================
+// ------------------------------------------------------------------------------------------------
+/*!@brief Constructor
+
+*/
+// ------------------------------------------------------------------------------------------------
+SfpPollPolicy::SfpPollPolicy() :
+m_minMs(SFP_POLL_MIN_MS),
+m_nominalMs(SFP_POLL_NOMINAL_MS),
+m_maxMs(SFP_POLL_MAX_MS),
+m_nearPct(SFP_POLL_NEAR_PCT)
+{
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Destructor
+
+*/
+// ------------------------------------------------------------------------------------------------
+SfpPollPolicy::~SfpPollPolicy()
+{
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Set the monitoring intervals
+
+   @param [in]     a_minMs     : Fastest interval in msec
+   @param [in]     a_nominalMs : Interval of a new module in msec
+   @param [in]     a_maxMs     : Slowest interval in msec
+
+   @return     true if successful
+*/
+// ------------------------------------------------------------------------------------------------
+bool SfpPollPolicy::SetIntervals(acd_uint32_t a_minMs, acd_uint32_t a_nominalMs, acd_uint32_t a_maxMs)
+{
+   if ( (a_minMs == 0) || (a_minMs > a_nominalMs) || (a_nominalMs > a_maxMs) )
+   {
+      return false;
+   }
+   m_minMs     = a_minMs;
+   m_nominalMs = a_nominalMs;
+   m_maxMs     = a_maxMs;
+   return true;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Set the margin to the warning thresholds under which the port is polled at the
+          fastest interval
+
+   @param [in]     a_percent : Margin in % of the range between the low and high warnings
+
+   @return     true if successful
+*/
+// ------------------------------------------------------------------------------------------------
+bool SfpPollPolicy::SetNearMargin(acd_uint32_t a_percent)
+{
+   if ( a_percent > 50 )
+   {
+      return false;
+   }
+   m_nearPct = a_percent;
+   return true;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Reset the state of a port
+
+   Called on insertion and removal: the port is polled immediately.
+
+   @param [out]    a_state : Port polling state
+*/
+// ------------------------------------------------------------------------------------------------
+void SfpPollPolicy::Reset(SfpPollState& a_state)
+{
+   a_state.bValid = false;
+   a_state.timestamp = 0;
+   a_state.intervalMs = 0;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Compute the next monitoring interval of a port
+
+   Called after each monitoring update.
+
+   @param [in]     a_pSfp  : SFP, with up to date monitoring data
+   @param [in,out] a_state : Port polling state
+   @param [in]     a_now   : Time of the update in usec, see sfpGetTimeUs()
+
+   @return     Interval in msec
+*/
+// ------------------------------------------------------------------------------------------------
+acd_uint32_t SfpPollPolicy::Evaluate(HalSfp* a_pSfp, SfpPollState& a_state, acd_uint64_t a_now)
+{
+   SfpDdmSample   sample;
+   acd_int32_t*   values = sample.values;
+   acd_uint64_t   dtUs = a_state.bValid ? (a_now - a_state.timestamp) : 0;
+   acd_uint32_t   interval;
+
+   // One page snapshot for all the values and thresholds
+   if ( !a_pSfp->GetDdmSample(sample) )
+   {
+      memset(&sample, 0, sizeof(sample));
+   }
+
+   // A stable port slows down
+   interval = (a_state.intervalMs == 0) ? m_nominalMs : a_state.intervalMs * 2;
+   if ( interval > m_maxMs )
+   {
+      interval = m_maxMs;
+   }
+
+   for(acd_uint32_t p = 0 ; p < SfpDdmParamMax ; p++)
+   {
+      acd_int32_t    high = sample.threshold[p][HalSfpThresholdHighWarning];
+      acd_int32_t    low = sample.threshold[p][HalSfpThresholdLowWarning];
+      acd_int64_t    range;
+      acd_int64_t    margin;
+      acd_int64_t    delta;
+      acd_int64_t    leftMs;
+
+      if ( !sample.bThreshold[p][HalSfpThresholdHighWarning] ||
+           !sample.bThreshold[p][HalSfpThresholdLowWarning] ||
+           (high <= low) )
+      {
+         continue;
+      }
+
+      range = (acd_int64_t)high - low;
+      margin = (acd_int64_t)high - values[p];
+      if ( ((acd_int64_t)values[p] - low) < margin )
+      {
+         margin = (acd_int64_t)values[p] - low;
+      }
+
+      if ( (margin * 100) <= (range * m_nearPct) )
+      {
+         // Close to or beyond a threshold
+         interval = m_minMs;
+         break;
+      }
+
+      if ( dtUs == 0 )
+      {
+         continue;
+      }
+      delta = (acd_int64_t)values[p] - a_state.values[p];
+      if ( delta == 0 )
+      {
+         continue;
+      }
+
+      // Distance to the threshold the value is moving toward
+      if ( delta > 0 )
+      {
+         margin = (acd_int64_t)high - values[p];
+      }
+      else
+      {
+         margin = (acd_int64_t)values[p] - low;
+         delta = -delta;
+      }
+
+      // Time left before the threshold at the current rate, in msec
+      leftMs = ((margin * (acd_int64_t)dtUs) / delta) / 1000;
+      if ( (leftMs / SFP_POLL_SAMPLES_AHEAD) < interval )
+      {
+         interval = (acd_uint32_t)(leftMs / SFP_POLL_SAMPLES_AHEAD);
+         if ( interval < m_minMs )
+         {
+            interval = m_minMs;
+         }
+      }
+   }
+
+   for(acd_uint32_t p = 0 ; p < SfpDdmParamMax ; p++)
+   {
+      a_state.values[p] = values[p];
+   }
+   a_state.bValid = true;
+   a_state.timestamp = a_now;
+   a_state.intervalMs = interval;
+   return interval;
+}
@@ -0,0 +1,74 @@
+// ------------------------------------------------------------------------------------------------
+/* ACCEDIAN PROPRIETARY - www.accedian.com
+   COPYRIGHT (c) 2004-2014 BY ACCEDIAN CORPORATION. ALL RIGHTS RESERVED. NO PART OF THIS PROGRAM OR
+   PUBLICATION MAY BE REPRODUCED, TRANSMITTED, TRANSCRIBED, STORED IN A RETRIEVAL SYSTEM,
+   OR TRANSLATED INTO ANY LANGUAGE OR COMPUTER LANGUAGE IN ANY FORM OR BY ANY MEANS, ELECTRONIC,
+   MECHANICAL, MAGNETIC, OPTICAL, CHEMICAL, MANUAL, OR OTHERWISE, WITHOUT THE PRIOR WRITTEN
+   PERMISSION OF ACCEDIAN INC.
+*/
+// ------------------------------------------------------------------------------------------------
+/*!@file    SfpPollPolicy.h
+   @brief   SFP adaptive polling policy
+
+   This file contains the SFP polling policy class definition
+*/
+// ------------------------------------------------------------------------------------------------
+#ifndef __SFPPOLLPOLICY_H__
+#define __SFPPOLLPOLICY_H__
+
+#include "HalSfp.h"
+
+#define SFP_POLL_MIN_MS          100   // Default fastest monitoring interval
+#define SFP_POLL_NOMINAL_MS      1000  // Default interval of a new module
+#define SFP_POLL_MAX_MS          10000 // Default slowest monitoring interval
+#define SFP_POLL_NEAR_PCT        10    // Default margin to a warning threshold, in % of the range
+#define SFP_POLL_SAMPLES_AHEAD   4     // Samples taken before a drifting value reaches a threshold
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief SFP polling state of one port
+*/
+// ------------------------------------------------------------------------------------------------
+struct SfpPollState
+{
+   bool           bValid;                       // Previous sample is valid
+   acd_uint64_t   timestamp;                    // Time of the previous sample in usec
+   acd_int32_t    values[SfpDdmParamMax];       // Previous sample
+   acd_uint32_t   intervalMs;                   // Current interval, 0 to poll immediately
+};
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief SFP adaptive polling policy
+
+   Computes the monitoring interval of a port from its last sample:
+   - the fastest interval when a value is within the near margin of its warning thresholds
+     (or beyond them),
+   - an interval giving SFP_POLL_SAMPLES_AHEAD samples before a drifting value reaches its
+     threshold at the current rate,
+   - otherwise the interval doubles on each sample up to the slowest interval.
+   A port is polled immediately after an insertion, see Reset().
+
+   The thresholds are the user thresholds, or the module thresholds when not set
+   (see HalSfp::GetDdmThreshold()).
+*/
+// ------------------------------------------------------------------------------------------------
+class SfpPollPolicy
+{
+
+public:
+   SfpPollPolicy();
+   virtual ~SfpPollPolicy();
+
+   bool SetIntervals(acd_uint32_t a_minMs, acd_uint32_t a_nominalMs, acd_uint32_t a_maxMs);
+   bool SetNearMargin(acd_uint32_t a_percent);
+
+   void Reset(SfpPollState& a_state);
+   acd_uint32_t Evaluate(HalSfp* a_pSfp, SfpPollState& a_state, acd_uint64_t a_now);
+
+private:
+   acd_uint32_t   m_minMs;          // Fastest interval
+   acd_uint32_t   m_nominalMs;      // Interval of a new module
+   acd_uint32_t   m_maxMs;          // Slowest interval
+   acd_uint32_t   m_nearPct;        // Margin to the warning thresholds, in % of the range
+};
+
+#endif // #ifndef __SFPPOLLPOLICY_H__
@@ -0,0 +1,368 @@
+// ------------------------------------------------------------------------------------------------
+/* ACCEDIAN PROPRIETARY - www.accedian.com
+   COPYRIGHT (c) 2004-2014 BY ACCEDIAN CORPORATION. ALL RIGHTS RESERVED. NO PART OF THIS PROGRAM OR
+   PUBLICATION MAY BE REPRODUCED, TRANSMITTED, TRANSCRIBED, STORED IN A RETRIEVAL SYSTEM,
+   OR TRANSLATED INTO ANY LANGUAGE OR COMPUTER LANGUAGE IN ANY FORM OR BY ANY MEANS, ELECTRONIC,
+   MECHANICAL, MAGNETIC, OPTICAL, CHEMICAL, MANUAL, OR OTHERWISE, WITHOUT THE PRIOR WRITTEN
+   PERMISSION OF ACCEDIAN INC.
+*/
+// ------------------------------------------------------------------------------------------------
+/*!@file    SfpPowerSeq.cpp
+   @brief   SFP power-up sequencer
+
+   This file contains the SFP power-up sequencer class
+
+*/
+// ------------------------------------------------------------------------------------------------
+
+#include <accedian/acclib/acd_utils.h>
+#include "SfpPowerSeq.h"
+#include "SfpTime.h"
+
+// ================================================================================================
+// ================================================================================================
+//            PUBLIC CLASS SECTION
+// ================================================================================================
+// ================================================================================================
+// ------------------------------------------------------------------------------------------------
+/*!@brief Constructor
+
+   @param [in]     a_spacingMs : Delay between power-up groups in msec
+   @param [in]     a_budget    : Maximum number of SFPs powered up together
+*/
+// ------------------------------------------------------------------------------------------------
+SfpPowerSequencer::SfpPowerSequencer(acd_uint32_t a_spacingMs, acd_uint32_t a_budget) :
+m_spacingUs(((a_spacingMs != 0) ? a_spacingMs : 1) * 1000),
+m_budget((a_budget != 0) ? a_budget : 1),
+m_current(0),
+m_slotTime(0),
+m_pFree(NULL),
+m_pReady(NULL),
+m_pActive(NULL),
+m_pending(0),
+m_pListener(NULL),
+m_bRunning(false)
+{
+   memset(m_slots, 0, sizeof(m_slots));
+   memset(m_slotLoad, 0, sizeof(m_slotLoad));
+   for(acd_uint32_t i = 0 ; i < SFP_POWER_MAX_REQUESTS ; i++)
+   {
+      m_entries[i].pNext = m_pFree;
+      m_pFree = &m_entries[i];
+   }
+   pthread_mutex_init(&m_mutex, NULL);
+   pthread_cond_init(&m_done, NULL);
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Destructor
+
+   The pending requests are dropped.
+*/
+// ------------------------------------------------------------------------------------------------
+SfpPowerSequencer::~SfpPowerSequencer()
+{
+   Stop();
+   pthread_cond_destroy(&m_done);
+   pthread_mutex_destroy(&m_mutex);
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Set the power-up listener
+
+   @param [in]     a_pListener : Listener, NULL for none
+*/
+// ------------------------------------------------------------------------------------------------
+void SfpPowerSequencer::SetListener(SfpPowerListener* a_pListener)
+{
+   m_pListener = a_pListener;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Request the power-up of a SFP
+
+   The SFP is powered up in the first interval with some budget left. Returns at once.
+
+   @param [in]     a_pSfp : SFP, see HalSfp::PowerUp()
+
+   @return     true if successful, false if the wheel is full
+*/
+// ------------------------------------------------------------------------------------------------
+bool SfpPowerSequencer::Request(HalSfp* a_pSfp)
+{
+   bool bRet = false;
+
+   pthread_mutex_lock(&m_mutex);
+   if ( m_slotTime == 0 )
+   {
+      // Idle wheel, the first group can be powered up right away
+      m_slotTime = sfpGetTimeUs();
+   }
+   // Keep one free entry per request for its notification
+   if ( (m_pFree != NULL) && (m_pFree->pNext != NULL) )
+   {
+      for(acd_uint32_t i = 0 ; i < SFP_POWER_WHEEL_SLOTS - 1 ; i++)
+      {
+         acd_uint32_t slot = (m_current + i) % SFP_POWER_WHEEL_SLOTS;
+
+         if ( m_slotLoad[slot] < m_budget )
+         {
+            Entry* pEntry = m_pFree;
+
+            m_pFree = pEntry->pNext;
+            pEntry->pSfp = a_pSfp;
+            pEntry->type = EntryPowerUp;
+            pEntry->bSuccess = false;
+            pEntry->bCancelled = false;
+            m_slotLoad[slot]++;
+            schedule(pEntry, slot);
+            bRet = true;
+            break;
+         }
+      }
+   }
+   pthread_mutex_unlock(&m_mutex);
+   return bRet;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Cancel the requests of a SFP
+
+   The power-up and the notification of the SFP are dropped. If the sequencer is calling the SFP
+   or the listener for it in another thread, waits for the call to return, so the SFP can be
+   powered down or deleted once this function returns.
+
+   @param [in]     a_pSfp : SFP
+*/
+// ------------------------------------------------------------------------------------------------
+void SfpPowerSequencer::Cancel(HalSfp* a_pSfp)
+{
+   pthread_mutex_lock(&m_mutex);
+   for(acd_uint32_t i = 0 ; i < SFP_POWER_WHEEL_SLOTS ; i++)
+   {
+      m_slotLoad[i] -= unlink(&m_slots[i], a_pSfp);
+   }
+   unlink(&m_pReady, a_pSfp);
+
+   if ( (m_pActive != NULL) && (m_pActive->pSfp == a_pSfp) )
+   {
+      m_pActive->bCancelled = true;
+      if ( !pthread_equal(m_runner, pthread_self()) )
+      {
+         while ( (m_pActive != NULL) && (m_pActive->pSfp == a_pSfp) )
+         {
+            pthread_cond_wait(&m_done, &m_mutex);
+         }
+      }
+   }
+   if ( m_pending == 0 )
+   {
+      m_slotTime = 0;
+   }
+   pthread_mutex_unlock(&m_mutex);
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Get the number of power-ups and notifications pending
+
+   @return     Number of entries
+*/
+// ------------------------------------------------------------------------------------------------
+acd_uint32_t SfpPowerSequencer::GetPendingCount()
+{
+   return m_pending;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Advance the timer wheel
+
+   Runs the entries of the current slot once its interval started. At most one slot is run per
+   call and the next slot starts one interval after this call, so the groups stay spaced even if
+   the calls are late. The SFPs and the listener are called without the lock held.
+
+   @param [in]     a_now : Current time in usec, see sfpGetTimeUs()
+*/
+// ------------------------------------------------------------------------------------------------
+void SfpPowerSequencer::Tick(acd_uint64_t a_now)
+{
+   pthread_mutex_lock(&m_mutex);
+   if ( (m_slotTime == 0) || (a_now < m_slotTime) )
+   {
+      pthread_mutex_unlock(&m_mutex);
+      return;
+   }
+   m_pReady = m_slots[m_current];
+   m_slots[m_current] = NULL;
+   m_slotLoad[m_current] = 0;
+   m_current = (m_current + 1) % SFP_POWER_WHEEL_SLOTS;
+   // The next slot starts one interval from now, even if this call is late
+   m_slotTime = a_now + m_spacingUs;
+
+   while ( m_pReady != NULL )
+   {
+      Entry* pEntry = m_pReady;
+
+      m_pReady = pEntry->pNext;
+      m_pActive = pEntry;
+      m_runner = pthread_self();
+      pthread_mutex_unlock(&m_mutex);
+
+      if ( pEntry->type == EntryPowerUp )
+      {
+         pEntry->bSuccess = pEntry->pSfp->PowerUp();
+      }
+      else if ( m_pListener != NULL )
+      {
+         m_pListener->OnSfpPowered(pEntry->pSfp, pEntry->bSuccess);
+      }
+
+      pthread_mutex_lock(&m_mutex);
+      m_pActive = NULL;
+      pthread_cond_broadcast(&m_done);
+      if ( (pEntry->type == EntryPowerUp) && !pEntry->bCancelled )
+      {
+         // Notify once the supply settled, on the next interval
+         pEntry->type = EntryNotify;
+         m_pending--;
+         schedule(pEntry, m_current);
+      }
+      else
+      {
+         release(pEntry);
+      }
+   }
+
+   if ( m_pending == 0 )
+   {
+      // Nothing left, the next request starts right away
+      m_slotTime = 0;
+   }
+   pthread_mutex_unlock(&m_mutex);
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Start the sequencer thread
+
+   The thread calls Tick() on each spacing interval.
+
+   @return     true if successful
+*/
+// ------------------------------------------------------------------------------------------------
+bool SfpPowerSequencer::Start()
+{
+   if ( m_bRunning )
+   {
+      return false;
+   }
+   m_bRunning = true;
+   if ( pthread_create(&m_thread, NULL, threadMain, this) != 0 )
+   {
+      m_bRunning = false;
+      return false;
+   }
+   return true;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Stop the sequencer thread
+
+*/
+// ------------------------------------------------------------------------------------------------
+void SfpPowerSequencer::Stop()
+{
+   if ( m_bRunning )
+   {
+      m_bRunning = false;
+      pthread_join(m_thread, NULL);
+   }
+}
+
+// ================================================================================================
+// ================================================================================================
+//            PRIVATE CLASS SECTION
+// ================================================================================================
+// ================================================================================================
+// ------------------------------------------------------------------------------------------------
+/*!@brief Add an entry to a slot
+
+   Must be called with the lock held.
+
+   @param [in]     a_pEntry : Entry
+   @param [in]     a_slot   : Slot
+*/
+// ------------------------------------------------------------------------------------------------
+void SfpPowerSequencer::schedule(Entry* a_pEntry, acd_uint32_t a_slot)
+{
+   a_pEntry->pNext = m_slots[a_slot];
+   m_slots[a_slot] = a_pEntry;
+   m_pending++;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Return a scheduled entry to the free list
+
+   Must be called with the lock held.
+
+   @param [in]     a_pEntry : Entry
+*/
+// ------------------------------------------------------------------------------------------------
+void SfpPowerSequencer::release(Entry* a_pEntry)
+{
+   a_pEntry->pNext = m_pFree;
+   m_pFree = a_pEntry;
+   m_pending--;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Remove the entries of a SFP from a list
+
+   Must be called with the lock held.
+
+   @param [in,out] a_ppList : List
+   @param [in]     a_pSfp   : SFP
+
+   @return     Number of power-ups removed
+*/
+// ------------------------------------------------------------------------------------------------
+acd_uint32_t SfpPowerSequencer::unlink(Entry** a_ppList, HalSfp* a_pSfp)
+{
+   acd_uint32_t nbPowerUps = 0;
+
+   while ( *a_ppList != NULL )
+   {
+      Entry* pEntry = *a_ppList;
+
+      if ( pEntry->pSfp != a_pSfp )
+      {
+         a_ppList = &pEntry->pNext;
+         continue;
+      }
+      *a_ppList = pEntry->pNext;
+      if ( pEntry->type == EntryPowerUp )
+      {
+         nbPowerUps++;
+      }
+      release(pEntry);
+   }
+   return nbPowerUps;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Sequencer thread
+
+   @param [in]     a_pArg : Sequencer
+
+   @return     NULL
+*/
+// ------------------------------------------------------------------------------------------------
+void* SfpPowerSequencer::threadMain(void* a_pArg)
+{
+   SfpPowerSequencer* pSeq = (SfpPowerSequencer*)a_pArg;
+
+   while ( pSeq->m_bRunning )
+   {
+      pSeq->Tick(sfpGetTimeUs());
+      acd_usleep(pSeq->m_spacingUs);
+   }
+   return NULL;
+}
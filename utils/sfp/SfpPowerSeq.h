@@ -0,0 +1,108 @@
+// ------------------------------------------------------------------------------------------------
+/* ACCEDIAN PROPRIETARY - www.accedian.com
+   COPYRIGHT (c) 2004-2014 BY ACCEDIAN CORPORATION. ALL RIGHTS RESERVED. NO PART OF THIS PROGRAM OR
+   PUBLICATION MAY BE REPRODUCED, TRANSMITTED, TRANSCRIBED, STORED IN A RETRIEVAL SYSTEM,
+   OR TRANSLATED INTO ANY LANGUAGE OR COMPUTER LANGUAGE IN ANY FORM OR BY ANY MEANS, ELECTRONIC,
+   MECHANICAL, MAGNETIC, OPTICAL, CHEMICAL, MANUAL, OR OTHERWISE, WITHOUT THE PRIOR WRITTEN
+   PERMISSION OF ACCEDIAN INC.
+*/
+// ------------------------------------------------------------------------------------------------
+/*!@file    SfpPowerSeq.h
+   @brief   SFP power-up sequencer
+
+   This file contains the SFP power-up sequencer class definition
+*/
+// ------------------------------------------------------------------------------------------------
+#ifndef __SFPPOWERSEQ_H__
+#define __SFPPOWERSEQ_H__
+
+#include <pthread.h>
+#include "HalSfp.h"
+
+#define SFP_POWER_SPACING_MS     5     // Default delay between power-up groups (inrush current)
+#define SFP_POWER_BUDGET         1     // Default number of SFPs powered up per group
+#define SFP_POWER_WHEEL_SLOTS    32    // Timer wheel slots, one per spacing interval
+#define SFP_POWER_MAX_REQUESTS   64    // Maximum number of pending requests
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief SFP power-up listener
+
+   Interface implemented by the users of the power-up sequencer
+*/
+// ------------------------------------------------------------------------------------------------
+class SfpPowerListener
+{
+public:
+   virtual ~SfpPowerListener() {}
+   virtual void OnSfpPowered(HalSfp* a_pSfp, bool a_bSuccess) = 0;
+};
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief SFP power-up sequencer
+
+   Powers up the SFPs in groups of at most "budget" SFPs, one group per spacing interval, to
+   limit the inrush current, without blocking the caller. The requests are kept in a timer wheel
+   with one slot per spacing interval. The listener is notified one interval after the power-up
+   of a SFP, once its supply is stable.
+
+   The wheel is advanced by Tick(), either by the caller or by the sequencer thread (see Start()),
+   one slot per call: a late Tick() delays the next groups instead of powering them up together.
+*/
+// ------------------------------------------------------------------------------------------------
+class SfpPowerSequencer
+{
+
+public:
+   SfpPowerSequencer(acd_uint32_t a_spacingMs = SFP_POWER_SPACING_MS, acd_uint32_t a_budget = SFP_POWER_BUDGET);
+   virtual ~SfpPowerSequencer();
+
+   void SetListener(SfpPowerListener* a_pListener);
+   bool Request(HalSfp* a_pSfp);
+   void Cancel(HalSfp* a_pSfp);
+   acd_uint32_t GetPendingCount();
+
+   void Tick(acd_uint64_t a_now);
+   bool Start();
+   void Stop();
+
+private:
+   enum EntryType
+   {
+      EntryPowerUp = 0,    // Power-up the SFP
+      EntryNotify          // Notify the listener
+   };
+
+   struct Entry
+   {
+      HalSfp*        pSfp;             // SFP
+      EntryType      type;             // Action
+      bool           bSuccess;         // Power-up result, for EntryNotify
+      bool           bCancelled;       // Cancelled while running
+      Entry*         pNext;            // Next entry of the slot or of the free list
+   };
+
+   void schedule(Entry* a_pEntry, acd_uint32_t a_slot);
+   void release(Entry* a_pEntry);
+   acd_uint32_t unlink(Entry** a_ppList, HalSfp* a_pSfp);
+   static void* threadMain(void* a_pArg);
+
+   acd_uint32_t      m_spacingUs;                         // Slot duration
+   acd_uint32_t      m_budget;                            // Power-ups per slot
+   Entry*            m_slots[SFP_POWER_WHEEL_SLOTS];      // Entries of each slot
+   acd_uint32_t      m_slotLoad[SFP_POWER_WHEEL_SLOTS];   // Power-ups scheduled in each slot
+   acd_uint32_t      m_current;                           // Slot of the current interval
+   acd_uint64_t      m_slotTime;                          // Start time of the current slot, 0 if idle
+   Entry             m_entries[SFP_POWER_MAX_REQUESTS];   // Entry pool
+   Entry*            m_pFree;                             // Free entries
+   Entry*            m_pReady;                            // Entries of the slot being run
+   Entry*            m_pActive;                           // Entry being run, NULL for none
+   pthread_t         m_runner;                            // Thread running m_pActive
+   acd_uint32_t      m_pending;                           // Entries scheduled
+   SfpPowerListener* m_pListener;                         // Listener, NULL for none
+   pthread_mutex_t   m_mutex;                             // Protects the wheel
+   pthread_cond_t    m_done;                              // Signaled when m_pActive is done
+   pthread_t         m_thread;                            // Sequencer thread
+   volatile bool     m_bRunning;                          // Sequencer thread running
+};
+
+#endif // #ifndef __SFPPOWERSEQ_H__
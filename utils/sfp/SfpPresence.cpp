@@ -0,0 +1,202 @@
+// ------------------------------------------------------------------------------------------------
+/* ACCEDIAN PROPRIETARY - www.accedian.com
+   COPYRIGHT (c) 2004-2014 BY ACCEDIAN CORPORATION. ALL RIGHTS RESERVED. NO PART OF THIS PROGRAM OR
+   PUBLICATION MAY BE REPRODUCED, TRANSMITTED, TRANSCRIBED, STORED IN A RETRIEVAL SYSTEM,
+   OR TRANSLATED INTO ANY LANGUAGE OR COMPUTER LANGUAGE IN ANY FORM OR BY ANY MEANS, ELECTRONIC,
+   MECHANICAL, MAGNETIC, OPTICAL, CHEMICAL, MANUAL, OR OTHERWISE, WITHOUT THE PRIOR WRITTEN
+   PERMISSION OF ACCEDIAN INC.
+*/
+// ------------------------------------------------------------------------------------------------
+/*!@file    SfpPresence.cpp
+   @brief   SFP presence change detection
+
+   This file contains the SFP presence tracker class
+
+*/
+// ------------------------------------------------------------------------------------------------
+
+#include <string.h>
+#include "SfpPresence.h"
+#include "SfpTime.h"
+
+// ================================================================================================
+// ================================================================================================
+//            PUBLIC CLASS SECTION
+// ================================================================================================
+// ================================================================================================
+// ------------------------------------------------------------------------------------------------
+/*!@brief Constructor
+
+*/
+// ------------------------------------------------------------------------------------------------
+SfpPresenceTracker::SfpPresenceTracker() :
+m_portPresent(0),
+m_portChanged(0),
+m_portInserted(0),
+m_portRemoved(0)
+{
+   memset(m_detectMask, 0, sizeof(m_detectMask));
+   memset(m_changeTime, 0, sizeof(m_changeTime));
+   memset(m_present, 0, sizeof(m_present));
+   memset(m_bitToPort, SFP_PRESENCE_NO_PORT, sizeof(m_bitToPort));
+   pthread_mutex_init(&m_mutex, NULL);
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Destructor
+
+*/
+// ------------------------------------------------------------------------------------------------
+SfpPresenceTracker::~SfpPresenceTracker()
+{
+   pthread_mutex_destroy(&m_mutex);
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Add a port
+
+   A port added again replaces the previous port using the same detect bit.
+
+   @param [in]     a_portId : Port identifier
+   @param [in]     a_word   : Status register index, as given to Update()
+   @param [in]     a_bit    : Detect bit in the status register (0 when present)
+
+   @return     true if successful
+*/
+// ------------------------------------------------------------------------------------------------
+bool SfpPresenceTracker::AddPort(acd_uint32_t a_portId, acd_uint32_t a_word, acd_uint32_t a_bit)
+{
+   if ( (a_portId >= SFP_PRESENCE_MAX_PORTS) || (a_word >= SFP_PRESENCE_MAX_WORDS) || (a_bit >= 64) )
+   {
+      return false;
+   }
+
+   pthread_mutex_lock(&m_mutex);
+   m_bitToPort[a_word][a_bit] = a_portId;
+   m_detectMask[a_word] |= (1ULL << a_bit);
+   pthread_mutex_unlock(&m_mutex);
+   return true;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Update the presence from a status register
+
+   The first update reports a change for each port already present.
+
+   @param [in]     a_word   : Status register index
+   @param [in]     a_status : Status register value
+
+   @return     Number of ports changed
+*/
+// ------------------------------------------------------------------------------------------------
+acd_uint32_t SfpPresenceTracker::Update(acd_uint32_t a_word, acd_uint64_t a_status)
+{
+   acd_uint64_t   present;
+   acd_uint64_t   changed;
+   acd_uint64_t   now;
+   acd_uint32_t   nbChanged = 0;
+
+   if ( a_word >= SFP_PRESENCE_MAX_WORDS )
+   {
+      return 0;
+   }
+
+   pthread_mutex_lock(&m_mutex);
+   present = ~a_status & m_detectMask[a_word];
+   changed = present ^ m_present[a_word];
+   if ( changed != 0 )
+   {
+      m_present[a_word] = present;
+      now = sfpGetTimeUs();
+
+      // Visit the changed bits only, lowest first
+      while ( changed != 0 )
+      {
+         acd_uint32_t   bit = __builtin_ctzll(changed);
+         acd_uint32_t   portId = m_bitToPort[a_word][bit];
+         bool           bInserted = ((present >> bit) & 1) != 0;
+
+         changed &= changed - 1;
+         if ( bInserted )
+         {
+            m_portPresent |= (1ULL << portId);
+            m_portInserted |= (1ULL << portId);
+         }
+         else
+         {
+            m_portPresent &= ~(1ULL << portId);
+            m_portRemoved |= (1ULL << portId);
+         }
+         m_portChanged |= (1ULL << portId);
+         m_changeTime[portId] = now;
+         nbChanged++;
+      }
+   }
+   pthread_mutex_unlock(&m_mutex);
+   return nbChanged;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Get and clear the ports changed since the last call
+
+   A port inserted then removed (or the reverse) between two calls is reported in both the
+   inserted and removed masks, its current presence is given by IsPresent(). Only the change
+   times of the changed ports are set.
+
+   @param [out]    a_pChanges : Changed ports with their direction and change time, NULL if not needed
+
+   @return     Changed ports, bit N for port identifier N
+*/
+// ------------------------------------------------------------------------------------------------
+acd_uint64_t SfpPresenceTracker::TakeChanged(SfpPresenceChanges* a_pChanges)
+{
+   acd_uint64_t changed;
+
+   pthread_mutex_lock(&m_mutex);
+   changed = m_portChanged;
+   if ( a_pChanges != NULL )
+   {
+      acd_uint64_t ports = changed;
+
+      a_pChanges->changed  = changed;
+      a_pChanges->inserted = m_portInserted;
+      a_pChanges->removed  = m_portRemoved;
+      while ( ports != 0 )
+      {
+         acd_uint32_t portId = __builtin_ctzll(ports);
+
+         ports &= ports - 1;
+         a_pChanges->changeTime[portId] = m_changeTime[portId];
+      }
+   }
+   m_portChanged = 0;
+   m_portInserted = 0;
+   m_portRemoved = 0;
+   pthread_mutex_unlock(&m_mutex);
+   return changed;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Get the presence of a port as of the last update
+
+   @param [in]     a_portId : Port identifier
+
+   @return     true if present
+*/
+// ------------------------------------------------------------------------------------------------
+bool SfpPresenceTracker::IsPresent(acd_uint32_t a_portId)
+{
+   acd_uint64_t present;
+
+   if ( a_portId >= SFP_PRESENCE_MAX_PORTS )
+   {
+      return false;
+   }
+
+   // The 64 bit mask is not read atomically on all the targets
+   pthread_mutex_lock(&m_mutex);
+   present = m_portPresent;
+   pthread_mutex_unlock(&m_mutex);
+   return ((present >> a_portId) & 1) != 0;
+}
+
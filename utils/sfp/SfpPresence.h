@@ -0,0 +1,75 @@
+// ------------------------------------------------------------------------------------------------
+/* ACCEDIAN PROPRIETARY - www.accedian.com
+   COPYRIGHT (c) 2004-2014 BY ACCEDIAN CORPORATION. ALL RIGHTS RESERVED. NO PART OF THIS PROGRAM OR
+   PUBLICATION MAY BE REPRODUCED, TRANSMITTED, TRANSCRIBED, STORED IN A RETRIEVAL SYSTEM,
+   OR TRANSLATED INTO ANY LANGUAGE OR COMPUTER LANGUAGE IN ANY FORM OR BY ANY MEANS, ELECTRONIC,
+   MECHANICAL, MAGNETIC, OPTICAL, CHEMICAL, MANUAL, OR OTHERWISE, WITHOUT THE PRIOR WRITTEN
+   PERMISSION OF ACCEDIAN INC.
+*/
+// ------------------------------------------------------------------------------------------------
+/*!@file    SfpPresence.h
+   @brief   SFP presence change detection
+
+   This file contains the SFP presence tracker class definition
+*/
+// ------------------------------------------------------------------------------------------------
+#ifndef __SFPPRESENCE_H__
+#define __SFPPRESENCE_H__
+
+#include <pthread.h>
+#include <global/acd_types.h>
+
+#define SFP_PRESENCE_MAX_WORDS   2     // Maximum number of status registers
+#define SFP_PRESENCE_MAX_PORTS   64    // Port identifiers 0 to 63
+#define SFP_PRESENCE_NO_PORT     0xFF
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief SFP presence changes, see SfpPresenceTracker::TakeChanged()
+
+   A port inserted then removed between two calls is in both the inserted and removed masks.
+*/
+// ------------------------------------------------------------------------------------------------
+struct SfpPresenceChanges
+{
+   acd_uint64_t   changed;          // Ports changed, bit N for port identifier N
+   acd_uint64_t   inserted;         // Ports inserted
+   acd_uint64_t   removed;          // Ports removed
+   acd_uint64_t   changeTime[SFP_PRESENCE_MAX_PORTS];  // Time of the last change in usec, see sfpGetTimeUs()
+};
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief SFP presence tracker
+
+   Tracks the presence of all the SFPs of a board from the status registers holding their
+   detect pins (active low). Each status update is compared to the previous one with a XOR, and
+   only the changed bits are visited, so the cost depends on the number of ports that changed,
+   not on the number of ports. The changed ports are accumulated in masks, with the direction
+   and the time of the last change of each port, until the consumer takes them (see
+   TakeChanged()), so no change is lost however late the consumer is.
+*/
+// ------------------------------------------------------------------------------------------------
+class SfpPresenceTracker
+{
+
+public:
+   SfpPresenceTracker();
+   virtual ~SfpPresenceTracker();
+
+   bool AddPort(acd_uint32_t a_portId, acd_uint32_t a_word, acd_uint32_t a_bit);
+   acd_uint32_t Update(acd_uint32_t a_word, acd_uint64_t a_status);
+   acd_uint64_t TakeChanged(SfpPresenceChanges* a_pChanges = NULL);
+   bool IsPresent(acd_uint32_t a_portId);
+
+private:
+   acd_uint64_t      m_detectMask[SFP_PRESENCE_MAX_WORDS];     // Detect bits of the ports
+   acd_uint64_t      m_present[SFP_PRESENCE_MAX_WORDS];        // Present ports, one bit per detect bit
+   acd_uint8_t       m_bitToPort[SFP_PRESENCE_MAX_WORDS][64];  // Port of each detect bit
+   acd_uint64_t      m_portPresent;                            // Present ports, one bit per port
+   acd_uint64_t      m_portChanged;                            // Ports changed since TakeChanged()
+   acd_uint64_t      m_portInserted;                           // Ports inserted since TakeChanged()
+   acd_uint64_t      m_portRemoved;                            // Ports removed since TakeChanged()
+   acd_uint64_t      m_changeTime[SFP_PRESENCE_MAX_PORTS];     // Time of the last change of each port
+   pthread_mutex_t   m_mutex;                                  // Protects the state
+};
+
+#endif // #ifndef __SFPPRESENCE_H__
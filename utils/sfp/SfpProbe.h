@@ -0,0 +1,61 @@
+// ------------------------------------------------------------------------------------------------
+/* ACCEDIAN PROPRIETARY - www.accedian.com
+   COPYRIGHT (c) 2004-2014 BY ACCEDIAN CORPORATION. ALL RIGHTS RESERVED. NO PART OF THIS PROGRAM OR
+   PUBLICATION MAY BE REPRODUCED, TRANSMITTED, TRANSCRIBED, STORED IN A RETRIEVAL SYSTEM,
+   OR TRANSLATED INTO ANY LANGUAGE OR COMPUTER LANGUAGE IN ANY FORM OR BY ANY MEANS, ELECTRONIC,
+   MECHANICAL, MAGNETIC, OPTICAL, CHEMICAL, MANUAL, OR OTHERWISE, WITHOUT THE PRIOR WRITTEN
+   PERMISSION OF ACCEDIAN INC.
+*/
+// ------------------------------------------------------------------------------------------------
+/*!@file    SfpProbe.h
+   @brief   SFP static tracepoints
+
+   This file contains the static tracepoints (USDT probes) of the SFP stack.
+
+   The probes are compiled in when SFP_TRACEPOINTS is defined, they need <sys/sdt.h> (systemtap
+   sdt headers). A probe is a single nop in the code and a note in the ELF file, the arguments
+   are only evaluated by the tracer when the probe is attached. Without SFP_TRACEPOINTS the probes
+   compile to nothing.
+
+   All the probes are in the "sfp" provider:
+
+   Probe                Arguments
+   i2c_lock             base address
+   i2c_unlock           base address
+   i2c_select           base address, device, offset, result
+   i2c_cmd              base address, device, offset, length
+   i2c_waitbusy         base address, status, retries, result
+   update_start         SFP, page (0xA0 or 0xA2)
+   update_end           SFP, page (0xA0 or 0xA2), result
+   checksum_fail        SFP, page (0xA0 or 0xA2)
+   db_lookup            part number, found
+
+   The probes can be listed with "perf list sdt_sfp:*" (after "perf buildid-cache --add <binary>")
+   or "bpftrace -l 'usdt:<binary>:sfp:*'", and used as bpftrace probes, for example:
+
+   bpftrace -e 'usdt:<binary>:sfp:i2c_lock { @t[tid] = nsecs; }
+                usdt:<binary>:sfp:i2c_unlock /@t[tid]/ { @hold = hist(nsecs - @t[tid]); delete(@t[tid]); }'
+*/
+// ------------------------------------------------------------------------------------------------
+#ifndef __SFPPROBE_H__
+#define __SFPPROBE_H__
+
+#ifdef SFP_TRACEPOINTS
+
+#include <sys/sdt.h>
+
+#define SFP_PROBE1(name, a1)                 DTRACE_PROBE1(sfp, name, a1)
+#define SFP_PROBE2(name, a1, a2)             DTRACE_PROBE2(sfp, name, a1, a2)
+#define SFP_PROBE3(name, a1, a2, a3)         DTRACE_PROBE3(sfp, name, a1, a2, a3)
+#define SFP_PROBE4(name, a1, a2, a3, a4)     DTRACE_PROBE4(sfp, name, a1, a2, a3, a4)
+
+#else
+
+#define SFP_PROBE1(name, a1)                 do {} while (0)
+#define SFP_PROBE2(name, a1, a2)             do {} while (0)
+#define SFP_PROBE3(name, a1, a2, a3)         do {} while (0)
+#define SFP_PROBE4(name, a1, a2, a3, a4)     do {} while (0)
+
+#endif // #ifdef SFP_TRACEPOINTS
+
+#endif // #ifndef __SFPPROBE_H__
@@ -0,0 +1,50 @@
+// ------------------------------------------------------------------------------------------------
+/* ACCEDIAN PROPRIETARY - www.accedian.com
+   COPYRIGHT (c) 2004-2014 BY ACCEDIAN CORPORATION. ALL RIGHTS RESERVED. NO PART OF THIS PROGRAM OR
+   PUBLICATION MAY BE REPRODUCED, TRANSMITTED, TRANSCRIBED, STORED IN A RETRIEVAL SYSTEM,
+   OR TRANSLATED INTO ANY LANGUAGE OR COMPUTER LANGUAGE IN ANY FORM OR BY ANY MEANS, ELECTRONIC,
+   MECHANICAL, MAGNETIC, OPTICAL, CHEMICAL, MANUAL, OR OTHERWISE, WITHOUT THE PRIOR WRITTEN
+   PERMISSION OF ACCEDIAN INC.
+*/
+// ------------------------------------------------------------------------------------------------
+/*!@file    SfpTime.h
+   @brief   SFP time helpers
+
+   This file contains the time helpers used to timestamp the SFP events and samples
+*/
+// ------------------------------------------------------------------------------------------------
+#ifndef __SFPTIME_H__
+#define __SFPTIME_H__
+
+#include <time.h>
+#include <global/acd_types.h>
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Get the monotonic time
+
+   @return     Time in usec since an arbitrary point (not affected by date changes)
+*/
+// ------------------------------------------------------------------------------------------------
+static inline acd_uint64_t sfpGetTimeUs()
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ((acd_uint64_t)ts.tv_sec * 1000000) + (ts.tv_nsec / 1000);
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Get the wall clock time
+
+   @return     Time in usec since the Epoch
+*/
+// ------------------------------------------------------------------------------------------------
+static inline acd_uint64_t sfpGetRealTimeUs()
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_REALTIME, &ts);
+   return ((acd_uint64_t)ts.tv_sec * 1000000) + (ts.tv_nsec / 1000);
+}
+
+#endif // #ifndef __SFPTIME_H__
@@ -0,0 +1,434 @@
+// ------------------------------------------------------------------------------------------------
+/* ACCEDIAN PROPRIETARY - www.accedian.com
+   COPYRIGHT (c) 2004-2014 BY ACCEDIAN CORPORATION. ALL RIGHTS RESERVED. NO PART OF THIS PROGRAM OR
+   PUBLICATION MAY BE REPRODUCED, TRANSMITTED, TRANSCRIBED, STORED IN A RETRIEVAL SYSTEM,
+   OR TRANSLATED INTO ANY LANGUAGE OR COMPUTER LANGUAGE IN ANY FORM OR BY ANY MEANS, ELECTRONIC,
+   MECHANICAL, MAGNETIC, OPTICAL, CHEMICAL, MANUAL, OR OTHERWISE, WITHOUT THE PRIOR WRITTEN
+   PERMISSION OF ACCEDIAN INC.
+*/
+// ------------------------------------------------------------------------------------------------
+/*!@file    SfpTrace.cpp
+   @brief   SFP I/O trace recording and replay
+
+   This file contains the SFP I/O trace recorder and player classes
+
+*/
+// ------------------------------------------------------------------------------------------------
+
+#include <accedian/acclib/acd_utils.h>
+#include "SfpTrace.h"
+#include "SfpTime.h"
+
+#define SFP_TRACE_FILE_HDR_SIZE  16    // Magic, version and start time
+#define SFP_TRACE_HDR_SIZE       12    // Transaction header, see SfpTraceRecorder
+
+// ================================================================================================
+// ================================================================================================
+//            PUBLIC CLASS SECTION
+// ================================================================================================
+// ================================================================================================
+// ------------------------------------------------------------------------------------------------
+/*!@brief Constructor
+
+*/
+// ------------------------------------------------------------------------------------------------
+SfpTraceRecorder::SfpTraceRecorder() :
+m_pFile(NULL),
+m_lastUs(0),
+m_nbRecords(0),
+m_nbDropped(0)
+{
+   pthread_mutex_init(&m_mutex, NULL);
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Destructor
+
+*/
+// ------------------------------------------------------------------------------------------------
+SfpTraceRecorder::~SfpTraceRecorder()
+{
+   Close();
+   pthread_mutex_destroy(&m_mutex);
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Start a recording
+
+   @param [in]     a_path : Trace file, replaced if it exists
+
+   @return     true if successful
+*/
+// ------------------------------------------------------------------------------------------------
+bool SfpTraceRecorder::Open(const char* a_path)
+{
+   acd_uint8_t    header[SFP_TRACE_FILE_HDR_SIZE];
+   acd_uint32_t   magic = SFP_TRACE_MAGIC;
+   acd_uint32_t   version = SFP_TRACE_VERSION;
+   acd_uint64_t   start = sfpGetRealTimeUs();
+   bool           bRet = false;
+
+   pthread_mutex_lock(&m_mutex);
+   if ( m_pFile == NULL )
+   {
+      m_pFile = fopen(a_path, "wb");
+      if ( m_pFile != NULL )
+      {
+         memcpy(&header[0], &magic, sizeof(magic));
+         memcpy(&header[4], &version, sizeof(version));
+         memcpy(&header[8], &start, sizeof(start));
+         bRet = (fwrite(header, sizeof(header), 1, m_pFile) == 1);
+         if ( !bRet )
+         {
+            fclose(m_pFile);
+            m_pFile = NULL;
+         }
+         m_lastUs = sfpGetTimeUs();
+         m_nbRecords = 0;
+         m_nbDropped = 0;
+      }
+   }
+   pthread_mutex_unlock(&m_mutex);
+   return bRet;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Stop the recording
+
+*/
+// ------------------------------------------------------------------------------------------------
+void SfpTraceRecorder::Close()
+{
+   pthread_mutex_lock(&m_mutex);
+   if ( m_pFile != NULL )
+   {
+      fclose(m_pFile);
+      m_pFile = NULL;
+   }
+   pthread_mutex_unlock(&m_mutex);
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Check if a recording is in progress
+
+   @return     true if recording
+*/
+// ------------------------------------------------------------------------------------------------
+bool SfpTraceRecorder::IsOpen()
+{
+   return m_pFile != NULL;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Record a transaction
+
+   Does nothing if no recording is in progress.
+
+   @param [in]     a_channel : Channel of the driver
+   @param [in]     a_flags   : Flags, see SFP_TRACE_WRITE
+   @param [in]     a_reg     : Register
+   @param [in]     a_width   : Value size in bytes
+   @param [in]     a_count   : Number of values
+   @param [in]     a_pData   : Values
+*/
+// ------------------------------------------------------------------------------------------------
+void SfpTraceRecorder::Record(acd_uint8_t a_channel, acd_uint8_t a_flags, acd_uint32_t a_reg,
+                              acd_uint32_t a_width, acd_uint32_t a_count, const void* a_pData)
+{
+   acd_uint8_t    buffer[SFP_TRACE_HDR_SIZE + SFP_TRACE_MAX_DATA];
+   acd_uint32_t   size = a_width * a_count;
+   acd_uint64_t   now;
+   acd_uint32_t   delta;
+   acd_uint16_t   count = a_count;
+
+   if ( m_pFile == NULL )
+   {
+      return;
+   }
+
+   pthread_mutex_lock(&m_mutex);
+   if ( m_pFile == NULL )
+   {
+      pthread_mutex_unlock(&m_mutex);
+      return;
+   }
+   if ( (size > SFP_TRACE_MAX_DATA) || (a_width > 0x0F) )
+   {
+      m_nbDropped++;
+      pthread_mutex_unlock(&m_mutex);
+      return;
+   }
+
+   now = sfpGetTimeUs();
+   delta = (acd_uint32_t)(now - m_lastUs);
+   m_lastUs = now;
+   memcpy(&buffer[0], &delta, sizeof(delta));
+   memcpy(&buffer[4], &a_reg, sizeof(a_reg));
+   memcpy(&buffer[8], &count, sizeof(count));
+   buffer[10] = a_channel;
+   buffer[11] = (acd_uint8_t)((a_width << 4) | (a_flags & 0x0F));
+   memcpy(&buffer[SFP_TRACE_HDR_SIZE], a_pData, size);
+   if ( fwrite(buffer, SFP_TRACE_HDR_SIZE + size, 1, m_pFile) == 1 )
+   {
+      m_nbRecords++;
+   }
+   else
+   {
+      m_nbDropped++;
+   }
+   pthread_mutex_unlock(&m_mutex);
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Get the number of transactions recorded
+
+   @return     Number of transactions
+*/
+// ------------------------------------------------------------------------------------------------
+acd_uint32_t SfpTraceRecorder::GetRecordCount()
+{
+   return m_nbRecords;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Get the number of transactions that could not be recorded
+
+   @return     Number of transactions
+*/
+// ------------------------------------------------------------------------------------------------
+acd_uint32_t SfpTraceRecorder::GetDroppedCount()
+{
+   return m_nbDropped;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Constructor
+
+*/
+// ------------------------------------------------------------------------------------------------
+SfpTracePlayer::SfpTracePlayer() :
+m_pData(NULL),
+m_pEntries(NULL),
+m_nbEntries(0),
+m_speed(1),
+m_startUs(0),
+m_nbMismatch(0)
+{
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Destructor
+
+*/
+// ------------------------------------------------------------------------------------------------
+SfpTracePlayer::~SfpTracePlayer()
+{
+   delete [] m_pEntries;
+   delete [] m_pData;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Load a trace
+
+   Must be called before the replay drivers are used.
+
+   @param [in]     a_path : Trace file written by SfpTraceRecorder
+
+   @return     true if successful
+*/
+// ------------------------------------------------------------------------------------------------
+bool SfpTracePlayer::Load(const char* a_path)
+{
+   FILE*          pFile;
+   long           size;
+   acd_uint32_t   magic;
+   acd_uint32_t   version;
+   acd_uint32_t   offset;
+   acd_uint32_t   nbEntries = 0;
+   acd_uint64_t   timeUs = 0;
+
+   pFile = fopen(a_path, "rb");
+   if ( pFile == NULL )
+   {
+      return false;
+   }
+   if ( (fseek(pFile, 0, SEEK_END) != 0) || ((size = ftell(pFile)) < SFP_TRACE_FILE_HDR_SIZE) ||
+        (fseek(pFile, 0, SEEK_SET) != 0) )
+   {
+      fclose(pFile);
+      return false;
+   }
+
+   delete [] m_pEntries;
+   delete [] m_pData;
+   m_pEntries = NULL;
+   m_nbEntries = 0;
+   m_pData = new acd_uint8_t[size];
+   if ( fread(m_pData, size, 1, pFile) != 1 )
+   {
+      fclose(pFile);
+      return false;
+   }
+   fclose(pFile);
+
+   memcpy(&magic, &m_pData[0], sizeof(magic));
+   memcpy(&version, &m_pData[4], sizeof(version));
+   if ( (magic != SFP_TRACE_MAGIC) || (version != SFP_TRACE_VERSION) )
+   {
+      return false;
+   }
+
+   // Count the complete transactions, a recording may have been interrupted
+   for(offset = SFP_TRACE_FILE_HDR_SIZE ; (offset + SFP_TRACE_HDR_SIZE) <= (acd_uint32_t)size ; nbEntries++)
+   {
+      acd_uint16_t count;
+      acd_uint32_t length;
+
+      memcpy(&count, &m_pData[offset + 8], sizeof(count));
+      length = SFP_TRACE_HDR_SIZE + (m_pData[offset + 11] >> 4) * count;
+      if ( (offset + length) > (acd_uint32_t)size )
+      {
+         break;
+      }
+      offset += length;
+   }
+
+   m_pEntries = new Entry[(nbEntries != 0) ? nbEntries : 1];
+   offset = SFP_TRACE_FILE_HDR_SIZE;
+   for(acd_uint32_t i = 0 ; i < nbEntries ; i++)
+   {
+      Entry*         pEntry = &m_pEntries[i];
+      acd_uint32_t   delta;
+
+      memcpy(&delta, &m_pData[offset], sizeof(delta));
+      memcpy(&pEntry->reg, &m_pData[offset + 4], sizeof(pEntry->reg));
+      memcpy(&pEntry->count, &m_pData[offset + 8], sizeof(pEntry->count));
+      pEntry->channel = m_pData[offset + 10];
+      pEntry->flags   = m_pData[offset + 11] & 0x0F;
+      pEntry->width   = m_pData[offset + 11] >> 4;
+      pEntry->pData   = &m_pData[offset + SFP_TRACE_HDR_SIZE];
+      timeUs += delta;
+      pEntry->timeUs  = timeUs;
+      offset += SFP_TRACE_HDR_SIZE + pEntry->width * pEntry->count;
+   }
+   m_nbEntries = nbEntries;
+   Rewind();
+   return true;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Set the replay speed
+
+   @param [in]     a_speed : 1 for the recorded speed (default), N for N times faster, 0 for no wait
+*/
+// ------------------------------------------------------------------------------------------------
+void SfpTracePlayer::SetSpeed(acd_uint32_t a_speed)
+{
+   m_speed = a_speed;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Restart the replay clock
+
+   The replay drivers must be rewound as well, see SfpReplayIoDrv::Rewind().
+*/
+// ------------------------------------------------------------------------------------------------
+void SfpTracePlayer::Rewind()
+{
+   m_startUs = 0;
+   m_nbMismatch = 0;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Get the next transaction of a channel
+
+   Waits until the time of the transaction, according to the replay speed.
+
+   @param [in]     a_channel : Channel
+   @param [in,out] a_cursor  : Index of the next entry to look at, kept by the driver
+   @param [in]     a_flags   : Access flags, SFP_TRACE_WRITE and SFP_TRACE_BLOCK
+   @param [in]     a_reg     : Register accessed
+   @param [in]     a_width   : Value size in bytes
+   @param [in]     a_count   : Number of values
+
+   @return     Transaction, NULL at the end of the trace or if the access does not match
+*/
+// ------------------------------------------------------------------------------------------------
+const SfpTracePlayer::Entry* SfpTracePlayer::Next(acd_uint8_t a_channel, acd_uint32_t& a_cursor, acd_uint8_t a_flags,
+                                                  acd_uint32_t a_reg, acd_uint32_t a_width, acd_uint32_t a_count)
+{
+   while ( a_cursor < m_nbEntries )
+   {
+      const Entry* pEntry = &m_pEntries[a_cursor++];
+
+      if ( pEntry->channel != a_channel )
+      {
+         continue;
+      }
+      if ( ((pEntry->flags & (SFP_TRACE_WRITE | SFP_TRACE_BLOCK)) != a_flags) ||
+           (pEntry->reg != a_reg) || (pEntry->width != a_width) || (pEntry->count != a_count) )
+      {
+         // The transaction is consumed so the replay can resynchronize
+         __sync_fetch_and_add(&m_nbMismatch, 1);
+         return NULL;
+      }
+      wait(pEntry);
+      return pEntry;
+   }
+   return NULL;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Get the number of transactions loaded
+
+   @return     Number of transactions
+*/
+// ------------------------------------------------------------------------------------------------
+acd_uint32_t SfpTracePlayer::GetEntryCount()
+{
+   return m_nbEntries;
+}
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Get the number of accesses that did not match the trace
+
+   A non zero count means the code replayed does not issue the accesses recorded.
+
+   @return     Number of accesses
+*/
+// ------------------------------------------------------------------------------------------------
+acd_uint32_t SfpTracePlayer::GetMismatchCount()
+{
+   return m_nbMismatch;
+}
+
+// ================================================================================================
+// ================================================================================================
+//            PRIVATE CLASS SECTION
+// ================================================================================================
+// ================================================================================================
+// ------------------------------------------------------------------------------------------------
+/*!@brief Wait until the time of a transaction
+
+   The first transaction replayed starts the replay clock.
+
+   @param [in]     a_pEntry : Transaction
+*/
+// ------------------------------------------------------------------------------------------------
+void SfpTracePlayer::wait(const Entry* a_pEntry)
+{
+   acd_uint64_t   now;
+   acd_uint64_t   due;
+
+   if ( m_speed == 0 )
+   {
+      return;
+   }
+   now = sfpGetTimeUs();
+   __sync_bool_compare_and_swap(&m_startUs, 0, now - (a_pEntry->timeUs / m_speed));
+   due = m_startUs + (a_pEntry->timeUs / m_speed);
+   if ( due > now )
+   {
+      acd_usleep(due - now);
+   }
+}
@@ -0,0 +1,272 @@
+// ------------------------------------------------------------------------------------------------
+/* ACCEDIAN PROPRIETARY - www.accedian.com
+   COPYRIGHT (c) 2004-2014 BY ACCEDIAN CORPORATION. ALL RIGHTS RESERVED. NO PART OF THIS PROGRAM OR
+   PUBLICATION MAY BE REPRODUCED, TRANSMITTED, TRANSCRIBED, STORED IN A RETRIEVAL SYSTEM,
+   OR TRANSLATED INTO ANY LANGUAGE OR COMPUTER LANGUAGE IN ANY FORM OR BY ANY MEANS, ELECTRONIC,
+   MECHANICAL, MAGNETIC, OPTICAL, CHEMICAL, MANUAL, OR OTHERWISE, WITHOUT THE PRIOR WRITTEN
+   PERMISSION OF ACCEDIAN INC.
+*/
+// ------------------------------------------------------------------------------------------------
+/*!@file    SfpTrace.h
+   @brief   SFP I/O trace recording and replay
+
+   This file contains the SFP I/O trace recorder and player class definitions, and the I/O
+   drivers recording or replaying a trace
+*/
+// ------------------------------------------------------------------------------------------------
+#ifndef __SFPTRACE_H__
+#define __SFPTRACE_H__
+
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <accedian/acclib/BaseIoDrv.h>
+
+#define SFP_TRACE_MAGIC          0x53465054     // "SFPT"
+#define SFP_TRACE_VERSION        1              // File layout version
+#define SFP_TRACE_MAX_DATA       256            // Maximum number of data bytes per transaction
+
+// Transaction flags
+#define SFP_TRACE_WRITE          0x01           // Write, read otherwise
+#define SFP_TRACE_OK             0x02           // Transaction succeeded
+#define SFP_TRACE_BLOCK          0x04           // Block access (count argument)
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief SFP I/O trace recorder
+
+   Writes the transactions of the traced drivers (see SfpTraceIoDrv) to a binary file. The file
+   starts with the magic, the version and the recording start time (wall clock, in usec), each
+   transaction is then stored as:
+
+   - Time since the previous transaction in usec (32 bits)
+   - Register, as passed to the driver (32 bits)
+   - Number of values (16 bits)
+   - Channel, identifies the traced driver (8 bits), ex: port id
+   - Flags, see SFP_TRACE_WRITE (4 bits) and value size in bytes (4 bits)
+   - Values, read or written
+
+   Values are in host byte order. The recorder can be shared by drivers used by different threads.
+*/
+// ------------------------------------------------------------------------------------------------
+class SfpTraceRecorder
+{
+
+public:
+   SfpTraceRecorder();
+   virtual ~SfpTraceRecorder();
+
+   bool Open(const char* a_path);
+   void Close();
+   bool IsOpen();
+
+   void Record(acd_uint8_t a_channel, acd_uint8_t a_flags, acd_uint32_t a_reg,
+               acd_uint32_t a_width, acd_uint32_t a_count, const void* a_pData);
+   acd_uint32_t GetRecordCount();
+   acd_uint32_t GetDroppedCount();
+
+private:
+   FILE*             m_pFile;          // Trace file, NULL if closed
+   acd_uint64_t      m_lastUs;         // Time of the last transaction
+   acd_uint32_t      m_nbRecords;      // Transactions recorded
+   acd_uint32_t      m_nbDropped;      // Transactions not recorded (too large or write error)
+   pthread_mutex_t   m_mutex;          // Serializes the records
+};
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief SFP I/O trace player
+
+   Loads a trace written by SfpTraceRecorder and feeds it to the replay drivers (see
+   SfpReplayIoDrv), at the recorded speed, faster, or as fast as possible. Each driver replays
+   the transactions of its channel, in order.
+*/
+// ------------------------------------------------------------------------------------------------
+class SfpTracePlayer
+{
+
+public:
+   struct Entry
+   {
+      acd_uint64_t         timeUs;     // Time since the start of the recording
+      acd_uint32_t         reg;        // Register
+      acd_uint16_t         count;      // Number of values
+      acd_uint8_t          channel;    // Channel
+      acd_uint8_t          flags;      // Flags, see SFP_TRACE_WRITE
+      acd_uint32_t         width;      // Value size in bytes
+      const acd_uint8_t*   pData;      // Values
+   };
+
+   SfpTracePlayer();
+   virtual ~SfpTracePlayer();
+
+   bool Load(const char* a_path);
+   void SetSpeed(acd_uint32_t a_speed);
+   void Rewind();
+
+   const Entry* Next(acd_uint8_t a_channel, acd_uint32_t& a_cursor, acd_uint8_t a_flags, acd_uint32_t a_reg,
+                     acd_uint32_t a_width, acd_uint32_t a_count);
+   acd_uint32_t GetEntryCount();
+   acd_uint32_t GetMismatchCount();
+
+private:
+   void wait(const Entry* a_pEntry);
+
+   acd_uint8_t*      m_pData;          // File content
+   Entry*            m_pEntries;       // Transactions
+   acd_uint32_t      m_nbEntries;      // Number of transactions
+   acd_uint32_t      m_speed;          // Speed factor, 0 for no wait
+   acd_uint64_t      m_startUs;        // Time the replay started, 0 if not started
+   acd_uint32_t      m_nbMismatch;     // Transactions not matching the trace
+};
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Tracing I/O driver
+
+   Forwards the accesses to a driver and records them. Wraps the I2C drivers (EEPROM) as well as
+   the FPGA drivers (status registers).
+*/
+// ------------------------------------------------------------------------------------------------
+template <class T>
+class SfpTraceIoDrv : public BaseIoDrv<T>
+{
+
+public:
+   // ---------------------------------------------------------------------------------------------
+   /*!@brief Constructor
+
+      @param [in]     a_pIoDrv    : Driver traced
+      @param [in]     a_pRecorder : Trace recorder
+      @param [in]     a_channel   : Channel of the driver in the trace
+   */
+   // ---------------------------------------------------------------------------------------------
+   SfpTraceIoDrv(BaseIoDrv<T>* a_pIoDrv, SfpTraceRecorder* a_pRecorder, acd_uint8_t a_channel) :
+   BaseIoDrv<T>(0),
+   m_pIoDrv(a_pIoDrv),
+   m_pRecorder(a_pRecorder),
+   m_channel(a_channel)
+   {
+   }
+
+   virtual bool Read(acd_uint32_t a_reg, T& a_data, bool a_bCheckState = true)
+   {
+      bool bRet = m_pIoDrv->Read(a_reg, a_data, a_bCheckState);
+
+      m_pRecorder->Record(m_channel, bRet ? SFP_TRACE_OK : 0, a_reg, sizeof(T), 1, &a_data);
+      return bRet;
+   }
+
+   virtual bool Read(acd_uint32_t a_reg, acd_uint32_t a_nbr, T* a_data, bool a_bCheckState = true)
+   {
+      bool bRet = m_pIoDrv->Read(a_reg, a_nbr, a_data, a_bCheckState);
+
+      m_pRecorder->Record(m_channel, SFP_TRACE_BLOCK | (bRet ? SFP_TRACE_OK : 0), a_reg, sizeof(T), a_nbr, a_data);
+      return bRet;
+   }
+
+   virtual bool Write(acd_uint32_t a_reg, T a_data, bool a_bCheckState = true)
+   {
+      bool bRet = m_pIoDrv->Write(a_reg, a_data, a_bCheckState);
+
+      m_pRecorder->Record(m_channel, SFP_TRACE_WRITE | (bRet ? SFP_TRACE_OK : 0), a_reg, sizeof(T), 1, &a_data);
+      return bRet;
+   }
+
+   virtual bool Write(acd_uint32_t a_reg, acd_uint32_t a_count, T* a_data, bool a_bCheckState = true)
+   {
+      bool bRet = m_pIoDrv->Write(a_reg, a_count, a_data, a_bCheckState);
+
+      m_pRecorder->Record(m_channel, SFP_TRACE_WRITE | SFP_TRACE_BLOCK | (bRet ? SFP_TRACE_OK : 0),
+                          a_reg, sizeof(T), a_count, a_data);
+      return bRet;
+   }
+
+   virtual bool IsReady()
+   {
+      return m_pIoDrv->IsReady();
+   }
+
+private:
+   BaseIoDrv<T>*     m_pIoDrv;         // Driver traced
+   SfpTraceRecorder* m_pRecorder;      // Trace recorder
+   acd_uint8_t       m_channel;        // Channel in the trace
+};
+
+// ------------------------------------------------------------------------------------------------
+/*!@brief Replay I/O driver
+
+   Replaces a traced driver: the reads return the recorded values and results, the writes
+   return the recorded results. An access that does not match the next transaction of the
+   channel fails (see SfpTracePlayer::GetMismatchCount()).
+*/
+// ------------------------------------------------------------------------------------------------
+template <class T>
+class SfpReplayIoDrv : public BaseIoDrv<T>
+{
+
+public:
+   // ---------------------------------------------------------------------------------------------
+   /*!@brief Constructor
+
+      @param [in]     a_pPlayer  : Trace player
+      @param [in]     a_channel  : Channel of the traced driver
+   */
+   // ---------------------------------------------------------------------------------------------
+   SfpReplayIoDrv(SfpTracePlayer* a_pPlayer, acd_uint8_t a_channel) :
+   BaseIoDrv<T>(0),
+   m_pPlayer(a_pPlayer),
+   m_channel(a_channel),
+   m_cursor(0)
+   {
+   }
+
+   virtual bool Read(acd_uint32_t a_reg, T& a_data, bool a_bCheckState = true)
+   {
+      return replay(0, a_reg, 1, &a_data);
+   }
+
+   virtual bool Read(acd_uint32_t a_reg, acd_uint32_t a_nbr, T* a_data, bool a_bCheckState = true)
+   {
+      return replay(SFP_TRACE_BLOCK, a_reg, a_nbr, a_data);
+   }
+
+   virtual bool Write(acd_uint32_t a_reg, T a_data, bool a_bCheckState = true)
+   {
+      return replay(SFP_TRACE_WRITE, a_reg, 1, NULL);
+   }
+
+   virtual bool Write(acd_uint32_t a_reg, acd_uint32_t a_count, T* a_data, bool a_bCheckState = true)
+   {
+      return replay(SFP_TRACE_WRITE | SFP_TRACE_BLOCK, a_reg, a_count, NULL);
+   }
+
+   // ---------------------------------------------------------------------------------------------
+   /*!@brief Restart from the beginning of the trace
+
+   */
+   // ---------------------------------------------------------------------------------------------
+   void Rewind()
+   {
+      m_cursor = 0;
+   }
+
+private:
+   bool replay(acd_uint8_t a_flags, acd_uint32_t a_reg, acd_uint32_t a_count, T* a_pData)
+   {
+      const SfpTracePlayer::Entry* pEntry = m_pPlayer->Next(m_channel, m_cursor, a_flags, a_reg, sizeof(T), a_count);
+
+      if ( pEntry == NULL )
+      {
+         return false;
+      }
+      if ( a_pData != NULL )
+      {
+         memcpy(a_pData, pEntry->pData, a_count * sizeof(T));
+      }
+      return (pEntry->flags & SFP_TRACE_OK) != 0;
+   }
+
+   SfpTracePlayer*   m_pPlayer;        // Trace player
+   acd_uint8_t       m_channel;        // Channel replayed
+   acd_uint32_t      m_cursor;         // Next entry to look at
+};
+
+#endif // #ifndef __SFPTRACE_H__
@@ -43,7 +43,9 @@ enum sfp_id_enum
    SFP_ID_XPACK            = 0x9,
    SFP_ID_X2               = 0xA,
    SFP_ID_DWDM_SFP         = 0xB,
-   SFP_ID_QSFP             = 0xC
+   SFP_ID_QSFP             = 0xC,
+   SFP_ID_QSFP_PLUS        = 0xD,
+   SFP_ID_QSFP28           = 0x11
 };
 
 /*
@@ -144,6 +146,25 @@ enum sfp_rate_enum
    SFP_RATE_16_8_4G_RX_TX  = 0x0A   // Defined for FC-PI-5 (16/8/4G Independent Rx, Tx Rate_select) High=16G only, Low=8G/4G
 };
 
+/*
+ * QSFP (SFF-8636) memory map
+ */
+static const acd_uint8_t QSFP_LANES             = 4;
+static const acd_uint8_t QSFP_STATUS            = 2;     // Lower page status, bit 2: flat memory
+static const acd_uint8_t QSFP_FLAT_MEM          = 0x04;
+static const acd_uint8_t QSFP_TEMP              = 22;    // Lower page temperature
+static const acd_uint8_t QSFP_VCC               = 26;    // Lower page supply voltage
+static const acd_uint8_t QSFP_RX_PWR            = 34;    // Lower page rx power, lanes 1-4
+static const acd_uint8_t QSFP_TX_BIAS           = 42;    // Lower page tx bias, lanes 1-4
+static const acd_uint8_t QSFP_TX_PWR            = 50;    // Lower page tx power, lanes 1-4
+static const acd_uint8_t QSFP_SERIAL_ID_PAGE    = 0x00;  // Upper page 00h, same layout as the SFP serial ID
+static const acd_uint8_t QSFP_THRESHOLD_PAGE    = 0x03;  // Upper page 03h, thresholds
+static const acd_uint8_t QSFP_TEMP_THRESH       = 0;     // Page 03h offsets (bytes 128-255)
+static const acd_uint8_t QSFP_VCC_THRESH        = 16;
+static const acd_uint8_t QSFP_RX_PWR_THRESH     = 48;
+static const acd_uint8_t QSFP_TX_BIAS_THRESH    = 56;
+static const acd_uint8_t QSFP_TX_PWR_THRESH     = 64;
+
 /*
  * Serial ID data fields
  */